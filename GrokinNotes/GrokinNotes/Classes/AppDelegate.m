@@ -9,6 +9,7 @@
 #import "AppDelegate.h"
 #import "TestFlightManager.h"
 #import "NoteManager.h"
+#import "SyncBenchmark.h"
 
 @implementation AppDelegate
 
@@ -21,6 +22,11 @@
     //Initialize TestFlight
     [TestFlightManager startup];
 
+#if DEBUG
+    //Measure synchronization against a fake Drive server, when launched with -SyncBenchmark YES
+    [SyncBenchmark runIfRequested];
+#endif
+
     return YES;
 }
 							
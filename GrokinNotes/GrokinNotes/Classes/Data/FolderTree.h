@@ -0,0 +1,104 @@
+//
+//  FolderTree.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The hierarchy of remote (Google Drive) folders, and the folder holding each remote file, as learned from the change feed, so the folder path of a note can be shown (see `-[NoteManager folderPathOfNote:]`).
+ Notes themselves are kept flat in the documents directory, and are not moved between folders locally, so the tree only maps each folder to its parent and title. The path of a folder (or file) is found in O(depth) by following the parents, and moving or renaming a folder changes its own entry alone, which carries its subtree along.
+ A folder whose parent has not been seen yet (changes arrive in any order) is unresolved until its parent is recorded. So is a folder which a move has made its own ancestor, until a later change to one of the folders on the loop resolves it.
+ Not thread safe; used on the main queue.
+ */
+@interface FolderTree : NSObject
+
+/**
+ The number of folders recorded, resolved or not.
+ */
+@property (nonatomic,assign,readonly) NSUInteger folderCount;
+
+/**
+ Creates a tree from the given property list.
+
+ @param propertyList A property list previously returned by `propertyList`, or `nil` for an empty tree.
+
+ @return A new tree. Malformed entries of the property list are ignored.
+ */
+- (instancetype)initWithPropertyList:(id)propertyList;
+
+/**
+ A representation of the tree suitable for writing as a property list.
+
+ @return The property list.
+ */
+- (id)propertyList;
+
+/**
+ Records a folder, or its new title or parent. The folder's subtree moves with it.
+
+ @param folderID The ID of the folder.
+ @param title    The title of the folder.
+ @param parentID The ID of the parent folder, or `nil` if the folder is at the root.
+
+ @return `YES` if the folder is new, or its title or parent changed.
+ */
+- (BOOL)setFolderWithID:(NSString *)folderID title:(NSString *)title parentID:(NSString *)parentID;
+
+/**
+ Forgets a folder. Folders and files within it are kept, but are unresolved until the folder is recorded again.
+
+ @param folderID The ID of the folder.
+
+ @return `YES` if the folder was recorded.
+ */
+- (BOOL)removeFolderWithID:(NSString *)folderID;
+
+/**
+ Is the given ID that of a recorded folder?
+
+ @param folderID The ID.
+
+ @return `YES` if the folder is recorded.
+ */
+- (BOOL)containsFolderWithID:(NSString *)folderID;
+
+/**
+ Records the folder holding a file.
+
+ @param parentID The ID of the folder holding the file, or `nil` if the file is at the root (or is no longer tracked).
+ @param fileID   The ID of the file.
+
+ @return `YES` if the file was held by another folder (or by none).
+ */
+- (BOOL)setParentID:(NSString *)parentID ofFileWithID:(NSString *)fileID;
+
+/**
+ The IDs of folders which hold recorded folders or files, but which have not been recorded themselves (such as folders which have not changed since the tree began to be tracked). Recording them resolves the paths passing through them.
+
+ @return An NSSet of folder IDs.
+ */
+- (NSSet *)missingFolderIDs;
+
+/**
+ The path of a folder.
+
+ @param folderID The ID of the folder, or `nil` for the root.
+
+ @return An NSArray of the titles of the folders from the root down to and including the given folder (empty for the root), or `nil` if the folder is unknown or unresolved.
+ */
+- (NSArray *)pathOfFolderWithID:(NSString *)folderID;
+
+/**
+ The path of the folder holding a file.
+
+ @param fileID The ID of the file.
+
+ @return An NSArray of folder titles from the root (empty for a file at the root, or not in any recorded folder), or `nil` if the file's folder is unresolved.
+ */
+- (NSArray *)pathOfFileWithID:(NSString *)fileID;
+
+@end
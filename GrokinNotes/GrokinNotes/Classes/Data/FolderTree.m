@@ -0,0 +1,206 @@
+//
+//  FolderTree.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "FolderTree.h"
+
+static NSString * const kFolderTreeKeyFolders = @"folders";
+static NSString * const kFolderTreeKeyFiles = @"files";
+static NSString * const kFolderTreeKeyID = @"id";
+static NSString * const kFolderTreeKeyTitle = @"title";
+static NSString * const kFolderTreeKeyParentID = @"parentID";
+
+#pragma mark - FolderTreeNode
+
+@interface FolderTreeNode : NSObject
+
+@property (nonatomic,copy) NSString *identifier;
+@property (nonatomic,copy) NSString *title;
+//The ID of the parent folder, or nil if the folder is at the root
+@property (nonatomic,copy) NSString *parentID;
+
+@end
+
+@implementation FolderTreeNode
+
+@end
+
+#pragma mark - FolderTree
+
+@interface FolderTree ()
+
+//Maps a folder ID to its FolderTreeNode
+@property (nonatomic,strong) NSMutableDictionary *folders;
+//Maps a file ID to the ID of the folder holding it (files at the root are not held)
+@property (nonatomic,strong) NSMutableDictionary *fileParentIDs;
+
+@end
+
+@implementation FolderTree
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    return [self initWithPropertyList:nil];
+}
+
+- (instancetype)initWithPropertyList:(id)propertyList
+{
+    if ((self = [super init]))
+    {
+        self.folders = [NSMutableDictionary dictionary];
+        self.fileParentIDs = [NSMutableDictionary dictionary];
+        
+        if ([propertyList isKindOfClass:[NSDictionary class]])
+        {
+            NSArray *folders = [propertyList objectForKey:kFolderTreeKeyFolders];
+            for (NSDictionary *folder in ([folders isKindOfClass:[NSArray class]] ? folders : nil))
+            {
+                if ([folder isKindOfClass:[NSDictionary class]])
+                {
+                    NSString *folderID = [folder objectForKey:kFolderTreeKeyID];
+                    NSString *title = [folder objectForKey:kFolderTreeKeyTitle];
+                    NSString *parentID = [folder objectForKey:kFolderTreeKeyParentID];
+                    if ([folderID isKindOfClass:[NSString class]] && [title isKindOfClass:[NSString class]] && (!parentID || [parentID isKindOfClass:[NSString class]]))
+                    {
+                        [self setFolderWithID:folderID title:title parentID:parentID];
+                    }
+                }
+            }
+            
+            NSDictionary *files = [propertyList objectForKey:kFolderTreeKeyFiles];
+            if ([files isKindOfClass:[NSDictionary class]])
+            {
+                [files enumerateKeysAndObjectsUsingBlock:^(id fileID, id parentID, BOOL *stop) {
+                    if ([fileID isKindOfClass:[NSString class]] && [parentID isKindOfClass:[NSString class]])
+                    {
+                        [self.fileParentIDs setObject:parentID forKey:fileID];
+                    }
+                }];
+            }
+        }
+    }
+    
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (NSUInteger)folderCount
+{
+    return self.folders.count;
+}
+
+- (id)propertyList
+{
+    NSMutableArray *folders = [NSMutableArray arrayWithCapacity:self.folders.count];
+    for (FolderTreeNode *node in self.folders.objectEnumerator)
+    {
+        NSMutableDictionary *folder = [NSMutableDictionary dictionaryWithCapacity:3];
+        [folder setObject:node.identifier forKey:kFolderTreeKeyID];
+        [folder setObject:node.title forKey:kFolderTreeKeyTitle];
+        [folder setValue:node.parentID forKey:kFolderTreeKeyParentID];
+        [folders addObject:folder];
+    }
+    
+    return @{kFolderTreeKeyFolders: folders, kFolderTreeKeyFiles: [self.fileParentIDs copy]};
+}
+
+- (BOOL)setFolderWithID:(NSString *)folderID title:(NSString *)title parentID:(NSString *)parentID
+{
+    BOOL retVal = NO;
+    if (folderID && title)
+    {
+        FolderTreeNode *node = [self.folders objectForKey:folderID];
+        if (!node)
+        {
+            node = [[FolderTreeNode alloc] init];
+            node.identifier = folderID;
+            [self.folders setObject:node forKey:folderID];
+        }
+        retVal = ![node.title isEqualToString:title] || !(node.parentID == parentID || [node.parentID isEqualToString:parentID]);
+        //Folders within refer to this one by ID, so its subtree moves with it
+        node.title = title;
+        node.parentID = parentID;
+    }
+    return retVal;
+}
+
+- (BOOL)removeFolderWithID:(NSString *)folderID
+{
+    BOOL retVal = [self containsFolderWithID:folderID];
+    if (retVal)
+    {
+        //The folders and files within refer to it by ID, so they are unresolved until it is recorded again
+        [self.folders removeObjectForKey:folderID];
+    }
+    return retVal;
+}
+
+- (BOOL)containsFolderWithID:(NSString *)folderID
+{
+    return folderID && [self.folders objectForKey:folderID] != nil;
+}
+
+- (BOOL)setParentID:(NSString *)parentID ofFileWithID:(NSString *)fileID
+{
+    BOOL retVal = NO;
+    if (fileID)
+    {
+        NSString *oldParentID = [self.fileParentIDs objectForKey:fileID];
+        retVal = !(oldParentID == parentID || [oldParentID isEqualToString:parentID]);
+        [self.fileParentIDs setValue:parentID forKey:fileID];
+    }
+    return retVal;
+}
+
+- (NSSet *)missingFolderIDs
+{
+    NSMutableSet *retVal = [NSMutableSet setWithArray:[self.fileParentIDs allValues]];
+    for (FolderTreeNode *node in self.folders.objectEnumerator)
+    {
+        if (node.parentID)
+        {
+            [retVal addObject:node.parentID];
+        }
+    }
+    [retVal minusSet:[NSSet setWithArray:[self.folders allKeys]]];
+    return retVal;
+}
+
+- (NSArray *)pathOfFolderWithID:(NSString *)folderID
+{
+    NSMutableArray *titles = [NSMutableArray array];
+    
+    NSString *currentID = folderID;
+    while (currentID && titles)
+    {
+        FolderTreeNode *node = [self.folders objectForKey:currentID];
+        //A path longer than the number of folders has come back on itself
+        if (node && titles.count < self.folders.count)
+        {
+            [titles addObject:node.title];
+            currentID = node.parentID;
+        }
+        else
+        {
+            //Unknown, or unresolved
+            titles = nil;
+        }
+    }
+    
+    return [[titles reverseObjectEnumerator] allObjects];
+}
+
+- (NSArray *)pathOfFileWithID:(NSString *)fileID
+{
+    NSString *parentID = fileID ? [self.fileParentIDs objectForKey:fileID] : nil;
+    return [self pathOfFolderWithID:parentID];
+}
+
+@end
@@ -8,6 +8,11 @@
 
 #import <Foundation/Foundation.h>
 
+@class NoteIndexEntry;
+@class NoteJournal;
+@class NoteJournalState;
+@class NoteTable;
+
 @interface Note : NSObject
 
 @property (nonatomic,copy) NSString *title;
@@ -17,12 +22,25 @@
 @property (nonatomic,copy,readonly) NSString *MD5;
 @property (nonatomic,assign,readonly) BOOL deleted;
 @property (nonatomic,assign,readonly) BOOL dirty;
+//The table holding the note, and the note's row in it, which are maintained by the table (see NoteTable)
+@property (nonatomic,weak) NoteTable *table;
+@property (nonatomic,assign) NSUInteger tableRow;
+
+//Sets the file, taking the metadata from the given (validated) index entry rather than reading it from the file. If `entry` is `nil` this behaves as `setFile:`.
+- (void)setFile:(NSURL *)file indexEntry:(NoteIndexEntry *)entry;
+
+//Once set, metadata changes of notes in the journal's directory are recorded in the journal rather than written to the extended attributes of their files (see NoteJournal)
++ (void)setJournal:(NoteJournal *)journal;
++ (NoteJournal *)journal;
+//Writes journaled metadata to the extended attributes of the given file. Used when the journal is compacted.
++ (void)writeJournalState:(NoteJournalState *)state toFile:(NSURL *)file;
 
 - (NSString *)updateMD5;
 
 - (NSError *)updateTitle:(NSString *)title;
 
 - (void)writeRemoteID:(NSString *)remoteID;
+- (void)removeRemoteID;
 - (NSString *)readRemoteID;
 
 - (void)writeLocalID:(NSString *)localID;
@@ -34,6 +52,13 @@
 - (void)writeDirty:(BOOL)dirty;
 - (NSNumber *)readDirty;
 
+//The checksum of the content the remote was last known to have, which is kept in the blob store. Unlike the other metadata this is not loaded with the note, so it is read on demand.
+- (void)writeSyncedMD5:(NSString *)syncedMD5;
+- (void)removeSyncedMD5;
+- (NSString *)readSyncedMD5;
+//Safe to call from any queue
++ (NSString *)syncedMD5OfFile:(NSURL *)file;
+
 - (void)readContent:(void(^)(NSString *content, NSError *error))completion;
 - (void)writeContent:(NSString *)content completion:(void(^)(BOOL changed, NSString *content, NSError *error))completion;
 
@@ -7,13 +7,33 @@
 //
 
 #import "Note.h"
-#import "FileMD5Hash.h"
 #import "GRKFileManager.h"
+#import "GRKDigestCache.h"
+#import "NoteIndex.h"
+#import "NoteJournal.h"
+#import "NoteTable.h"
 
 static NSString * const kExtendedAttributeKeyRemoteID = @"com.levigroker.remote.id";
 static NSString * const kExtendedAttributeKeyLocalID = @"com.levigroker.local.id";
 static NSString * const kExtendedAttributeKeyDeleted = @"com.levigroker.local.deleted";
 static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirty";
+static NSString * const kExtendedAttributeKeySyncedMD5 = @"com.levigroker.synced.md5";
+
+//Records metadata changes in place of the extended attributes, for the note files in its directory (see setJournal:)
+static NoteJournal *gNoteJournal = nil;
+
+/**
+ The journal, if it describes the directory holding the given file.
+ */
+static NoteJournal *NoteJournalForFile(NSURL *file)
+{
+    NoteJournal *retVal = gNoteJournal;
+    if (retVal && (!file || ![[[file URLByDeletingLastPathComponent] path] isEqualToString:[retVal.directory path]]))
+    {
+        retVal = nil;
+    }
+    return retVal;
+}
 
 @interface Note ()
 
@@ -23,6 +43,12 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
 @property (nonatomic,assign,readwrite) BOOL deleted;
 @property (nonatomic,assign,readwrite) BOOL dirty;
 
+- (NoteJournal *)journal;
+- (NoteJournalState *)journalState;
+- (BOOL)canJournal;
+- (void)journalMetadata;
++ (BOOL)removeExtendedAttribute:(NSString *)attributeName ofFile:(NSURL *)file error:(__autoreleasing NSError **)error;
+
 @end
 
 @implementation Note
@@ -52,11 +78,103 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     }
 }
 
+- (void)setFile:(NSURL *)file indexEntry:(NoteIndexEntry *)entry
+{
+    if (entry)
+    {
+        _file = file;
+        _title = [entry.fileName copy];
+        self.localID = entry.localID;
+        self.remoteID = entry.remoteID;
+        self.MD5 = entry.MD5;
+        self.deleted = entry.deleted;
+        self.dirty = entry.dirty;
+        
+        //Changes recorded in the journal are newer than the index
+        NoteJournalState *state = [self journalState];
+        if (state)
+        {
+            self.localID = state.localID;
+            self.remoteID = state.remoteID;
+            self.deleted = state.deleted;
+            self.dirty = state.dirty;
+        }
+    }
+    else
+    {
+        self.file = file;
+    }
+}
+
 - (void)setTitle:(NSString *)title
 {
     [self updateTitle:title];
 }
 
+//The identifiers and flags are columns of the note table, which is kept up to date as they change (see tableNeedsUpdate)
+
+- (void)setLocalID:(NSString *)localID
+{
+    _localID = [localID copy];
+    [self tableNeedsUpdate];
+}
+
+- (void)setRemoteID:(NSString *)remoteID
+{
+    _remoteID = [remoteID copy];
+    [self tableNeedsUpdate];
+}
+
+- (void)setDeleted:(BOOL)deleted
+{
+    _deleted = deleted;
+    [self tableNeedsUpdate];
+}
+
+- (void)setDirty:(BOOL)dirty
+{
+    _dirty = dirty;
+    [self tableNeedsUpdate];
+}
+
+#pragma mark - Journal
+
++ (void)setJournal:(NoteJournal *)journal
+{
+    gNoteJournal = journal;
+}
+
++ (NoteJournal *)journal
+{
+    return gNoteJournal;
+}
+
++ (void)writeJournalState:(NoteJournalState *)state toFile:(NSURL *)file
+{
+    __autoreleasing NSError *error = nil;
+    BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyLocalID forFile:file toValue:state.localID error:&error];
+    if (success)
+    {
+        success = state.remoteID ? [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyRemoteID forFile:file toValue:state.remoteID error:&error] : [self removeExtendedAttribute:kExtendedAttributeKeyRemoteID ofFile:file error:&error];
+    }
+    if (success)
+    {
+        success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyDeleted forFile:file toBool:state.deleted error:&error];
+    }
+    if (success)
+    {
+        success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyDirty forFile:file toBool:state.dirty error:&error];
+    }
+    if (success)
+    {
+        success = state.syncedMD5 ? [GRKFileManager setExtendedAttribute:kExtendedAttributeKeySyncedMD5 forFile:file toValue:state.syncedMD5 error:&error] : [self removeExtendedAttribute:kExtendedAttributeKeySyncedMD5 ofFile:file error:&error];
+    }
+    if (!success)
+    {
+        DDLogError(@"Unable to write journaled metadata as extented attributes of '%@'. Error: %@", file, error);
+    }
+}
+
 #pragma mark - Implementation
 
 - (NSString *)updateMD5
@@ -65,9 +183,8 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     
     if (self.file)
     {
-        CFStringRef filePath = (__bridge CFStringRef)[self.file path];
-        CFStringRef md5value = FileMD5HashCreateWithPath(filePath, FileHashDefaultChunkSizeForReadingData);
-        retVal = (NSString *)CFBridgingRelease(md5value);
+        //Only reads the file if it has changed since it was last hashed
+        retVal = [[GRKDigestCache sharedCache] MD5ForFile:self.file];
     }
     
     self.MD5 = retVal;
@@ -84,6 +201,8 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
         GRKFileManager *grkFileManager = [[GRKFileManager alloc] init];
         NSURL *from = self.file;
         NSURL *to = [[self.file URLByDeletingLastPathComponent] URLByAppendingPathComponent:title];
+        //The journaled metadata is recorded under the file name, so read it before the name changes
+        NSString *syncedMD5 = [self journal] ? [self readSyncedMD5] : nil;
         BOOL success = [from isEqual:to] || [grkFileManager.fileManager moveItemAtURL:from toURL:to error:&error];
         if (success)
         {
@@ -96,21 +215,35 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
             //Update the reference to our file
             _file = to;
             
-            //Write out the local and remote IDs since the actual underlying file has changed (and the extended attributes may have been clobbered).
-            if (localID)
-            {
-                [self writeLocalID:localID];
-            }
-            if (remoteID)
-            {
-                [self writeRemoteID:remoteID];
-            }
-
             //Mark ourselves as dirty, if indeed we changed
             BOOL changed = ![[from lastPathComponent] isEqualToString:title];
-            if (changed)
+            
+            NoteJournal *journal = [self journal];
+            if (journal && localID)
             {
-                [self writeDirty:YES];
+                //Record the metadata under the new name
+                if (changed)
+                {
+                    self.dirty = YES;
+                }
+                [journal recordNote:self syncedMD5:syncedMD5];
+            }
+            else
+            {
+                //Write out the local and remote IDs since the actual underlying file has changed (and the extended attributes may have been clobbered).
+                if (localID)
+                {
+                    [self writeLocalID:localID];
+                }
+                if (remoteID)
+                {
+                    [self writeRemoteID:remoteID];
+                }
+                
+                if (changed)
+                {
+                    [self writeDirty:YES];
+                }
             }
         }
         else
@@ -128,15 +261,45 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
 
 - (void)writeRemoteID:(NSString *)remoteID
 {
-    __autoreleasing NSError *error = nil;
-    BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyRemoteID forFile:self.file toValue:remoteID error:&error];
-    if (success)
+    if ([self canJournal])
     {
         self.remoteID = remoteID;
+        [self journalMetadata];
     }
     else
     {
-        DDLogError(@"Unable to write 'remoteID' as extented attribute. Error: %@", error);
+        __autoreleasing NSError *error = nil;
+        BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyRemoteID forFile:self.file toValue:remoteID error:&error];
+        if (success)
+        {
+            self.remoteID = remoteID;
+        }
+        else
+        {
+            DDLogError(@"Unable to write 'remoteID' as extented attribute. Error: %@", error);
+        }
+    }
+}
+
+- (void)removeRemoteID
+{
+    if ([self canJournal])
+    {
+        self.remoteID = nil;
+        [self journalMetadata];
+    }
+    else
+    {
+        __autoreleasing NSError *error = nil;
+        BOOL success = [Note removeExtendedAttribute:kExtendedAttributeKeyRemoteID ofFile:self.file error:&error];
+        if (success)
+        {
+            self.remoteID = nil;
+        }
+        else
+        {
+            DDLogError(@"Unable to remove 'remoteID' extented attribute. Error: %@", error);
+        }
     }
 }
 
@@ -145,8 +308,13 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     NSString *retVal = nil;
     
     __autoreleasing NSError *error = nil;
-    retVal = [GRKFileManager stringForExtendedAttribute:kExtendedAttributeKeyRemoteID ofFile:self.file error:&error];
-    if (retVal)
+    NoteJournalState *state = [self journalState];
+    if (state)
+    {
+        retVal = state.remoteID;
+        self.remoteID = retVal;
+    }
+    else if ((retVal = [GRKFileManager stringForExtendedAttribute:kExtendedAttributeKeyRemoteID ofFile:self.file error:&error]))
     {
         self.remoteID = retVal;
     }
@@ -165,15 +333,23 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
 
 - (void)writeLocalID:(NSString *)localID
 {
-    __autoreleasing NSError *error = nil;
-    BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyLocalID forFile:self.file toValue:localID error:&error];
-    if (success)
+    if (localID && [self journal])
     {
         self.localID = localID;
+        [self journalMetadata];
     }
     else
     {
-        DDLogError(@"Unable to write 'localID' as extented attribute. Error: %@", error);
+        __autoreleasing NSError *error = nil;
+        BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyLocalID forFile:self.file toValue:localID error:&error];
+        if (success)
+        {
+            self.localID = localID;
+        }
+        else
+        {
+            DDLogError(@"Unable to write 'localID' as extented attribute. Error: %@", error);
+        }
     }
 }
 
@@ -182,8 +358,13 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     NSString *retVal = nil;
     
     __autoreleasing NSError *error = nil;
-    retVal = [GRKFileManager stringForExtendedAttribute:kExtendedAttributeKeyLocalID ofFile:self.file error:&error];
-    if (retVal)
+    NoteJournalState *state = [self journalState];
+    if (state)
+    {
+        retVal = state.localID;
+        self.localID = retVal;
+    }
+    else if ((retVal = [GRKFileManager stringForExtendedAttribute:kExtendedAttributeKeyLocalID ofFile:self.file error:&error]))
     {
         self.localID = retVal;
     }
@@ -202,15 +383,23 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
 
 - (void)writeDeleted:(BOOL)deleted
 {
-    __autoreleasing NSError *error = nil;
-    BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyDeleted forFile:self.file toBool:deleted error:&error];
-    if (success)
+    if ([self canJournal])
     {
         self.deleted = deleted;
+        [self journalMetadata];
     }
     else
     {
-        DDLogError(@"Unable to write 'deleted' as extented attribute. Error: %@", error);
+        __autoreleasing NSError *error = nil;
+        BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyDeleted forFile:self.file toBool:deleted error:&error];
+        if (success)
+        {
+            self.deleted = deleted;
+        }
+        else
+        {
+            DDLogError(@"Unable to write 'deleted' as extented attribute. Error: %@", error);
+        }
     }
 }
 
@@ -219,8 +408,13 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     NSNumber *retVal = nil;
     
     __autoreleasing NSError *error = nil;
-    retVal = [GRKFileManager boolForExtendedAttribute:kExtendedAttributeKeyDeleted ofFile:self.file error:&error];
-    if (retVal)
+    NoteJournalState *state = [self journalState];
+    if (state)
+    {
+        retVal = [NSNumber numberWithBool:state.deleted];
+        self.deleted = state.deleted;
+    }
+    else if ((retVal = [GRKFileManager boolForExtendedAttribute:kExtendedAttributeKeyDeleted ofFile:self.file error:&error]))
     {
         self.deleted = [retVal boolValue];
     }
@@ -239,15 +433,23 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
 
 - (void)writeDirty:(BOOL)dirty
 {
-    __autoreleasing NSError *error = nil;
-    BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyDirty forFile:self.file toBool:dirty error:&error];
-    if (success)
+    if ([self canJournal])
     {
         self.dirty = dirty;
+        [self journalMetadata];
     }
     else
     {
-        DDLogError(@"Unable to write 'dirty' as extented attribute. Error: %@", error);
+        __autoreleasing NSError *error = nil;
+        BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeyDirty forFile:self.file toBool:dirty error:&error];
+        if (success)
+        {
+            self.dirty = dirty;
+        }
+        else
+        {
+            DDLogError(@"Unable to write 'dirty' as extented attribute. Error: %@", error);
+        }
     }
 }
 
@@ -256,8 +458,13 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     NSNumber *retVal = nil;
     
     __autoreleasing NSError *error = nil;
-    retVal = [GRKFileManager boolForExtendedAttribute:kExtendedAttributeKeyDirty ofFile:self.file error:&error];
-    if (retVal)
+    NoteJournalState *state = [self journalState];
+    if (state)
+    {
+        retVal = [NSNumber numberWithBool:state.dirty];
+        self.dirty = state.dirty;
+    }
+    else if ((retVal = [GRKFileManager boolForExtendedAttribute:kExtendedAttributeKeyDirty ofFile:self.file error:&error]))
     {
         self.dirty = [retVal boolValue];
     }
@@ -274,6 +481,68 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     return retVal;
 }
 
+- (void)writeSyncedMD5:(NSString *)syncedMD5
+{
+    if ([self canJournal])
+    {
+        [[self journal] recordNote:self syncedMD5:syncedMD5];
+    }
+    else
+    {
+        __autoreleasing NSError *error = nil;
+        BOOL success = [GRKFileManager setExtendedAttribute:kExtendedAttributeKeySyncedMD5 forFile:self.file toValue:syncedMD5 error:&error];
+        if (!success)
+        {
+            DDLogError(@"Unable to write 'syncedMD5' as extented attribute. Error: %@", error);
+        }
+    }
+}
+
+- (void)removeSyncedMD5
+{
+    if ([self canJournal])
+    {
+        [[self journal] recordNote:self syncedMD5:nil];
+    }
+    else
+    {
+        __autoreleasing NSError *error = nil;
+        BOOL success = [Note removeExtendedAttribute:kExtendedAttributeKeySyncedMD5 ofFile:self.file error:&error];
+        if (!success)
+        {
+            DDLogError(@"Unable to remove 'syncedMD5' extented attribute. Error: %@", error);
+        }
+    }
+}
+
+- (NSString *)readSyncedMD5
+{
+    return [Note syncedMD5OfFile:self.file];
+}
+
++ (NSString *)syncedMD5OfFile:(NSURL *)file
+{
+    NSString *retVal = nil;
+    
+    __autoreleasing NSError *error = nil;
+    NoteJournalState *state = [NoteJournalForFile(file) stateForFileName:[file lastPathComponent]];
+    if (state)
+    {
+        retVal = state.syncedMD5;
+    }
+    else if (!(retVal = [GRKFileManager stringForExtendedAttribute:kExtendedAttributeKeySyncedMD5 ofFile:file error:&error]))
+    {
+        //If we get anything besides ENOATTR (the attribute doesn't exist) then log a warning
+        NSNumber *errnoValue = [error.userInfo objectForKey:kGRKFileManagerErrorKeyErrno];
+        if (!errnoValue || [errnoValue intValue] != ENOATTR)
+        {
+            DDLogWarn(@"Unable to read 'syncedMD5' as extented attribute. Error: %@", error);
+        }
+    }
+    
+    return retVal;
+}
+
 - (void)readContent:(void(^)(NSString *content, NSError *error))completion
 {
     if (completion)
@@ -292,29 +561,55 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
 {
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
         NSString *priorChecksum = [self updateMD5];
+        //Read before the save replaces the file (and its extended attributes)
+        NSString *syncedMD5 = [self readSyncedMD5];
         NSError *error = nil;
         NSString *contentObj = content ?: [NSString string];
-        BOOL success = [contentObj writeToURL:self.file atomically:YES encoding:NSUTF8StringEncoding error:&error];
+        NSData *data = [contentObj dataUsingEncoding:NSUTF8StringEncoding];
+        BOOL success = [data writeToURL:self.file options:NSDataWritingAtomic error:&error];
+        if (success)
+        {
+            //We have the content in hand, so hash it directly rather than reading the file back, and let the cache know
+            NSString *currentChecksum = [GRKDigestCache MD5ForData:data];
+            [[GRKDigestCache sharedCache] setMD5:currentChecksum forFile:self.file];
+            self.MD5 = currentChecksum;
+        }
         if (completion)
         {
             BOOL changed = NO;
             if (success)
             {
-                //Write out the local and remote IDs since the actual underlying file has changed (and the extended attributes have been clobbered).
-                if (self.localID)
+                changed = ![self.MD5 isEqualToString:priorChecksum];
+                
+                if ([self canJournal])
                 {
-                    [self writeLocalID:self.localID];
+                    //A single journal record stands in for the extended attributes the save clobbered. Any synchronized checksum recorded since it was read is in the journal.
+                    if (changed)
+                    {
+                        self.dirty = YES;
+                    }
+                    [[self journal] recordNote:self syncedMD5:[self readSyncedMD5] ?: syncedMD5];
                 }
-                if (self.remoteID)
+                else
                 {
-                    [self writeRemoteID:self.remoteID];
-                }
-                
-                NSString *currentChecksum = [self updateMD5];
-                changed = ![currentChecksum isEqualToString:priorChecksum];
-                if (changed)
-                {
-                    [self writeDirty:YES];
+                    //Write out the local and remote IDs since the actual underlying file has changed (and the extended attributes have been clobbered).
+                    if (self.localID)
+                    {
+                        [self writeLocalID:self.localID];
+                    }
+                    if (self.remoteID)
+                    {
+                        [self writeRemoteID:self.remoteID];
+                    }
+                    if (syncedMD5)
+                    {
+                        [self writeSyncedMD5:syncedMD5];
+                    }
+                    
+                    if (changed)
+                    {
+                        [self writeDirty:YES];
+                    }
                 }
             }
             dispatch_async(dispatch_get_main_queue(), ^{
@@ -324,6 +619,71 @@ static NSString * const kExtendedAttributeKeyDirty = @"com.levigroker.local.dirt
     });
 }
 
+#pragma mark - Helpers
+
+- (void)tableNeedsUpdate
+{
+    NoteTable *table = self.table;
+    if (!table)
+    {
+        return;
+    }
+    
+    //The table is used on the main queue, but metadata also changes on others (i.e. as content is saved), so the row catches up from there
+    if ([NSThread isMainThread])
+    {
+        [table noteDidChange:self];
+    }
+    else
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [table noteDidChange:self];
+        });
+    }
+}
+
+- (NoteJournal *)journal
+{
+    return NoteJournalForFile(self.file);
+}
+
+- (NoteJournalState *)journalState
+{
+    return [[self journal] stateForFileName:[self.file lastPathComponent]];
+}
+
+/**
+ Determines if metadata changes are recorded in the journal rather than the extended attributes of the file. A note must have a local ID to be journaled.
+ */
+- (BOOL)canJournal
+{
+    return self.localID && [self journal];
+}
+
+- (void)journalMetadata
+{
+    [[self journal] recordNote:self syncedMD5:[self readSyncedMD5]];
+}
+
+/**
+ Removes an extended attribute, treating an attribute which does not exist as removed.
+ */
++ (BOOL)removeExtendedAttribute:(NSString *)attributeName ofFile:(NSURL *)file error:(__autoreleasing NSError **)error
+{
+    __autoreleasing NSError *removeError = nil;
+    BOOL retVal = [GRKFileManager removeExtendedAttribute:attributeName ofFile:file error:&removeError];
+    NSNumber *errnoValue = [removeError.userInfo objectForKey:kGRKFileManagerErrorKeyErrno];
+    if (!retVal && errnoValue && [errnoValue intValue] == ENOATTR)
+    {
+        retVal = YES;
+    }
+    else if (!retVal && error)
+    {
+        *error = removeError;
+    }
+    return retVal;
+}
+
 #pragma mark - Overrides
 
 - (NSString *)description
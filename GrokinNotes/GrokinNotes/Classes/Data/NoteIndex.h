@@ -0,0 +1,134 @@
+//
+//  NoteIndex.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/16/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "GRKDirectoryListing.h"
+
+@class Note;
+
+extern NSString * const NoteIndexErrorDomain;
+
+typedef NS_ENUM(NSInteger, NoteIndexError) {
+    NoteIndexErrorBadFormat = 1,
+    NoteIndexErrorBadVersion
+};
+
+/**
+ A snapshot of the metadata for a single note file, as recorded in the NoteIndex.
+ The file statistics (inode, size, modification and change times) are used to determine if the entry still describes the file on disk.
+ */
+@interface NoteIndexEntry : NSObject
+
+@property (nonatomic,copy) NSString *localID;
+@property (nonatomic,copy) NSString *remoteID;
+@property (nonatomic,copy) NSString *fileName;
+@property (nonatomic,copy) NSString *MD5;
+@property (nonatomic,assign) BOOL deleted;
+@property (nonatomic,assign) BOOL dirty;
+@property (nonatomic,assign) unsigned long long inode;
+@property (nonatomic,assign) unsigned long long fileSize;
+/**
+ The file modification time, in nanoseconds since the epoch.
+ */
+@property (nonatomic,assign) long long modificationTime;
+/**
+ The file status change time, in nanoseconds since the epoch. This is bumped by the filesystem on any extended attribute write, so a matching value means the extended attributes have not changed since the entry was recorded.
+ */
+@property (nonatomic,assign) long long changeTime;
+
+/**
+ Creates an entry describing the given note's current metadata and the current state of its file on disk.
+
+ @param note The note to describe.
+
+ @return A new entry, or `nil` if the note's file could not be examined.
+ */
++ (instancetype)entryForNote:(Note *)note;
+
+@end
+
+/**
+ A persistent, compact index of note metadata which allows the notes to be loaded at startup without reading each note file's extended attributes and content.
+ The index is stored as a single file containing a table of fixed size records sorted by localID, a secondary table of record numbers sorted by file name, and a string table. It is memory mapped when loaded, so lookups do not require the index to be parsed up front.
+ The extended attributes of the note files remain authoritative; an entry is only used if the file on disk still matches the statistics recorded for it.
+ */
+@interface NoteIndex : NSObject
+
+/**
+ The file URL where the index is stored.
+ */
+@property (nonatomic,readonly) NSURL *url;
+
+/**
+ The number of entries in the currently loaded index.
+ */
+@property (nonatomic,readonly) NSUInteger count;
+
+/**
+ Creates an index backed by the given file.
+
+ @param url The file URL where the index is stored.
+
+ @return A new, empty, index. Use `load:` to read the existing index from disk.
+ */
+- (instancetype)initWithURL:(NSURL *)url;
+
+/**
+ Loads (memory maps) the index from disk, replacing any previously loaded content.
+ A missing index file is not considered an error; the index will simply be empty.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)load:(__autoreleasing NSError **)error;
+
+/**
+ Looks up the entry for the note with the given local ID.
+
+ @param localID The local ID of the note.
+
+ @return The entry, or `nil` if the index holds no entry for the ID.
+ */
+- (NoteIndexEntry *)entryForLocalID:(NSString *)localID;
+
+/**
+ Looks up the entry for the given file, and verifies it still describes the file on disk.
+
+ @param fileURL The file URL of the note file.
+
+ @return The entry, or `nil` if there is no entry for the file or the file has changed since the entry was recorded.
+ */
+- (NoteIndexEntry *)validEntryForFile:(NSURL *)fileURL;
+
+/**
+ Looks up the entry for a file found in a directory listing, and verifies it still describes the file, using the file statistics already gathered by the listing.
+
+ @param directoryEntry An entry of `listing`.
+ @param listing        The listing of the notes directory.
+
+ @return The entry, or `nil` if there is no entry for the file or the file has changed since the entry was recorded.
+ */
+- (NoteIndexEntry *)validEntryForDirectoryEntry:(const GRKDirectoryEntry *)directoryEntry inListing:(GRKDirectoryListing *)listing;
+
+/**
+ Rebuilds the index from the given notes and atomically writes it to disk. The newly written index is then loaded.
+
+ @param notes An array of Note objects to record in the index.
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)saveNotes:(NSArray *)notes error:(__autoreleasing NSError **)error;
+
+/**
+ Removes the index from memory and disk.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,521 @@
+//
+//  NoteIndex.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/16/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "NoteIndex.h"
+#import "Note.h"
+#include <sys/stat.h>
+
+NSString * const NoteIndexErrorDomain = @"NoteIndexErrorDomain";
+
+static uint32_t const kNoteIndexMagic = 0x58494E47; // "GNIX"
+static uint32_t const kNoteIndexVersion = 1;
+static NSUInteger const kNoteIndexDigestLength = 16;
+
+typedef NS_OPTIONS(uint16_t, NoteIndexRecordFlags) {
+    NoteIndexRecordFlagDeleted = 1 << 0,
+    NoteIndexRecordFlagDirty = 1 << 1,
+    NoteIndexRecordFlagHasMD5 = 1 << 2,
+    NoteIndexRecordFlagHasRemoteID = 1 << 3
+};
+
+/**
+ The file layout is: header | records (sorted by localID) | file name order (record numbers sorted by file name) | strings
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t stringsLength;
+} NoteIndexHeader;
+
+typedef struct {
+    uint64_t inode;
+    uint64_t fileSize;
+    int64_t modificationTime;
+    int64_t changeTime;
+    uint32_t localIDOffset;
+    uint32_t remoteIDOffset;
+    uint32_t fileNameOffset;
+    uint16_t localIDLength;
+    uint16_t remoteIDLength;
+    uint16_t fileNameLength;
+    uint16_t flags;
+    uint8_t digest[16];
+    uint32_t reserved;
+} NoteIndexRecord;
+
+#pragma mark - Helpers
+
+static long long NoteIndexNanoseconds(struct timespec time)
+{
+    return (long long)time.tv_sec * (long long)NSEC_PER_SEC + (long long)time.tv_nsec;
+}
+
+static int NoteIndexCompareBytes(const char *bytes1, NSUInteger length1, const char *bytes2, NSUInteger length2)
+{
+    int retVal = memcmp(bytes1, bytes2, MIN(length1, length2));
+    if (retVal == 0)
+    {
+        retVal = length1 < length2 ? -1 : (length1 > length2 ? 1 : 0);
+    }
+    return retVal;
+}
+
+static BOOL NoteIndexDigestFromString(NSString *string, uint8_t *digest)
+{
+    BOOL retVal = NO;
+
+    const char *hex = [string UTF8String];
+    if (hex && strlen(hex) == kNoteIndexDigestLength * 2)
+    {
+        retVal = YES;
+        for (NSUInteger i = 0; i < kNoteIndexDigestLength && retVal; ++i)
+        {
+            unsigned int byte = 0;
+            retVal = sscanf(hex + (i * 2), "%2x", &byte) == 1;
+            digest[i] = (uint8_t)byte;
+        }
+    }
+
+    return retVal;
+}
+
+static NSString *NoteIndexStringFromDigest(const uint8_t *digest)
+{
+    //Lower case hex, to match the format produced by FileMD5Hash
+    char hex[kNoteIndexDigestLength * 2 + 1];
+    for (NSUInteger i = 0; i < kNoteIndexDigestLength; ++i)
+    {
+        snprintf(hex + (i * 2), 3, "%02x", (int)digest[i]);
+    }
+    return [[NSString alloc] initWithBytes:hex length:kNoteIndexDigestLength * 2 encoding:NSASCIIStringEncoding];
+}
+
+static NSError *NoteIndexError(NoteIndexError code, NSString *message)
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    return [NSError errorWithDomain:NoteIndexErrorDomain code:code userInfo:userInfo];
+}
+
+#pragma mark - NoteIndexEntry
+
+@implementation NoteIndexEntry
+
++ (instancetype)entryForNote:(Note *)note
+{
+    NoteIndexEntry *retVal = nil;
+
+    struct stat fileStat;
+    if (note.file && lstat([note.file fileSystemRepresentation], &fileStat) == 0)
+    {
+        retVal = [[NoteIndexEntry alloc] init];
+        retVal.localID = note.localID;
+        retVal.remoteID = note.remoteID;
+        retVal.fileName = [note.file lastPathComponent];
+        retVal.MD5 = note.MD5;
+        retVal.deleted = note.deleted;
+        retVal.dirty = note.dirty;
+        retVal.inode = (unsigned long long)fileStat.st_ino;
+        retVal.fileSize = (unsigned long long)fileStat.st_size;
+        retVal.modificationTime = NoteIndexNanoseconds(fileStat.st_mtimespec);
+        retVal.changeTime = NoteIndexNanoseconds(fileStat.st_ctimespec);
+    }
+
+    return retVal;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"[%@ <%p> fileName: \"%@\", dirty: %@, deleted: %@, localID \"%@\", remoteID \"%@\", MD5 \"%@\"]", [self class],
+            self, self.fileName, self.dirty ? @"YES" : @"NO", self.deleted ? @"YES" : @"NO", self.localID, self.remoteID, self.MD5];
+}
+
+@end
+
+#pragma mark - NoteIndex
+
+@interface NoteIndex ()
+
+@property (nonatomic,strong,readwrite) NSURL *url;
+//Atomic, so lookups may be performed from any queue while the index is being replaced.
+@property (atomic,strong) NSData *data;
+
+@end
+
+@implementation NoteIndex
+
+#pragma mark - Initialization
+
+- (instancetype)initWithURL:(NSURL *)url
+{
+    if ((self = [super init]))
+    {
+        self.url = url;
+    }
+
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)count
+{
+    NSData *data = self.data;
+    return data ? ((const NoteIndexHeader *)[data bytes])->count : 0;
+}
+
+#pragma mark - Implementation
+
+- (BOOL)load:(__autoreleasing NSError **)error
+{
+    BOOL success = YES;
+    NSData *data = nil;
+
+    if ([[NSFileManager defaultManager] fileExistsAtPath:[self.url path]])
+    {
+        data = [NSData dataWithContentsOfURL:self.url options:NSDataReadingMappedIfSafe error:error];
+        success = data != nil;
+        if (success)
+        {
+            NSError *validationError = [self validateData:data];
+            if (validationError)
+            {
+                DDLogWarn(@"Discarding note index '%@'. Error: %@", self.url, validationError);
+                data = nil;
+                success = NO;
+                if (error)
+                {
+                    *error = validationError;
+                }
+            }
+        }
+    }
+
+    self.data = data;
+
+    return success;
+}
+
+- (NoteIndexEntry *)entryForLocalID:(NSString *)localID
+{
+    NoteIndexEntry *retVal = nil;
+
+    NSData *data = self.data;
+    const char *key = [localID UTF8String];
+    if (data && key)
+    {
+        NSUInteger keyLength = strlen(key);
+        const NoteIndexHeader *header = [data bytes];
+        const NoteIndexRecord *records = (const NoteIndexRecord *)(header + 1);
+        const char *strings = [self stringsInData:data];
+
+        //Binary search of the records, which are sorted by localID
+        NSInteger low = 0;
+        NSInteger high = (NSInteger)header->count - 1;
+        while (low <= high)
+        {
+            NSInteger mid = low + ((high - low) / 2);
+            const NoteIndexRecord *record = &records[mid];
+            int comparison = NoteIndexCompareBytes(strings + record->localIDOffset, record->localIDLength, key, keyLength);
+            if (comparison == 0)
+            {
+                retVal = [self entryForRecord:record strings:strings];
+                break;
+            }
+            else if (comparison < 0)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid - 1;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (NoteIndexEntry *)validEntryForFile:(NSURL *)fileURL
+{
+    NoteIndexEntry *retVal = nil;
+
+    struct stat fileStat;
+    const char *fileName = [[fileURL lastPathComponent] UTF8String];
+    if (fileName && lstat([fileURL fileSystemRepresentation], &fileStat) == 0)
+    {
+        GRKDirectoryEntry directoryEntry;
+        directoryEntry.inode = (uint64_t)fileStat.st_ino;
+        directoryEntry.size = (uint64_t)fileStat.st_size;
+        directoryEntry.modificationTime = NoteIndexNanoseconds(fileStat.st_mtimespec);
+        directoryEntry.changeTime = NoteIndexNanoseconds(fileStat.st_ctimespec);
+        retVal = [self validEntryForFileName:fileName length:strlen(fileName) directoryEntry:&directoryEntry];
+    }
+
+    return retVal;
+}
+
+- (NoteIndexEntry *)validEntryForDirectoryEntry:(const GRKDirectoryEntry *)directoryEntry inListing:(GRKDirectoryListing *)listing
+{
+    //Directory listings hold names in filesystem representation, which is UTF-8 on our platforms
+    NoteIndexEntry *retVal = [self validEntryForFileName:[listing fileSystemNameOfEntry:directoryEntry] length:directoryEntry->nameLength directoryEntry:directoryEntry];
+    return retVal;
+}
+
+- (BOOL)saveNotes:(NSArray *)notes error:(__autoreleasing NSError **)error
+{
+    //Gather the entries, along with their keys as UTF-8 data for sorting
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:notes.count];
+    for (Note *note in notes)
+    {
+        if (note.localID)
+        {
+            NoteIndexEntry *entry = [NoteIndexEntry entryForNote:note];
+            if (entry)
+            {
+                [entries addObject:entry];
+            }
+        }
+    }
+
+    [entries sortUsingComparator:^NSComparisonResult(NoteIndexEntry *entry1, NoteIndexEntry *entry2) {
+        const char *key1 = [entry1.localID UTF8String];
+        const char *key2 = [entry2.localID UTF8String];
+        int comparison = NoteIndexCompareBytes(key1, strlen(key1), key2, strlen(key2));
+        return comparison < 0 ? NSOrderedAscending : (comparison > 0 ? NSOrderedDescending : NSOrderedSame);
+    }];
+
+    //Build the records and string table
+    NSUInteger count = entries.count;
+    NSMutableData *recordData = [NSMutableData dataWithLength:count * sizeof(NoteIndexRecord)];
+    NoteIndexRecord *records = [recordData mutableBytes];
+    NSMutableData *strings = [NSMutableData data];
+
+    uint32_t (^appendString)(NSString *, uint16_t *) = ^uint32_t(NSString *string, uint16_t *length) {
+        uint32_t offset = (uint32_t)strings.length;
+        NSData *bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+        if (bytes.length <= UINT16_MAX)
+        {
+            [strings appendData:bytes];
+            *length = (uint16_t)bytes.length;
+        }
+        else
+        {
+            *length = 0;
+        }
+        return offset;
+    };
+
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        NoteIndexEntry *entry = [entries objectAtIndex:i];
+        NoteIndexRecord *record = &records[i];
+        record->inode = entry.inode;
+        record->fileSize = entry.fileSize;
+        record->modificationTime = entry.modificationTime;
+        record->changeTime = entry.changeTime;
+        record->localIDOffset = appendString(entry.localID, &record->localIDLength);
+        record->fileNameOffset = appendString(entry.fileName, &record->fileNameLength);
+
+        NoteIndexRecordFlags flags = 0;
+        if (entry.remoteID)
+        {
+            record->remoteIDOffset = appendString(entry.remoteID, &record->remoteIDLength);
+            flags |= NoteIndexRecordFlagHasRemoteID;
+        }
+        if (entry.MD5 && NoteIndexDigestFromString(entry.MD5, record->digest))
+        {
+            flags |= NoteIndexRecordFlagHasMD5;
+        }
+        if (entry.deleted)
+        {
+            flags |= NoteIndexRecordFlagDeleted;
+        }
+        if (entry.dirty)
+        {
+            flags |= NoteIndexRecordFlagDirty;
+        }
+        record->flags = flags;
+    }
+
+    //Build the file name order table
+    NSMutableData *nameOrderData = [NSMutableData dataWithLength:count * sizeof(uint32_t)];
+    uint32_t *nameOrder = [nameOrderData mutableBytes];
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        nameOrder[i] = (uint32_t)i;
+    }
+    const char *stringBytes = [strings bytes];
+    qsort_b(nameOrder, count, sizeof(uint32_t), ^int(const void *a, const void *b) {
+        const NoteIndexRecord *record1 = &records[*(const uint32_t *)a];
+        const NoteIndexRecord *record2 = &records[*(const uint32_t *)b];
+        return NoteIndexCompareBytes(stringBytes + record1->fileNameOffset, record1->fileNameLength, stringBytes + record2->fileNameOffset, record2->fileNameLength);
+    });
+
+    NoteIndexHeader header;
+    header.magic = kNoteIndexMagic;
+    header.version = kNoteIndexVersion;
+    header.count = (uint32_t)count;
+    header.stringsLength = (uint32_t)strings.length;
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + recordData.length + nameOrderData.length + strings.length];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:recordData];
+    [data appendData:nameOrderData];
+    [data appendData:strings];
+
+    BOOL success = [data writeToURL:self.url options:NSDataWritingAtomic error:error];
+    if (success)
+    {
+        self.data = data;
+        DDLogVerbose(@"Saved note index with %@ entries to '%@'.", @(count), self.url);
+    }
+
+    return success;
+}
+
+- (void)reset
+{
+    self.data = nil;
+    [[NSFileManager defaultManager] removeItemAtURL:self.url error:nil];
+}
+
+#pragma mark - Helpers
+
+- (const char *)stringsInData:(NSData *)data
+{
+    const NoteIndexHeader *header = [data bytes];
+    return (const char *)[data bytes] + sizeof(NoteIndexHeader) + (header->count * (sizeof(NoteIndexRecord) + sizeof(uint32_t)));
+}
+
+- (NoteIndexEntry *)validEntryForFileName:(const char *)key length:(NSUInteger)keyLength directoryEntry:(const GRKDirectoryEntry *)directoryEntry
+{
+    NoteIndexEntry *retVal = nil;
+
+    NSData *data = self.data;
+    if (data && key)
+    {
+        const NoteIndexHeader *header = [data bytes];
+        const NoteIndexRecord *records = (const NoteIndexRecord *)(header + 1);
+        const uint32_t *nameOrder = (const uint32_t *)(records + header->count);
+        const char *strings = [self stringsInData:data];
+
+        //Binary search of the file name order table
+        const NoteIndexRecord *found = NULL;
+        NSInteger low = 0;
+        NSInteger high = (NSInteger)header->count - 1;
+        while (low <= high)
+        {
+            NSInteger mid = low + ((high - low) / 2);
+            const NoteIndexRecord *record = &records[nameOrder[mid]];
+            int comparison = NoteIndexCompareBytes(strings + record->fileNameOffset, record->fileNameLength, key, keyLength);
+            if (comparison == 0)
+            {
+                found = record;
+                break;
+            }
+            else if (comparison < 0)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid - 1;
+            }
+        }
+
+        //Only trust the entry if the file has not been touched since the entry was recorded.
+        if (found &&
+            found->inode == directoryEntry->inode &&
+            found->fileSize == directoryEntry->size &&
+            found->modificationTime == directoryEntry->modificationTime &&
+            found->changeTime == directoryEntry->changeTime)
+        {
+            retVal = [self entryForRecord:found strings:strings];
+        }
+    }
+
+    return retVal;
+}
+
+- (NoteIndexEntry *)entryForRecord:(const NoteIndexRecord *)record strings:(const char *)strings
+{
+    NoteIndexEntry *entry = [[NoteIndexEntry alloc] init];
+    entry.localID = [[NSString alloc] initWithBytes:strings + record->localIDOffset length:record->localIDLength encoding:NSUTF8StringEncoding];
+    entry.fileName = [[NSString alloc] initWithBytes:strings + record->fileNameOffset length:record->fileNameLength encoding:NSUTF8StringEncoding];
+    if (record->flags & NoteIndexRecordFlagHasRemoteID)
+    {
+        entry.remoteID = [[NSString alloc] initWithBytes:strings + record->remoteIDOffset length:record->remoteIDLength encoding:NSUTF8StringEncoding];
+    }
+    if (record->flags & NoteIndexRecordFlagHasMD5)
+    {
+        entry.MD5 = NoteIndexStringFromDigest(record->digest);
+    }
+    entry.deleted = (record->flags & NoteIndexRecordFlagDeleted) != 0;
+    entry.dirty = (record->flags & NoteIndexRecordFlagDirty) != 0;
+    entry.inode = record->inode;
+    entry.fileSize = record->fileSize;
+    entry.modificationTime = record->modificationTime;
+    entry.changeTime = record->changeTime;
+
+    return entry;
+}
+
+- (NSError *)validateData:(NSData *)data
+{
+    NSError *retVal = nil;
+
+    if (data.length < sizeof(NoteIndexHeader))
+    {
+        retVal = NoteIndexError(NoteIndexErrorBadFormat, @"Index is truncated.");
+    }
+    else
+    {
+        const NoteIndexHeader *header = [data bytes];
+        if (header->magic != kNoteIndexMagic)
+        {
+            retVal = NoteIndexError(NoteIndexErrorBadFormat, @"Index has an unexpected signature.");
+        }
+        else if (header->version != kNoteIndexVersion)
+        {
+            retVal = NoteIndexError(NoteIndexErrorBadVersion, [NSString stringWithFormat:@"Index version %@ is not supported (expecting %@).", @(header->version), @(kNoteIndexVersion)]);
+        }
+        else
+        {
+            unsigned long long expectedLength = sizeof(NoteIndexHeader) + ((unsigned long long)header->count * (sizeof(NoteIndexRecord) + sizeof(uint32_t))) + header->stringsLength;
+            if (expectedLength != data.length)
+            {
+                retVal = NoteIndexError(NoteIndexErrorBadFormat, @"Index length does not match its header.");
+            }
+            else
+            {
+                //Bounds check every record, so lookups may trust the offsets
+                const NoteIndexRecord *records = (const NoteIndexRecord *)(header + 1);
+                const uint32_t *nameOrder = (const uint32_t *)(records + header->count);
+                unsigned long long stringsLength = header->stringsLength;
+                for (uint32_t i = 0; i < header->count && !retVal; ++i)
+                {
+                    const NoteIndexRecord *record = &records[i];
+                    BOOL valid = (unsigned long long)record->localIDOffset + record->localIDLength <= stringsLength &&
+                                 (unsigned long long)record->fileNameOffset + record->fileNameLength <= stringsLength &&
+                                 (unsigned long long)record->remoteIDOffset + record->remoteIDLength <= stringsLength &&
+                                 nameOrder[i] < header->count;
+                    if (!valid)
+                    {
+                        retVal = NoteIndexError(NoteIndexErrorBadFormat, [NSString stringWithFormat:@"Index record %@ is out of bounds.", @(i)]);
+                    }
+                }
+            }
+        }
+    }
+
+    return retVal;
+}
+
+@end
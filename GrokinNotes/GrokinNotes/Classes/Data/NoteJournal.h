@@ -0,0 +1,117 @@
+//
+//  NoteJournal.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class Note;
+
+extern NSString * const NoteJournalErrorDomain;
+
+typedef NS_ENUM(NSInteger, NoteJournalError) {
+    NoteJournalErrorBadFormat = 1,
+    NoteJournalErrorBadVersion
+};
+
+/**
+ The metadata of a single note file, as last recorded in the NoteJournal.
+ */
+@interface NoteJournalState : NSObject
+
+@property (nonatomic,copy,readonly) NSString *localID;
+@property (nonatomic,copy,readonly) NSString *remoteID;
+@property (nonatomic,copy,readonly) NSString *fileName;
+@property (nonatomic,copy,readonly) NSString *syncedMD5;
+@property (nonatomic,assign,readonly) BOOL deleted;
+@property (nonatomic,assign,readonly) BOOL dirty;
+
+@end
+
+/**
+ An append only log of note metadata changes, which stands in for writing the extended attributes of the note files on every change.
+ Each record is a checksummed snapshot of a note's metadata, keyed by local ID, so replaying the log in order always yields the same state, and a record torn by a crash is detected and discarded along with anything after it.
+ Records are buffered and written with a single fsync per batch (group commit). The log is compacted by writing the recorded metadata to the extended attributes of the note files and truncating it, which happens when it grows beyond `compactionThreshold`, or on request.
+ The recorded state of a file takes precedence over its extended attributes (see `stateForFileName:`). All methods are safe to call from any queue.
+ */
+@interface NoteJournal : NSObject
+
+/**
+ The file URL where the journal is stored.
+ */
+@property (nonatomic,readonly) NSURL *url;
+
+/**
+ The directory holding the note files the journal describes.
+ */
+@property (nonatomic,readonly) NSURL *directory;
+
+/**
+ How long records are buffered before they are committed, so that bursts of changes share a single fsync. Defaults to 0.1 seconds.
+ */
+@property (nonatomic,assign) NSTimeInterval commitInterval;
+
+/**
+ The size, in bytes, beyond which the journal is compacted after a commit. Defaults to 256KB.
+ */
+@property (nonatomic,assign) unsigned long long compactionThreshold;
+
+/**
+ Creates a journal backed by the given file.
+
+ @param url       The file URL where the journal is stored.
+ @param directory The directory holding the note files.
+
+ @return A new, empty, journal. Use `replay:` to read the existing journal from disk.
+ */
+- (instancetype)initWithURL:(NSURL *)url directory:(NSURL *)directory;
+
+/**
+ Reads the journal from disk, replacing any state held in memory. A missing journal is not considered an error. Records following a torn or corrupt record are discarded, and the journal file is truncated to the last good record.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)replay:(__autoreleasing NSError **)error;
+
+/**
+ The recorded metadata of the note file with the given name.
+
+ @param fileName The name of the note file.
+
+ @return The state, or `nil` if the journal holds nothing for the file (in which case its extended attributes are authoritative).
+ */
+- (NoteJournalState *)stateForFileName:(NSString *)fileName;
+
+/**
+ Records the current metadata of the given note.
+
+ @param note      The note, which must have a local ID.
+ @param syncedMD5 The checksum of the synchronized content of the note (see `-[Note readSyncedMD5]`).
+ */
+- (void)recordNote:(Note *)note syncedMD5:(NSString *)syncedMD5;
+
+/**
+ Records that the note with the given local ID is no longer tracked, so its state is not applied to any other file which takes its name.
+
+ @param localID The local ID of the note.
+ */
+- (void)forgetLocalID:(NSString *)localID;
+
+/**
+ Commits any buffered records now, waiting for them to reach the disk.
+ */
+- (void)flush;
+
+/**
+ Writes the recorded metadata to the extended attributes of the note files, and empties the journal.
+
+ @return The number of notes whose metadata was written.
+ */
+- (NSUInteger)compact;
+
+@end
@@ -0,0 +1,556 @@
+//
+//  NoteJournal.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "NoteJournal.h"
+#import "Note.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+NSString * const NoteJournalErrorDomain = @"NoteJournalErrorDomain";
+
+static uint32_t const kNoteJournalMagic = 0x4C4A4E47; // "GNJL"
+static uint32_t const kNoteJournalVersion = 1;
+
+static NSTimeInterval const kDefaultCommitInterval = 0.1f;
+static unsigned long long const kDefaultCompactionThreshold = 256 * 1024;
+
+typedef NS_ENUM(uint8_t, NoteJournalRecordType) {
+    //A snapshot of the metadata of a note
+    NoteJournalRecordTypeState = 1,
+    //The note is no longer tracked
+    NoteJournalRecordTypeForget
+};
+
+typedef NS_OPTIONS(uint8_t, NoteJournalRecordFlags) {
+    NoteJournalRecordFlagDeleted = 1 << 0,
+    NoteJournalRecordFlagDirty = 1 << 1,
+    NoteJournalRecordFlagHasRemoteID = 1 << 2,
+    NoteJournalRecordFlagHasSyncedMD5 = 1 << 3
+};
+
+/**
+ The file layout is: header | records, where each record is: record header | record | strings (localID, remoteID, fileName, syncedMD5)
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} NoteJournalHeader;
+
+typedef struct {
+    //The length of the record which follows, including its strings
+    uint32_t length;
+    uint32_t checksum;
+} NoteJournalRecordHeader;
+
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t localIDLength;
+    uint16_t remoteIDLength;
+    uint16_t fileNameLength;
+    uint16_t syncedMD5Length;
+    uint16_t reserved;
+} NoteJournalRecord;
+
+#pragma mark - Helpers
+
+static uint32_t NoteJournalChecksum(const uint8_t *bytes, size_t length)
+{
+    //FNV-1a
+    uint32_t retVal = 2166136261U;
+    for (size_t i = 0; i < length; ++i)
+    {
+        retVal ^= bytes[i];
+        retVal *= 16777619U;
+    }
+    return retVal;
+}
+
+static NSError *NoteJournalError(NoteJournalError code, NSString *message)
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    return [NSError errorWithDomain:NoteJournalErrorDomain code:code userInfo:userInfo];
+}
+
+static NSString *NoteJournalString(const uint8_t **bytes, uint16_t length)
+{
+    NSString *retVal = [[NSString alloc] initWithBytes:*bytes length:length encoding:NSUTF8StringEncoding];
+    *bytes += length;
+    return retVal;
+}
+
+#pragma mark - NoteJournalState
+
+@interface NoteJournalState ()
+
+@property (nonatomic,copy,readwrite) NSString *localID;
+@property (nonatomic,copy,readwrite) NSString *remoteID;
+@property (nonatomic,copy,readwrite) NSString *fileName;
+@property (nonatomic,copy,readwrite) NSString *syncedMD5;
+@property (nonatomic,assign,readwrite) BOOL deleted;
+@property (nonatomic,assign,readwrite) BOOL dirty;
+
+@end
+
+@implementation NoteJournalState
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"[%@ <%p> fileName: \"%@\", dirty: %@, deleted: %@, localID \"%@\", remoteID \"%@\", syncedMD5 \"%@\"]", [self class],
+            self, self.fileName, self.dirty ? @"YES" : @"NO", self.deleted ? @"YES" : @"NO", self.localID, self.remoteID, self.syncedMD5];
+}
+
+@end
+
+#pragma mark - NoteJournal
+
+@interface NoteJournal ()
+{
+    //The journal file, opened for appending on the first commit
+    int _fileDescriptor;
+}
+
+@property (nonatomic,strong,readwrite) NSURL *url;
+@property (nonatomic,strong,readwrite) NSURL *directory;
+//Confines all of the following
+@property (nonatomic,strong) dispatch_queue_t queue;
+@property (nonatomic,strong) NSMutableDictionary *statesByLocalID;
+@property (nonatomic,strong) NSMutableDictionary *statesByFileName;
+//Records waiting to be committed
+@property (nonatomic,strong) NSMutableData *pending;
+@property (nonatomic,assign) BOOL commitScheduled;
+//The length of the journal file
+@property (nonatomic,assign) unsigned long long length;
+
+@end
+
+@implementation NoteJournal
+
+#pragma mark - Initialization
+
+- (instancetype)initWithURL:(NSURL *)url directory:(NSURL *)directory
+{
+    if ((self = [super init]))
+    {
+        self.url = url;
+        self.directory = directory;
+        self.commitInterval = kDefaultCommitInterval;
+        self.compactionThreshold = kDefaultCompactionThreshold;
+        self.queue = dispatch_queue_create("com.levigroker.GrokinNotes.NoteJournal", DISPATCH_QUEUE_SERIAL);
+        self.statesByLocalID = [NSMutableDictionary dictionary];
+        self.statesByFileName = [NSMutableDictionary dictionary];
+        self.pending = [NSMutableData data];
+        _fileDescriptor = -1;
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+    }
+}
+
+#pragma mark - Implementation
+
+- (BOOL)replay:(__autoreleasing NSError **)error
+{
+    __block BOOL retVal = YES;
+    __block NSError *replayError = nil;
+
+    dispatch_sync(self.queue, ^{
+        //Anything recorded so far is replayed along with the rest
+        [self commit];
+        [self.statesByLocalID removeAllObjects];
+        [self.statesByFileName removeAllObjects];
+        [self closeFile];
+        self.length = 0;
+
+        if ([[NSFileManager defaultManager] fileExistsAtPath:[self.url path]])
+        {
+            __autoreleasing NSError *readError = nil;
+            NSData *data = [NSData dataWithContentsOfURL:self.url options:0 error:&readError];
+            const NoteJournalHeader *header = [data bytes];
+            if (!data)
+            {
+                replayError = readError;
+                retVal = NO;
+            }
+            else if (data.length < sizeof(NoteJournalHeader) || header->magic != kNoteJournalMagic)
+            {
+                replayError = NoteJournalError(NoteJournalErrorBadFormat, [NSString stringWithFormat:@"Note journal '%@' is not valid.", self.url]);
+                retVal = NO;
+            }
+            else if (header->version != kNoteJournalVersion)
+            {
+                replayError = NoteJournalError(NoteJournalErrorBadVersion, [NSString stringWithFormat:@"Note journal '%@' has unsupported version %@.", self.url, @(header->version)]);
+                retVal = NO;
+            }
+            else
+            {
+                NSUInteger recordCount = 0;
+                NSUInteger offset = sizeof(NoteJournalHeader);
+                while ([self applyRecordInData:data atOffset:&offset])
+                {
+                    ++recordCount;
+                }
+
+                if (offset < data.length)
+                {
+                    //A commit was interrupted; drop the partial record so later records are appended after the last good one
+                    DDLogWarn(@"Discarding %@ bytes of torn or corrupt records from note journal '%@'.", @(data.length - offset), self.url);
+                    truncate([self.url fileSystemRepresentation], (off_t)offset);
+                }
+                self.length = offset;
+
+                DDLogVerbose(@"Replayed %@ note journal records, describing %@ notes.", @(recordCount), @(self.statesByLocalID.count));
+            }
+
+            if (!retVal)
+            {
+                DDLogWarn(@"Discarding note journal '%@'. Error: %@", self.url, replayError);
+                [[NSFileManager defaultManager] removeItemAtURL:self.url error:nil];
+            }
+        }
+    });
+
+    if (error)
+    {
+        *error = replayError;
+    }
+
+    return retVal;
+}
+
+- (NoteJournalState *)stateForFileName:(NSString *)fileName
+{
+    __block NoteJournalState *retVal = nil;
+
+    if (fileName)
+    {
+        dispatch_sync(self.queue, ^{
+            retVal = [self.statesByFileName objectForKey:fileName];
+        });
+    }
+
+    return retVal;
+}
+
+- (void)recordNote:(Note *)note syncedMD5:(NSString *)syncedMD5
+{
+    NoteJournalState *state = [[NoteJournalState alloc] init];
+    state.localID = note.localID;
+    state.remoteID = note.remoteID;
+    state.fileName = [note.file lastPathComponent];
+    state.syncedMD5 = syncedMD5;
+    state.deleted = note.deleted;
+    state.dirty = note.dirty;
+
+    if (state.localID && state.fileName)
+    {
+        NSData *record = [self recordWithType:NoteJournalRecordTypeState state:state];
+        dispatch_async(self.queue, ^{
+            [self applyState:state];
+            [self appendRecord:record];
+        });
+    }
+}
+
+- (void)forgetLocalID:(NSString *)localID
+{
+    if (localID)
+    {
+        NoteJournalState *state = [[NoteJournalState alloc] init];
+        state.localID = localID;
+        NSData *record = [self recordWithType:NoteJournalRecordTypeForget state:state];
+        dispatch_async(self.queue, ^{
+            //Only worth recording if there is something to forget
+            if ([self.statesByLocalID objectForKey:localID])
+            {
+                [self forgetState:localID];
+                [self appendRecord:record];
+            }
+        });
+    }
+}
+
+- (void)flush
+{
+    dispatch_sync(self.queue, ^{
+        [self commit];
+    });
+}
+
+- (NSUInteger)compact
+{
+    __block NSUInteger retVal = 0;
+
+    dispatch_sync(self.queue, ^{
+        retVal = [self compactOnQueue];
+    });
+
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+/**
+ Encodes a record. May be called on any queue.
+ */
+- (NSData *)recordWithType:(NoteJournalRecordType)type state:(NoteJournalState *)state
+{
+    NSData *localID = [state.localID dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *remoteID = [state.remoteID dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *fileName = [state.fileName dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *syncedMD5 = [state.syncedMD5 dataUsingEncoding:NSUTF8StringEncoding];
+
+    NoteJournalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.localIDLength = (uint16_t)MIN(localID.length, UINT16_MAX);
+    record.remoteIDLength = (uint16_t)MIN(remoteID.length, UINT16_MAX);
+    record.fileNameLength = (uint16_t)MIN(fileName.length, UINT16_MAX);
+    record.syncedMD5Length = (uint16_t)MIN(syncedMD5.length, UINT16_MAX);
+    NoteJournalRecordFlags flags = 0;
+    if (state.deleted)
+    {
+        flags |= NoteJournalRecordFlagDeleted;
+    }
+    if (state.dirty)
+    {
+        flags |= NoteJournalRecordFlagDirty;
+    }
+    if (remoteID)
+    {
+        flags |= NoteJournalRecordFlagHasRemoteID;
+    }
+    if (syncedMD5)
+    {
+        flags |= NoteJournalRecordFlagHasSyncedMD5;
+    }
+    record.flags = flags;
+
+    NSMutableData *payload = [NSMutableData dataWithBytes:&record length:sizeof(record)];
+    [payload appendBytes:[localID bytes] length:record.localIDLength];
+    [payload appendBytes:[remoteID bytes] length:record.remoteIDLength];
+    [payload appendBytes:[fileName bytes] length:record.fileNameLength];
+    [payload appendBytes:[syncedMD5 bytes] length:record.syncedMD5Length];
+
+    NoteJournalRecordHeader header;
+    header.length = (uint32_t)payload.length;
+    header.checksum = NoteJournalChecksum([payload bytes], payload.length);
+
+    NSMutableData *retVal = [NSMutableData dataWithCapacity:sizeof(header) + payload.length];
+    [retVal appendBytes:&header length:sizeof(header)];
+    [retVal appendData:payload];
+
+    return retVal;
+}
+
+/**
+ Decodes and applies the record at the given offset, advancing the offset past it.
+ Returns `NO`, leaving the offset unchanged, if there is no complete and valid record at the offset.
+ */
+- (BOOL)applyRecordInData:(NSData *)data atOffset:(NSUInteger *)offset
+{
+    BOOL retVal = NO;
+
+    const uint8_t *bytes = (const uint8_t *)[data bytes] + *offset;
+    NSUInteger available = data.length - *offset;
+    if (available >= sizeof(NoteJournalRecordHeader))
+    {
+        NoteJournalRecordHeader header;
+        memcpy(&header, bytes, sizeof(header));
+        const uint8_t *payload = bytes + sizeof(header);
+        if (header.length >= sizeof(NoteJournalRecord) && header.length <= available - sizeof(header) && NoteJournalChecksum(payload, header.length) == header.checksum)
+        {
+            NoteJournalRecord record;
+            memcpy(&record, payload, sizeof(record));
+            const uint8_t *strings = payload + sizeof(record);
+            if (sizeof(record) + record.localIDLength + record.remoteIDLength + record.fileNameLength + record.syncedMD5Length == header.length)
+            {
+                NoteJournalState *state = [[NoteJournalState alloc] init];
+                state.localID = NoteJournalString(&strings, record.localIDLength);
+                NSString *remoteID = NoteJournalString(&strings, record.remoteIDLength);
+                state.fileName = NoteJournalString(&strings, record.fileNameLength);
+                NSString *syncedMD5 = NoteJournalString(&strings, record.syncedMD5Length);
+                state.remoteID = (record.flags & NoteJournalRecordFlagHasRemoteID) ? remoteID : nil;
+                state.syncedMD5 = (record.flags & NoteJournalRecordFlagHasSyncedMD5) ? syncedMD5 : nil;
+                state.deleted = (record.flags & NoteJournalRecordFlagDeleted) != 0;
+                state.dirty = (record.flags & NoteJournalRecordFlagDirty) != 0;
+
+                if (record.type == NoteJournalRecordTypeState && state.localID.length > 0 && state.fileName.length > 0)
+                {
+                    [self applyState:state];
+                    retVal = YES;
+                }
+                else if (record.type == NoteJournalRecordTypeForget && state.localID.length > 0)
+                {
+                    [self forgetState:state.localID];
+                    retVal = YES;
+                }
+            }
+        }
+
+        if (retVal)
+        {
+            *offset += sizeof(header) + header.length;
+        }
+    }
+
+    return retVal;
+}
+
+- (void)applyState:(NoteJournalState *)state
+{
+    [self forgetState:state.localID];
+    [self.statesByLocalID setObject:state forKey:state.localID];
+    [self.statesByFileName setObject:state forKey:state.fileName];
+}
+
+- (void)forgetState:(NSString *)localID
+{
+    NoteJournalState *oldState = [self.statesByLocalID objectForKey:localID];
+    if (oldState)
+    {
+        [self.statesByLocalID removeObjectForKey:localID];
+        //The file name may since have been taken by another note
+        if ([self.statesByFileName objectForKey:oldState.fileName] == oldState)
+        {
+            [self.statesByFileName removeObjectForKey:oldState.fileName];
+        }
+    }
+}
+
+- (void)appendRecord:(NSData *)record
+{
+    [self.pending appendData:record];
+
+    //Records arriving before the commit runs are written along with this one
+    if (!self.commitScheduled)
+    {
+        self.commitScheduled = YES;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.commitInterval * NSEC_PER_SEC)), self.queue, ^{
+            [self commit];
+        });
+    }
+}
+
+/**
+ Writes the pending records with a single fsync. Must be called on the journal queue.
+ */
+- (void)commit
+{
+    self.commitScheduled = NO;
+
+    if (self.pending.length > 0 && [self openFile])
+    {
+        NSUInteger written = 0;
+        const uint8_t *bytes = [self.pending bytes];
+        while (written < self.pending.length)
+        {
+            ssize_t result = write(_fileDescriptor, bytes + written, self.pending.length - written);
+            if (result < 0 && errno != EINTR)
+            {
+                break;
+            }
+            written += result > 0 ? (NSUInteger)result : 0;
+        }
+
+        if (written == self.pending.length && fsync(_fileDescriptor) == 0)
+        {
+            self.length += written;
+            [self.pending setLength:0];
+        }
+        else
+        {
+            //The state in memory is still correct, so the records will be written by the next compaction. Drop any partial write, so later records follow the last good one.
+            DDLogError(@"Unable to commit note journal '%@'. Error: %s", self.url, strerror(errno));
+            ftruncate(_fileDescriptor, (off_t)self.length);
+            [self.pending setLength:0];
+            [self closeFile];
+        }
+
+        if (self.length > self.compactionThreshold)
+        {
+            [self compactOnQueue];
+        }
+    }
+}
+
+- (NSUInteger)compactOnQueue
+{
+    NSUInteger retVal = 0;
+
+    for (NoteJournalState *state in [self.statesByLocalID allValues])
+    {
+        NSURL *file = [self.directory URLByAppendingPathComponent:state.fileName];
+        struct stat fileStat;
+        if (lstat([file fileSystemRepresentation], &fileStat) == 0)
+        {
+            [Note writeJournalState:state toFile:file];
+            ++retVal;
+        }
+    }
+
+    [self.statesByLocalID removeAllObjects];
+    [self.statesByFileName removeAllObjects];
+    [self.pending setLength:0];
+    [self closeFile];
+    [[NSFileManager defaultManager] removeItemAtURL:self.url error:nil];
+    self.length = 0;
+
+    DDLogVerbose(@"Compacted note journal, writing the metadata of %@ notes.", @(retVal));
+
+    return retVal;
+}
+
+- (BOOL)openFile
+{
+    if (_fileDescriptor < 0)
+    {
+        _fileDescriptor = open([self.url fileSystemRepresentation], O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+        struct stat fileStat;
+        if (_fileDescriptor >= 0 && fstat(_fileDescriptor, &fileStat) == 0 && fileStat.st_size == 0)
+        {
+            NoteJournalHeader header;
+            header.magic = kNoteJournalMagic;
+            header.version = kNoteJournalVersion;
+            if (write(_fileDescriptor, &header, sizeof(header)) == sizeof(header))
+            {
+                self.length = sizeof(header);
+            }
+            else
+            {
+                [self closeFile];
+            }
+        }
+        else if (_fileDescriptor < 0)
+        {
+            DDLogError(@"Unable to open note journal '%@'. Error: %s", self.url, strerror(errno));
+        }
+    }
+
+    return _fileDescriptor >= 0;
+}
+
+- (void)closeFile
+{
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+}
+
+@end
@@ -0,0 +1,100 @@
+//
+//  NoteTable.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class Note;
+
+typedef NS_OPTIONS(NSUInteger, NoteTableFlags) {
+    NoteTableFlagDirty = 1 << 0,
+    NoteTableFlagDeleted = 1 << 1
+};
+
+/**
+ The set of notes, held by column: each note occupies a row, its dirty and deleted flags are bits of per column bitmaps, and its local and remote IDs are indexed by open addressing hash tables of row numbers.
+ Scans for notes with given flags walk the bitmaps a word (64 notes) at a time, rather than visiting each note. Rows of removed notes are reused, so the columns stay dense.
+ Notes report changes to their identifiers and flags to the table holding them (see `-[Note table]`). A note may be held by only one table. Not thread safe; used on the main queue.
+ The rows, indexes and flag bitmaps are read and written only on the main queue. A note changed on another queue (i.e. as its content is saved) brings its row up to date asynchronously on the main queue, so the flags are eventually consistent with the notes: a scan may briefly miss a note just marked dirty elsewhere, which is caught by the next scan. Code off the main queue must ask the notes themselves.
+ */
+@interface NoteTable : NSObject
+
+/**
+ The number of notes in the table.
+ */
+@property (nonatomic,assign,readonly) NSUInteger count;
+
+/**
+ Adds notes to the table. Notes already in the table are ignored. A note whose local or remote ID is already indexed takes the place of the earlier note in the index. Should it leave the table, or its ID change, the earlier note is found by the ID again.
+
+ @param notes An NSArray of Note objects.
+ */
+- (void)addNotes:(NSArray *)notes;
+
+/**
+ Removes notes from the table. Notes not in the table are ignored.
+
+ @param notes An NSArray of Note objects.
+ */
+- (void)removeNotes:(NSArray *)notes;
+
+/**
+ Removes every note from the table.
+ */
+- (void)removeAllNotes;
+
+/**
+ The notes in the table, in row order.
+
+ @return An NSArray of Note objects.
+ */
+- (NSArray *)allNotes;
+
+/**
+ The note with the given local ID.
+
+ @param localID The local ID.
+
+ @return The Note, or `nil` if there is no such note.
+ */
+- (Note *)noteWithLocalID:(NSString *)localID;
+
+/**
+ The note with the given remote ID.
+
+ @param remoteID The remote ID.
+
+ @return The Note, or `nil` if there is no such note.
+ */
+- (Note *)noteWithRemoteID:(NSString *)remoteID;
+
+/**
+ The notes having any of the given flags, found by walking the flag bitmaps.
+
+ @param flags The flags.
+
+ @return An NSArray of Note objects, in row order.
+ */
+- (NSArray *)notesWithAnyFlags:(NoteTableFlags)flags;
+
+/**
+ Determines if any note has any of the given flags.
+
+ @param flags The flags.
+
+ @return `YES` if there is such a note.
+ */
+- (BOOL)containsNotesWithAnyFlags:(NoteTableFlags)flags;
+
+/**
+ Brings the row of a note up to date with its identifiers and flags. Called by the note as they change.
+
+ @param note The Note, which is ignored if it is not in the table.
+ */
+- (void)noteDidChange:(Note *)note;
+
+@end
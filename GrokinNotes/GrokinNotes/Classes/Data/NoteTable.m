@@ -0,0 +1,419 @@
+//
+//  NoteTable.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "NoteTable.h"
+#import "Note.h"
+
+static uint32_t const kNoteTableEmptySlot = UINT32_MAX;
+static uint32_t const kNoteTableRemovedSlot = UINT32_MAX - 1;
+static NSUInteger const kNoteTableMinimumIndexCapacity = 16;
+
+//A slot of a hash index
+typedef struct {
+    uint32_t hash;
+    uint32_t row;
+} NoteTableSlot;
+
+//An open addressing (linear probing) hash table of rows, keyed by a column of identifiers
+typedef struct {
+    NoteTableSlot *slots;
+    //A power of two
+    NSUInteger capacity;
+    NSUInteger count;
+    //Slots which are not empty, including removed ones, which still lengthen probes
+    NSUInteger used;
+    //Rows whose key is shared with a later row, which holds the slot
+    NSUInteger shadowed;
+} NoteTableIndex;
+
+#pragma mark - Helpers
+
+static uint32_t NoteTableHash(NSString *key)
+{
+    //Mixed (the MurmurHash3 finalizer), so the low bits used to pick a slot depend on every bit of the string hash
+    uint64_t value = (uint64_t)[key hash];
+    uint32_t retVal = (uint32_t)(value ^ (value >> 32));
+    retVal ^= retVal >> 16;
+    retVal *= 0x85EBCA6BU;
+    retVal ^= retVal >> 13;
+    retVal *= 0xC2B2AE35U;
+    retVal ^= retVal >> 16;
+    return retVal;
+}
+
+static inline void NoteTableSetBit(uint64_t *words, NSUInteger row, BOOL value)
+{
+    if (value)
+    {
+        words[row >> 6] |= 1ULL << (row & 63);
+    }
+    else
+    {
+        words[row >> 6] &= ~(1ULL << (row & 63));
+    }
+}
+
+@interface NoteTable ()
+{
+    NoteTableIndex _localIDIndex;
+    NoteTableIndex _remoteIDIndex;
+}
+
+@property (nonatomic,assign,readwrite) NSUInteger count;
+//Note objects by row, with NSNull for unused rows
+@property (nonatomic,strong) NSMutableArray *handles;
+//The local and remote IDs under which each row is indexed, with NSNull for none
+@property (nonatomic,strong) NSMutableArray *localIDs;
+@property (nonatomic,strong) NSMutableArray *remoteIDs;
+//Bitmaps of rows in use, and of rows whose notes are dirty or deleted, in 64 bit words
+@property (nonatomic,strong) NSMutableData *liveRows;
+@property (nonatomic,strong) NSMutableData *dirtyRows;
+@property (nonatomic,strong) NSMutableData *deletedRows;
+//Rows of removed notes, which are used before new ones are added
+@property (nonatomic,strong) NSMutableIndexSet *unusedRows;
+
+@end
+
+@implementation NoteTable
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    if ((self = [super init]))
+    {
+        self.handles = [NSMutableArray array];
+        self.localIDs = [NSMutableArray array];
+        self.remoteIDs = [NSMutableArray array];
+        self.liveRows = [NSMutableData data];
+        self.dirtyRows = [NSMutableData data];
+        self.deletedRows = [NSMutableData data];
+        self.unusedRows = [NSMutableIndexSet indexSet];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_localIDIndex.slots);
+    free(_remoteIDIndex.slots);
+}
+
+#pragma mark - Implementation
+
+- (void)addNotes:(NSArray *)notes
+{
+    for (Note *note in notes)
+    {
+        if (note.table != self)
+        {
+            NSUInteger row = [self.unusedRows firstIndex];
+            if (row == NSNotFound)
+            {
+                row = self.handles.count;
+                [self.handles addObject:note];
+                [self.localIDs addObject:[NSNull null]];
+                [self.remoteIDs addObject:[NSNull null]];
+                if (row >> 6 >= self.liveRows.length / sizeof(uint64_t))
+                {
+                    //Zero filled
+                    NSUInteger length = self.liveRows.length + sizeof(uint64_t);
+                    [self.liveRows setLength:length];
+                    [self.dirtyRows setLength:length];
+                    [self.deletedRows setLength:length];
+                }
+            }
+            else
+            {
+                [self.unusedRows removeIndex:row];
+                [self.handles replaceObjectAtIndex:row withObject:note];
+            }
+
+            note.table = self;
+            note.tableRow = row;
+            NoteTableSetBit(self.liveRows.mutableBytes, row, YES);
+            self.count += 1;
+            [self noteDidChange:note];
+        }
+    }
+}
+
+- (void)removeNotes:(NSArray *)notes
+{
+    for (Note *note in notes)
+    {
+        if (note.table == self)
+        {
+            uint32_t row = (uint32_t)note.tableRow;
+            [self setKey:nil ofRow:row inIndex:&_localIDIndex column:self.localIDs];
+            [self setKey:nil ofRow:row inIndex:&_remoteIDIndex column:self.remoteIDs];
+            NoteTableSetBit(self.liveRows.mutableBytes, row, NO);
+            NoteTableSetBit(self.dirtyRows.mutableBytes, row, NO);
+            NoteTableSetBit(self.deletedRows.mutableBytes, row, NO);
+            [self.handles replaceObjectAtIndex:row withObject:[NSNull null]];
+            [self.unusedRows addIndex:row];
+            self.count -= 1;
+
+            note.table = nil;
+            note.tableRow = NSNotFound;
+        }
+    }
+}
+
+- (void)removeAllNotes
+{
+    for (id handle in self.handles)
+    {
+        if (handle != [NSNull null])
+        {
+            Note *note = handle;
+            note.table = nil;
+            note.tableRow = NSNotFound;
+        }
+    }
+    [self.handles removeAllObjects];
+    [self.localIDs removeAllObjects];
+    [self.remoteIDs removeAllObjects];
+    [self.liveRows setLength:0];
+    [self.dirtyRows setLength:0];
+    [self.deletedRows setLength:0];
+    [self.unusedRows removeAllIndexes];
+    self.count = 0;
+
+    free(_localIDIndex.slots);
+    free(_remoteIDIndex.slots);
+    memset(&_localIDIndex, 0, sizeof(NoteTableIndex));
+    memset(&_remoteIDIndex, 0, sizeof(NoteTableIndex));
+}
+
+- (NSArray *)allNotes
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:self.count];
+    for (id handle in self.handles)
+    {
+        if (handle != [NSNull null])
+        {
+            [retVal addObject:handle];
+        }
+    }
+    return retVal;
+}
+
+- (Note *)noteWithLocalID:(NSString *)localID
+{
+    NSUInteger slot = [self slotOfKey:localID inIndex:&_localIDIndex column:self.localIDs];
+    return slot != NSNotFound ? [self.handles objectAtIndex:_localIDIndex.slots[slot].row] : nil;
+}
+
+- (Note *)noteWithRemoteID:(NSString *)remoteID
+{
+    NSUInteger slot = [self slotOfKey:remoteID inIndex:&_remoteIDIndex column:self.remoteIDs];
+    return slot != NSNotFound ? [self.handles objectAtIndex:_remoteIDIndex.slots[slot].row] : nil;
+}
+
+- (NSArray *)notesWithAnyFlags:(NoteTableFlags)flags
+{
+    NSMutableArray *retVal = [NSMutableArray array];
+    const uint64_t *dirty = self.dirtyRows.bytes;
+    const uint64_t *deleted = self.deletedRows.bytes;
+    uint64_t dirtyMask = (flags & NoteTableFlagDirty) ? ~0ULL : 0;
+    uint64_t deletedMask = (flags & NoteTableFlagDeleted) ? ~0ULL : 0;
+    NSUInteger wordCount = self.dirtyRows.length / sizeof(uint64_t);
+    for (NSUInteger i = 0; i < wordCount; ++i)
+    {
+        uint64_t word = (dirty[i] & dirtyMask) | (deleted[i] & deletedMask);
+        while (word)
+        {
+            NSUInteger row = (i << 6) | (NSUInteger)__builtin_ctzll(word);
+            [retVal addObject:[self.handles objectAtIndex:row]];
+            word &= word - 1;
+        }
+    }
+    return retVal;
+}
+
+- (BOOL)containsNotesWithAnyFlags:(NoteTableFlags)flags
+{
+    const uint64_t *dirty = self.dirtyRows.bytes;
+    const uint64_t *deleted = self.deletedRows.bytes;
+    uint64_t dirtyMask = (flags & NoteTableFlagDirty) ? ~0ULL : 0;
+    uint64_t deletedMask = (flags & NoteTableFlagDeleted) ? ~0ULL : 0;
+    NSUInteger wordCount = self.dirtyRows.length / sizeof(uint64_t);
+    uint64_t any = 0;
+    for (NSUInteger i = 0; i < wordCount; ++i)
+    {
+        any |= (dirty[i] & dirtyMask) | (deleted[i] & deletedMask);
+    }
+    return any != 0;
+}
+
+- (void)noteDidChange:(Note *)note
+{
+    if (note.table == self)
+    {
+        uint32_t row = (uint32_t)note.tableRow;
+        NoteTableSetBit(self.dirtyRows.mutableBytes, row, note.dirty);
+        NoteTableSetBit(self.deletedRows.mutableBytes, row, note.deleted);
+        [self setKey:note.localID ofRow:row inIndex:&_localIDIndex column:self.localIDs];
+        [self setKey:note.remoteID ofRow:row inIndex:&_remoteIDIndex column:self.remoteIDs];
+    }
+}
+
+#pragma mark - Helpers
+
+/**
+ Finds the slot of an index holding the given key.
+ @return The slot, or NSNotFound.
+ */
+- (NSUInteger)slotOfKey:(NSString *)key inIndex:(NoteTableIndex *)index column:(NSArray *)column
+{
+    NSUInteger retVal = NSNotFound;
+    if (key && index->count > 0)
+    {
+        uint32_t hash = NoteTableHash(key);
+        NSUInteger mask = index->capacity - 1;
+        NSUInteger slot = hash & mask;
+        while (retVal == NSNotFound && index->slots[slot].row != kNoteTableEmptySlot)
+        {
+            NoteTableSlot *candidate = &index->slots[slot];
+            if (candidate->row != kNoteTableRemovedSlot && candidate->hash == hash && [key isEqualToString:[column objectAtIndex:candidate->row]])
+            {
+                retVal = slot;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    return retVal;
+}
+
+/**
+ Changes the key under which a row is indexed, recording it in the column.
+ @param key The key, or nil for none.
+ */
+- (void)setKey:(NSString *)key ofRow:(uint32_t)row inIndex:(NoteTableIndex *)index column:(NSMutableArray *)column
+{
+    id oldKey = [column objectAtIndex:row];
+    if (!(oldKey == key || (key && [key isEqual:oldKey])))
+    {
+        if (oldKey != [NSNull null])
+        {
+            NSUInteger slot = [self slotOfKey:oldKey inIndex:index column:column];
+            if (slot != NSNotFound && index->slots[slot].row == row)
+            {
+                //An earlier row with the same key takes the slot back, if there is one
+                NSUInteger other = index->shadowed > 0 ? [self rowOfKey:oldKey inColumn:column otherThanRow:row] : NSNotFound;
+                if (other != NSNotFound)
+                {
+                    index->slots[slot].row = (uint32_t)other;
+                    index->shadowed -= 1;
+                }
+                else
+                {
+                    index->slots[slot].row = kNoteTableRemovedSlot;
+                    index->count -= 1;
+                }
+            }
+            else if (slot != NSNotFound)
+            {
+                //The key had been taken by a later row
+                index->shadowed -= 1;
+            }
+        }
+        [column replaceObjectAtIndex:row withObject:key ?: [NSNull null]];
+
+        if (key)
+        {
+            NSUInteger slot = [self slotOfKey:key inIndex:index column:column];
+            if (slot != NSNotFound)
+            {
+                //The later row takes the key, and the earlier row is found again should the later one give it up
+                index->slots[slot].row = row;
+                index->shadowed += 1;
+            }
+            else
+            {
+                if ((index->used + 1) * 2 > index->capacity)
+                {
+                    [self rebuildIndex:index];
+                }
+                uint32_t hash = NoteTableHash(key);
+                NSUInteger mask = index->capacity - 1;
+                slot = hash & mask;
+                while (index->slots[slot].row != kNoteTableEmptySlot && index->slots[slot].row != kNoteTableRemovedSlot)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                if (index->slots[slot].row == kNoteTableEmptySlot)
+                {
+                    index->used += 1;
+                }
+                index->slots[slot].hash = hash;
+                index->slots[slot].row = row;
+                index->count += 1;
+            }
+        }
+    }
+}
+
+/**
+ Finds a row of the column holding the given key, other than the given row.
+ @return The row, or NSNotFound.
+ */
+- (NSUInteger)rowOfKey:(NSString *)key inColumn:(NSArray *)column otherThanRow:(NSUInteger)row
+{
+    NSUInteger retVal = NSNotFound;
+    NSUInteger count = column.count;
+    for (NSUInteger i = 0; i < count && retVal == NSNotFound; ++i)
+    {
+        if (i != row && [key isEqual:[column objectAtIndex:i]])
+        {
+            retVal = i;
+        }
+    }
+    return retVal;
+}
+
+/**
+ Moves the keys of an index into new slots, dropping removed slots, with room for as many keys again.
+ */
+- (void)rebuildIndex:(NoteTableIndex *)index
+{
+    NSUInteger capacity = kNoteTableMinimumIndexCapacity;
+    while (capacity < (index->count + 1) * 4)
+    {
+        capacity *= 2;
+    }
+
+    NoteTableSlot *slots = malloc(capacity * sizeof(NoteTableSlot));
+    for (NSUInteger i = 0; i < capacity; ++i)
+    {
+        slots[i].row = kNoteTableEmptySlot;
+    }
+    NSUInteger mask = capacity - 1;
+    for (NSUInteger i = 0; i < index->capacity; ++i)
+    {
+        NoteTableSlot old = index->slots[i];
+        if (old.row != kNoteTableEmptySlot && old.row != kNoteTableRemovedSlot)
+        {
+            NSUInteger slot = old.hash & mask;
+            while (slots[slot].row != kNoteTableEmptySlot)
+            {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = old;
+        }
+    }
+
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    index->used = index->count;
+}
+
+@end
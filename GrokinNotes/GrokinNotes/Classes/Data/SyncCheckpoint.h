@@ -0,0 +1,121 @@
+//
+//  SyncCheckpoint.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class GTLDriveChange;
+@class FolderTree;
+
+extern NSString * const SyncCheckpointErrorDomain;
+
+typedef NS_ENUM(NSInteger, SyncCheckpointError) {
+    SyncCheckpointErrorBadFormat = 1,
+    SyncCheckpointErrorBadVersion,
+    SyncCheckpointErrorBadChecksum
+};
+
+/**
+ How far synchronization with the remote has progressed: the change ID through which remote changes have been processed, the changes which failed to apply, which are tried again with exponential backoff rather than holding back the change ID, and the remote folder hierarchy learned from the changes.
+ Stored in a checksummed file which is replaced atomically, so a crash leaves either the previous checkpoint or the new one. A checkpoint which can not be read is discarded, which costs a full refresh from the remote.
+ Not thread safe.
+ */
+@interface SyncCheckpoint : NSObject
+
+/**
+ The file URL where the checkpoint is stored.
+ */
+@property (nonatomic,readonly) NSURL *url;
+
+/**
+ An NSNumber representing a long long identifying the last remote change processed, or `nil` if no changes have been.
+ */
+@property (nonatomic,strong) NSNumber *changeID;
+
+/**
+ The remote folders, and the folders holding remote files, as of `changeID`. Folders which have not changed since the tree began to be kept are missing until retrieved (see `-[FolderTree missingFolderIDs]`).
+ */
+@property (nonatomic,strong,readonly) FolderTree *folderTree;
+
+/**
+ The number of changes waiting to be tried again.
+ */
+@property (nonatomic,assign,readonly) NSUInteger failedChangeCount;
+
+/**
+ The most changes which may wait to be tried again. Defaults to 64.
+ */
+@property (nonatomic,assign) NSUInteger maximumFailedChangeCount;
+
+/**
+ How long after its first failure a change is tried again. The interval doubles with each further failure. Defaults to 30 seconds.
+ */
+@property (nonatomic,assign) NSTimeInterval initialRetryInterval;
+
+/**
+ The longest interval between attempts to apply a change. Defaults to one hour.
+ */
+@property (nonatomic,assign) NSTimeInterval maximumRetryInterval;
+
+/**
+ Creates a checkpoint backed by the given file.
+
+ @param url The file URL where the checkpoint is stored.
+
+ @return A new, empty, checkpoint. Use `load:` to read the stored checkpoint.
+ */
+- (instancetype)initWithURL:(NSURL *)url;
+
+/**
+ Reads the checkpoint from disk, replacing any state held in memory. A missing checkpoint is not considered an error. If the checkpoint can not be read the state is left empty.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)load:(__autoreleasing NSError **)error;
+
+/**
+ Writes the checkpoint to disk, replacing the stored checkpoint atomically.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)save:(__autoreleasing NSError **)error;
+
+/**
+ Determines if the given failed changes can be recorded without exceeding `maximumFailedChangeCount`. Changes to files which already have a failed change take its place.
+
+ @param changes An NSArray of GTLDriveChange objects.
+
+ @return `YES` if there is room for the changes.
+ */
+- (BOOL)hasRoomForFailedChanges:(NSArray *)changes;
+
+/**
+ Records that a change was applied, so any earlier failed change to the same file is no longer tried again.
+
+ @param change The GTLDriveChange.
+ */
+- (void)recordAppliedChange:(GTLDriveChange *)change;
+
+/**
+ Records that a change failed to apply, replacing any earlier failed change to the same file. The change is tried again once the retry interval has passed, which grows with each failure of the same change.
+
+ @param change The GTLDriveChange.
+ */
+- (void)recordFailedChange:(GTLDriveChange *)change;
+
+/**
+ The failed changes which are due to be tried again.
+
+ @return An NSArray of GTLDriveChange objects, in the order they were first recorded.
+ */
+- (NSArray *)dueFailedChanges;
+
+@end
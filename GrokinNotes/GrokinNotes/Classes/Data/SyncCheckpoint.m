@@ -0,0 +1,318 @@
+//
+//  SyncCheckpoint.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "SyncCheckpoint.h"
+#import "GTLDrive.h"
+#import "FolderTree.h"
+#include <math.h>
+
+NSString * const SyncCheckpointErrorDomain = @"SyncCheckpointErrorDomain";
+
+static uint32_t const kSyncCheckpointMagic = 0x50435347; // "GSCP"
+static uint32_t const kSyncCheckpointVersion = 2;
+//Before the folder tree was kept. The folders are learned as notes refer to them (see -[FolderTree missingFolderIDs]), so the change ID is kept.
+static uint32_t const kSyncCheckpointVersionWithoutFolders = 1;
+
+static NSUInteger const kDefaultMaximumFailedChangeCount = 64;
+static NSTimeInterval const kDefaultInitialRetryInterval = 30.0f;
+static NSTimeInterval const kDefaultMaximumRetryInterval = 60.0f * 60.0f;
+
+static NSString * const kSyncCheckpointKeyChangeID = @"changeID";
+static NSString * const kSyncCheckpointKeyFailedChanges = @"failedChanges";
+static NSString * const kSyncCheckpointKeyChange = @"change";
+static NSString * const kSyncCheckpointKeyAttempts = @"attempts";
+static NSString * const kSyncCheckpointKeyNextAttemptDate = @"nextAttemptDate";
+static NSString * const kSyncCheckpointKeyFolders = @"folders";
+
+/**
+ The file layout is: header | payload, where the payload is a binary property list of the change ID, the failed changes (each held as the JSON of the change), and the folder tree
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t length;
+    //Of the payload
+    uint32_t checksum;
+} SyncCheckpointHeader;
+
+#pragma mark - Helpers
+
+static uint32_t SyncCheckpointChecksum(const uint8_t *bytes, size_t length)
+{
+    //FNV-1a
+    uint32_t retVal = 2166136261U;
+    for (size_t i = 0; i < length; ++i)
+    {
+        retVal ^= bytes[i];
+        retVal *= 16777619U;
+    }
+    return retVal;
+}
+
+static NSError *SyncCheckpointMakeError(SyncCheckpointError code, NSString *message)
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    return [NSError errorWithDomain:SyncCheckpointErrorDomain code:code userInfo:userInfo];
+}
+
+#pragma mark - SyncCheckpointFailedChange
+
+@interface SyncCheckpointFailedChange : NSObject
+
+@property (nonatomic,strong) GTLDriveChange *change;
+@property (nonatomic,assign) NSUInteger attempts;
+@property (nonatomic,strong) NSDate *nextAttemptDate;
+
+@end
+
+@implementation SyncCheckpointFailedChange
+
+@end
+
+#pragma mark - SyncCheckpoint
+
+@interface SyncCheckpoint ()
+
+@property (nonatomic,strong,readwrite) NSURL *url;
+@property (nonatomic,strong,readwrite) FolderTree *folderTree;
+//SyncCheckpointFailedChange objects, in the order they were first recorded, with at most one for each file
+@property (nonatomic,strong) NSMutableArray *failedChanges;
+
+@end
+
+@implementation SyncCheckpoint
+
+#pragma mark - Initialization
+
+- (instancetype)initWithURL:(NSURL *)url
+{
+    if ((self = [super init]))
+    {
+        self.url = url;
+        self.failedChanges = [NSMutableArray array];
+        self.folderTree = [[FolderTree alloc] init];
+        self.maximumFailedChangeCount = kDefaultMaximumFailedChangeCount;
+        self.initialRetryInterval = kDefaultInitialRetryInterval;
+        self.maximumRetryInterval = kDefaultMaximumRetryInterval;
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (BOOL)load:(__autoreleasing NSError **)error
+{
+    BOOL retVal = YES;
+
+    self.changeID = nil;
+    [self.failedChanges removeAllObjects];
+    self.folderTree = [[FolderTree alloc] init];
+
+    __autoreleasing NSError *readError = nil;
+    NSData *data = [NSData dataWithContentsOfURL:self.url options:0 error:&readError];
+    if (data)
+    {
+        const SyncCheckpointHeader *header = data.bytes;
+        const uint8_t *payload = (const uint8_t *)data.bytes + sizeof(SyncCheckpointHeader);
+        NSError *formatError = nil;
+        if (data.length < sizeof(SyncCheckpointHeader) || header->magic != kSyncCheckpointMagic)
+        {
+            formatError = SyncCheckpointMakeError(SyncCheckpointErrorBadFormat, NSLocalizedString(@"The sync checkpoint is not in the expected format.", nil));
+        }
+        else if (header->version != kSyncCheckpointVersion && header->version != kSyncCheckpointVersionWithoutFolders)
+        {
+            formatError = SyncCheckpointMakeError(SyncCheckpointErrorBadVersion, [NSString stringWithFormat:@"%@ (%@)", NSLocalizedString(@"The sync checkpoint has an unsupported version.", nil), @(header->version)]);
+        }
+        else if (header->length != data.length - sizeof(SyncCheckpointHeader) || SyncCheckpointChecksum(payload, header->length) != header->checksum)
+        {
+            formatError = SyncCheckpointMakeError(SyncCheckpointErrorBadChecksum, NSLocalizedString(@"The sync checkpoint is damaged.", nil));
+        }
+        else
+        {
+            NSDictionary *state = [NSPropertyListSerialization propertyListWithData:[NSData dataWithBytesNoCopy:(void *)payload length:header->length freeWhenDone:NO] options:NSPropertyListImmutable format:NULL error:nil];
+            if ([state isKindOfClass:[NSDictionary class]])
+            {
+                NSNumber *changeID = [state objectForKey:kSyncCheckpointKeyChangeID];
+                self.changeID = [changeID isKindOfClass:[NSNumber class]] ? changeID : nil;
+                self.folderTree = [[FolderTree alloc] initWithPropertyList:[state objectForKey:kSyncCheckpointKeyFolders]];
+                for (NSDictionary *record in [state objectForKey:kSyncCheckpointKeyFailedChanges])
+                {
+                    NSData *JSONData = [record objectForKey:kSyncCheckpointKeyChange];
+                    NSMutableDictionary *JSON = JSONData ? [NSJSONSerialization JSONObjectWithData:JSONData options:NSJSONReadingMutableContainers error:nil] : nil;
+                    if ([JSON isKindOfClass:[NSMutableDictionary class]])
+                    {
+                        SyncCheckpointFailedChange *failedChange = [[SyncCheckpointFailedChange alloc] init];
+                        failedChange.change = [GTLDriveChange objectWithJSON:JSON];
+                        failedChange.attempts = [[record objectForKey:kSyncCheckpointKeyAttempts] unsignedIntegerValue];
+                        failedChange.nextAttemptDate = [record objectForKey:kSyncCheckpointKeyNextAttemptDate] ?: [NSDate date];
+                        if (failedChange.change.fileId)
+                        {
+                            [self.failedChanges addObject:failedChange];
+                        }
+                    }
+                }
+            }
+            else
+            {
+                formatError = SyncCheckpointMakeError(SyncCheckpointErrorBadFormat, NSLocalizedString(@"The sync checkpoint is not in the expected format.", nil));
+            }
+        }
+
+        if (formatError)
+        {
+            self.changeID = nil;
+            [self.failedChanges removeAllObjects];
+            self.folderTree = [[FolderTree alloc] init];
+            if (error)
+            {
+                *error = formatError;
+            }
+            retVal = NO;
+        }
+    }
+    else if (!([readError.domain isEqualToString:NSCocoaErrorDomain] && readError.code == NSFileReadNoSuchFileError))
+    {
+        if (error)
+        {
+            *error = readError;
+        }
+        retVal = NO;
+    }
+
+    return retVal;
+}
+
+- (BOOL)save:(__autoreleasing NSError **)error
+{
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:self.failedChanges.count];
+    for (SyncCheckpointFailedChange *failedChange in self.failedChanges)
+    {
+        NSData *JSONData = [NSJSONSerialization dataWithJSONObject:failedChange.change.JSON ?: @{} options:0 error:nil];
+        if (JSONData)
+        {
+            NSMutableDictionary *record = [NSMutableDictionary dictionaryWithCapacity:3];
+            [record setObject:JSONData forKey:kSyncCheckpointKeyChange];
+            [record setObject:@(failedChange.attempts) forKey:kSyncCheckpointKeyAttempts];
+            [record setObject:failedChange.nextAttemptDate forKey:kSyncCheckpointKeyNextAttemptDate];
+            [records addObject:record];
+        }
+    }
+    NSMutableDictionary *state = [NSMutableDictionary dictionaryWithCapacity:3];
+    [state setValue:self.changeID forKey:kSyncCheckpointKeyChangeID];
+    [state setObject:records forKey:kSyncCheckpointKeyFailedChanges];
+    [state setObject:[self.folderTree propertyList] forKey:kSyncCheckpointKeyFolders];
+
+    BOOL retVal = NO;
+    NSData *payload = [NSPropertyListSerialization dataWithPropertyList:state format:NSPropertyListBinaryFormat_v1_0 options:0 error:error];
+    if (payload)
+    {
+        SyncCheckpointHeader header;
+        header.magic = kSyncCheckpointMagic;
+        header.version = kSyncCheckpointVersion;
+        header.length = (uint32_t)payload.length;
+        header.checksum = SyncCheckpointChecksum(payload.bytes, payload.length);
+
+        NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + payload.length];
+        [data appendBytes:&header length:sizeof(header)];
+        [data appendData:payload];
+        //Written to a temporary file which then replaces the checkpoint
+        retVal = [data writeToURL:self.url options:NSDataWritingAtomic error:error];
+    }
+
+    return retVal;
+}
+
+- (NSUInteger)failedChangeCount
+{
+    return self.failedChanges.count;
+}
+
+- (BOOL)hasRoomForFailedChanges:(NSArray *)changes
+{
+    NSMutableSet *fileIDs = [NSMutableSet setWithCapacity:self.failedChanges.count + changes.count];
+    for (SyncCheckpointFailedChange *failedChange in self.failedChanges)
+    {
+        [fileIDs addObject:failedChange.change.fileId];
+    }
+    for (GTLDriveChange *change in changes)
+    {
+        if (change.fileId)
+        {
+            [fileIDs addObject:change.fileId];
+        }
+    }
+    return fileIDs.count <= self.maximumFailedChangeCount;
+}
+
+- (void)recordAppliedChange:(GTLDriveChange *)change
+{
+    NSUInteger index = [self indexOfFailedChangeForFileID:change.fileId];
+    if (index != NSNotFound)
+    {
+        [self.failedChanges removeObjectAtIndex:index];
+    }
+}
+
+- (void)recordFailedChange:(GTLDriveChange *)change
+{
+    if (change.fileId)
+    {
+        NSUInteger index = [self indexOfFailedChangeForFileID:change.fileId];
+        SyncCheckpointFailedChange *failedChange = index != NSNotFound ? [self.failedChanges objectAtIndex:index] : nil;
+        if (!failedChange)
+        {
+            failedChange = [[SyncCheckpointFailedChange alloc] init];
+            [self.failedChanges addObject:failedChange];
+        }
+
+        //Another failure of the same change waits longer, while a later change to the file starts over
+        if (failedChange.change && [failedChange.change.identifier isEqual:change.identifier])
+        {
+            failedChange.attempts += 1;
+        }
+        else
+        {
+            failedChange.change = change;
+            failedChange.attempts = 1;
+        }
+        NSTimeInterval interval = self.initialRetryInterval * pow(2.0, (double)MIN(failedChange.attempts - 1, (NSUInteger)32));
+        failedChange.nextAttemptDate = [NSDate dateWithTimeIntervalSinceNow:MIN(interval, self.maximumRetryInterval)];
+    }
+}
+
+- (NSArray *)dueFailedChanges
+{
+    NSMutableArray *retVal = [NSMutableArray array];
+    NSDate *now = [NSDate date];
+    for (SyncCheckpointFailedChange *failedChange in self.failedChanges)
+    {
+        if ([failedChange.nextAttemptDate compare:now] != NSOrderedDescending)
+        {
+            [retVal addObject:failedChange.change];
+        }
+    }
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+- (NSUInteger)indexOfFailedChangeForFileID:(NSString *)fileID
+{
+    NSUInteger retVal = NSNotFound;
+    if (fileID)
+    {
+        retVal = [self.failedChanges indexOfObjectPassingTest:^BOOL(SyncCheckpointFailedChange *failedChange, NSUInteger index, BOOL *stop) {
+            return [failedChange.change.fileId isEqualToString:fileID];
+        }];
+    }
+    return retVal;
+}
+
+@end
@@ -0,0 +1,143 @@
+//
+//  FakeDriveServer.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#if DEBUG
+
+#import "GTMHTTPFetcher.h"
+
+/**
+ A stand in for the Google Drive v2 service, served over HTTP on the loopback interface, for measuring synchronization without a Google account. DEBUG builds only.
+ It speaks the JSON-RPC protocol the Drive client library uses (see `-[GoogleDriveManager startupWithServiceURL:authorizer:]`), including batches and resumable uploads, and implements the calls the app makes: `drive.files.insert`, `update`, `patch`, `get`, `list`, `trash` and `untrash`, `drive.changes.list` with paging, and media download.
+ Files are kept in memory. Like Drive, the change feed holds only the most recent change to each file, and a `fields` parameter limits a response to the fields it selects (a partial response).
+ Latency, bandwidth and errors can be injected. Errors are drawn from a seeded generator, so a run can be repeated exactly.
+ */
+@interface FakeDriveServer : NSObject
+
+/**
+ The URL of the root of the server, or `nil` if it is not started.
+ */
+@property (nonatomic,readonly) NSURL *baseURL;
+
+/**
+ An authorizer which authorizes every request, for use with the server.
+ */
+@property (nonatomic,readonly) id<GTMFetcherAuthorizationProtocol> authorizer;
+
+/**
+ The delay added to every response. Defaults to 0.
+ */
+@property (atomic,assign) NSTimeInterval latency;
+
+/**
+ The simulated bandwidth, in bytes per second, by which the time to transfer each request and response is added to the delay. If `0` (the default) bandwidth is unlimited.
+ */
+@property (atomic,assign) NSUInteger bytesPerSecond;
+
+/**
+ The probability, from 0 to 1, of a request failing (for batches, of each query in the batch failing). Defaults to 0.
+ */
+@property (atomic,assign) double errorRate;
+
+/**
+ The HTTP status, and error code, of injected errors. Defaults to 503.
+ */
+@property (atomic,assign) NSInteger injectedErrorCode;
+
+/**
+ The number of bytes received in requests, and sent in responses.
+ */
+@property (atomic,assign,readonly) unsigned long long bytesReceived;
+@property (atomic,assign,readonly) unsigned long long bytesSent;
+
+/**
+ Creates a server.
+
+ @param seed The seed for the generator deciding which requests fail.
+
+ @return A new server, which is not yet started.
+ */
+- (instancetype)initWithSeed:(uint32_t)seed;
+
+/**
+ Starts the server on an unused port.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)start:(__autoreleasing NSError **)error;
+
+/**
+ Stops the server.
+ */
+- (void)stop;
+
+/**
+ Creates a plain text file directly, as another client would.
+
+ @param title   The title of the file.
+ @param content The content of the file.
+
+ @return The ID of the new file.
+ */
+- (NSString *)insertFileWithTitle:(NSString *)title content:(NSData *)content;
+
+/**
+ Creates a file of any type directly, as another client would.
+
+ @param title    The title of the file.
+ @param mimeType The MIME type of the file.
+ @param content  The content of the file.
+
+ @return The ID of the new file.
+ */
+- (NSString *)insertFileWithTitle:(NSString *)title mimeType:(NSString *)mimeType content:(NSData *)content;
+
+/**
+ Replaces the content of a file directly, as another client would.
+
+ @param fileID  The ID of the file.
+ @param content The new content.
+
+ @return `YES` if there is such a file.
+ */
+- (BOOL)updateFileWithID:(NSString *)fileID content:(NSData *)content;
+
+/**
+ Moves a file to the trash directly, as another client would.
+
+ @param fileID The ID of the file.
+
+ @return `YES` if there is such a file.
+ */
+- (BOOL)trashFileWithID:(NSString *)fileID;
+
+/**
+ The IDs of the files which are not in the trash.
+
+ @return An NSArray of NSString objects, in the order the files were created.
+ */
+- (NSArray *)fileIDs;
+
+/**
+ The time taken to answer each request since the statistics were last reset, including injected delays.
+
+ @return An NSDictionary mapping the name of each kind of request (the JSON-RPC method, or `batch`, `upload` or `download`) to an NSArray of NSNumber durations in seconds.
+ */
+- (NSDictionary *)requestDurations;
+
+/**
+ Forgets the recorded request durations and transfer counts.
+ */
+- (void)resetStatistics;
+
+@end
+
+#endif
@@ -0,0 +1,824 @@
+//
+//  FakeDriveServer.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "FakeDriveServer.h"
+
+#if DEBUG
+
+#import <objc/message.h>
+#import "GRKHTTPServer.h"
+#import "GRKDigestCache.h"
+
+static NSString * const kFakeDriveMIMETypeFolder = @"application/vnd.google-apps.folder";
+static NSString * const kFakeDriveMIMETypeDefault = @"application/octet-stream";
+static NSString * const kFakeDriveContentTypeJSON = @"application/json; charset=UTF-8";
+
+static NSString * const kFakeDriveRequestKindBatch = @"batch";
+static NSString * const kFakeDriveRequestKindUpload = @"upload";
+static NSString * const kFakeDriveRequestKindDownload = @"download";
+static NSString * const kFakeDriveRequestKindOther = @"other";
+
+static NSString * const kFakeDriveUploadSessionPath = @"/upload/session/";
+static NSString * const kFakeDriveDownloadPath = @"/download/";
+
+static NSUInteger const kFakeDriveDefaultChangesPageSize = 100;
+static NSUInteger const kFakeDriveMaximumChangesPageSize = 1000;
+
+#pragma mark - Helpers
+
+static NSString *FakeDriveString(long long value)
+{
+    return [NSString stringWithFormat:@"%lld", value];
+}
+
+//A JSON-RPC error object, as Drive reports them
+static NSDictionary *FakeDriveError(NSInteger code, NSString *reason, NSString *message)
+{
+    return @{@"code": @(code), @"message": message, @"data": @[@{@"domain": @"global", @"reason": reason, @"message": message}]};
+}
+
+/**
+ Parses a partial response field selection (e.g. `items(id,file(title,labels/trashed)),nextPageToken`) from the given position, up to the end or an unmatched closing parenthesis.
+ @return A tree of NSDictionary objects keyed by field name, in which an empty dictionary selects the whole value.
+ */
+static NSDictionary *FakeDriveFieldTree(NSString *fields, NSUInteger *position)
+{
+    NSMutableDictionary *retVal = [NSMutableDictionary dictionary];
+    NSCharacterSet *delimiters = [NSCharacterSet characterSetWithCharactersInString:@",()"];
+    while (*position < fields.length)
+    {
+        NSRange delimiter = [fields rangeOfCharacterFromSet:delimiters options:0 range:NSMakeRange(*position, fields.length - *position)];
+        NSUInteger end = delimiter.location != NSNotFound ? delimiter.location : fields.length;
+        NSString *path = [[fields substringWithRange:NSMakeRange(*position, end - *position)] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        *position = end;
+
+        //A path (e.g. `labels/trashed`) selects within nested objects
+        NSMutableDictionary *node = retVal;
+        for (NSString *name in [path componentsSeparatedByString:@"/"])
+        {
+            if (name.length > 0)
+            {
+                NSMutableDictionary *child = [node objectForKey:name];
+                if (!child)
+                {
+                    child = [NSMutableDictionary dictionary];
+                    [node setObject:child forKey:name];
+                }
+                node = child;
+            }
+        }
+
+        unichar next = *position < fields.length ? [fields characterAtIndex:*position] : 0;
+        if (next == '(')
+        {
+            *position += 1;
+            [node addEntriesFromDictionary:FakeDriveFieldTree(fields, position)];
+            next = *position < fields.length ? [fields characterAtIndex:*position] : 0;
+        }
+        if (next == ')')
+        {
+            *position += 1;
+            break;
+        }
+        *position += 1;
+    }
+    return retVal;
+}
+
+//The parts of a JSON value selected by a field tree (see FakeDriveFieldTree), which applies to each element of an array
+static id FakeDriveProjection(id value, NSDictionary *fieldTree)
+{
+    id retVal = value;
+    if (fieldTree.count > 0 && [value isKindOfClass:[NSArray class]])
+    {
+        NSMutableArray *elements = [NSMutableArray arrayWithCapacity:[value count]];
+        for (id element in value)
+        {
+            [elements addObject:FakeDriveProjection(element, fieldTree)];
+        }
+        retVal = elements;
+    }
+    else if (fieldTree.count > 0 && [value isKindOfClass:[NSDictionary class]])
+    {
+        NSMutableDictionary *selected = [NSMutableDictionary dictionaryWithCapacity:fieldTree.count];
+        for (NSString *name in fieldTree)
+        {
+            id field = [value objectForKey:name];
+            if (field)
+            {
+                [selected setObject:FakeDriveProjection(field, [fieldTree objectForKey:name]) forKey:name];
+            }
+        }
+        retVal = selected;
+    }
+    return retVal;
+}
+
+static GRKHTTPResponse *FakeDriveJSONResponse(NSInteger statusCode, id JSON)
+{
+    NSData *body = [NSJSONSerialization dataWithJSONObject:JSON options:0 error:NULL];
+    return [GRKHTTPResponse responseWithStatusCode:statusCode headers:@{@"Content-Type": kFakeDriveContentTypeJSON} body:body];
+}
+
+static GRKHTTPResponse *FakeDriveErrorResponse(NSInteger code, NSString *reason, NSString *message)
+{
+    return FakeDriveJSONResponse(code, @{@"error": FakeDriveError(code, reason, message)});
+}
+
+//Authorizes every request, standing in for the OAuth 2 authorizer
+@interface FakeDriveAuthorizer : NSObject <GTMFetcherAuthorizationProtocol>
+
+@end
+
+@implementation FakeDriveAuthorizer
+
+- (void)authorizeRequest:(NSMutableURLRequest *)request delegate:(id)delegate didFinishSelector:(SEL)sel
+{
+    [request setValue:@"Bearer fake" forHTTPHeaderField:@"Authorization"];
+    if (delegate && sel)
+    {
+        //- (void)authorizer:(id)auth request:(NSMutableURLRequest *)request finishedWithError:(NSError *)error
+        ((void (*)(id, SEL, id, NSMutableURLRequest *, NSError *))objc_msgSend)(delegate, sel, self, request, nil);
+    }
+}
+
+- (void)authorizeRequest:(NSMutableURLRequest *)request completionHandler:(void (^)(NSError *error))handler
+{
+    [request setValue:@"Bearer fake" forHTTPHeaderField:@"Authorization"];
+    if (handler)
+    {
+        handler(nil);
+    }
+}
+
+- (void)stopAuthorization
+{
+}
+
+- (void)stopAuthorizationForRequest:(NSURLRequest *)request
+{
+}
+
+- (BOOL)isAuthorizingRequest:(NSURLRequest *)request
+{
+    return NO;
+}
+
+- (BOOL)isAuthorizedRequest:(NSURLRequest *)request
+{
+    return [request valueForHTTPHeaderField:@"Authorization"] != nil;
+}
+
+- (NSString *)userEmail
+{
+    return @"fake@localhost";
+}
+
+- (BOOL)canAuthorize
+{
+    return YES;
+}
+
+- (BOOL)primeForRefresh
+{
+    return NO;
+}
+
+@end
+
+//A resumable upload in progress
+@interface FakeDriveUploadSession : NSObject
+
+@property (nonatomic,strong) NSDictionary *call;
+@property (nonatomic,copy) NSString *mediaType;
+@property (nonatomic,strong) NSMutableData *data;
+
+@end
+
+@implementation FakeDriveUploadSession
+
+@end
+
+@interface FakeDriveServer ()
+{
+    uint32_t _randomState;
+}
+
+@property (nonatomic,strong) GRKHTTPServer *server;
+@property (nonatomic,strong,readwrite) id<GTMFetcherAuthorizationProtocol> authorizer;
+@property (atomic,assign,readwrite) unsigned long long bytesReceived;
+@property (atomic,assign,readwrite) unsigned long long bytesSent;
+//Guards all of the following
+@property (nonatomic,strong) dispatch_queue_t stateQueue;
+@property (nonatomic,copy) NSString *baseURLString;
+//File metadata (as Drive JSON) by file ID, and file content by file ID
+@property (nonatomic,strong) NSMutableDictionary *files;
+@property (nonatomic,strong) NSMutableDictionary *contents;
+@property (nonatomic,strong) NSMutableArray *fileIDsInCreationOrder;
+@property (nonatomic,assign) NSUInteger nextFileNumber;
+//The ID of the file changed by each change, where change N is at index N - 1, and the ID of the latest change to each file
+@property (nonatomic,strong) NSMutableArray *changedFileIDs;
+@property (nonatomic,strong) NSMutableDictionary *latestChangeIDs;
+@property (nonatomic,strong) NSMutableDictionary *uploadSessions;
+@property (nonatomic,assign) NSUInteger nextUploadSessionNumber;
+@property (nonatomic,strong) NSMutableDictionary *durations;
+@property (nonatomic,strong) NSDateFormatter *dateFormatter;
+
+@end
+
+@implementation FakeDriveServer
+
+#pragma mark - Initialization
+
+- (instancetype)initWithSeed:(uint32_t)seed
+{
+    if ((self = [super init]))
+    {
+        _randomState = seed ?: 1;
+        self.injectedErrorCode = 503;
+        self.authorizer = [[FakeDriveAuthorizer alloc] init];
+        self.stateQueue = dispatch_queue_create("com.levigroker.GrokinNotes.FakeDriveServer.state", DISPATCH_QUEUE_SERIAL);
+        self.files = [NSMutableDictionary dictionary];
+        self.contents = [NSMutableDictionary dictionary];
+        self.fileIDsInCreationOrder = [NSMutableArray array];
+        self.changedFileIDs = [NSMutableArray array];
+        self.latestChangeIDs = [NSMutableDictionary dictionary];
+        self.uploadSessions = [NSMutableDictionary dictionary];
+        self.durations = [NSMutableDictionary dictionary];
+        self.dateFormatter = [[NSDateFormatter alloc] init];
+        self.dateFormatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+        self.dateFormatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        self.dateFormatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ss.SSS'Z'";
+
+        __weak FakeDriveServer *weakSelf = self;
+        self.server = [[GRKHTTPServer alloc] initWithHandler:^(GRKHTTPRequest *request, void (^respond)(GRKHTTPResponse *response)) {
+            FakeDriveServer *strongSelf = weakSelf;
+            if (strongSelf)
+            {
+                [strongSelf handleRequest:request respond:respond];
+            }
+            else
+            {
+                respond(FakeDriveErrorResponse(503, @"backendError", @"The server is shutting down."));
+            }
+        }];
+    }
+
+    return self;
+}
+
+- (id)init
+{
+    return [self initWithSeed:1];
+}
+
+#pragma mark - Implementation
+
+- (NSURL *)baseURL
+{
+    return self.server.baseURL;
+}
+
+- (BOOL)start:(__autoreleasing NSError **)error
+{
+    BOOL retVal = [self.server start:error];
+    if (retVal)
+    {
+        NSString *baseURLString = [[self.server.baseURL absoluteString] stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"/"]];
+        dispatch_sync(self.stateQueue, ^{
+            self.baseURLString = baseURLString;
+        });
+        DDLogVerbose(@"Fake Drive server listening at '%@'.", self.server.baseURL);
+    }
+    return retVal;
+}
+
+- (void)stop
+{
+    [self.server stop];
+}
+
+- (NSString *)insertFileWithTitle:(NSString *)title content:(NSData *)content
+{
+    return [self insertFileWithTitle:title mimeType:@"text/plain" content:content];
+}
+
+- (NSString *)insertFileWithTitle:(NSString *)title mimeType:(NSString *)mimeType content:(NSData *)content
+{
+    __block NSString *retVal = nil;
+    dispatch_sync(self.stateQueue, ^{
+        retVal = [[self insertFileWithMetadata:@{@"title": title ?: @"", @"mimeType": mimeType ?: kFakeDriveMIMETypeDefault} content:content mediaType:nil] objectForKey:@"id"];
+    });
+    return retVal;
+}
+
+- (BOOL)updateFileWithID:(NSString *)fileID content:(NSData *)content
+{
+    __block BOOL retVal = NO;
+    dispatch_sync(self.stateQueue, ^{
+        NSMutableDictionary *file = [self.files objectForKey:fileID];
+        if (file)
+        {
+            [self setContent:content ofFile:file];
+            [self recordChangeToFile:file];
+            retVal = YES;
+        }
+    });
+    return retVal;
+}
+
+- (BOOL)trashFileWithID:(NSString *)fileID
+{
+    __block BOOL retVal = NO;
+    dispatch_sync(self.stateQueue, ^{
+        NSMutableDictionary *file = [self.files objectForKey:fileID];
+        if (file)
+        {
+            [self setTrashed:YES ofFile:file];
+            retVal = YES;
+        }
+    });
+    return retVal;
+}
+
+- (NSArray *)fileIDs
+{
+    __block NSMutableArray *retVal = nil;
+    dispatch_sync(self.stateQueue, ^{
+        retVal = [NSMutableArray arrayWithCapacity:self.fileIDsInCreationOrder.count];
+        for (NSString *fileID in self.fileIDsInCreationOrder)
+        {
+            if (![[[[self.files objectForKey:fileID] objectForKey:@"labels"] objectForKey:@"trashed"] boolValue])
+            {
+                [retVal addObject:fileID];
+            }
+        }
+    });
+    return retVal;
+}
+
+- (NSDictionary *)requestDurations
+{
+    __block NSMutableDictionary *retVal = nil;
+    dispatch_sync(self.stateQueue, ^{
+        retVal = [NSMutableDictionary dictionaryWithCapacity:self.durations.count];
+        for (NSString *kind in self.durations)
+        {
+            [retVal setObject:[[self.durations objectForKey:kind] copy] forKey:kind];
+        }
+    });
+    return retVal;
+}
+
+- (void)resetStatistics
+{
+    dispatch_sync(self.stateQueue, ^{
+        [self.durations removeAllObjects];
+        self.bytesReceived = 0;
+        self.bytesSent = 0;
+    });
+}
+
+#pragma mark - Helpers
+
+- (void)handleRequest:(GRKHTTPRequest *)request respond:(void (^)(GRKHTTPResponse *response))respond
+{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    __block GRKHTTPResponse *response = nil;
+    __block NSString *kind = nil;
+    dispatch_sync(self.stateQueue, ^{
+        response = [self responseToRequest:request kind:&kind];
+        self.bytesReceived += request.body.length;
+        self.bytesSent += response.body.length;
+    });
+
+    NSTimeInterval delay = self.latency;
+    NSUInteger bytesPerSecond = self.bytesPerSecond;
+    if (bytesPerSecond > 0)
+    {
+        delay += (double)(request.body.length + response.body.length) / bytesPerSecond;
+    }
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        respond(response);
+        NSNumber *duration = [NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent() - start];
+        dispatch_async(self.stateQueue, ^{
+            NSMutableArray *durations = [self.durations objectForKey:kind];
+            if (!durations)
+            {
+                durations = [NSMutableArray array];
+                [self.durations setObject:durations forKey:kind];
+            }
+            [durations addObject:duration];
+        });
+    });
+}
+
+//Called on the state queue
+- (GRKHTTPResponse *)responseToRequest:(GRKHTTPRequest *)request kind:(NSString * __autoreleasing *)kind
+{
+    GRKHTTPResponse *retVal = nil;
+    *kind = kFakeDriveRequestKindOther;
+
+    NSString *method = request.method;
+    NSString *path = request.path;
+    if ([method isEqualToString:@"POST"] && [path isEqualToString:@"/rpc"])
+    {
+        id payload = [NSJSONSerialization JSONObjectWithData:request.body options:0 error:NULL];
+        if ([payload isKindOfClass:[NSArray class]])
+        {
+            *kind = kFakeDriveRequestKindBatch;
+            NSMutableArray *results = [NSMutableArray arrayWithCapacity:[payload count]];
+            for (id call in payload)
+            {
+                if ([call isKindOfClass:[NSDictionary class]])
+                {
+                    [results addObject:[self shouldInjectError] ? [self injectedErrorForCall:call] : [self resultOfCall:call media:nil mediaType:nil]];
+                }
+            }
+            retVal = FakeDriveJSONResponse(200, results);
+        }
+        else if ([payload isKindOfClass:[NSDictionary class]])
+        {
+            *kind = [payload objectForKey:@"method"] ?: kFakeDriveRequestKindOther;
+            retVal = [self shouldInjectError] ? [self injectedErrorResponse] : [self responseWithResult:[self resultOfCall:payload media:nil mediaType:nil]];
+        }
+        else
+        {
+            retVal = FakeDriveErrorResponse(400, @"parseError", @"The request is not valid JSON-RPC.");
+        }
+    }
+    else if ([method isEqualToString:@"POST"] && [path isEqualToString:@"/upload/rpc"])
+    {
+        *kind = kFakeDriveRequestKindUpload;
+        id call = [NSJSONSerialization JSONObjectWithData:request.body options:0 error:NULL];
+        if ([self shouldInjectError])
+        {
+            retVal = [self injectedErrorResponse];
+        }
+        else if ([call isKindOfClass:[NSDictionary class]])
+        {
+            //Start a resumable upload, whose media is sent to the session location
+            FakeDriveUploadSession *session = [[FakeDriveUploadSession alloc] init];
+            session.call = call;
+            session.mediaType = [request valueForHeader:@"X-Upload-Content-Type"];
+            session.data = [NSMutableData data];
+            self.nextUploadSessionNumber += 1;
+            NSString *sessionID = [NSString stringWithFormat:@"%lu", (unsigned long)self.nextUploadSessionNumber];
+            [self.uploadSessions setObject:session forKey:sessionID];
+            NSString *location = [NSString stringWithFormat:@"%@%@%@", self.baseURLString, kFakeDriveUploadSessionPath, sessionID];
+            retVal = [GRKHTTPResponse responseWithStatusCode:200 headers:@{@"Location": location} body:nil];
+        }
+        else
+        {
+            retVal = FakeDriveErrorResponse(400, @"parseError", @"The request is not valid JSON-RPC.");
+        }
+    }
+    else if ([method isEqualToString:@"PUT"] && [path hasPrefix:kFakeDriveUploadSessionPath])
+    {
+        *kind = kFakeDriveRequestKindUpload;
+        NSString *sessionID = [path substringFromIndex:kFakeDriveUploadSessionPath.length];
+        FakeDriveUploadSession *session = [self.uploadSessions objectForKey:sessionID];
+        if (!session)
+        {
+            retVal = FakeDriveErrorResponse(404, @"notFound", @"No such upload session.");
+        }
+        else if ([self shouldInjectError])
+        {
+            retVal = [self injectedErrorResponse];
+        }
+        else
+        {
+            retVal = [self responseToUploadChunk:request session:session sessionID:sessionID];
+        }
+    }
+    else if ([method isEqualToString:@"GET"] && [path hasPrefix:kFakeDriveDownloadPath])
+    {
+        *kind = kFakeDriveRequestKindDownload;
+        NSString *fileID = [path substringFromIndex:kFakeDriveDownloadPath.length];
+        NSData *content = [self.contents objectForKey:fileID];
+        if (!content)
+        {
+            retVal = FakeDriveErrorResponse(404, @"notFound", [NSString stringWithFormat:@"File not found: %@", fileID]);
+        }
+        else if ([self shouldInjectError])
+        {
+            retVal = [self injectedErrorResponse];
+        }
+        else
+        {
+            NSString *mimeType = [[self.files objectForKey:fileID] objectForKey:@"mimeType"];
+            retVal = [GRKHTTPResponse responseWithStatusCode:200 headers:@{@"Content-Type": mimeType} body:content];
+        }
+    }
+    else
+    {
+        retVal = FakeDriveErrorResponse(404, @"notFound", [NSString stringWithFormat:@"No such resource: %@ %@", method, path]);
+    }
+
+    return retVal;
+}
+
+/**
+ Accepts a chunk of a resumable upload, sent with a `Content-Range` of `bytes <first>-<last>/<total>`, or `bytes */<total>` to ask how much has been received.
+ */
+- (GRKHTTPResponse *)responseToUploadChunk:(GRKHTTPRequest *)request session:(FakeDriveUploadSession *)session sessionID:(NSString *)sessionID
+{
+    GRKHTTPResponse *retVal = nil;
+
+    NSString *contentRange = [request valueForHeader:@"Content-Range"];
+    NSString *range = [contentRange hasPrefix:@"bytes "] ? [contentRange substringFromIndex:6] : nil;
+    NSArray *parts = [range componentsSeparatedByString:@"/"];
+    if (parts.count != 2)
+    {
+        retVal = FakeDriveErrorResponse(400, @"badContent", @"Missing or malformed Content-Range.");
+    }
+    else
+    {
+        long long total = [[parts objectAtIndex:1] longLongValue];
+        NSString *span = [parts objectAtIndex:0];
+        if (![span isEqualToString:@"*"])
+        {
+            long long first = [span longLongValue];
+            if (first == (long long)session.data.length)
+            {
+                [session.data appendData:request.body];
+            }
+        }
+
+        if ((long long)session.data.length >= total)
+        {
+            [self.uploadSessions removeObjectForKey:sessionID];
+            retVal = [self responseWithResult:[self resultOfCall:session.call media:session.data mediaType:session.mediaType]];
+        }
+        else
+        {
+            //Resume incomplete; tell the client what has been received
+            NSDictionary *headers = session.data.length > 0 ? @{@"Range": [NSString stringWithFormat:@"bytes=0-%lu", (unsigned long)session.data.length - 1]} : nil;
+            retVal = [GRKHTTPResponse responseWithStatusCode:308 headers:headers body:nil];
+        }
+    }
+
+    return retVal;
+}
+
+- (GRKHTTPResponse *)responseWithResult:(NSDictionary *)result
+{
+    NSDictionary *error = [result objectForKey:@"error"];
+    return FakeDriveJSONResponse(error ? [[error objectForKey:@"code"] integerValue] : 200, result);
+}
+
+- (BOOL)shouldInjectError
+{
+    BOOL retVal = NO;
+    double errorRate = self.errorRate;
+    if (errorRate > 0)
+    {
+        //xorshift32
+        _randomState ^= _randomState << 13;
+        _randomState ^= _randomState >> 17;
+        _randomState ^= _randomState << 5;
+        retVal = (_randomState / 4294967296.0) < errorRate;
+    }
+    return retVal;
+}
+
+- (GRKHTTPResponse *)injectedErrorResponse
+{
+    return FakeDriveErrorResponse(self.injectedErrorCode, @"backendError", @"Injected error.");
+}
+
+- (NSDictionary *)injectedErrorForCall:(NSDictionary *)call
+{
+    NSMutableDictionary *retVal = [NSMutableDictionary dictionaryWithCapacity:2];
+    [retVal setObject:FakeDriveError(self.injectedErrorCode, @"backendError", @"Injected error.") forKey:@"error"];
+    if ([call objectForKey:@"id"])
+    {
+        [retVal setObject:[call objectForKey:@"id"] forKey:@"id"];
+    }
+    return retVal;
+}
+
+/**
+ Performs a single JSON-RPC call.
+ @param call      The call, with `method`, `params` and `id`.
+ @param media     The uploaded content, if any.
+ @param mediaType The MIME type of the uploaded content.
+ @return The JSON-RPC response, with either a `result` or an `error`.
+ */
+- (NSDictionary *)resultOfCall:(NSDictionary *)call media:(NSData *)media mediaType:(NSString *)mediaType
+{
+    NSString *method = [call objectForKey:@"method"];
+    NSDictionary *params = [call objectForKey:@"params"];
+    NSDictionary *resource = [params objectForKey:@"resource"];
+    NSString *fileID = [params objectForKey:@"fileId"];
+    NSMutableDictionary *file = fileID ? [self.files objectForKey:fileID] : nil;
+
+    id result = nil;
+    NSDictionary *error = nil;
+
+    if ([method isEqualToString:@"drive.files.insert"])
+    {
+        result = [self JSONForFile:[self insertFileWithMetadata:resource content:media mediaType:mediaType]];
+    }
+    else if ([method isEqualToString:@"drive.changes.list"])
+    {
+        result = [self changeListWithParameters:params];
+    }
+    else if ([method isEqualToString:@"drive.files.list"])
+    {
+        result = [self fileListWithQuery:[params objectForKey:@"q"]];
+    }
+    else if (![method hasPrefix:@"drive.files."])
+    {
+        error = FakeDriveError(400, @"badRequest", [NSString stringWithFormat:@"Unsupported method: %@", method]);
+    }
+    else if (!file)
+    {
+        error = FakeDriveError(404, @"notFound", [NSString stringWithFormat:@"File not found: %@", fileID]);
+    }
+    else if ([method isEqualToString:@"drive.files.get"])
+    {
+        result = [self JSONForFile:file];
+    }
+    else if ([method isEqualToString:@"drive.files.update"] || [method isEqualToString:@"drive.files.patch"])
+    {
+        [self applyMetadata:resource toFile:file];
+        if (media)
+        {
+            [self setContent:media ofFile:file];
+        }
+        [self recordChangeToFile:file];
+        result = [self JSONForFile:file];
+    }
+    else if ([method isEqualToString:@"drive.files.trash"] || [method isEqualToString:@"drive.files.untrash"])
+    {
+        [self setTrashed:[method isEqualToString:@"drive.files.trash"] ofFile:file];
+        result = [self JSONForFile:file];
+    }
+    else
+    {
+        error = FakeDriveError(400, @"badRequest", [NSString stringWithFormat:@"Unsupported method: %@", method]);
+    }
+
+    //Partial responses, as the client asks for with `fields`
+    NSString *fields = [params objectForKey:@"fields"];
+    if (result && fields.length > 0)
+    {
+        NSUInteger position = 0;
+        result = FakeDriveProjection(result, FakeDriveFieldTree(fields, &position));
+    }
+
+    NSMutableDictionary *retVal = [NSMutableDictionary dictionaryWithCapacity:2];
+    if (result)
+    {
+        [retVal setObject:result forKey:@"result"];
+    }
+    else
+    {
+        [retVal setObject:error forKey:@"error"];
+    }
+    if ([call objectForKey:@"id"])
+    {
+        [retVal setObject:[call objectForKey:@"id"] forKey:@"id"];
+    }
+    return retVal;
+}
+
+- (NSMutableDictionary *)insertFileWithMetadata:(NSDictionary *)metadata content:(NSData *)content mediaType:(NSString *)mediaType
+{
+    self.nextFileNumber += 1;
+    NSString *fileID = [NSString stringWithFormat:@"fake%08lu", (unsigned long)self.nextFileNumber];
+
+    NSMutableDictionary *retVal = [NSMutableDictionary dictionary];
+    [retVal setObject:@"drive#file" forKey:@"kind"];
+    [retVal setObject:fileID forKey:@"id"];
+    [retVal setObject:@"Untitled" forKey:@"title"];
+    [retVal setObject:(mediaType.length > 0 ? mediaType : kFakeDriveMIMETypeDefault) forKey:@"mimeType"];
+    [retVal setObject:[NSMutableDictionary dictionaryWithObject:@NO forKey:@"trashed"] forKey:@"labels"];
+    [retVal setObject:([metadata objectForKey:@"parents"] ?: @[@{@"id": @"root", @"isRoot": @YES}]) forKey:@"parents"];
+    [retVal setObject:@YES forKey:@"editable"];
+    [self applyMetadata:metadata toFile:retVal];
+
+    [self.files setObject:retVal forKey:fileID];
+    [self.fileIDsInCreationOrder addObject:fileID];
+    if (![[retVal objectForKey:@"mimeType"] isEqualToString:kFakeDriveMIMETypeFolder])
+    {
+        [self setContent:(content ?: [NSData data]) ofFile:retVal];
+    }
+    [self recordChangeToFile:retVal];
+
+    return retVal;
+}
+
+- (void)applyMetadata:(NSDictionary *)metadata toFile:(NSMutableDictionary *)file
+{
+    for (NSString *key in @[@"title", @"mimeType", @"description"])
+    {
+        id value = [metadata objectForKey:key];
+        if (value)
+        {
+            [file setObject:value forKey:key];
+        }
+    }
+}
+
+- (void)setContent:(NSData *)content ofFile:(NSMutableDictionary *)file
+{
+    NSString *fileID = [file objectForKey:@"id"];
+    [self.contents setObject:[content copy] forKey:fileID];
+    [file setObject:[GRKDigestCache MD5ForData:content] forKey:@"md5Checksum"];
+    [file setObject:FakeDriveString((long long)content.length) forKey:@"fileSize"];
+    [file setObject:[NSString stringWithFormat:@"%@%@%@", self.baseURLString, kFakeDriveDownloadPath, fileID] forKey:@"downloadUrl"];
+}
+
+- (void)setTrashed:(BOOL)trashed ofFile:(NSMutableDictionary *)file
+{
+    [[file objectForKey:@"labels"] setObject:[NSNumber numberWithBool:trashed] forKey:@"trashed"];
+    [self recordChangeToFile:file];
+}
+
+- (void)recordChangeToFile:(NSMutableDictionary *)file
+{
+    NSString *fileID = [file objectForKey:@"id"];
+    [file setObject:[self.dateFormatter stringFromDate:[NSDate date]] forKey:@"modifiedDate"];
+    [self.changedFileIDs addObject:fileID];
+    [self.latestChangeIDs setObject:[NSNumber numberWithUnsignedInteger:self.changedFileIDs.count] forKey:fileID];
+}
+
+- (NSDictionary *)JSONForFile:(NSDictionary *)file
+{
+    //A deep copy, so later changes to the file do not show through
+    return [NSJSONSerialization JSONObjectWithData:[NSJSONSerialization dataWithJSONObject:file options:0 error:NULL] options:0 error:NULL];
+}
+
+/**
+ A page of the change feed, which starts at `pageToken` (the next change ID) or `startChangeId`, and holds only the latest change to each file.
+ */
+- (NSDictionary *)changeListWithParameters:(NSDictionary *)params
+{
+    id pageToken = [params objectForKey:@"pageToken"];
+    id startChangeID = [params objectForKey:@"startChangeId"];
+    long long changeID = MAX(1, pageToken ? [pageToken longLongValue] : (startChangeID ? [startChangeID longLongValue] : 1));
+    NSInteger requestedPageSize = [[params objectForKey:@"maxResults"] integerValue];
+    NSUInteger pageSize = requestedPageSize > 0 ? MIN((NSUInteger)requestedPageSize, kFakeDriveMaximumChangesPageSize) : kFakeDriveDefaultChangesPageSize;
+
+    long long largestChangeID = (long long)self.changedFileIDs.count;
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:pageSize];
+    while (changeID <= largestChangeID && items.count < pageSize)
+    {
+        NSString *fileID = [self.changedFileIDs objectAtIndex:(NSUInteger)(changeID - 1)];
+        if ([[self.latestChangeIDs objectForKey:fileID] longLongValue] == changeID)
+        {
+            [items addObject:@{@"kind": @"drive#change", @"id": FakeDriveString(changeID), @"fileId": fileID, @"deleted": @NO, @"file": [self JSONForFile:[self.files objectForKey:fileID]]}];
+        }
+        ++changeID;
+    }
+
+    NSMutableDictionary *retVal = [NSMutableDictionary dictionaryWithCapacity:4];
+    [retVal setObject:@"drive#changeList" forKey:@"kind"];
+    [retVal setObject:items forKey:@"items"];
+    [retVal setObject:FakeDriveString(largestChangeID) forKey:@"largestChangeId"];
+    if (changeID <= largestChangeID)
+    {
+        [retVal setObject:FakeDriveString(changeID) forKey:@"nextPageToken"];
+    }
+    return retVal;
+}
+
+/**
+ The files which are not in the trash. Of the query language only a `mimeType = '<type>'` term is understood; all files are taken to be in the root folder.
+ */
+- (NSDictionary *)fileListWithQuery:(NSString *)query
+{
+    NSString *mimeType = nil;
+    NSRange term = [query rangeOfString:@"mimeType = '"];
+    if (term.location != NSNotFound)
+    {
+        NSString *rest = [query substringFromIndex:NSMaxRange(term)];
+        NSRange end = [rest rangeOfString:@"'"];
+        mimeType = end.location != NSNotFound ? [rest substringToIndex:end.location] : rest;
+    }
+
+    NSMutableArray *items = [NSMutableArray array];
+    for (NSString *fileID in self.fileIDsInCreationOrder)
+    {
+        NSDictionary *file = [self.files objectForKey:fileID];
+        BOOL trashed = [[[file objectForKey:@"labels"] objectForKey:@"trashed"] boolValue];
+        if (!trashed && (!mimeType || [mimeType isEqualToString:[file objectForKey:@"mimeType"]]))
+        {
+            [items addObject:[self JSONForFile:file]];
+        }
+    }
+    return @{@"kind": @"drive#fileList", @"items": items};
+}
+
+@end
+
+#endif
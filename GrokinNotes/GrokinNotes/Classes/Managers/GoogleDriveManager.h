@@ -17,7 +17,8 @@ typedef NS_ENUM(NSInteger, GoogleDriveManagerError) {
     GoogleDriveManagerErrorBadConfig,
     GoogleDriveManagerErrorNotInitialized,
     GoogleDriveManagerErrorNotAuthorized,
-    GoogleDriveManagerErrorBadParameter
+    GoogleDriveManagerErrorBadParameter,
+    GoogleDriveManagerErrorNoResult
 };
 
 NSString * const kMIMETypeTextPlain;
@@ -58,6 +59,16 @@ NSString * const kMIMETypeTextPlain;
  */
 - (GTMOAuth2ViewControllerTouch *)createAuthControllerWithCompletion:(void(^)(GTMOAuth2ViewControllerTouch *viewController, NSError *error))completion;
 
+#if DEBUG
+/**
+ Configures the manager to use the given server in place of Google Drive, instead of `startup`. Used to measure synchronization against a fake server (see FakeDriveServer).
+ 
+ @param serviceURL The URL of the root of the server, which must accept JSON-RPC requests at `rpc` and resumable uploads at `upload/rpc`.
+ @param authorizer The authorizer for requests to the server.
+ */
+- (void)startupWithServiceURL:(NSURL *)serviceURL authorizer:(id<GTMFetcherAuthorizationProtocol>)authorizer;
+#endif
+
 /**
  Creates a folder in Google Drive.
  
@@ -140,6 +151,75 @@ NSString * const kMIMETypeTextPlain;
  */
 - (void)restoreFileWithID:(NSString *)fileID completion:(void(^)(GTLDriveFile *file, NSError *error))completion;
 
+/**
+ Moves the specified files to Google Drive trash, using as few requests as possible.
+ 
+ @param fileIDs    An NSArray of the IDs of the files to be moved to the trash.
+ @param completion Called on the main queue once all files have been processed, with `files` mapping the ID of each file which was trashed to the `GTLDriveFile` representing it, and `errors` mapping the ID of each file which could not be trashed to an NSError.
+ */
+- (void)trashFilesWithIDs:(NSArray *)fileIDs completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion;
+
+/**
+ Restores the specified files from the Google Drive trash, using as few requests as possible.
+ 
+ @param fileIDs    An NSArray of the IDs of the files to be restored from the trash.
+ @param completion Called on the main queue once all files have been processed, with `files` mapping the ID of each file which was restored to the `GTLDriveFile` representing it, and `errors` mapping the ID of each file which could not be restored to an NSError.
+ */
+- (void)restoreFilesWithIDs:(NSArray *)fileIDs completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion;
+
+/**
+ Retrieves the metadata of the specified files, using as few requests as possible. Only the fields describing a file's place in the folder hierarchy (ID, title, MIME type, trashed label and parents) are retrieved.
+ 
+ @param fileIDs    An NSArray of the IDs of the files to retrieve.
+ @param completion Called on the main queue once all files have been processed, with `files` mapping the ID of each file which was retrieved to the `GTLDriveFile` representing it, and `errors` mapping the ID of each file which could not be retrieved to an NSError.
+ */
+- (void)retrieveFilesWithIDs:(NSArray *)fileIDs completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion;
+
+/**
+ Changes the titles of the specified files on Google Drive without touching their content, using as few requests as possible.
+ 
+ @param titles     An NSDictionary mapping the ID of each file to be renamed to its new title.
+ @param completion Called on the main queue once all files have been processed, with `files` mapping the ID of each file which was renamed to the `GTLDriveFile` representing it, and `errors` mapping the ID of each file which could not be renamed to an NSError.
+ */
+- (void)renameFiles:(NSDictionary *)titles completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion;
+
+/**
+ Creates empty files on Google Drive from metadata alone, using as few requests as possible. Files with content must be created with `createFile:withMIMEType:inFolder:completion:`, since content can not be uploaded in a batch.
+ 
+ @param files      An NSDictionary mapping a key of the caller's choosing to the `GTLDriveFile` metadata (at least a title) of each file to create. Files without a MIME type are created as `kMIMETypeTextPlain`.
+ @param folder     The `GTLDriveFile` representing the parent directory to receive the files (if `nil` the files will be created in the root directory).
+ @param completion Called on the main queue once all files have been processed, with `files` mapping the key of each file which was created to the `GTLDriveFile` representing it, and `errors` mapping the key of each file which could not be created to an NSError.
+ */
+- (void)createFilesWithMetadata:(NSDictionary *)files inFolder:(GTLDriveFile *)folder completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion;
+
+/**
+ Determines if the given file is one which should be treated as a note (a plain text file with an identifier and title).
+ The change feed is narrowed on the server as far as the Drive API allows, but may still include other files, so each changed file should be checked with this method.
+ 
+ @param file The `GTLDriveFile` to check.
+ 
+ @return `YES` if the file represents a note.
+ */
+- (BOOL)isNoteFile:(GTLDriveFile *)file;
+
+/**
+ Determines if the given file is a folder.
+ 
+ @param file The `GTLDriveFile` to check.
+ 
+ @return `YES` if the file represents a folder.
+ */
+- (BOOL)isFolder:(GTLDriveFile *)file;
+
+/**
+ The folder holding the given file. Drive allows a file to be in several folders, in which case the first is used.
+ 
+ @param file The `GTLDriveFile`.
+ 
+ @return The ID of the folder, or `nil` if the file is at the root (or in no folder).
+ */
+- (NSString *)parentIDOfFile:(GTLDriveFile *)file;
+
 /**
  Retrieves a list of changes since the given change ID.
  
@@ -148,4 +228,15 @@ NSString * const kMIMETypeTextPlain;
  */
 - (void)retrieveAllChangesSinceChangeID:(NSNumber *)startChangeID completion:(void (^)(NSArray *changes, NSNumber *largestChangeID, NSError *error))completion;
 
+/**
+ Retrieves the changes since the given change ID one page at a time, so that no more than one page of changes is held in memory regardless of how many changes are outstanding.
+ Each page is handed to `pageHandler`, and the next page is not requested until `pageHandler` calls its `next` block, which allows each page to be fully processed before more changes are retrieved.
+ 
+ @param startChangeID An NSNumber representing a long long identifying the change ID to start with when performing the query. If `nil` all changes will be returned.
+ @param pageSize      The maximum number of changes to retrieve per page. If `0` a default page size is used.
+ @param pageHandler   Called for each page with `changes` an NSArray of `GTLDriveChange` objects in the order they occurred, `checkpointChangeID` an NSNumber representing a long long which identifies the change ID through which all changes have been delivered once this page has been processed, and `lastPage` indicating if this is the final page. Call `next` with `YES` to retrieve the next page, or `NO` to stop. `next` must be called exactly once, and is ignored for the last page.
+ @param completion    Called once all pages have been processed or retrieval has stopped, with `largestChangeID` an NSNumber representing a long long which identifies the ending change ID (or `nil` if retrieval did not reach the last page), or error.
+ */
+- (void)enumerateChangesSinceChangeID:(NSNumber *)startChangeID pageSize:(NSUInteger)pageSize pageHandler:(void (^)(NSArray *changes, NSNumber *checkpointChangeID, BOOL lastPage, void (^next)(BOOL proceed)))pageHandler completion:(void (^)(NSNumber *largestChangeID, NSError *error))completion;
+
 @end
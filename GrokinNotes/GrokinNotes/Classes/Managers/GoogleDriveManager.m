@@ -7,6 +7,7 @@
 //
 
 #import "GoogleDriveManager.h"
+#import "GRKMetrics.h"
 
 NSString * const GoogleDriveManagerErrorDomain = @"GoogleDriveManager";
 
@@ -21,6 +22,26 @@ static NSString * const kGoogleMIMETypeFolder = @"application/vnd.google-apps.fo
 
 static NSString * const kGoogleDriveRootFolderID = @"root";
 
+static NSUInteger const kDefaultChangesPageSize = 100;
+
+//The most queries the Drive API accepts in a single batch request
+static NSUInteger const kMaximumBatchSize = 100;
+
+//A partial response projection for change lists, limited to what is needed to apply changes to notes (see https://developers.google.com/drive/v2/web/performance#partial-response)
+static NSString * const kChangesListFields = @"items(id,fileId,deleted,file(id,title,mimeType,md5Checksum,downloadUrl,labels/trashed,parents(id,isRoot))),largestChangeId,nextPageToken";
+//Likewise for the files retrieved by retrieveFilesWithIDs:completion:, limited to what is needed to place them in the folder hierarchy
+static NSString * const kFileHierarchyFields = @"id,title,mimeType,labels/trashed,parents(id,isRoot)";
+
+//Metrics (see GRKMetrics). The duration of each query is recorded, in microseconds, under its method name (e.g. "drive.files.insert").
+static NSString * const kMetricBatch = @"drive.batch";
+static NSString * const kMetricBatchQueries = @"drive.batch.queries";
+static NSString * const kMetricDownload = @"drive.download";
+static NSString * const kMetricBytesUp = @"drive.bytes.up";
+static NSString * const kMetricBytesDown = @"drive.bytes.down";
+static NSString * const kMetricChanges = @"drive.changes";
+static NSString * const kMetricErrors = @"drive.errors";
+static NSString * const kMetricRetries = @"drive.retries";
+
 @interface GoogleDriveManager ()
 
 @property (nonatomic,assign) BOOL initialized;
@@ -57,7 +78,7 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
                 self.driveService = [[GTLServiceDrive alloc] init];
                 self.driveService.authorizer = [GTMOAuth2ViewControllerTouch authForGoogleFromKeychainForName:kGoogleKeychainItemName clientID:self.clientID clientSecret:self.clientSecrect];
                 //Fetch all pages of items.
-                //NOTE: This could be a performance concern moving forward, but hadling pages of content is currently out of scope.
+                //NOTE: This could be a performance concern moving forward. The change feed, which can be very large, is paged explicitly instead (see enumerateChangesSinceChangeID:pageSize:pageHandler:completion:).
                 self.driveService.shouldFetchNextPages = YES;
                 self.initialized = YES;
             }
@@ -90,6 +111,18 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
     return retVal;
 }
 
+#if DEBUG
+- (void)startupWithServiceURL:(NSURL *)serviceURL authorizer:(id<GTMFetcherAuthorizationProtocol>)authorizer
+{
+    self.driveService = [[GTLServiceDrive alloc] init];
+    self.driveService.rpcURL = [[NSURL URLWithString:@"rpc" relativeToURL:serviceURL] absoluteURL];
+    self.driveService.rpcUploadURL = [[NSURL URLWithString:@"upload/rpc?uploadType=resumable" relativeToURL:serviceURL] absoluteURL];
+    self.driveService.authorizer = authorizer;
+    self.driveService.shouldFetchNextPages = YES;
+    self.initialized = YES;
+}
+#endif
+
 - (BOOL)authorized
 {
     BOOL retVal = [((GTMOAuth2Authentication *)self.driveService.authorizer) canAuthorize];
@@ -136,7 +169,7 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
         folder.parents = @[parent];
 
         GTLQueryDrive *query = [GTLQueryDrive queryForFilesInsertWithObject:folder uploadParameters:nil];
-        [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *updatedFile, NSError *error) {
+        [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *updatedFile, NSError *error) {
             if (completion)
             {
                 completion(updatedFile, error);
@@ -197,7 +230,7 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
             {
                 query.q = [query.q stringByAppendingFormat:@" and mimeType = '%@'", mimeType];
             }
-            [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFileList *files, NSError *error) {
+            [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFileList *files, NSError *error) {
                 completion(files, error);
             }];
         }
@@ -227,9 +260,27 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
         {
             GTMHTTPFetcher *fetcher = [self.driveService.fetcherService fetcherWithURLString:file.downloadUrl];
             fetcher.retryEnabled = YES;
+            fetcher.retryBlock = ^(BOOL suggestedWillRetry, NSError *error) {
+                if (suggestedWillRetry)
+                {
+                    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricRetries by:1];
+                }
+                return suggestedWillRetry;
+            };
             fetcher.shouldFetchInBackground = YES;
             fetcher.downloadPath = [fileURL path];
+            uint64_t start = GRKMetricsTime();
             [fetcher beginFetchWithCompletionHandler:^(NSData *data, NSError *error) {
+                GRKMetrics *metrics = [GRKMetrics sharedMetrics];
+                [metrics recordTimeSince:start inHistogramNamed:kMetricDownload];
+                if (error)
+                {
+                    [metrics incrementCounterNamed:kMetricErrors by:1];
+                }
+                else
+                {
+                    [metrics incrementCounterNamed:kMetricBytesDown by:[[[NSFileManager defaultManager] attributesOfItemAtPath:[fileURL path] error:nil] fileSize]];
+                }
                 if (completion)
                 {
                     completion(file, fileURL, error);
@@ -292,8 +343,13 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
             GTLUploadParameters *uploadParameters = [GTLUploadParameters uploadParametersWithFileHandle:fileHandle MIMEType:targetMIMEType];
             
             GTLQueryDrive *query = [GTLQueryDrive queryForFilesInsertWithObject:metadata uploadParameters:uploadParameters];
+            unsigned long long fileSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:[file path] error:nil] fileSize];
             
-            [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *createdFile, NSError *error) {
+            [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *createdFile, NSError *error) {
+                if (!error)
+                {
+                    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricBytesUp by:fileSize];
+                }
                 if (completion)
                 {
                     completion(createdFile, error);
@@ -333,9 +389,13 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
             GTLUploadParameters *uploadParameters = [GTLUploadParameters uploadParametersWithFileHandle:fileHandle MIMEType:driveFile.mimeType];
             
             GTLQueryDrive *query = [GTLQueryDrive queryForFilesUpdateWithObject:driveFile fileId:driveFile.identifier uploadParameters:uploadParameters];
-
+            unsigned long long fileSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:[fileURL path] error:nil] fileSize];
             
-            [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *updatedFile, NSError *error) {
+            [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *updatedFile, NSError *error) {
+                if (!error)
+                {
+                    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricBytesUp by:fileSize];
+                }
                 if (completion)
                 {
                     completion(updatedFile, error);
@@ -419,7 +479,7 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
                         query = [GTLQueryDrive queryForFilesInsertWithObject:metadata uploadParameters:uploadParameters];
                     }
 
-                    [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *updatedFile, NSError *error) {
+                    [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *updatedFile, NSError *error) {
                         if (completion)
                         {
                             completion(updatedFile, error);
@@ -462,7 +522,7 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
     if (self.initialized)
     {
         GTLQueryDrive *query = [GTLQueryDrive queryForFilesTrashWithFileId:fileID];
-        [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *file, NSError *error) {
+        [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *file, NSError *error) {
             if (completion)
             {
                 completion(file, error);
@@ -488,7 +548,7 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
     if (self.initialized)
     {
         GTLQueryDrive *query = [GTLQueryDrive queryForFilesUntrashWithFileId:fileID];
-        [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *file, NSError *error) {
+        [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveFile *file, NSError *error) {
             if (completion)
             {
                 completion(file, error);
@@ -509,20 +569,90 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
     }
 }
 
+- (void)trashFilesWithIDs:(NSArray *)fileIDs completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion
+{
+    NSMutableDictionary *queries = [NSMutableDictionary dictionaryWithCapacity:fileIDs.count];
+    for (NSString *fileID in fileIDs)
+    {
+        [queries setObject:[GTLQueryDrive queryForFilesTrashWithFileId:fileID] forKey:fileID];
+    }
+    [self executeBatchOfQueries:queries completion:completion];
+}
+
+- (void)restoreFilesWithIDs:(NSArray *)fileIDs completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion
+{
+    NSMutableDictionary *queries = [NSMutableDictionary dictionaryWithCapacity:fileIDs.count];
+    for (NSString *fileID in fileIDs)
+    {
+        [queries setObject:[GTLQueryDrive queryForFilesUntrashWithFileId:fileID] forKey:fileID];
+    }
+    [self executeBatchOfQueries:queries completion:completion];
+}
+
+- (void)retrieveFilesWithIDs:(NSArray *)fileIDs completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion
+{
+    NSMutableDictionary *queries = [NSMutableDictionary dictionaryWithCapacity:fileIDs.count];
+    for (NSString *fileID in fileIDs)
+    {
+        GTLQueryDrive *query = [GTLQueryDrive queryForFilesGetWithFileId:fileID];
+        query.fields = kFileHierarchyFields;
+        [queries setObject:query forKey:fileID];
+    }
+    [self executeBatchOfQueries:queries completion:completion];
+}
+
+- (void)renameFiles:(NSDictionary *)titles completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion
+{
+    NSMutableDictionary *queries = [NSMutableDictionary dictionaryWithCapacity:titles.count];
+    for (NSString *fileID in titles)
+    {
+        GTLDriveFile *metadata = [GTLDriveFile object];
+        metadata.title = [titles objectForKey:fileID];
+        [queries setObject:[GTLQueryDrive queryForFilesPatchWithObject:metadata fileId:fileID] forKey:fileID];
+    }
+    [self executeBatchOfQueries:queries completion:completion];
+}
+
+- (void)createFilesWithMetadata:(NSDictionary *)files inFolder:(GTLDriveFile *)folder completion:(void(^)(NSDictionary *files, NSDictionary *errors))completion
+{
+    NSMutableDictionary *queries = [NSMutableDictionary dictionaryWithCapacity:files.count];
+    for (id key in files)
+    {
+        GTLDriveFile *metadata = [[files objectForKey:key] copy];
+        
+        //Setup the parent relationship
+        if (folder)
+        {
+            GTLDriveParentReference *parent = [GTLDriveParentReference object];
+            parent.identifier = folder.identifier;
+            metadata.parents = @[parent];
+        }
+        
+        //Default MIME type
+        if (metadata.mimeType.length == 0)
+        {
+            metadata.mimeType = kMIMETypeTextPlain;
+        }
+        
+        [queries setObject:[GTLQueryDrive queryForFilesInsertWithObject:metadata uploadParameters:nil] forKey:key];
+    }
+    [self executeBatchOfQueries:queries completion:completion];
+}
+
 - (void)retrieveAllChangesSinceChangeID:(NSNumber *)startChangeID completion:(void (^)(NSArray *changes, NSNumber *largestChangeID, NSError *error))completion
 {
     if (self.initialized)
     {
         if (completion)
         {
-            //TODO: Receives all changes to the entire drive since the change ID. It would be nice to be able to limit this to files of a particular type, and/or specific directories.
             GTLQueryDrive *query = [GTLQueryDrive queryForChangesList];
+            [self configureChangesListQuery:query];
             if (startChangeID)
             {
                 query.startChangeId = [startChangeID longLongValue];
             }
             
-            [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveChangeList *changeList, NSError *error) {
+            [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveChangeList *changeList, NSError *error) {
                 completion(changeList.items, changeList.largestChangeId, error);
             }];
         }
@@ -541,4 +671,232 @@ static NSString * const kGoogleDriveRootFolderID = @"root";
     }
 }
 
+- (BOOL)isNoteFile:(GTLDriveFile *)file
+{
+    BOOL retVal = file.identifier.length > 0 && file.title.length > 0 && [file.mimeType isEqualToString:kMIMETypeTextPlain];
+    return retVal;
+}
+
+- (BOOL)isFolder:(GTLDriveFile *)file
+{
+    BOOL retVal = file.identifier.length > 0 && [file.mimeType isEqualToString:kGoogleMIMETypeFolder];
+    return retVal;
+}
+
+- (NSString *)parentIDOfFile:(GTLDriveFile *)file
+{
+    GTLDriveParentReference *parent = [file.parents firstObject];
+    NSString *retVal = [parent.isRoot boolValue] ? nil : parent.identifier;
+    return retVal;
+}
+
+- (void)enumerateChangesSinceChangeID:(NSNumber *)startChangeID pageSize:(NSUInteger)pageSize pageHandler:(void (^)(NSArray *changes, NSNumber *checkpointChangeID, BOOL lastPage, void (^next)(BOOL proceed)))pageHandler completion:(void (^)(NSNumber *largestChangeID, NSError *error))completion
+{
+    if (self.initialized)
+    {
+        [self fetchChangesPageWithToken:nil startChangeID:startChangeID pageSize:(pageSize > 0 ? pageSize : kDefaultChangesPageSize) pageHandler:pageHandler completion:completion];
+    }
+    else
+    {
+        NSString *message = @"Drive services not initialized.";
+        DDLogError(@"%@", message);
+        if (completion)
+        {
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+            [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+            NSError *error = [NSError errorWithDomain:GoogleDriveManagerErrorDomain code:GoogleDriveManagerErrorNotInitialized userInfo:userInfo];
+            completion(nil, error);
+        }
+    }
+}
+
+#pragma mark - Helpers
+
+/**
+ Executes the given query with the drive service, recording its duration, and any failure, in the shared metrics.
+ */
+- (GTLServiceTicket *)executeQuery:(id<GTLQueryProtocol>)query completionHandler:(void (^)(GTLServiceTicket *ticket, id object, NSError *error))handler
+{
+    NSString *metric = [query isBatchQuery] ? kMetricBatch : [(GTLQuery *)query methodName];
+    uint64_t start = GRKMetricsTime();
+    return [self.driveService executeQuery:query completionHandler:^(GTLServiceTicket *ticket, id object, NSError *error) {
+        GRKMetrics *metrics = [GRKMetrics sharedMetrics];
+        [metrics recordTimeSince:start inHistogramNamed:metric];
+        if (error)
+        {
+            [metrics incrementCounterNamed:kMetricErrors by:1];
+        }
+        handler(ticket, object, error);
+    }];
+}
+
+/**
+ Narrows a change list query to what is relevant to us.
+ The change feed can not be filtered by folder or MIME type on the server, but the `drive.file` scope we authorize with already limits it to files created or opened by this app. Shared and public files are excluded, and the response is limited to the fields we use, which keeps the payload (and its parsing) small.
+ Callers must still check each change (see `isNoteFile:`), since the feed can include other files the app has opened.
+ */
+- (void)configureChangesListQuery:(GTLQueryDrive *)query
+{
+    query.includeSubscribed = NO;
+    query.fields = kChangesListFields;
+}
+
+/**
+ Executes the given queries in as few batch requests as possible.
+ @param queries    An NSDictionary mapping a caller chosen key to each `GTLQueryDrive` to execute. The queries must not upload media, which batch requests do not support.
+ @param completion Called once all batches complete, with `results` mapping the key of each query which succeeded to its result object (NSNull if there is none), and `errors` mapping the key of each query which failed to an NSError. Every key appears in exactly one of the two.
+ */
+- (void)executeBatchOfQueries:(NSDictionary *)queries completion:(void(^)(NSDictionary *results, NSDictionary *errors))completion
+{
+    NSMutableDictionary *results = [NSMutableDictionary dictionaryWithCapacity:queries.count];
+    NSMutableDictionary *errors = [NSMutableDictionary dictionary];
+    
+    if (!self.initialized)
+    {
+        NSString *message = @"Drive services not initialized.";
+        DDLogError(@"%@", message);
+        NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+        [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+        NSError *error = [NSError errorWithDomain:GoogleDriveManagerErrorDomain code:GoogleDriveManagerErrorNotInitialized userInfo:userInfo];
+        for (id key in queries)
+        {
+            [errors setObject:error forKey:key];
+        }
+        if (completion)
+        {
+            completion(results, errors);
+        }
+        return;
+    }
+    
+    dispatch_group_t batchGroup = dispatch_group_create();
+    
+    NSArray *keys = [queries allKeys];
+    for (NSUInteger start = 0; start < keys.count; start += kMaximumBatchSize)
+    {
+        NSArray *batchKeys = [keys subarrayWithRange:NSMakeRange(start, MIN(kMaximumBatchSize, keys.count - start))];
+        
+        //Map each request ID back to the caller's key
+        GTLBatchQuery *batchQuery = [GTLBatchQuery batchQuery];
+        NSMutableDictionary *keysByRequestID = [NSMutableDictionary dictionaryWithCapacity:batchKeys.count];
+        for (id key in batchKeys)
+        {
+            GTLQueryDrive *query = [queries objectForKey:key];
+            [batchQuery addQuery:query];
+            [keysByRequestID setObject:key forKey:query.requestID];
+        }
+        
+        [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricBatchQueries by:batchKeys.count];
+        dispatch_group_enter(batchGroup);
+        [self executeQuery:batchQuery completionHandler:^(GTLServiceTicket *ticket, GTLBatchResult *batchResult, NSError *error) {
+            for (NSString *requestID in keysByRequestID)
+            {
+                id key = [keysByRequestID objectForKey:requestID];
+                id result = [batchResult.successes objectForKey:requestID];
+                GTLErrorObject *errorObject = [batchResult.failures objectForKey:requestID];
+                if (result)
+                {
+                    [results setObject:result forKey:key];
+                }
+                else if (errorObject)
+                {
+                    [errors setObject:[errorObject foundationError] forKey:key];
+                }
+                else if (error)
+                {
+                    //The whole batch failed
+                    [errors setObject:error forKey:key];
+                }
+                else
+                {
+                    NSString *message = [NSString stringWithFormat:@"No result for batched query: %@", [queries objectForKey:key]];
+                    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+                    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+                    [errors setObject:[NSError errorWithDomain:GoogleDriveManagerErrorDomain code:GoogleDriveManagerErrorNoResult userInfo:userInfo] forKey:key];
+                }
+            }
+            [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricErrors by:batchResult.failures.count];
+            dispatch_group_leave(batchGroup);
+        }];
+    }
+    
+    dispatch_group_notify(batchGroup, dispatch_get_main_queue(), ^{
+        if (completion)
+        {
+            completion(results, errors);
+        }
+    });
+}
+
+- (void)fetchChangesPageWithToken:(NSString *)pageToken startChangeID:(NSNumber *)startChangeID pageSize:(NSUInteger)pageSize pageHandler:(void (^)(NSArray *changes, NSNumber *checkpointChangeID, BOOL lastPage, void (^next)(BOOL proceed)))pageHandler completion:(void (^)(NSNumber *largestChangeID, NSError *error))completion
+{
+    GTLQueryDrive *query = [GTLQueryDrive queryForChangesList];
+    [self configureChangesListQuery:query];
+    query.maxResults = pageSize;
+    if (pageToken)
+    {
+        query.pageToken = pageToken;
+    }
+    else if (startChangeID)
+    {
+        query.startChangeId = [startChangeID longLongValue];
+    }
+    
+    GTLServiceTicket *ticket = [self executeQuery:query completionHandler:^(GTLServiceTicket *ticket, GTLDriveChangeList *changeList, NSError *error) {
+        if (error)
+        {
+            if (completion)
+            {
+                completion(nil, error);
+            }
+            return;
+        }
+        
+        NSArray *changes = changeList.items ?: @[];
+        [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricChanges by:changes.count];
+        NSString *nextPageToken = changeList.nextPageToken;
+        BOOL lastPage = nextPageToken.length == 0;
+        
+        //Once the last page is processed everything through the largest change ID has been seen. Before that, only the changes on this page (which are in ascending order) are known to have been delivered.
+        NSNumber *checkpointChangeID = nil;
+        if (lastPage)
+        {
+            checkpointChangeID = changeList.largestChangeId;
+        }
+        else
+        {
+            long long largest = startChangeID ? [startChangeID longLongValue] - 1 : -1;
+            for (GTLDriveChange *change in changes)
+            {
+                largest = MAX(largest, [change.identifier longLongValue]);
+            }
+            checkpointChangeID = largest >= 0 ? [NSNumber numberWithLongLong:largest] : nil;
+        }
+        
+        void (^next)(BOOL proceed) = ^(BOOL proceed) {
+            if (proceed && !lastPage)
+            {
+                NSNumber *nextStartChangeID = checkpointChangeID ? [NSNumber numberWithLongLong:[checkpointChangeID longLongValue] + 1] : startChangeID;
+                [self fetchChangesPageWithToken:nextPageToken startChangeID:nextStartChangeID pageSize:pageSize pageHandler:pageHandler completion:completion];
+            }
+            else if (completion)
+            {
+                completion(lastPage ? changeList.largestChangeId : nil, nil);
+            }
+        };
+        
+        if (pageHandler)
+        {
+            pageHandler(changes, checkpointChangeID, lastPage, next);
+        }
+        else
+        {
+            next(YES);
+        }
+    }];
+    
+    //We fetch the next page ourselves, once this one has been processed
+    ticket.shouldFetchNextPages = NO;
+}
+
 @end
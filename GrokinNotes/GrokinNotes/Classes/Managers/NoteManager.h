@@ -9,6 +9,9 @@
 #import <Foundation/Foundation.h>
 #import "Note.h"
 #import "GoogleDriveManager.h"
+#import "SyncScheduler.h"
+#import "TransferScheduler.h"
+#import "GRKSortedSet.h"
 
 ////
 //// Errors
@@ -46,11 +49,49 @@ NSString * const kNoteNotificationInfoKeyUpdatedNotes;
  The userInfo key, for a notification, which represents the array of notes which were added.
  */
 NSString * const kNoteNotificationInfoKeyAddedNotes;
+/**
+ The userInfo key, for a notification, which represents the NSIndexSet of the visible notes which were removed, as indexes into the visible notes before the changes.
+ */
+NSString * const kNoteNotificationInfoKeyDeletedIndexes;
+/**
+ The userInfo key, for a notification, which represents the NSIndexSet of the visible notes which were inserted, as indexes into the visible notes after the changes.
+ A visible note whose title changed is removed from its old index and inserted at its new one.
+ */
+NSString * const kNoteNotificationInfoKeyInsertedIndexes;
+/**
+ The userInfo key, for a notification, which represents the NSIndexSet of the visible notes which were updated in place, as indexes into the visible notes before the changes.
+ */
+NSString * const kNoteNotificationInfoKeyReloadedIndexes;
+/**
+ The userInfo key, for a notification, which represents the GRKSortedSetSnapshot of the visible notes after the changes, which the indexes refer to.
+ */
+NSString * const kNoteNotificationInfoKeyVisibleNotes;
 
 @interface NoteManager : NSObject
 
 @property (nonatomic,readonly) GoogleDriveManager *driveManager;
 
+/**
+ Decides when synchronization occurs. Observe its published state to present synchronization status.
+ */
+@property (nonatomic,readonly) SyncScheduler *syncScheduler;
+
+/**
+ Runs the uploads and downloads of note content, favoring the notes the user is looking at. Its statistics show how each priority class is being served.
+ */
+@property (nonatomic,readonly) TransferScheduler *transferScheduler;
+
+/**
+ The number of bytes of note content which did not need to be uploaded, since the content was found to be unchanged from what the remote already has, and only the title was sent.
+ */
+@property (nonatomic,assign,readonly) unsigned long long uploadBytesSaved;
+
+/**
+ An immutable snapshot of the notes which are currently visible to the User, in sorted order, which is safe to read from any queue.
+ Each change to the visible notes publishes a new snapshot, with a greater version, before the change notification is posted. Readers are never blocked by changes, and keep a consistent view for as long as they hold a snapshot.
+ */
+@property (atomic,strong,readonly) GRKSortedSetSnapshot *visibleNotesSnapshot;
+
 /**
  The shared singleton instance of the NoteManager object to be used.
  
@@ -66,7 +107,8 @@ NSString * const kNoteNotificationInfoKeyAddedNotes;
 - (void)startup:(void(^)(NSError *error))completion;
 
 /**
- Stops all recurring operations.
+ Stops all recurring operations, and saves the note index, digest cache and search index in the background. Saving runs in a background task, so it completes even as the app is being suspended.
+ Must be called on the main queue.
  */
 - (void)shutdown;
 
@@ -77,6 +119,14 @@ NSString * const kNoteNotificationInfoKeyAddedNotes;
  */
 - (NSArray *)visibleNotes;
 
+/**
+ Searches the titles and content of the visible notes. Notes containing the query as typed (or with a few typing errors) come first, followed by notes containing any of its words. The results reflect every change made to the notes before the search.
+ 
+ @param query      The text to search for. The last word also matches words which begin with it, so notes are found as the query is typed.
+ @param completion Called on the main queue with an NSArray of the matching Note objects, best match first.
+ */
+- (void)searchNotes:(NSString *)query completion:(void(^)(NSArray *notes))completion;
+
 /**
  Marks the given note as deleted and removes it from the visible notes.
  The note will be deleted from the filesystem at some time in the future.
@@ -86,7 +136,7 @@ NSString * const kNoteNotificationInfoKeyAddedNotes;
 - (void)markNoteAsDeleted:(Note *)note;
 
 /**
- Performs steps to synchronize with the remote.
+ Requests that a synchronization with the remote is performed as soon as possible. Requests made while a synchronization is in progress are coalesced into a single follow up synchronization.
  First, local changes are uploaded, then local deletes are processed, then changes from the remote are processed.
  Appropriate notifications are posted when changes to the local collections are made.
  This will also toggle the visibility of the UIApplication network activity indicator as needed.
@@ -95,6 +145,37 @@ NSString * const kNoteNotificationInfoKeyAddedNotes;
  */
 - (void)synchronize:(void(^)(NSArray *errors))completion;
 
+/**
+ The remote (Google Drive) folders holding the given note, as learned from the changes retrieved from the remote. Note files themselves are kept at the top level of the documents directory.
+ Must be called on the main queue.
+ 
+ @param note The Note.
+ 
+ @return An NSArray of the titles of the folders from the root (empty if the note is at the root, or has not been synchronized), or `nil` if some folders on the way are not yet known.
+ */
+- (NSArray *)folderPathOfNote:(Note *)note;
+
+/**
+ Informs the manager that the given note has been modified locally, so the change is synchronized soon. If the note's title has changed, it is moved within the visible notes and a notification is posted.
+ 
+ @param note The Note which was modified.
+ */
+- (void)noteWasModified:(Note *)note;
+
+/**
+ Informs the manager which note the user has open, so its transfers take priority over all others.
+ 
+ @param note The Note which was opened, or `nil` if no note is open.
+ */
+- (void)noteWasOpened:(Note *)note;
+
+/**
+ Informs the manager which notes are on screen, so their transfers take priority over those of other notes (other than the open note).
+ 
+ @param notes An NSArray of the Note objects on screen, replacing those previously given.
+ */
+- (void)notesWereDisplayed:(NSArray *)notes;
+
 /**
  Refreshes the local notes with information from the server.
  
@@ -9,6 +9,22 @@
 #import "NoteManager.h"
 #import "GRKFileManager.h"
 #import "NSString+UUID.h"
+#import "NoteIndex.h"
+#import "NoteJournal.h"
+#import "NoteTable.h"
+#import "SyncCheckpoint.h"
+#import "FolderTree.h"
+#import "GRKDigestCache.h"
+#import "GRKDirectoryWatcher.h"
+#import "SyncScheduler.h"
+#import "TransferScheduler.h"
+#import "GRKBlockSignature.h"
+#import "GRKBlobStore.h"
+#import "GRKMerge.h"
+#import "GRKSearchIndex.h"
+#import "GRKTrigramIndex.h"
+#import "GRKNameAllocator.h"
+#import "GRKMetrics.h"
 
 NSString * const NoteManagerErrorDomain = @"NoteManagerErrorDomain";
 
@@ -37,27 +53,133 @@ NSString * const kNoteNotificationInfoKeyUpdatedNotes = @"NoteNotificationInfoKe
  The userInfo key, for a notification, which represents the array of notes which were added.
  */
 NSString * const kNoteNotificationInfoKeyAddedNotes = @"NoteNotificationInfoKeyAddedNotes";
+/**
+ The userInfo key, for a notification, which represents the NSIndexSet of the visible notes which were removed, as indexes into the visible notes before the changes.
+ */
+NSString * const kNoteNotificationInfoKeyDeletedIndexes = @"NoteNotificationInfoKeyDeletedIndexes";
+/**
+ The userInfo key, for a notification, which represents the NSIndexSet of the visible notes which were inserted, as indexes into the visible notes after the changes.
+ A visible note whose title changed is removed from its old index and inserted at its new one.
+ */
+NSString * const kNoteNotificationInfoKeyInsertedIndexes = @"NoteNotificationInfoKeyInsertedIndexes";
+/**
+ The userInfo key, for a notification, which represents the NSIndexSet of the visible notes which were updated in place, as indexes into the visible notes before the changes.
+ */
+NSString * const kNoteNotificationInfoKeyReloadedIndexes = @"NoteNotificationInfoKeyReloadedIndexes";
+/**
+ The userInfo key, for a notification, which represents the GRKSortedSetSnapshot of the visible notes after the changes, which the indexes refer to.
+ */
+NSString * const kNoteNotificationInfoKeyVisibleNotes = @"NoteNotificationInfoKeyVisibleNotes";
 
 //Internals
 
-//Delay between synchronization attempts
+//The shortest and longest intervals between recurring synchronizations
 static NSTimeInterval const kSynchronizationInterval = 5.0f;
+static NSTimeInterval const kMaximumSynchronizationInterval = 300.0f;
 
+//Where the Google Drive change ID was stored before the sync checkpoint, from which it is carried over
 static NSString * const kDefaultsKeyGoogleDriveChangeID = @"google_drive_change_id";
 
+//The number of remote changes retrieved and applied at a time
+static NSUInteger const kRemoteChangesPageSize = 100;
+
+//The most names tried when creating a uniquely named file, should files which are not known notes hold the names it would be given
 static NSUInteger const kMaxUniqueFilenameAttempts = 1000;
 
+static NSString * const kNoteIndexFileName = @"NoteIndex.bin";
+static NSString * const kNoteJournalFileName = @"NoteJournal.log";
+static NSString * const kSyncCheckpointFileName = @"SyncCheckpoint.bin";
+
+//Holds the block signature of the last synchronized content of each note, named by local ID
+static NSString * const kSignaturesDirectoryName = @"Signatures";
+static NSString * const kSignatureFileExtension = @"sig";
+
+//Holds the content of notes as last synchronized, by checksum
+static NSString * const kBlobsDirectoryName = @"Blobs";
+
+//Holds the full text index of note titles and content
+static NSString * const kSearchIndexDirectoryName = @"SearchIndex";
+static NSString * const kTrigramIndexFileName = @"TrigramIndex.bin";
+
+//The most notes a search returns
+static NSUInteger const kSearchResultLimit = 100;
+
+//The most typing errors tolerated in a match of a search
+static NSUInteger const kSearchMaximumErrors = 2;
+
+//The number of directory items each worker processes at a time when scanning for notes
+static NSUInteger const kNoteScanChunkSize = 256;
+
+//Metrics (see GRKMetrics), with durations in microseconds
+static NSString * const kMetricSynchronize = @"sync.total";
+static NSString * const kMetricSynchronizations = @"sync.runs";
+static NSString * const kMetricSynchronizeErrors = @"sync.errors";
+static NSString * const kMetricReap = @"sync.reap";
+static NSString * const kMetricSend = @"sync.send";
+static NSString * const kMetricRefresh = @"sync.refresh";
+static NSString * const kMetricApply = @"sync.apply";
+static NSString * const kMetricDigest = @"sync.digest";
+static NSString * const kMetricMerge = @"sync.merge";
+static NSString * const kMetricReplaceFile = @"sync.replaceFile";
+static NSString * const kMetricNotesSent = @"sync.notes.sent";
+static NSString * const kMetricNotesReaped = @"sync.notes.reaped";
+static NSString * const kMetricNotesAdded = @"sync.notes.added";
+static NSString * const kMetricNotesUpdated = @"sync.notes.updated";
+static NSString * const kMetricNotesDeleted = @"sync.notes.deleted";
+static NSString * const kMetricChangesFailed = @"sync.changes.failed";
+static NSString * const kMetricChangesRetried = @"sync.changes.retried";
+static NSString * const kMetricBytesSaved = @"sync.bytes.saved";
+
+//The signature under which the search index holds a note, so notes whose title or content changed since they were indexed are found
+static NSString *NoteManagerSearchSignature(NSString *MD5, NSString *title)
+{
+    return [NSString stringWithFormat:@"%@ %@", MD5 ?: @"", title ?: @""];
+}
+
 @interface NoteManager ()
 
 //All notes
-@property (nonatomic,strong) NSMutableArray *notes;
-@property (nonatomic,strong) NSMutableArray *mVisibleNotes;
-@property (nonatomic,strong) NSMutableDictionary *notesByRemoteID;
-@property (nonatomic,strong) NSMutableDictionary *notesByLocalID;
+@property (nonatomic,strong) NoteTable *noteTable;
+//Notes which are not deleted, sorted by title, then remote ID, then local ID
+@property (nonatomic,strong) GRKSortedSet *sortedVisibleNotes;
+//Published from the main queue after each change to sortedVisibleNotes, and read from any queue
+@property (atomic,strong,readwrite) GRKSortedSetSnapshot *visibleNotesSnapshot;
 @property (nonatomic,strong) GRKFileManager *grkFileManager;
+@property (nonatomic,strong) NoteIndex *noteIndex;
+//Records note metadata changes in place of extended attribute writes (see Note)
+@property (nonatomic,strong) NoteJournal *journal;
+@property (nonatomic,strong) GRKDirectoryWatcher *directoryWatcher;
+//Hashes the files of each batch of directory events before it is applied, so the main queue finds their checksums in the digest cache
+@property (nonatomic,strong) dispatch_queue_t directoryEventQueue;
 @property (nonatomic,strong,readwrite) GoogleDriveManager *driveManager;
-@property (nonatomic,strong) NSNumber *lastGoogleDriveChangeID;
-@property (nonatomic,assign) BOOL willSynchronize;
+//The Google Drive change ID through which remote changes have been processed, and the changes to try again
+@property (nonatomic,strong) SyncCheckpoint *syncCheckpoint;
+@property (nonatomic,strong,readwrite) SyncScheduler *syncScheduler;
+@property (nonatomic,strong,readwrite) TransferScheduler *transferScheduler;
+//Maps a note key (see enqueueOperationForKey:operation:) to the array of pending operations for that note (the first being the one in progress)
+@property (nonatomic,strong) NSMutableDictionary *noteOperations;
+//Entered for the duration of each remote file creation
+@property (nonatomic,strong) dispatch_group_t remoteCreateGroup;
+//Map a remote file ID to the array of completion blocks waiting on the next batch of trash or restore operations
+@property (nonatomic,strong) NSMutableDictionary *pendingTrashes;
+@property (nonatomic,strong) NSMutableDictionary *pendingRestores;
+@property (nonatomic,strong) NSMutableDictionary *pendingRenames;
+@property (nonatomic,strong) NSURL *signaturesDirectory;
+@property (nonatomic,strong) GRKBlobStore *blobStore;
+@property (nonatomic,strong) GRKSearchIndex *searchIndex;
+//The names of the note files, so new notes are given unused names directly
+@property (nonatomic,strong) GRKNameAllocator *nameAllocator;
+//Finds notes containing a search as typed, or nearly so
+@property (nonatomic,strong) GRKTrigramIndex *trigramIndex;
+//Reads note content for the search indexes, so changes reach them in the order they occur, and runs searches after them
+@property (nonatomic,strong) dispatch_queue_t searchIndexingQueue;
+//The IDs of folders found missing from the folder tree which could not be retrieved (i.e. deleted, or not visible to us), so they are not asked for again this session
+@property (nonatomic,strong) NSMutableSet *unavailableFolderIDs;
+//Digests added to the blob store during this session, which are kept even before a note refers to them (confined to syncedContentQueue)
+@property (nonatomic,strong) NSMutableSet *recordedDigests;
+//Serializes reading and writing of signatures and the blob store
+@property (nonatomic,strong) dispatch_queue_t syncedContentQueue;
+@property (nonatomic,assign,readwrite) unsigned long long uploadBytesSaved;
 
 @end
 
@@ -80,10 +202,90 @@ static NSUInteger const kMaxUniqueFilenameAttempts = 1000;
     {
         self.grkFileManager = [[GRKFileManager alloc] init];
         self.driveManager = [[GoogleDriveManager alloc] init];
-        self.notes = [NSMutableArray array];
-        self.mVisibleNotes = [NSMutableArray array];
-        self.notesByRemoteID = [NSMutableDictionary dictionary];
-        self.notesByLocalID = [NSMutableDictionary dictionary];
+        self.noteTable = [[NoteTable alloc] init];
+        self.sortedVisibleNotes = [[GRKSortedSet alloc] initWithKeyBlock:^id(Note *note) {
+            //A snapshot of the sort properties, since a note's title changes with its file
+            return @[note.title ?: @"", note.remoteID ?: @"", note.localID ?: @""];
+        } comparator:^NSComparisonResult(NSArray *key1, NSArray *key2) {
+            //Sort by note title, and fallback to note remoteID then localID
+            NSComparisonResult retVal = NSOrderedSame;
+            for (NSUInteger i = 0; i < key1.count && retVal == NSOrderedSame; ++i)
+            {
+                retVal = [[key1 objectAtIndex:i] compare:[key2 objectAtIndex:i]];
+            }
+            return retVal;
+        }];
+        self.visibleNotesSnapshot = [self.sortedVisibleNotes snapshot];
+        self.noteOperations = [NSMutableDictionary dictionary];
+        self.remoteCreateGroup = dispatch_group_create();
+        self.pendingTrashes = [NSMutableDictionary dictionary];
+        self.pendingRestores = [NSMutableDictionary dictionary];
+        self.pendingRenames = [NSMutableDictionary dictionary];
+        self.recordedDigests = [NSMutableSet set];
+        self.unavailableFolderIDs = [NSMutableSet set];
+        self.syncedContentQueue = dispatch_queue_create("com.levigroker.GrokinNotes.NoteManager.syncedContent", DISPATCH_QUEUE_SERIAL);
+        self.searchIndexingQueue = dispatch_queue_create("com.levigroker.GrokinNotes.NoteManager.searchIndexing", DISPATCH_QUEUE_SERIAL);
+        self.directoryEventQueue = dispatch_queue_create("com.levigroker.GrokinNotes.NoteManager.directoryEvents", DISPATCH_QUEUE_SERIAL);
+        self.nameAllocator = [[GRKNameAllocator alloc] init];
+        
+        __weak NoteManager *weakSelf = self;
+        self.syncScheduler = [[SyncScheduler alloc] initWithSyncBlock:^(void (^completion)(BOOL changed, NSArray *errors)) {
+            [weakSelf performSynchronize:completion];
+        }];
+        self.syncScheduler.minimumInterval = kSynchronizationInterval;
+        self.syncScheduler.maximumInterval = kMaximumSynchronizationInterval;
+        self.transferScheduler = [[TransferScheduler alloc] init];
+        
+        NSURL *privateDir = [self.grkFileManager privateDocumentsDirectory];
+        //Without a private documents directory the checkpoint is only held in memory
+        self.syncCheckpoint = [[SyncCheckpoint alloc] initWithURL:[privateDir URLByAppendingPathComponent:kSyncCheckpointFileName]];
+        if (privateDir)
+        {
+            self.noteIndex = [[NoteIndex alloc] initWithURL:[privateDir URLByAppendingPathComponent:kNoteIndexFileName]];
+            
+            //NOTE: This assumes all notes are stored at the top level of the documents directory
+            self.journal = [[NoteJournal alloc] initWithURL:[privateDir URLByAppendingPathComponent:kNoteJournalFileName] directory:[self.grkFileManager documentsDirectory]];
+            [Note setJournal:self.journal];
+            
+            NSURL *signaturesDirectory = [privateDir URLByAppendingPathComponent:kSignaturesDirectoryName isDirectory:YES];
+            __autoreleasing NSError *error = nil;
+            if ([self.grkFileManager.fileManager createDirectoryAtURL:signaturesDirectory withIntermediateDirectories:YES attributes:nil error:&error])
+            {
+                self.signaturesDirectory = signaturesDirectory;
+            }
+            else
+            {
+                DDLogError(@"Unable to create the signatures directory. Notes will always be uploaded in full. Error: %@", error);
+            }
+            
+            self.blobStore = [[GRKBlobStore alloc] initWithDirectory:[privateDir URLByAppendingPathComponent:kBlobsDirectoryName isDirectory:YES] error:&error];
+            if (!self.blobStore)
+            {
+                DDLogError(@"Unable to create the blob store. Synchronized content will not be kept. Error: %@", error);
+            }
+            
+            self.searchIndex = [[GRKSearchIndex alloc] initWithDirectory:[privateDir URLByAppendingPathComponent:kSearchIndexDirectoryName isDirectory:YES] error:&error];
+            if (!self.searchIndex)
+            {
+                DDLogError(@"Unable to create the search index. Notes can not be searched. Error: %@", error);
+            }
+            
+            //Loaded ahead of any indexing or searching
+            GRKTrigramIndex *trigramIndex = [[GRKTrigramIndex alloc] initWithURL:[privateDir URLByAppendingPathComponent:kTrigramIndexFileName]];
+            self.trigramIndex = trigramIndex;
+            dispatch_async(self.searchIndexingQueue, ^{
+                __autoreleasing NSError *loadError = nil;
+                if (![trigramIndex load:&loadError])
+                {
+                    DDLogWarn(@"Unable to load trigram index. Notes will be indexed again. Error: %@", loadError);
+                }
+            });
+        }
+        else
+        {
+            DDLogError(@"Unable to locate the private documents directory. Notes will be loaded without an index.");
+            self.trigramIndex = [[GRKTrigramIndex alloc] init];
+        }
     }
     
     return self;
@@ -95,12 +297,18 @@ static NSUInteger const kMaxUniqueFilenameAttempts = 1000;
 {
     NSError *driveManagerError = [self.driveManager startup];
     
-    //Fetch any stored Google Drive change ID
-    self.lastGoogleDriveChangeID = [[NSUserDefaults standardUserDefaults] objectForKey:kDefaultsKeyGoogleDriveChangeID];
+    //Fetch the stored sync checkpoint
+    [self loadSyncCheckpoint];
     
     //Update our knowlege of notes from the local file system
     [self updateNotesWithCompletion:^{
         
+        //Pick up changes made to the note files by others (i.e. iTunes File Sharing) as they happen
+        [self startWatching];
+        
+        //Drop synchronized content which was left behind by notes since deleted
+        [self collectUnusedBlobs];
+        
         if (!driveManagerError)
         {
             //Start ongoing synchronization operations
@@ -114,746 +322,1908 @@ static NSUInteger const kMaxUniqueFilenameAttempts = 1000;
 - (void)shutdown
 {
     [self stopSynchronize];
+    [self stopWatching];
+    
+    //We are called as the app enters the background, so ask for the time to finish saving before the app is suspended
+    UIApplication *application = [UIApplication sharedApplication];
+    __block UIBackgroundTaskIdentifier backgroundTask = UIBackgroundTaskInvalid;
+    void(^endBackgroundTask)(void) = ^{
+        if (backgroundTask != UIBackgroundTaskInvalid)
+        {
+            [application endBackgroundTask:backgroundTask];
+            backgroundTask = UIBackgroundTaskInvalid;
+        }
+    };
+    backgroundTask = [application beginBackgroundTaskWithExpirationHandler:^{
+        DDLogWarn(@"Ran out of background time before saving completed.");
+        endBackgroundTask();
+    }];
+    
+    dispatch_group_t saveGroup = dispatch_group_create();
+    [self saveNoteIndexInGroup:saveGroup];
+    [self saveDigestCacheInGroup:saveGroup];
+    [self saveSearchIndexInGroup:saveGroup];
+    dispatch_group_notify(saveGroup, dispatch_get_main_queue(), ^{
+        DDLogVerbose(@"Completed saving on shutdown.");
+        endBackgroundTask();
+    });
 }
 
 - (NSArray *)visibleNotes
 {
-    if (!self.mVisibleNotes)
-    {
-        self.mVisibleNotes = [NSMutableArray array];
-        for (Note *note in self.notes)
+    return [self.visibleNotesSnapshot allObjects];
+}
+
+- (void)searchNotes:(NSString *)query completion:(void(^)(NSArray *notes))completion
+{
+    GRKSearchIndex *searchIndex = self.searchIndex;
+    GRKTrigramIndex *trigramIndex = self.trigramIndex;
+    //Run after any indexing already requested, so the results reflect the latest edits
+    dispatch_async(self.searchIndexingQueue, ^{
+        //Notes containing the query as typed come first, then notes containing any of its words
+        NSMutableOrderedSet *localIDs = [NSMutableOrderedSet orderedSetWithArray:[trigramIndex identifiersMatchingQuery:query maximumErrors:kSearchMaximumErrors limit:kSearchResultLimit]];
+        if (localIDs.count < kSearchResultLimit)
         {
-            if (!note.deleted)
+            for (NSString *localID in [searchIndex identifiersMatchingQuery:query limit:kSearchResultLimit])
             {
-                [self.mVisibleNotes addObject:note];
+                if (localIDs.count < kSearchResultLimit)
+                {
+                    [localIDs addObject:localID];
+                }
             }
         }
-    }
-    
-    return [self.mVisibleNotes copy];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSMutableArray *notes = [NSMutableArray arrayWithCapacity:localIDs.count];
+            for (NSString *localID in localIDs)
+            {
+                Note *note = [self.noteTable noteWithLocalID:localID];
+                if (note && !note.deleted)
+                {
+                    [notes addObject:note];
+                }
+            }
+            if (completion)
+            {
+                completion(notes);
+            }
+        });
+    });
 }
 
 - (void)markNoteAsDeleted:(Note *)note
 {
     [note writeDeleted:YES];
-    if (self.mVisibleNotes)
-    {
-        [self.mVisibleNotes removeObject:note];
-    }
+    [self unindexNotes:@[note]];
+    NSDictionary *changes = [self updateVisibleNotesWithDeletedNotes:@[note] updatedNotes:nil addedNotes:nil];
 
     //Post a notification informing subscribers that the note has been deleted
-    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:changes];
     [userInfo setObject:@[note] forKey:kNoteNotificationInfoKeyDeletedNotes];
     [[NSNotificationCenter defaultCenter] postNotificationName:kNoteNotificationNoteChanges object:self userInfo:userInfo];
 }
 
 - (void)synchronize:(void(^)(NSArray *errors))completion
+{
+    //Coalesced with any other synchronization requests
+    [self.syncScheduler requestSynchronization:completion];
+}
+
+- (NSArray *)folderPathOfNote:(Note *)note
+{
+    NSArray *retVal = @[];
+    if (note.remoteID)
+    {
+        retVal = [self.syncCheckpoint.folderTree pathOfFileWithID:note.remoteID];
+    }
+    return retVal;
+}
+
+- (void)noteWasOpened:(Note *)note
+{
+    //Transfers of the open note go ahead of all others
+    [self.transferScheduler setKeys:(note.localID ? [NSSet setWithObject:note.localID] : nil) forPriority:TransferPriorityOpen];
+}
+
+- (void)notesWereDisplayed:(NSArray *)notes
+{
+    NSMutableSet *keys = [NSMutableSet setWithCapacity:notes.count];
+    for (Note *note in notes)
+    {
+        if (note.localID)
+        {
+            [keys addObject:note.localID];
+        }
+    }
+    [self.transferScheduler setKeys:keys forPriority:TransferPriorityVisible];
+}
+
+- (void)noteWasModified:(Note *)note
+{
+    //Ensure we are on the main queue
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self indexNotes:@[note]];
+        //The title is the name of the note's file
+        [self recordNamesOfNotes:@[note]];
+        
+        //A new title moves the note within the visible notes
+        if ([self.sortedVisibleNotes keyHasChangedForObject:note])
+        {
+            NSDictionary *changes = [self updateVisibleNotesWithDeletedNotes:nil updatedNotes:@[note] addedNotes:nil];
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:changes];
+            [userInfo setObject:@[note] forKey:kNoteNotificationInfoKeyUpdatedNotes];
+            [[NSNotificationCenter defaultCenter] postNotificationName:kNoteNotificationNoteChanges object:self userInfo:userInfo];
+        }
+        [self.syncScheduler localChangeOccurred];
+    });
+}
+
+/**
+ Performs one synchronization with the remote. Use `synchronize:` to request a synchronization, which coordinates with the SyncScheduler.
+ @param completion Called on the main queue when the synchronization completes, with `changed` indicating if there were any local changes to send, or remote changes which were applied to notes or folders, and an array of NSError objects which may have occurred (the array will be `nil` if no errors occurred).
+ */
+- (void)performSynchronize:(void(^)(BOOL changed, NSArray *errors))completion
 {
     NSMutableArray *allErrors = [NSMutableArray array];
+    GRKMetrics *metrics = [GRKMetrics sharedMetrics];
+    uint64_t start = GRKMetricsTime();
+    
+    //Anything to send to the remote?
+    BOOL localChanges = [self.noteTable containsNotesWithAnyFlags:NoteTableFlagDirty | NoteTableFlagDeleted];
+    //The change ID is account wide, so it moves with activity which has nothing to do with our notes. Only the changes applied count.
+    __block BOOL remoteChanges = NO;
     
     [[UIApplication sharedApplication] setNetworkActivityIndicatorVisible:YES];
 
+    //The phases run concurrently. Operations on the same note are kept in order by note (see enqueueOperationForKey:operation:), and since the local phases queue their operations first, remote changes to a note are applied after the local changes to that note have been sent.
+    //Each phase is timed from the start of the synchronization to its completion
+    dispatch_group_t syncGroup = dispatch_group_create();
+    
     DDLogVerbose(@"Synchronize: Reaping deleted notes...");
+    dispatch_group_enter(syncGroup);
     [self reapDeletedNotes:^(NSArray *errors) {
-        DDLogVerbose(@"Synchronize: Updating changes to remote...");
+        [metrics recordTimeSince:start inHistogramNamed:kMetricReap];
         [allErrors addObjectsFromArray:errors];
-        [self updateDirtyNotes:^(NSArray *errors) {
-            [allErrors addObjectsFromArray:errors];
-            DDLogVerbose(@"Synchronize: Refreshing with changes from remote...");
-            [self refreshFromRemote:^(NSArray *errors) {
-                [allErrors addObjectsFromArray:errors];
-                [[UIApplication sharedApplication] setNetworkActivityIndicatorVisible:NO];
-                if (errors)
-                {
-                    DDLogError(@"Synchronize: Failed attempt with %@ error%@: %@", @(errors.count), errors.count == 1 ? @"" : @"s", errors);
-                }
-                else
-                {
-                    DDLogVerbose(@"Synchronize: Complete.");
-                }
-                
-                if (completion)
-                {
-                    completion(errors);
-                }
-            }];
-        }];
+        dispatch_group_leave(syncGroup);
+    }];
+    
+    DDLogVerbose(@"Synchronize: Updating changes to remote...");
+    dispatch_group_enter(syncGroup);
+    [self updateDirtyNotes:^(NSArray *errors) {
+        [metrics recordTimeSince:start inHistogramNamed:kMetricSend];
+        [allErrors addObjectsFromArray:errors];
+        dispatch_group_leave(syncGroup);
+    }];
+    
+    DDLogVerbose(@"Synchronize: Refreshing with changes from remote...");
+    dispatch_group_enter(syncGroup);
+    [self refreshFromRemoteReportingChanges:^(BOOL changed, NSArray *errors) {
+        [metrics recordTimeSince:start inHistogramNamed:kMetricRefresh];
+        remoteChanges = changed;
+        [allErrors addObjectsFromArray:errors];
+        dispatch_group_leave(syncGroup);
     }];
+    
+    dispatch_group_notify(syncGroup, dispatch_get_main_queue(), ^{
+        [[UIApplication sharedApplication] setNetworkActivityIndicatorVisible:NO];
+        [metrics recordTimeSince:start inHistogramNamed:kMetricSynchronize];
+        [metrics incrementCounterNamed:kMetricSynchronizations by:1];
+        [metrics incrementCounterNamed:kMetricSynchronizeErrors by:allErrors.count];
+        if (allErrors.count > 0)
+        {
+            DDLogError(@"Synchronize: Failed attempt with %@ error%@: %@", @(allErrors.count), allErrors.count == 1 ? @"" : @"s", allErrors);
+        }
+        else
+        {
+            DDLogVerbose(@"Synchronize: Complete.");
+        }
+        DDLogVerbose(@"Synchronize: Transfers (open: %@) (visible: %@) (background: %@)", [self.transferScheduler statisticsForPriority:TransferPriorityOpen], [self.transferScheduler statisticsForPriority:TransferPriorityVisible], [self.transferScheduler statisticsForPriority:TransferPriorityBackground]);
+        DDLogVerbose(@"Synchronize: %llu bytes of unchanged content not uploaded.", self.uploadBytesSaved);
+        DDLogVerbose(@"Synchronize: Metrics:\n%@", [metrics snapshot]);
+        
+        if (completion)
+        {
+            completion(localChanges || remoteChanges, allErrors.count > 0 ? allErrors : nil);
+        }
+    });
 }
 
 - (void)refreshFromRemote:(void(^)(NSArray *errors))completion
+{
+    [self refreshFromRemoteReportingChanges:^(BOOL changed, NSArray *errors) {
+        if (completion)
+        {
+            completion(errors);
+        }
+    }];
+}
+
+/**
+ Refreshes the local notes with the changes from the remote, as `refreshFromRemote:` does.
+ @param completion Called on the main queue once the refresh completes, with `changed` indicating if any remote change was applied to notes or folders, and an array of NSError objects which may have occurred (the array will be `nil` if no errors occurred).
+ */
+- (void)refreshFromRemoteReportingChanges:(void(^)(BOOL changed, NSArray *errors))completion
 {
     //Ensure we are on the main queue
     dispatch_async(dispatch_get_main_queue(), ^{
 
         NSNumber *startChangeID = nil;
-        if (self.lastGoogleDriveChangeID)
+        if (self.syncCheckpoint.changeID)
         {
             //Increment the change ID to +1 so we start with new changes...
-            startChangeID = [NSNumber numberWithLongLong:[self.lastGoogleDriveChangeID longLongValue] + 1];
+            startChangeID = [NSNumber numberWithLongLong:[self.syncCheckpoint.changeID longLongValue] + 1];
         }
-    
-        [self.driveManager retrieveAllChangesSinceChangeID:startChangeID completion:^(NSArray *changes, NSNumber *largestChangeID, NSError *error) {
-
-            NSMutableArray *errors = [NSMutableArray array];
-            if (error)
-            {
-                [errors addObject:error];
-            }
-            
-            //Create a dispatch group to track subtask completion
-            dispatch_group_t updateGroup = dispatch_group_create();
-
-            NSMutableArray *deletedNotes = [NSMutableArray array];
-            NSMutableArray *newNotes = [NSMutableArray array];
-            NSMutableArray *updatedNotes = [NSMutableArray array];
-            
-            //Iterate over the changes in order, since they will be returned in the order they occurred
-            for (GTLDriveChange *change in changes)
-            {
-                //The ID of the file associated with this change.
-                NSString *fileID = change.fileId;
-                //The actual file (if it is available (i.e. not deleted))
-                GTLDriveFile *file = change.file;
-                //Look up our local note by ID
-                Note *note = [self.notesByRemoteID objectForKey:fileID];
-                
-                BOOL deleted = [change.deleted boolValue];
-                BOOL trashed = [file.labels.trashed boolValue];
+        
+        NSMutableArray *allErrors = [NSMutableArray array];
+        __block BOOL anyChanged = NO;
+        
+        //Process the changes a page at a time, so a large backlog of changes is never held in memory all at once
+        [self.driveManager enumerateChangesSinceChangeID:startChangeID pageSize:kRemoteChangesPageSize pageHandler:^(NSArray *changes, NSNumber *checkpointChangeID, BOOL lastPage, void (^next)(BOOL proceed)) {
+            DDLogVerbose(@"Processing page of %@ remote change%@ (checkpoint: %@)...", @(changes.count), changes.count == 1 ? @"" : @"s", checkpointChangeID);
+            [self applyRemoteChanges:changes completion:^(BOOL changed, NSArray *errors, NSArray *failedChanges) {
+                anyChanged = anyChanged || changed;
+                if (errors)
+                {
+                    [allErrors addObjectsFromArray:errors];
+                }
                 
-                if (deleted || trashed)
+                if (![self.syncCheckpoint hasRoomForFailedChanges:failedChanges])
                 {
-                    DDLogVerbose(@"Remote file %@ with ID '%@' local note: '%@'", deleted ? @"deleted" : @"trashed", fileID, note);
-                    
-                    //If the note is dirty locally.
-                    if (note.dirty)
-                    {
-                        DDLogWarn(@"Local note has changes. Ignoring update from remote.");
-                        if (trashed)
-                        {
-                            //We choose to restore the remote version, and let the remote note be updated with the local changes
-                            [self.driveManager restoreFileWithID:fileID completion:^(GTLDriveFile *file, NSError *error) {
-                                if (error)
-                                {
-                                    DDLogError(@"Unable to restore note: '%@'. Error: %@", note, error);
-                                }
-                            }];
-                        }
-                    }
-                    else
-                    {
-                        //The local note is not dirty, so we can just delete it
-                        //The note object may also just be nil (not tracked locally)
-                        if (note)
-                        {
-                            //Attempt to delete the local file (if this fails, we sill remove the note from our data structures)
-                            [self deleteLocalFile:note.file];
-                            
-                            //Track the deleted note for additional processing
-                            [deletedNotes addObject:note];
-                            
-                            DDLogVerbose(@"Deleted note: '%@'", note);
-                        }
-                    }
+                    //Too many changes are failing to try each again on its own, so stop here and try again from the last checkpoint
+                    next(NO);
                 }
                 else
                 {
-                    //The note has updates and there are no local changes (or no local note)...
-                    
-                    //Only want text files
-                    if ([file.mimeType isEqualToString:kMIMETypeTextPlain])
-                    {
-                        DDLogVerbose(@"Update avaialble from remote for remote file ID '%@'. Local note: '%@'", fileID, note);
-                        
-                        if (note.dirty)
-                        {
-                            DDLogWarn(@"Local note has changes. Ignoring update from remote.");
-                        }
-                        else
-                        {
-                            NSString *remoteMD5 = file.md5Checksum;
-                            NSString *localMD5 = nil;
-                            BOOL contentMatch = (remoteMD5 && (localMD5 = [note MD5]) && [remoteMD5 isEqualToString:localMD5]);
-                            
-                            if (contentMatch)
-                            {
-                                //If the content is the same, there's no need to download the file.
-                                DDLogVerbose(@"Remote content matches local content (checksums: remote: '%@' local: '%@').", remoteMD5, localMD5);
-                                
-                                BOOL titleMatch = [note.title isEqualToString:file.title];
-                                if (!titleMatch)
-                                {
-                                    DDLogVerbose(@"Remote title '%@' differs from local title '%@'", file.title, note.title);
-
-                                    //Update the local title
-                                    NSURL *newFile = [[note.file URLByDeletingLastPathComponent] URLByAppendingPathComponent:file.title];
-                                    __autoreleasing NSError *error = nil;
-                                    BOOL success = [self.grkFileManager.fileManager moveItemAtURL:note.file toURL:newFile error:&error];
-                                    if (success)
-                                    {
-                                        note.file = newFile;
-                                        //Track the updated note for additional processing
-                                        [updatedNotes addObject:note];
-                                    }
-                                    else
-                                    {
-                                        //TODO: Assuming the error is due to a name conflic, we could possibly retry renaming with a unique name.
-                                        //This is problematic, however, since Google Drive allows for files with the same title, and we are trying
-                                        //to retain title to file name parody. If we want to allow for localID as filename (with title as an attribute)
-                                        //then this would be a non-issue (except the user might be presented with the localID filename in the app
-                                        //documents directory which is not ideal).
-                                        [errors addObject:error];
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                //Download the updated note into a temp directory
-                                NSURL *tempDir = [self.grkFileManager tempDirectory];
-                                //Track this dispatch to completion
-                                dispatch_group_enter(updateGroup);
-                                [self.driveManager downloadFile:file toFolder:tempDir completion:^(GTLDriveFile *file, NSURL *fileURL, NSError *error) {
-                                    if (error)
-                                    {
-                                        [errors addObject:error];
-                                    }
-
-                                    //Could have been made dirty while we were fetching changes
-                                    if (note.dirty)
-                                    {
-                                        DDLogWarn(@"Local note has changes. Ignoring update from remote.");
-                                        //Discard remote changes (still in temp dir, so we don't care if this fails)
-                                        [self deleteLocalFile:fileURL];
-                                    }
-                                    else
-                                    {
-                                        if (note)
-                                        {
-                                            DDLogVerbose(@"Existing note being updated: '%@'", note);
-                                            
-                                            //Move the note into place
-                                            __autoreleasing NSError *error = nil;
-                                            NSURL *resultingItemURL = [self.grkFileManager replaceFile:note.file withFile:fileURL error:&error];
-                                            if (resultingItemURL)
-                                            {
-                                                //Save the note metadata, which is associated with the old file
-                                                NSString *localID = note.localID;
-                                                NSString *remoteID = note.remoteID;
-                                                //Set the note's file to the new file (this will update the note's medatata with that from the file, which will not exist)
-                                                note.file = resultingItemURL;
-                                                //Repopulate the file's medatata
-                                                [note writeLocalID:localID];
-                                                [note writeRemoteID:remoteID];
-
-                                                //Track the updated note for additional processing
-                                                [updatedNotes addObject:note];
-
-                                                DDLogVerbose(@"Updated note: '%@'", note);
-                                            }
-                                            else
-                                            {
-                                                DDLogError(@"Unable to relocate updated note file to destination directory. Error: %@", error);
-                                                if (error)
-                                                {
-                                                    [errors addObject:error];
-                                                }
-                                            }
-                                        }
-                                        else
-                                        {
-                                            //We don't have the note locally yet, so create it.
-                                            DDLogVerbose(@"No local note. Creating one from remote file: %@", file);
-
-                                            //TODO: We are not paying attention to the driveFile's parent hierarchy, and simply flattenting the structure. We should create the needed hierarchy to correctly place the file locally.
-                                            //NOTE: This assumes all notes are stored at the top level of the documents directory
-                                            NSURL *documentsDir = [self.grkFileManager documentsDirectory];
-                                            NSString *title = file.title;
-                                            NSURL *noteFile = [documentsDir URLByAppendingPathComponent:title];
-
-                                            //Move the note into place
-                                            __autoreleasing NSError *error = nil;
-                                            BOOL success = [self.grkFileManager.fileManager moveItemAtURL:fileURL toURL:noteFile error:&error];
-                                            if (success)
-                                            {
-                                                Note *newNote = [[Note alloc] init];
-                                                newNote.file = noteFile;
-                                                [newNote writeLocalID:[NSString UUID]];
-                                                [newNote writeRemoteID:file.identifier];
-                                                
-                                                //Track the new note for additional processing
-                                                [newNotes addObject:newNote];
-
-                                                DDLogVerbose(@"Created note: '%@'", newNote);
-                                            }
-                                            else
-                                            {
-                                                DDLogError(@"Unable to relocate new note file to destination directory. Error: %@", error);
-                                                if (error)
-                                                {
-                                                    [errors addObject:error];
-                                                }
-                                            }
-                                        }
-                                    }
-                                    
-                                    //Exit the dispatch group
-                                    dispatch_group_leave(updateGroup);
-                                    
-                                }]; //end downloadFile
-                            } //end else if contentMatch
-                        }
-                    }
-                    else
+                    //The changes which failed are tried again on their own, so the checkpoint moves past them and the changes which were applied are not processed again
+                    [self recordOutcomeOfRemoteChanges:changes failedChanges:failedChanges];
+                    if (checkpointChangeID)
                     {
-                        DDLogVerbose(@"Ignoring update from remote file (of type '%@' (expecting '%@')). File: %@", file.mimeType, kMIMETypeTextPlain, file);
+                        self.syncCheckpoint.changeID = checkpointChangeID;
                     }
+                    [self saveSyncCheckpoint];
+                    next(YES);
                 }
-            } //end change for loop
+            }];
+        } completion:^(NSNumber *largestChangeID, NSError *error) {
+            if (error)
+            {
+                DDLogError(@"Unable to retrieve changes from remote. Error: %@", error);
+                [allErrors addObject:error];
+            }
             
-            DDLogVerbose(@"Waiting for refresh action to complete...");
-            dispatch_group_notify(updateGroup, dispatch_get_main_queue(), ^{
-                DDLogVerbose(@"Completed refresh actions.");
-                if (errors.count > 0)
-                {
-                    DDLogError(@"%@ (%@) occurred during the refresh process. %@", errors.count == 1 ? @"An error" : @"Errors", @(errors.count), errors);
-                }
-                else
+            //Now that later changes have had their turn, try again the changes which are due
+            [self retryFailedRemoteChanges:^(BOOL changed, NSArray *errors) {
+                anyChanged = anyChanged || changed;
+                if (errors)
                 {
-                    //We only want to save the updated ID if successfull, so we can try again to get the changes
-                    if (largestChangeID)
-                    {
-                        self.lastGoogleDriveChangeID = largestChangeID;
-                        //Store the change ID so we only update deltas since last refresh
-                        [[NSUserDefaults standardUserDefaults]  setObject:self.lastGoogleDriveChangeID forKey:kDefaultsKeyGoogleDriveChangeID];
-                    }
+                    [allErrors addObjectsFromArray:errors];
                 }
-
-                //Update our data structures with the changes
                 
-                BOOL deletes = deletedNotes.count > 0;
-                BOOL updates = updatedNotes.count > 0;
-                BOOL additions = newNotes.count > 0;
-                
-                //Deletes
-                if (deletes)
-                {
-                    [self.notes removeObjectsInArray:deletedNotes];
-                    [self.notesByRemoteID removeObjectsForKeys:[deletedNotes valueForKey:@"remoteID"]];
-                    [self.notesByLocalID removeObjectsForKeys:[deletedNotes valueForKey:@"localID"]];
-                    //Only need to manage the removal of notes from mVisibleNotes if we have no additions (if we have additions, the mVisibleNotes array will be discarded).
-                    if (!additions)
+                //Learn the folders holding notes which the changes did not describe
+                [self retrieveMissingFolders:^(NSArray *errors) {
+                    if (errors)
                     {
-                        [self.mVisibleNotes removeObjectsInArray:deletedNotes];
+                        [allErrors addObjectsFromArray:errors];
                     }
-                }
-                
-                //Additions
-                if (additions)
-                {
-                    self.mVisibleNotes = nil; //Cause the visible note array to be rebuilt, since we are adding new items (may change sort order)
-                    [self.notes addObjectsFromArray:newNotes];
-                    [self sortNotes:self.notes];
-                    for (Note *note in newNotes)
+                    
+                    if (completion)
                     {
-                        if (note.remoteID)
-                        {
-                            [self.notesByRemoteID setObject:note forKey:note.remoteID];
-                        }
-                        if (note.localID)
-                        {
-                            [self.notesByLocalID setObject:note forKey:note.localID];
-                        }
+                        completion(anyChanged, allErrors.count > 0 ? allErrors : nil);
                     }
-                }
-                
-                if (deletes || updates || additions)
-                {
-                    //Post a notification informing subscribers that there are changes for the notes
-                    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:3];
-                    [userInfo setValue:deletedNotes forKey:kNoteNotificationInfoKeyDeletedNotes];
-                    [userInfo setValue:updatedNotes forKey:kNoteNotificationInfoKeyUpdatedNotes];
-                    [userInfo setValue:newNotes forKey:kNoteNotificationInfoKeyAddedNotes];
-                    [[NSNotificationCenter defaultCenter] postNotificationName:kNoteNotificationNoteChanges object:self userInfo:userInfo];
-                }
-
-                if (completion)
-                {
-                    completion(errors.count > 0 ? errors : nil);
-                }
-            }); //End group notify
-            
-        }]; //End of retrieve
+                }];
+            }];
+        }];
     });
 }
 
-- (void)createNewUniqueNote:(void(^)(Note *note, NSError *error))completion
+/**
+ Applies a set of changes from the remote to our local notes, downloading content as needed, and posts a notification describing the resulting changes.
+ Must be called on the main queue.
+ @param changes    An NSArray of GTLDriveChange objects, in the order they occurred.
+ @param completion Called on the main queue once the changes have been applied, with `changed` indicating if any of them changed notes or folders, an array of NSError objects which may have occurred (the array will be `nil` if no errors occurred), and an array of the GTLDriveChange objects which failed to apply.
+ */
+- (void)applyRemoteChanges:(NSArray *)changes completion:(void(^)(BOOL changed, NSArray *errors, NSArray *failedChanges))completion
 {
-    //Ensure we are on the main queue
-    dispatch_async(dispatch_get_main_queue(), ^{
+    NSMutableArray *errors = [NSMutableArray array];
+    NSMutableArray *failedChanges = [NSMutableArray array];
+    uint64_t start = GRKMetricsTime();
+    
+    //Create a dispatch group to track subtask completion
+    dispatch_group_t updateGroup = dispatch_group_create();
 
-        //NOTE: This assumes all notes are stored at the top level of the documents directory
-        NSURL *documentsDir = [self.grkFileManager documentsDirectory];
-        __autoreleasing NSError *fileError = nil;
-        NSURL *file = [self uniqueFileInDirectory:documentsDir error:&fileError];
-        if (file)
+    NSMutableArray *deletedNotes = [NSMutableArray array];
+    NSMutableArray *newNotes = [NSMutableArray array];
+    NSMutableArray *updatedNotes = [NSMutableArray array];
+    NSMutableSet *changedFileIDs = [NSMutableSet set];
+    
+    //Iterate over the changes in order, since they will be returned in the order they occurred
+    //Changes are ordered with any other operations on the same note (see orderRemoteChangeForFileID:operation:), but changes to different notes are applied concurrently
+    for (GTLDriveChange *change in changes)
+    {
+        //Track this change to completion
+        dispatch_group_enter(updateGroup);
+        [self orderRemoteChangeForFileID:change.fileId operation:^(void (^done)(void)) {
+            dispatch_group_t changeGroup = dispatch_group_create();
+            //Kept apart from the errors of other changes, so a failed change can be tried again on its own
+            NSMutableArray *changeErrors = [NSMutableArray array];
+            [self applyRemoteChange:change updateGroup:changeGroup errors:changeErrors deletedNotes:deletedNotes newNotes:newNotes updatedNotes:updatedNotes changedFileIDs:changedFileIDs];
+            dispatch_group_notify(changeGroup, dispatch_get_main_queue(), ^{
+                if (changeErrors.count > 0)
+                {
+                    [errors addObjectsFromArray:changeErrors];
+                    [failedChanges addObject:change];
+                }
+                done();
+                dispatch_group_leave(updateGroup);
+            });
+        }];
+    } //end change for loop
+    
+    DDLogVerbose(@"Waiting for refresh action to complete...");
+    dispatch_group_notify(updateGroup, dispatch_get_main_queue(), ^{
+        DDLogVerbose(@"Completed refresh actions.");
+        GRKMetrics *metrics = [GRKMetrics sharedMetrics];
+        [metrics recordTimeSince:start inHistogramNamed:kMetricApply];
+        [metrics incrementCounterNamed:kMetricNotesDeleted by:deletedNotes.count];
+        [metrics incrementCounterNamed:kMetricNotesUpdated by:updatedNotes.count];
+        [metrics incrementCounterNamed:kMetricNotesAdded by:newNotes.count];
+        [metrics incrementCounterNamed:kMetricChangesFailed by:failedChanges.count];
+        if (errors.count > 0)
         {
-            Note *note = [[Note alloc] init];
-            note.file = file;
-            [note writeLocalID:[NSString UUID]];
-            [note writeDirty:YES];
+            DDLogError(@"%@ (%@) occurred during the refresh process. %@", errors.count == 1 ? @"An error" : @"Errors", @(errors.count), errors);
+        }
 
-            [self.notes addObject:note];
-            [self sortNotes:self.notes];
-            self.mVisibleNotes = nil; //Cause our visible notes to be rebuilt since the sort order may have changed.
+        //Update our data structures with the changes
+        
+        BOOL deletes = deletedNotes.count > 0;
+        BOOL updates = updatedNotes.count > 0;
+        BOOL additions = newNotes.count > 0;
+        
+        //Deletes (the note table already reflects the deletes and additions, see applyRemoteChange:updateGroup:errors:deletedNotes:newNotes:updatedNotes:changedFileIDs:)
+        if (deletes)
+        {
+            [self forgetSyncedContentOfNotes:deletedNotes];
+            [self unindexNotes:deletedNotes];
+            [self forgetJournaledMetadataOfNotes:deletedNotes];
+            [self forgetNamesOfNotes:deletedNotes];
+        }
+        
+        if (deletes || updates || additions)
+        {
+            [self indexNotes:updatedNotes];
+            [self indexNotes:newNotes];
+            //Updated notes may have been renamed
+            [self recordNamesOfNotes:updatedNotes];
+            [self recordNamesOfNotes:newNotes];
             
-            if (note.remoteID)
-            {
-                [self.notesByRemoteID setObject:note forKey:note.remoteID];
-            }
-            if (note.localID)
-            {
-                [self.notesByLocalID setObject:note forKey:note.localID];
-            }
-            DDLogVerbose(@"Created new note: '%@'", note);
+            //Move the changed notes into place among the visible notes
+            NSDictionary *changes = [self updateVisibleNotesWithDeletedNotes:deletedNotes updatedNotes:updatedNotes addedNotes:newNotes];
             
-            //Post a notification informing subscribers that the note has been created
-            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
-            [userInfo setObject:@[note] forKey:kNoteNotificationInfoKeyAddedNotes];
+            //Post a notification informing subscribers that there are changes for the notes
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:changes];
+            [userInfo setValue:deletedNotes forKey:kNoteNotificationInfoKeyDeletedNotes];
+            [userInfo setValue:updatedNotes forKey:kNoteNotificationInfoKeyUpdatedNotes];
+            [userInfo setValue:newNotes forKey:kNoteNotificationInfoKeyAddedNotes];
             [[NSNotificationCenter defaultCenter] postNotificationName:kNoteNotificationNoteChanges object:self userInfo:userInfo];
-                
-            if (completion)
-            {
-                completion(note, nil);
-            }
         }
-        else
+
+        if (completion)
         {
-            if (completion)
-            {
-                NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
-                [userInfo setObject:NSLocalizedString(@"Odd, I could not create a new note for you.", nil) forKey:NSLocalizedDescriptionKey];
-                [userInfo setValue:fileError forKey:NSUnderlyingErrorKey];
-                NSError *error = [[NSError alloc] initWithDomain:NoteManagerErrorDomain code:NoteManagerErrorBadCreate userInfo:userInfo];
-                
-                completion(nil, error);
-            }
+            completion(deletes || updates || additions || changedFileIDs.count > 0, errors.count > 0 ? errors : nil, failedChanges);
         }
-    });
+    }); //End group notify
 }
 
-#pragma mark - Recurring Operations
-
-- (void)startSynchronize
+/**
+ Applies again the remote changes which failed to apply before and are due to be tried again, and records the outcome in the sync checkpoint.
+ Must be called on the main queue.
+ @param completion Called on the main queue once the changes have been applied, with `changed` indicating if any of them changed notes or folders, and an array of NSError objects which may have occurred (the array will be `nil` if no errors occurred).
+ */
+- (void)retryFailedRemoteChanges:(void(^)(BOOL changed, NSArray *errors))completion
 {
-    if (!self.willSynchronize)
+    NSArray *changes = [self.syncCheckpoint dueFailedChanges];
+    if (changes.count > 0)
+    {
+        DDLogVerbose(@"Retrying %@ remote change%@ which failed to apply...", @(changes.count), changes.count == 1 ? @"" : @"s");
+        [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricChangesRetried by:changes.count];
+        [self applyRemoteChanges:changes completion:^(BOOL changed, NSArray *errors, NSArray *failedChanges) {
+            [self recordOutcomeOfRemoteChanges:changes failedChanges:failedChanges];
+            [self saveSyncCheckpoint];
+            if (completion)
+            {
+                completion(changed, errors);
+            }
+        }];
+    }
+    else if (completion)
     {
-        DDLogVerbose(@"Synchronize: Started recurring process.");
-        self.willSynchronize = YES;
-        [self recurringSynchronize];
+        completion(NO, nil);
     }
 }
 
-- (void)recurringSynchronize
+/**
+ Retrieves the folders which hold known folders or notes, but which have not been seen in the changes from the remote (such as folders unchanged since before the folder tree was kept), and records them in the folder tree. Continues up the hierarchy until every folder is known, or can not be retrieved.
+ Folders which the remote refuses for good (missing, forbidden, malformed IDs and the like) are logged and not asked for again this session, without failing the synchronization. Only transient failures are reported as errors, and are tried again on the next synchronization.
+ Must be called on the main queue.
+ @param completion Called on the main queue once done, with an array of NSError objects which may have occurred (the array will be `nil` if no errors occurred).
+ */
+- (void)retrieveMissingFolders:(void(^)(NSArray *errors))completion
 {
-    [self synchronize:^(NSArray *errors) {
-        DDLogVerbose(@"Synchronize: Waiting (%.2f seconds) for next attempt.", kSynchronizationInterval);
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kSynchronizationInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
-            if (self.willSynchronize)
+    FolderTree *folderTree = self.syncCheckpoint.folderTree;
+    NSMutableSet *folderIDs = [[folderTree missingFolderIDs] mutableCopy];
+    [folderIDs minusSet:self.unavailableFolderIDs];
+    if (folderIDs.count == 0)
+    {
+        completion(nil);
+        return;
+    }
+    
+    DDLogVerbose(@"Retrieving %@ missing remote folder%@...", @(folderIDs.count), folderIDs.count == 1 ? @"" : @"s");
+    [self.driveManager retrieveFilesWithIDs:[folderIDs allObjects] completion:^(NSDictionary *files, NSDictionary *errors) {
+        NSMutableArray *allErrors = [NSMutableArray array];
+        BOOL recorded = NO;
+        for (NSString *folderID in folderIDs)
+        {
+            GTLDriveFile *folder = [files objectForKey:folderID];
+            NSError *error = [errors objectForKey:folderID];
+            if (folder && [self.driveManager isFolder:folder] && ![folder.labels.trashed boolValue])
             {
-                [self recurringSynchronize];
+                [folderTree setFolderWithID:folderID title:folder.title parentID:[self.driveManager parentIDOfFile:folder]];
+                recorded = YES;
             }
-            else
+            else if (folder)
             {
-                DDLogVerbose(@"Synchronize: Stopped recurring process.");
+                DDLogVerbose(@"Remote folder with ID '%@' is not available.", folderID);
+                [self.unavailableFolderIDs addObject:folderID];
             }
-        });
+            else if ([self isPersistentFolderError:error])
+            {
+                //Asking again will not help, so the folder is left out of the folder tree
+                DDLogWarn(@"Remote folder with ID '%@' is not available. Error: %@", folderID, error);
+                [self.unavailableFolderIDs addObject:folderID];
+            }
+            else if (error)
+            {
+                DDLogError(@"Unable to retrieve remote folder with ID '%@'. Error: %@", folderID, error);
+                [allErrors addObject:error];
+            }
+        }
+        
+        if (recorded)
+        {
+            [self saveSyncCheckpoint];
+            //The folders retrieved may themselves be within missing folders
+            [self retrieveMissingFolders:^(NSArray *errors) {
+                if (errors)
+                {
+                    [allErrors addObjectsFromArray:errors];
+                }
+                completion(allErrors.count > 0 ? allErrors : nil);
+            }];
+        }
+        else
+        {
+            completion(allErrors.count > 0 ? allErrors : nil);
+        }
     }];
 }
 
-- (void)stopSynchronize
+/**
+ Determines if an error retrieving a remote folder will recur however often the folder is asked for.
+ @param error The NSError from retrieving the folder.
+ @return `YES` for client errors of the folder itself (HTTP 4xx), other than those of the authorization (401), a timeout (408) or a rate limit (429).
+ */
+- (BOOL)isPersistentFolderError:(NSError *)error
 {
-    self.willSynchronize = NO;
+    BOOL retVal = NO;
+    if ([error.domain isEqualToString:kGTLJSONRPCErrorDomain])
+    {
+        NSInteger code = error.code;
+        retVal = code >= 400 && code < 500 && code != 401 && code != 408 && code != 429;
+    }
+    return retVal;
 }
 
-#pragma mark - Helpers
-
-- (NSURL *)uniqueFileInDirectory:(NSURL *)directory error:(__autoreleasing NSError **)error
+/**
+ Records in the sync checkpoint which of the given changes were applied, and which failed and are to be tried again.
+ @param changes       An NSArray of the GTLDriveChange objects which were applied, in the order they occurred.
+ @param failedChanges An NSArray of those of the changes which failed to apply.
+ */
+- (void)recordOutcomeOfRemoteChanges:(NSArray *)changes failedChanges:(NSArray *)failedChanges
 {
-    NSURL *retVal = nil;
-
-    NSString *content = [NSString string];
-    NSData *data = [content dataUsingEncoding:NSUTF8StringEncoding];
-    BOOL success = NO;
-    NSUInteger i = 0;
-    while (!success) {
-        NSString *name = [NSString stringWithFormat:@"%@%@", NSLocalizedString(@"Untitled", nil), i++ == 0 ? @"" : [NSString stringWithFormat:@" %@", @(i)]];
-        NSURL *file = [directory URLByAppendingPathComponent:name];
-        __autoreleasing NSError *writeError = nil;
-        success = [data writeToURL:file options:NSDataWritingWithoutOverwriting error:&writeError];
-        if (success)
+    NSSet *failed = [NSSet setWithArray:failedChanges];
+    for (GTLDriveChange *change in changes)
+    {
+        if ([failed containsObject:change])
         {
-            retVal = file;
+            [self.syncCheckpoint recordFailedChange:change];
         }
         else
         {
-            if (i > kMaxUniqueFilenameAttempts)
-            {
-                if (error)
-                {
-                    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
-                    [userInfo setObject:[NSString stringWithFormat:@"%@ (%@) %@", NSLocalizedString(@"The maximum number of attempts", nil), @(kMaxUniqueFilenameAttempts), NSLocalizedString(@"was reached before success.", nil)] forKey:NSLocalizedDescriptionKey];
-                    [userInfo setValue:writeError forKey:NSUnderlyingErrorKey];
-                    *error = [[NSError alloc] initWithDomain:NoteManagerErrorDomain code:NoteManagerErrorTooManyAttempts userInfo:userInfo];
-                }
-                break;
-            }
+            [self.syncCheckpoint recordAppliedChange:change];
         }
     }
-
-    return retVal;
+    if (failedChanges.count > 0)
+    {
+        DDLogWarn(@"%@ remote change%@ failed to apply, and will be tried again. %@ change%@ waiting to be tried again.", @(failedChanges.count), failedChanges.count == 1 ? @"" : @"s", @(self.syncCheckpoint.failedChangeCount), self.syncCheckpoint.failedChangeCount == 1 ? @" is" : @"s are");
+    }
 }
 
-- (void)updateNotesWithCompletion:(void(^)(void))completion
+/**
+ Applies a single change from the remote to our local notes.
+ Must be called on the main queue.
+ @param change       The GTLDriveChange to apply.
+ @param updateGroup  A dispatch group which is entered for the duration of any asynchronous work (i.e. downloads) needed to apply the change.
+ @param errors       Receives any errors which occur.
+ @param deletedNotes Receives any notes which were deleted.
+ @param newNotes     Receives any notes which were created.
+ @param updatedNotes Receives any notes which were updated.
+ @param changedFileIDs Receives the IDs of any folders which changed, and of any files which moved between folders.
+ */
+- (void)applyRemoteChange:(GTLDriveChange *)change updateGroup:(dispatch_group_t)updateGroup errors:(NSMutableArray *)errors deletedNotes:(NSMutableArray *)deletedNotes newNotes:(NSMutableArray *)newNotes updatedNotes:(NSMutableArray *)updatedNotes changedFileIDs:(NSMutableSet *)changedFileIDs
 {
-    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-        //NOTE: This assumes all notes are stored at the top level of the documents directory
-        NSURL *documentsDir = [self.grkFileManager documentsDirectory];
-        NSMutableArray *notes = [NSMutableArray arrayWithArray:[self fetchNotesFromDirectory:documentsDir]];
-        
-        [self sortNotes:notes];
-
-        NSMutableDictionary *notesByRemoteID = [NSMutableDictionary dictionary];
-        NSMutableDictionary *notesByLocalID = [NSMutableDictionary dictionary];
-        for (Note *note in notes)
+    //The ID of the file associated with this change.
+    NSString *fileID = change.fileId;
+    //The actual file (if it is available (i.e. not deleted))
+    GTLDriveFile *file = change.file;
+    //Look up our local note by ID
+    Note *note = [self.noteTable noteWithRemoteID:fileID];
+    
+    BOOL deleted = [change.deleted boolValue];
+    BOOL trashed = [file.labels.trashed boolValue];
+    FolderTree *folderTree = self.syncCheckpoint.folderTree;
+    
+    if ([self.driveManager isFolder:file] || (!file && [folderTree containsFolderWithID:fileID]))
+    {
+        //Folders only shape the folder tree (see folderPathOfNote:)
+        if (deleted || trashed)
         {
-            NSString *localID = note.localID;
-            //If we don't have a local ID, then create one, since we must track this note.
-            if (!localID)
+            DDLogVerbose(@"Remote folder %@ with ID '%@'", deleted ? @"deleted" : @"trashed", fileID);
+            if ([folderTree removeFolderWithID:fileID])
             {
-                [note writeLocalID:[NSString UUID]];
-                localID = note.localID;
+                [changedFileIDs addObject:fileID];
             }
-            //Update local ID note map
-            if (localID)
+        }
+        else
+        {
+            DDLogVerbose(@"Remote folder '%@' with ID '%@' changed", file.title, fileID);
+            if ([folderTree setFolderWithID:fileID title:file.title parentID:[self.driveManager parentIDOfFile:file]])
             {
-                [notesByLocalID setObject:note forKey:localID];
+                [changedFileIDs addObject:fileID];
             }
-
-            //Update remote ID note map
-            NSString *remoteID = note.remoteID;
-            if (remoteID)
+        }
+    }
+    else if (note.deleted)
+    {
+        //The note is being deleted locally (see reapDeletedNotes:), which takes precedence
+        DDLogVerbose(@"Ignoring change from remote for note being deleted: '%@'", note);
+    }
+    else if (deleted || trashed)
+    {
+        DDLogVerbose(@"Remote file %@ with ID '%@' local note: '%@'", deleted ? @"deleted" : @"trashed", fileID, note);
+        
+        //If the note is dirty locally.
+        if (note.dirty)
+        {
+            DDLogWarn(@"Local note has changes. Ignoring update from remote.");
+            if (trashed)
             {
-                [notesByRemoteID setObject:note forKey:remoteID];
+                //We choose to restore the remote version, and let the remote note be updated with the local changes
+                [self restoreRemoteFileWithID:fileID completion:^(GTLDriveFile *file, NSError *error) {
+                    if (error)
+                    {
+                        DDLogError(@"Unable to restore note: '%@'. Error: %@", note, error);
+                    }
+                }];
             }
         }
-        
-        //Update our properties on the main queue
-        dispatch_async(dispatch_get_main_queue(), ^{
-            [self.notes removeAllObjects];
-            [self.notes addObjectsFromArray:notes];
-            self.mVisibleNotes = nil;
-            [self.notesByRemoteID removeAllObjects];
-            [self.notesByRemoteID addEntriesFromDictionary:notesByRemoteID];
-            [self.notesByLocalID removeAllObjects];
-            [self.notesByLocalID addEntriesFromDictionary:notesByLocalID];
-            if (completion)
+        else
+        {
+            //The local note is not dirty, so we can just delete it
+            [folderTree setParentID:nil ofFileWithID:fileID];
+            
+            //The note object may also just be nil (not tracked locally)
+            if (note)
             {
-                completion();
+                //Attempt to delete the local file (if this fails, we sill remove the note from our data structures)
+                [self deleteLocalFile:note.file];
+                //Removed from the note table with its file, so the directory watcher does not take the deletion for the user's (see applyDirectoryEvents:)
+                [self.noteTable removeNotes:@[note]];
+                
+                //Track the deleted note for additional processing
+                [deletedNotes addObject:note];
+                
+                DDLogVerbose(@"Deleted note: '%@'", note);
             }
-        });
-    });
-}
-
-- (void)updateDirtyNotes:(void(^)(NSArray *errors))completion
-{
-    //Ensure we are on the main queue
-    dispatch_async(dispatch_get_main_queue(), ^{
-        //Create a dispatch group to track all parts of the update to completion
-        dispatch_group_t updateGroup = dispatch_group_create();
-        
-        NSMutableArray *errors = [NSMutableArray array];
+        }
+    }
+    else
+    {
+        //The note has updates (any local changes are merged with them, see mergeRemoteFile:atURL:intoNote:errors:newNotes:updatedNotes:completion:)
         
-        for (Note *note in self.notes)
+        //Only want text files
+        if ([self.driveManager isNoteFile:file])
         {
-            if (note.dirty)
+            DDLogVerbose(@"Update avaialble from remote for remote file ID '%@'. Local note: '%@'", fileID, note);
+            if ([folderTree setParentID:[self.driveManager parentIDOfFile:file] ofFileWithID:fileID])
             {
-                DDLogVerbose(@"Processing locally dirty note: %@", note);
-                
-                //Capture the checksum before we attempt an update of the remote
-                NSString *oldMD5 = [note updateMD5];
+                [changedFileIDs addObject:fileID];
+            }
+            
+            NSString *remoteMD5 = file.md5Checksum;
+            
+            if (note.dirty && remoteMD5 && [remoteMD5 isEqualToString:[note readSyncedMD5]])
+            {
+                //The remote content has not changed since the note was last synchronized (this is often our own update), so only the local side has changes
+                DDLogVerbose(@"Local note has changes, and remote content is unchanged. Ignoring update from remote.");
+            }
+            else if (note.dirty && remoteMD5 && [remoteMD5 isEqualToString:[note MD5]])
+            {
+                //Both sides made the same change, so there is nothing to merge
+                DDLogVerbose(@"Local note has changes which match the remote content (checksum: '%@'). Ignoring update from remote.", remoteMD5);
+            }
+            else
+            {
+                NSString *localMD5 = nil;
+                BOOL contentMatch = (!note.dirty && remoteMD5 && (localMD5 = [note MD5]) && [remoteMD5 isEqualToString:localMD5]);
                 
-                if (note.remoteID)
+                if (contentMatch)
                 {
-                    DDLogVerbose(@"Updating existing remote note from local note %@", note);
+                    //If the content is the same, there's no need to download the file.
+                    DDLogVerbose(@"Remote content matches local content (checksums: remote: '%@' local: '%@').", remoteMD5, localMD5);
                     
-                    //Note exists remotely, so update it.
-                    GTLDriveFile *file = [GTLDriveFile object];
-                    file.identifier = note.remoteID;
-                    file.mimeType = kMIMETypeTextPlain;
-                    file.title = note.title;
-                    //Track this dispatch to completion
-                    dispatch_group_enter(updateGroup);
-                    [self.driveManager updateDriveFile:file fromFileURL:note.file completion:^(GTLDriveFile *updatedFile, NSError *error) {
-                        if (error)
+                    BOOL titleMatch = [note.title isEqualToString:file.title];
+                    if (!titleMatch)
+                    {
+                        DDLogVerbose(@"Remote title '%@' differs from local title '%@'", file.title, note.title);
+
+                        //Update the local title
+                        NSURL *newFile = [[note.file URLByDeletingLastPathComponent] URLByAppendingPathComponent:file.title];
+                        __autoreleasing NSError *error = nil;
+                        BOOL success = [self.grkFileManager.fileManager moveItemAtURL:note.file toURL:newFile error:&error];
+                        if (success)
                         {
-                            DDLogError(@"Unable to update remote file for note '%@'. Error: %@", note, error);
-                            [errors addObject:error];
+                            note.file = newFile;
+                            //Track the updated note for additional processing
+                            [updatedNotes addObject:note];
                         }
                         else
                         {
-                            //Is the title different?
-                            BOOL dirty = ![note.title isEqualToString:updatedFile.title];
-                            if (!dirty)
-                            {
-                                //Compare checksums (file content)
-                                NSString *newMD5 = [note updateMD5];
-                                dirty = ![oldMD5 isEqualToString:newMD5];
-                            }
-                            [note writeDirty:dirty];
-                            
-                            DDLogVerbose(@"Updated existing remote note from local note %@", note);
+                            //TODO: Assuming the error is due to a name conflic, we could possibly retry renaming with a unique name.
+                            //This is problematic, however, since Google Drive allows for files with the same title, and we are trying
+                            //to retain title to file name parody. If we want to allow for localID as filename (with title as an attribute)
+                            //then this would be a non-issue (except the user might be presented with the localID filename in the app
+                            //documents directory which is not ideal).
+                            [errors addObject:error];
                         }
-                        //Exit the dispatch group
-                        dispatch_group_leave(updateGroup);
-                    }];
+                    }
                 }
                 else
                 {
-                    DDLogVerbose(@"Creating new remote note from local note %@", note);
-                    
-                    //Note is only local, so create it remotely.
-                    //TODO: Specify a parent folder
-                    //Track this dispatch to completion
-                    dispatch_group_enter(updateGroup);
-                    [self.driveManager createFile:note.file withMIMEType:kMIMETypeTextPlain inFolder:nil completion:^(GTLDriveFile *createdFile, NSError *error) {
+                    //Called with the updated note in a temp directory
+                    void(^downloaded)(GTLDriveFile *file, NSURL *fileURL, NSError *error) = ^(GTLDriveFile *file, NSURL *fileURL, NSError *error) {
                         if (error)
                         {
-                            DDLogError(@"Unable to create remote file for note '%@'. Error: %@", note, error);
                             [errors addObject:error];
                         }
+
+                        //Could have been made dirty while we were fetching changes
+                        if (note.dirty && !error)
+                        {
+                            //Both sides have changed since the note was last synchronized
+                            [self mergeRemoteFile:file atURL:fileURL intoNote:note errors:errors newNotes:newNotes updatedNotes:updatedNotes completion:^{
+                                //Exit the dispatch group
+                                dispatch_group_leave(updateGroup);
+                            }];
+                        }
+                        else if (note.dirty)
+                        {
+                            DDLogWarn(@"Local note has changes. Ignoring update from remote.");
+                            //Discard remote changes (still in temp dir, so we don't care if this fails)
+                            [self deleteLocalFile:fileURL];
+                            //Exit the dispatch group
+                            dispatch_group_leave(updateGroup);
+                        }
                         else
                         {
-                            //Track the remote identifier
-                            NSString *remoteID = createdFile.identifier;
-                            [note writeRemoteID:remoteID];
-                            [self.notesByRemoteID setObject:note forKey:remoteID];
+                            //The downloaded content is what the remote has
+                            NSData *syncedContent = fileURL ? [NSData dataWithContentsOfURL:fileURL options:0 error:nil] : nil;
                             
-                            //The note may have been modified locally while we were trying to update the remote
-                            
-                            //Is the title different?
-                            BOOL dirty = ![note.title isEqualToString:createdFile.title];
-                            if (!dirty)
+                            if (note)
+                            {
+                                DDLogVerbose(@"Existing note being updated: '%@'", note);
+                                
+                                //Move the note into place
+                                __autoreleasing NSError *error = nil;
+                                if ([self replaceFileOfNote:note withFile:fileURL error:&error])
+                                {
+                                    [self recordSyncedContent:syncedContent ofNote:note];
+
+                                    //Track the updated note for additional processing
+                                    [updatedNotes addObject:note];
+
+                                    DDLogVerbose(@"Updated note: '%@'", note);
+                                }
+                                else
+                                {
+                                    DDLogError(@"Unable to relocate updated note file to destination directory. Error: %@", error);
+                                    if (error)
+                                    {
+                                        [errors addObject:error];
+                                    }
+                                }
+                            }
+                            else
                             {
-                                //Compare checksums (file content)
-                                NSString *newMD5 = [note updateMD5];
-                                dirty = ![oldMD5 isEqualToString:newMD5];
+                                //We don't have the note locally yet, so create it.
+                                DDLogVerbose(@"No local note. Creating one from remote file: %@", file);
+
+                                //NOTE: Note files are kept at the top level of the documents directory. The folder holding the remote file is tracked by the folder tree instead (see folderPathOfNote:).
+                                NSURL *documentsDir = [self.grkFileManager documentsDirectory];
+                                NSString *title = file.title;
+                                NSURL *noteFile = [documentsDir URLByAppendingPathComponent:title];
+
+                                //Move the note into place
+                                __autoreleasing NSError *error = nil;
+                                BOOL success = [self.grkFileManager.fileManager moveItemAtURL:fileURL toURL:noteFile error:&error];
+                                if (success)
+                                {
+                                    Note *newNote = [[Note alloc] init];
+                                    newNote.file = noteFile;
+                                    [newNote writeLocalID:[NSString UUID]];
+                                    [newNote writeRemoteID:file.identifier];
+                                    [self recordSyncedContent:syncedContent ofNote:newNote];
+                                    //Added to the note table with its file, so the directory watcher does not take the file for a new one (see applyDirectoryEvents:)
+                                    [self.noteTable addNotes:@[newNote]];
+                                    
+                                    //Track the new note for additional processing
+                                    [newNotes addObject:newNote];
+
+                                    DDLogVerbose(@"Created note: '%@'", newNote);
+                                }
+                                else
+                                {
+                                    DDLogError(@"Unable to relocate new note file to destination directory. Error: %@", error);
+                                    if (error)
+                                    {
+                                        [errors addObject:error];
+                                    }
+                                }
                             }
-                            [note writeDirty:dirty];
                             
-                            DDLogVerbose(@"Created new remote note from local note %@", note);
+                            //Exit the dispatch group
+                            dispatch_group_leave(updateGroup);
                         }
-                        //Exit the dispatch group
-                        dispatch_group_leave(updateGroup);
-                    }];
-                }
+                    }; //end downloaded
+                    
+                    NSURL *tempDir = [self.grkFileManager tempDirectory];
+                    //Track this dispatch to completion
+                    dispatch_group_enter(updateGroup);
+                    //The content may already be here, as the synchronized content of this or another note
+                    NSURL *localCopy = [self copyOfContentWithMD5:remoteMD5 named:file.title inFolder:tempDir];
+                    if (localCopy)
+                    {
+                        DDLogVerbose(@"Remote content for note '%@' found in the blob store (checksum: '%@'). Skipping download.", note, remoteMD5);
+                        downloaded(file, localCopy, nil);
+                    }
+                    else
+                    {
+                        //Download the updated note into a temp directory
+                        [self.transferScheduler enqueueTransferForKey:note.localID ?: fileID direction:TransferDirectionDownload operation:^(void (^done)(BOOL success, unsigned long long bytesTransferred)) {
+                            [self.driveManager downloadFile:file toFolder:tempDir completion:^(GTLDriveFile *file, NSURL *fileURL, NSError *error) {
+                                done(error == nil, [file.fileSize unsignedLongLongValue]);
+                                downloaded(file, fileURL, error);
+                            }];
+                        }];
+                    }
+                } //end else if contentMatch
             }
         }
-        
-        DDLogVerbose(@"Waiting for all updateDirtyNotes actions to complete...");
-        dispatch_group_notify(updateGroup, dispatch_get_main_queue(), ^{
-            DDLogVerbose(@"Completed updateDirtyNotes actions.");
-            if (completion)
-            {
-                completion(errors.count > 0 ? errors : nil);
-            }
-        });
-    });
+        else
+        {
+            DDLogVerbose(@"Ignoring update from remote file (of type '%@' (expecting '%@')). File: %@", file.mimeType, kMIMETypeTextPlain, file);
+        }
+    }
 }
 
-- (void)reapDeletedNotes:(void(^)(NSArray *errors))completion
+- (void)createNewUniqueNote:(void(^)(Note *note, NSError *error))completion
 {
     //Ensure we are on the main queue
     dispatch_async(dispatch_get_main_queue(), ^{
-        //Create a dispatch group to track all parts of the update to completion
-        dispatch_group_t updateGroup = dispatch_group_create();
-        
-        NSMutableArray *errors = [NSMutableArray array];
-        
-        //Copy our current note array in case it changes under us
-        NSArray *notes = [self.notes copy];
-        
-        NSMutableArray *deletedNotes = [NSMutableArray array];
-        
-        for (Note *note in notes)
+
+        //NOTE: This assumes all notes are stored at the top level of the documents directory
+        NSURL *documentsDir = [self.grkFileManager documentsDirectory];
+        __autoreleasing NSError *fileError = nil;
+        NSURL *file = [self uniqueFileInDirectory:documentsDir baseName:NSLocalizedString(@"Untitled", nil) content:[NSData data] error:&fileError];
+        if (file)
         {
-            if (note.deleted)
-            {
-                if (note.remoteID)
-                {
-                    //The file exists remotely
-                    //Track this dispatch to completion
-                    dispatch_group_enter(updateGroup);
-                    [self.driveManager trashFileWithID:note.remoteID completion:^(GTLDriveFile *file, NSError *error) {
-                        if (error)
-                        {
-                            DDLogError(@"Unable to move remote file to trash for note '%@'. Error: %@", note, error);
-                            [errors addObject:error];
-                        }
-                        else
+            Note *note = [[Note alloc] init];
+            note.file = file;
+            [note writeLocalID:[NSString UUID]];
+            [note writeDirty:YES];
+
+            [self.noteTable addNotes:@[note]];
+            [self recordNamesOfNotes:@[note]];
+            NSDictionary *changes = [self updateVisibleNotesWithDeletedNotes:nil updatedNotes:nil addedNotes:@[note]];
+            [self indexNotes:@[note]];
+            DDLogVerbose(@"Created new note: '%@'", note);
+            [self.syncScheduler localChangeOccurred];
+            
+            //Post a notification informing subscribers that the note has been created
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:changes];
+            [userInfo setObject:@[note] forKey:kNoteNotificationInfoKeyAddedNotes];
+            [[NSNotificationCenter defaultCenter] postNotificationName:kNoteNotificationNoteChanges object:self userInfo:userInfo];
+                
+            if (completion)
+            {
+                completion(note, nil);
+            }
+        }
+        else
+        {
+            if (completion)
+            {
+                NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
+                [userInfo setObject:NSLocalizedString(@"Odd, I could not create a new note for you.", nil) forKey:NSLocalizedDescriptionKey];
+                [userInfo setValue:fileError forKey:NSUnderlyingErrorKey];
+                NSError *error = [[NSError alloc] initWithDomain:NoteManagerErrorDomain code:NoteManagerErrorBadCreate userInfo:userInfo];
+                
+                completion(nil, error);
+            }
+        }
+    });
+}
+
+#pragma mark - Recurring Operations
+
+- (void)startSynchronize
+{
+    [self.syncScheduler start];
+}
+
+- (void)stopSynchronize
+{
+    [self.syncScheduler stop];
+}
+
+- (void)startWatching
+{
+    if (!self.directoryWatcher)
+    {
+        //NOTE: This assumes all notes are stored at the top level of the documents directory
+        NSURL *documentsDir = [self.grkFileManager documentsDirectory];
+        GRKDirectoryListingOptions options = GRKDirectoryListingSkipsHiddenFiles | GRKDirectoryListingRegularFilesOnly | GRKDirectoryListingReadableWritableOnly;
+        self.directoryWatcher = [[GRKDirectoryWatcher alloc] initWithDirectory:documentsDir options:options backend:nil];
+    }
+    
+    __weak NoteManager *weakSelf = self;
+    dispatch_queue_t directoryEventQueue = self.directoryEventQueue;
+    __autoreleasing NSError *error = nil;
+    BOOL success = [self.directoryWatcher startWithHandler:^(NSArray *events) {
+        //The batches pass through a serial queue, so they are still applied in order
+        dispatch_async(directoryEventQueue, ^{
+            GRKDigestCache *digestCache = [GRKDigestCache sharedCache];
+            for (GRKDirectoryWatcherEvent *event in events)
+            {
+                if (event.type != GRKDirectoryWatcherEventDeleted)
+                {
+                    [digestCache MD5ForFile:event.fileURL];
+                }
+            }
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [weakSelf applyDirectoryEvents:events];
+            });
+        });
+    } error:&error];
+    if (success)
+    {
+        DDLogVerbose(@"Watching for local changes in '%@'.", self.directoryWatcher.directory);
+    }
+    else
+    {
+        DDLogError(@"Unable to watch for local changes in '%@'. Error: %@", self.directoryWatcher.directory, error);
+    }
+}
+
+- (void)stopWatching
+{
+    [self.directoryWatcher stop];
+}
+
+#pragma mark - Helpers
+
+/**
+ Creates a new file with the given content and a name not already used in the given directory: the base name, or the base name followed by a number.
+ The name is the first one not used by a known note (see `recordNamesOfNotes:`), so it is normally found on the first attempt. The file is created exclusively, so should the name be in use by some other file the next unused name is tried.
+ @param directory The directory in which to create the file.
+ @param baseName  The name of the file, before any number is added.
+ @param data      The content of the file.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+ @return The file URL of the new file, or `nil` if no file could be created.
+ */
+- (NSURL *)uniqueFileInDirectory:(NSURL *)directory baseName:(NSString *)baseName content:(NSData *)data error:(__autoreleasing NSError **)error
+{
+    NSURL *retVal = nil;
+
+    NSMutableSet *takenNames = [NSMutableSet set];
+    __autoreleasing NSError *writeError = nil;
+    while (!retVal && takenNames.count < kMaxUniqueFilenameAttempts)
+    {
+        NSString *name = [self.nameAllocator unusedNameWithBaseName:baseName excludingNames:takenNames];
+        NSURL *file = [directory URLByAppendingPathComponent:name];
+        if ([data writeToURL:file options:NSDataWritingWithoutOverwriting error:&writeError])
+        {
+            retVal = file;
+        }
+        else
+        {
+            [takenNames addObject:name];
+        }
+    }
+
+    if (!retVal && error)
+    {
+        NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
+        [userInfo setObject:[NSString stringWithFormat:@"%@ (%@) %@", NSLocalizedString(@"The maximum number of attempts", nil), @(kMaxUniqueFilenameAttempts), NSLocalizedString(@"was reached before success.", nil)] forKey:NSLocalizedDescriptionKey];
+        [userInfo setValue:writeError forKey:NSUnderlyingErrorKey];
+        *error = [[NSError alloc] initWithDomain:NoteManagerErrorDomain code:NoteManagerErrorTooManyAttempts userInfo:userInfo];
+    }
+
+    return retVal;
+}
+
+/**
+ Records the names of the files of the given notes as in use, replacing any names recorded for them before. Must be called on the main queue.
+ @param notes An NSArray of Note objects. Can be nil.
+ */
+- (void)recordNamesOfNotes:(NSArray *)notes
+{
+    for (Note *note in notes)
+    {
+        [self.nameAllocator setName:[note.file lastPathComponent] forObject:note];
+    }
+}
+
+/**
+ Forgets the names of the files of the given notes, which are no longer tracked. Must be called on the main queue.
+ @param notes An NSArray of Note objects. Can be nil.
+ */
+- (void)forgetNamesOfNotes:(NSArray *)notes
+{
+    for (Note *note in notes)
+    {
+        [self.nameAllocator setName:nil forObject:note];
+    }
+}
+
+/**
+ Saves the note index, after compacting the journal, in the background.
+ Must be called on the main queue.
+ @param group The dispatch group which tracks the save to completion.
+ */
+- (void)saveNoteIndexInGroup:(dispatch_group_t)group
+{
+    NoteIndex *noteIndex = self.noteIndex;
+    if (noteIndex)
+    {
+        //Snapshot the notes on the current (main) queue, and write the index in the background
+        NSArray *notes = [self.noteTable allNotes];
+        NoteJournal *journal = self.journal;
+        dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+            //Compact first, since writing the extended attributes changes the file statistics recorded in the index
+            [journal compact];
+            __autoreleasing NSError *error = nil;
+            if (![noteIndex saveNotes:notes error:&error])
+            {
+                DDLogError(@"Unable to save note index. Error: %@", error);
+            }
+        });
+    }
+}
+
+- (void)loadSyncCheckpoint
+{
+    if (self.syncCheckpoint.url)
+    {
+        __autoreleasing NSError *error = nil;
+        if (![self.syncCheckpoint load:&error])
+        {
+            DDLogError(@"Unable to read sync checkpoint. All remote changes will be retrieved again. Error: %@", error);
+        }
+    }
+    
+    //Carry over a change ID stored before there was a sync checkpoint
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSNumber *storedChangeID = [defaults objectForKey:kDefaultsKeyGoogleDriveChangeID];
+    if (storedChangeID)
+    {
+        if (!self.syncCheckpoint.changeID)
+        {
+            self.syncCheckpoint.changeID = storedChangeID;
+        }
+        if ([self saveSyncCheckpoint])
+        {
+            [defaults removeObjectForKey:kDefaultsKeyGoogleDriveChangeID];
+        }
+    }
+}
+
+- (BOOL)saveSyncCheckpoint
+{
+    BOOL retVal = NO;
+    if (self.syncCheckpoint.url)
+    {
+        __autoreleasing NSError *error = nil;
+        retVal = [self.syncCheckpoint save:&error];
+        if (!retVal)
+        {
+            DDLogError(@"Unable to save sync checkpoint. Error: %@", error);
+        }
+    }
+    return retVal;
+}
+
+/**
+ Saves the full text and trigram indexes, after any pending indexing.
+ @param group The dispatch group which tracks the save to completion.
+ */
+- (void)saveSearchIndexInGroup:(dispatch_group_t)group
+{
+    GRKSearchIndex *searchIndex = self.searchIndex;
+    GRKTrigramIndex *trigramIndex = self.trigramIndex;
+    //After any pending indexing
+    dispatch_group_async(group, self.searchIndexingQueue, ^{
+        __autoreleasing NSError *error = nil;
+        if (searchIndex && ![searchIndex save:&error])
+        {
+            DDLogError(@"Unable to save search index. Error: %@", error);
+        }
+        if (trigramIndex.url && ![trigramIndex save:&error])
+        {
+            DDLogError(@"Unable to save trigram index. Error: %@", error);
+        }
+    });
+}
+
+/**
+ Saves the digest cache in the background.
+ @param group The dispatch group which tracks the save to completion.
+ */
+- (void)saveDigestCacheInGroup:(dispatch_group_t)group
+{
+    NSURL *documentsDir = [self.grkFileManager documentsDirectory];
+    dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        GRKDigestCache *digestCache = [GRKDigestCache sharedCache];
+        DDLogVerbose(@"Digest cache: %@ hits, %@ misses.", @(digestCache.hits), @(digestCache.misses));
+        //Only note files are hashed, so drop the entries of files which have gone from the documents directory
+        [digestCache pruneFilesNotInDirectory:documentsDir];
+        __autoreleasing NSError *error = nil;
+        if (![digestCache save:&error])
+        {
+            DDLogError(@"Unable to save digest cache. Error: %@", error);
+        }
+    });
+}
+
+- (void)updateNotesWithCompletion:(void(^)(void))completion
+{
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        //Load the index of note metadata, so we can avoid reading the metadata of each file which has not changed
+        __autoreleasing NSError *indexError = nil;
+        if (self.noteIndex && ![self.noteIndex load:&indexError])
+        {
+            DDLogWarn(@"Unable to load note index. Falling back to reading note files. Error: %@", indexError);
+        }
+        
+        //Replay the metadata changes recorded since the journal was last compacted, which take precedence over the index and the note files
+        __autoreleasing NSError *journalError = nil;
+        if (self.journal && ![self.journal replay:&journalError])
+        {
+            DDLogError(@"Unable to replay note journal. Recent metadata changes may be lost. Error: %@", journalError);
+        }
+        
+        //NOTE: This assumes all notes are stored at the top level of the documents directory
+        NSURL *documentsDir = [self.grkFileManager documentsDirectory];
+        NSUInteger indexedCount = 0;
+        NSArray *notes = [self fetchNotesFromDirectory:documentsDir indexedCount:&indexedCount];
+        DDLogVerbose(@"Loaded %@ of %@ notes from the note index.", @(indexedCount), @(notes.count));
+        
+        //Write the replayed metadata to the note files, so both agree with the index saved below
+        NSUInteger compactedCount = [self.journal compact];
+        
+        //Bring the index up to date if any note had to be read from its file, notes have gone away, or metadata was compacted
+        if (self.noteIndex && (indexedCount != notes.count || self.noteIndex.count != notes.count || compactedCount > 0))
+        {
+            __autoreleasing NSError *saveError = nil;
+            if (![self.noteIndex saveNotes:notes error:&saveError])
+            {
+                DDLogError(@"Unable to save note index. Error: %@", saveError);
+            }
+        }
+        
+        //Persist any digests computed for notes which were not indexed
+        GRKDigestCache *digestCache = [GRKDigestCache sharedCache];
+        DDLogVerbose(@"Digest cache after startup scan: %@ hits, %@ misses.", @(digestCache.hits), @(digestCache.misses));
+        if (digestCache.misses > 0)
+        {
+            [self saveDigestCacheInGroup:dispatch_group_create()];
+        }
+        
+        //Update our properties on the main queue
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self.noteTable removeAllNotes];
+            [self.noteTable addNotes:notes];
+            [self.nameAllocator removeAllNames];
+            [self recordNamesOfNotes:notes];
+            NSMutableArray *visibleNotes = [NSMutableArray arrayWithCapacity:notes.count];
+            for (Note *note in notes)
+            {
+                if (!note.deleted)
+                {
+                    [visibleNotes addObject:note];
+                }
+            }
+            [self.sortedVisibleNotes setObjects:visibleNotes];
+            self.visibleNotesSnapshot = [self.sortedVisibleNotes snapshot];
+            [self reconcileSearchIndexWithNotes:visibleNotes];
+            if (completion)
+            {
+                completion();
+            }
+        });
+    });
+}
+
+- (void)updateDirtyNotes:(void(^)(NSArray *errors))completion
+{
+    //Ensure we are on the main queue
+    dispatch_async(dispatch_get_main_queue(), ^{
+        //Create a dispatch group to track all parts of the update to completion
+        dispatch_group_t updateGroup = dispatch_group_create();
+        
+        NSMutableArray *errors = [NSMutableArray array];
+        
+        for (Note *note in [self.noteTable notesWithAnyFlags:NoteTableFlagDirty])
+        {
+            //Track this dispatch to completion
+            dispatch_group_enter(updateGroup);
+            BOOL create = note.remoteID == nil;
+            if (create)
+            {
+                //Remote changes for files we don't know about wait for creates to complete, since they may be the files we are creating
+                dispatch_group_enter(self.remoteCreateGroup);
+            }
+            [self enqueueOperationForKey:note.localID operation:^(void (^done)(void)) {
+                [self updateDirtyNote:note errors:errors completion:^{
+                    done();
+                    if (create)
+                    {
+                        dispatch_group_leave(self.remoteCreateGroup);
+                    }
+                    //Exit the dispatch group
+                    dispatch_group_leave(updateGroup);
+                }];
+            }];
+        }
+        
+        DDLogVerbose(@"Waiting for all updateDirtyNotes actions to complete...");
+        dispatch_group_notify(updateGroup, dispatch_get_main_queue(), ^{
+            DDLogVerbose(@"Completed updateDirtyNotes actions.");
+            if (completion)
+            {
+                completion(errors.count > 0 ? errors : nil);
+            }
+        });
+    });
+}
+
+/**
+ Sends the local changes of the given note to the remote, creating the remote file if needed.
+ Must be called on the main queue.
+ @param note       The dirty Note to update the remote with.
+ @param errors     Receives any errors which occur.
+ @param completion Called on the main queue once the update completes.
+ */
+- (void)updateDirtyNote:(Note *)note errors:(NSMutableArray *)errors completion:(void(^)(void))completion
+{
+    if (!note.dirty || note.deleted)
+    {
+        //Changed while waiting for other operations on this note
+        completion();
+        return;
+    }
+    
+    DDLogVerbose(@"Processing locally dirty note: %@", note);
+    
+    //Take a snapshot of the content to compare against the last synchronized content (see recordSyncedContent:ofNote:)
+    NSURL *fileURL = note.file;
+    NSURL *signatureURL = [self signatureURLForNote:note];
+    dispatch_async(self.syncedContentQueue, ^{
+        __autoreleasing NSError *error = nil;
+        NSData *content = fileURL ? [NSData dataWithContentsOfURL:fileURL options:0 error:&error] : nil;
+        GRKBlockDelta *delta = nil;
+        NSString *contentMD5 = nil;
+        if (content)
+        {
+            uint64_t start = GRKMetricsTime();
+            contentMD5 = [GRKDigestCache MD5ForData:content];
+            GRKBlockSignature *basis = signatureURL ? [GRKBlockSignature signatureWithContentsOfURL:signatureURL error:nil] : nil;
+            delta = [basis deltaOfData:content];
+            [[GRKMetrics sharedMetrics] recordTimeSince:start inHistogramNamed:kMetricDigest];
+        }
+        else
+        {
+            DDLogWarn(@"Unable to read content of note '%@'. Error: %@", note, error);
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self sendDirtyNote:note content:content contentMD5:contentMD5 delta:delta errors:errors completion:completion];
+        });
+    });
+}
+
+/**
+ Sends the local changes of the given note to the remote, once its content has been compared to the last synchronized content.
+ Must be called on the main queue.
+ @param note       The dirty Note to update the remote with.
+ @param content    The content which was compared, which is recorded as the synchronized content if that content is what the remote ends up with, or `nil` if the content could not be read.
+ @param contentMD5 The checksum of `content`.
+ @param delta      The delta of the content against the last synchronized content, or `nil` if unknown.
+ @param errors     Receives any errors which occur.
+ @param completion Called on the main queue once the update completes.
+ */
+- (void)sendDirtyNote:(Note *)note content:(NSData *)content contentMD5:(NSString *)contentMD5 delta:(GRKBlockDelta *)delta errors:(NSMutableArray *)errors completion:(void(^)(void))completion
+{
+    //Called once the remote has been updated, to work out if the note is still dirty
+    void(^finish)(GTLDriveFile *remoteFile) = ^(GTLDriveFile *remoteFile) {
+        //The note may have been modified locally while we were trying to update the remote
+        
+        //Is the title different?
+        BOOL titleDirty = ![note.title isEqualToString:remoteFile.title];
+        //Compare checksums (file content) against what the remote ended up with, since the upload reads the file when it runs rather than when it was compared
+        NSString *remoteMD5 = remoteFile.md5Checksum;
+        NSString *newMD5 = [note updateMD5];
+        BOOL contentDirty = !remoteMD5 || ![remoteMD5 isEqualToString:newMD5];
+        [note writeDirty:titleDirty || contentDirty];
+        [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricNotesSent by:1];
+        //Only content which is known to be on the remote may serve as the basis of future deltas
+        BOOL contentSynced = contentMD5 && [contentMD5 isEqualToString:remoteMD5];
+        [self recordSyncedContent:(contentSynced ? content : nil) ofNote:note];
+    };
+    
+    if (note.remoteID && delta.unchanged)
+    {
+        //Only the title has changed, so there is no need to upload the content
+        DDLogVerbose(@"Updating title only of existing remote note from local note %@", note);
+        
+        [self renameRemoteFileWithID:note.remoteID completion:^(GTLDriveFile *updatedFile, NSError *error) {
+            if (error)
+            {
+                DDLogError(@"Unable to update remote file title for note '%@'. Error: %@", note, error);
+                [errors addObject:error];
+            }
+            else
+            {
+                self.uploadBytesSaved += delta.length;
+                [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricBytesSaved by:delta.length];
+                finish(updatedFile);
+                
+                DDLogVerbose(@"Updated title of existing remote note from local note %@ (%llu bytes saved)", note, delta.length);
+            }
+            completion();
+        }];
+    }
+    else if (note.remoteID)
+    {
+        DDLogVerbose(@"Updating existing remote note from local note %@", note);
+        if (delta)
+        {
+            //The Drive API can only replace the content of a file, so the unchanged blocks must be sent too
+            DDLogVerbose(@"Content delta for note '%@': %@", note, delta);
+        }
+        
+        //Note exists remotely, so update it.
+        GTLDriveFile *file = [GTLDriveFile object];
+        file.identifier = note.remoteID;
+        file.mimeType = kMIMETypeTextPlain;
+        file.title = note.title;
+        [self.transferScheduler enqueueTransferForKey:note.localID direction:TransferDirectionUpload operation:^(void (^done)(BOOL success, unsigned long long bytesTransferred)) {
+            [self.driveManager updateDriveFile:file fromFileURL:note.file completion:^(GTLDriveFile *updatedFile, NSError *error) {
+                done(error == nil, [updatedFile.fileSize unsignedLongLongValue]);
+                if (error)
+                {
+                    DDLogError(@"Unable to update remote file for note '%@'. Error: %@", note, error);
+                    [errors addObject:error];
+                }
+                else
+                {
+                    finish(updatedFile);
+                    
+                    DDLogVerbose(@"Updated existing remote note from local note %@", note);
+                }
+                completion();
+            }];
+        }];
+    }
+    else
+    {
+        DDLogVerbose(@"Creating new remote note from local note %@", note);
+        
+        //Note is only local, so create it remotely.
+        //Created at the root, since notes are kept flat locally (the folder tree only records where remote notes are, see folderPathOfNote:)
+        [self.transferScheduler enqueueTransferForKey:note.localID direction:TransferDirectionUpload operation:^(void (^done)(BOOL success, unsigned long long bytesTransferred)) {
+            [self.driveManager createFile:note.file withMIMEType:kMIMETypeTextPlain inFolder:nil completion:^(GTLDriveFile *createdFile, NSError *error) {
+                done(error == nil, [createdFile.fileSize unsignedLongLongValue]);
+                if (error)
+                {
+                    DDLogError(@"Unable to create remote file for note '%@'. Error: %@", note, error);
+                    [errors addObject:error];
+                }
+                else
+                {
+                    //Track the remote identifier
+                    NSString *remoteID = createdFile.identifier;
+                    [note writeRemoteID:remoteID];
+                    
+                    finish(createdFile);
+                    
+                    DDLogVerbose(@"Created new remote note from local note %@", note);
+                }
+                completion();
+            }];
+        }];
+    }
+}
+
+- (void)reapDeletedNotes:(void(^)(NSArray *errors))completion
+{
+    //Ensure we are on the main queue
+    dispatch_async(dispatch_get_main_queue(), ^{
+        //Create a dispatch group to track all parts of the update to completion
+        dispatch_group_t updateGroup = dispatch_group_create();
+        
+        NSMutableArray *errors = [NSMutableArray array];
+        
+        //Snapshot the deleted notes in case they change under us
+        NSArray *notes = [self.noteTable notesWithAnyFlags:NoteTableFlagDeleted];
+        
+        NSMutableArray *deletedNotes = [NSMutableArray array];
+        
+        for (Note *note in notes)
+        {
+            if (note.deleted)
+            {
+                if (note.remoteID)
+                {
+                    //The file exists remotely
+                    //Track this dispatch to completion
+                    dispatch_group_enter(updateGroup);
+                    [self enqueueOperationForKey:note.localID operation:^(void (^done)(void)) {
+                        [self trashRemoteFileWithID:note.remoteID completion:^(GTLDriveFile *file, NSError *error) {
+                            if (error)
+                            {
+                                DDLogError(@"Unable to move remote file to trash for note '%@'. Error: %@", note, error);
+                                [errors addObject:error];
+                            }
+                            else
+                            {
+                                //Success, so delete the local note too
+                            
+                                //Attempt to delete the local file (if this fails, we sill remove the note from our data structures)
+                                [self deleteLocalFile:note.file];
+                            
+                                //NOTE: We don't send out a notification here since the note should have already been removed from the visibleNotes which the UI cares about.
+                            
+                                [deletedNotes addObject:note];
+                            
+                                DDLogVerbose(@"Deleted note: '%@'", note);
+                            }
+                            done();
+                            //Exit the dispatch group
+                            dispatch_group_leave(updateGroup);
+                        }];
+                    }];
+                }
+                else
+                {
+                    //The note exists only locally, so delete it.
+                    
+                    //Attempt to delete the local file (if this fails, we sill remove the note from our data structures)
+                    [self deleteLocalFile:note.file];
+                    
+                    [deletedNotes addObject:note];
+                    
+                    //NOTE: We don't send out a notification here since the note should have already been removed from the visibleNotes which the UI cares about.
+                    
+                    DDLogVerbose(@"Deleted note: '%@'", note);
+                }
+            }
+        }
+        
+        DDLogVerbose(@"Waiting for all reapDeletedNotes actions to complete...");
+        dispatch_group_notify(updateGroup, dispatch_get_main_queue(), ^{
+            DDLogVerbose(@"Completed reapDeletedNotes actions.");
+            [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricNotesReaped by:deletedNotes.count];
+            
+            if (deletedNotes.count > 0)
+            {
+                [self.noteTable removeNotes:deletedNotes];
+                [self forgetSyncedContentOfNotes:deletedNotes];
+                [self unindexNotes:deletedNotes];
+                [self forgetJournaledMetadataOfNotes:deletedNotes];
+                [self forgetNamesOfNotes:deletedNotes];
+            }
+            
+            if (completion)
+            {
+                completion(errors.count > 0 ? errors : nil);
+            }
+        });
+    });
+}
+
+/**
+ Runs the given operation once all operations previously enqueued for the same key have completed, so operations on a single note happen in order while operations on different notes run concurrently.
+ Must be called on the main queue.
+ @param key       Identifies the note the operation acts on (the note's local ID).
+ @param operation The operation, which must call `done` (on any queue) exactly once when it has completed.
+ */
+- (void)enqueueOperationForKey:(NSString *)key operation:(void(^)(void(^done)(void)))operation
+{
+    if (!key)
+    {
+        operation(^{});
+        return;
+    }
+    
+    NSMutableArray *operations = [self.noteOperations objectForKey:key];
+    if (operations)
+    {
+        //Wait for the operations ahead of us
+        [operations addObject:[operation copy]];
+    }
+    else
+    {
+        operations = [NSMutableArray arrayWithObject:[operation copy]];
+        [self.noteOperations setObject:operations forKey:key];
+        [self runNextOperationForKey:key];
+    }
+}
+
+- (void)runNextOperationForKey:(NSString *)key
+{
+    NSMutableArray *operations = [self.noteOperations objectForKey:key];
+    void(^operation)(void(^done)(void)) = [operations firstObject];
+    operation(^{
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [operations removeObjectAtIndex:0];
+            if (operations.count > 0)
+            {
+                [self runNextOperationForKey:key];
+            }
+            else
+            {
+                [self.noteOperations removeObjectForKey:key];
+            }
+        });
+    });
+}
+
+/**
+ Runs the given operation, which applies a remote change to the file with the given remote ID, in order with other operations on the same note.
+ If we have no note for the file, the operation waits for any remote file creations in progress, since the change may be for one of the files being created.
+ Must be called on the main queue.
+ @param fileID    The remote ID of the changed file.
+ @param operation The operation, which must call `done` exactly once when it has completed.
+ */
+- (void)orderRemoteChangeForFileID:(NSString *)fileID operation:(void(^)(void(^done)(void)))operation
+{
+    Note *note = [self.noteTable noteWithRemoteID:fileID];
+    if (note)
+    {
+        [self enqueueOperationForKey:note.localID ?: fileID operation:operation];
+    }
+    else
+    {
+        dispatch_group_notify(self.remoteCreateGroup, dispatch_get_main_queue(), ^{
+            Note *note = [self.noteTable noteWithRemoteID:fileID];
+            [self enqueueOperationForKey:note.localID ?: fileID operation:operation];
+        });
+    }
+}
+
+/**
+ Moves the given remote file to the trash. Requests made during the same pass of the main queue are sent together as a batch.
+ Must be called on the main queue.
+ @param fileID     The remote ID of the file to trash.
+ @param completion Called on the main queue with the trashed file, or error.
+ */
+- (void)trashRemoteFileWithID:(NSString *)fileID completion:(void(^)(GTLDriveFile *file, NSError *error))completion
+{
+    [self addFileID:fileID completion:completion toBatch:self.pendingTrashes send:^(NSArray *fileIDs, void (^batchCompletion)(NSDictionary *files, NSDictionary *errors)) {
+        DDLogVerbose(@"Trashing %@ remote file%@ in a batch.", @(fileIDs.count), fileIDs.count == 1 ? @"" : @"s");
+        [self.driveManager trashFilesWithIDs:fileIDs completion:batchCompletion];
+    }];
+}
+
+/**
+ Restores the given remote file from the trash. Requests made during the same pass of the main queue are sent together as a batch.
+ Must be called on the main queue.
+ @param fileID     The remote ID of the file to restore.
+ @param completion Called on the main queue with the restored file, or error.
+ */
+- (void)restoreRemoteFileWithID:(NSString *)fileID completion:(void(^)(GTLDriveFile *file, NSError *error))completion
+{
+    [self addFileID:fileID completion:completion toBatch:self.pendingRestores send:^(NSArray *fileIDs, void (^batchCompletion)(NSDictionary *files, NSDictionary *errors)) {
+        DDLogVerbose(@"Restoring %@ remote file%@ in a batch.", @(fileIDs.count), fileIDs.count == 1 ? @"" : @"s");
+        [self.driveManager restoreFilesWithIDs:fileIDs completion:batchCompletion];
+    }];
+}
+
+/**
+ Changes the title of the given remote file to the current title of its note, without uploading content. Requests made during the same pass of the main queue are sent together as a batch.
+ Must be called on the main queue.
+ @param fileID     The remote ID of the file to rename.
+ @param completion Called on the main queue with the renamed file, or error.
+ */
+- (void)renameRemoteFileWithID:(NSString *)fileID completion:(void(^)(GTLDriveFile *file, NSError *error))completion
+{
+    [self addFileID:fileID completion:completion toBatch:self.pendingRenames send:^(NSArray *fileIDs, void (^batchCompletion)(NSDictionary *files, NSDictionary *errors)) {
+        DDLogVerbose(@"Renaming %@ remote file%@ in a batch.", @(fileIDs.count), fileIDs.count == 1 ? @"" : @"s");
+        //Use the titles as of when the batch is sent
+        NSMutableDictionary *titles = [NSMutableDictionary dictionaryWithCapacity:fileIDs.count];
+        for (NSString *fileID in fileIDs)
+        {
+            NSString *title = [[self.noteTable noteWithRemoteID:fileID] title];
+            if (title)
+            {
+                [titles setObject:title forKey:fileID];
+            }
+        }
+        [self.driveManager renameFiles:titles completion:batchCompletion];
+    }];
+}
+
+/**
+ Adds a file to the given pending batch. The first file added schedules the batch to be sent once the current pass of the main queue completes, which lets a loop over many notes fill a batch before it goes.
+ Must be called on the main queue.
+ @param fileID     The remote ID of the file.
+ @param completion Called with the result for this file.
+ @param batch      The pending batch, mapping file IDs to arrays of completion blocks.
+ @param send       Sends the given file IDs as a batch, calling `batchCompletion` with the results.
+ */
+- (void)addFileID:(NSString *)fileID completion:(void(^)(GTLDriveFile *file, NSError *error))completion toBatch:(NSMutableDictionary *)batch send:(void(^)(NSArray *fileIDs, void(^batchCompletion)(NSDictionary *files, NSDictionary *errors)))send
+{
+    BOOL schedule = batch.count == 0;
+    
+    NSMutableArray *completions = [batch objectForKey:fileID];
+    if (!completions)
+    {
+        completions = [NSMutableArray array];
+        [batch setObject:completions forKey:fileID];
+    }
+    if (completion)
+    {
+        [completions addObject:[completion copy]];
+    }
+    
+    if (schedule)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSDictionary *requests = [batch copy];
+            [batch removeAllObjects];
+            send([requests allKeys], ^(NSDictionary *files, NSDictionary *errors) {
+                for (NSString *fileID in requests)
+                {
+                    GTLDriveFile *file = [files objectForKey:fileID];
+                    NSError *error = [errors objectForKey:fileID];
+                    for (void(^completion)(GTLDriveFile *file, NSError *error) in [requests objectForKey:fileID])
+                    {
+                        completion(file, error);
+                    }
+                }
+            });
+        });
+    }
+}
+
+- (NSURL *)signatureURLForNote:(Note *)note
+{
+    NSURL *retVal = nil;
+    
+    if (self.signaturesDirectory && note.localID)
+    {
+        retVal = [self.signaturesDirectory URLByAppendingPathComponent:[note.localID stringByAppendingPathExtension:kSignatureFileExtension]];
+    }
+    
+    return retVal;
+}
+
+/**
+ Records the content the remote has for the given note. The content is kept in the blob store, and its signature is the basis of the delta when the note is next sent.
+ @param content The remote content, or `nil` if it is not known, in which case the note will be uploaded in full.
+ @param note    The Note.
+ */
+- (void)recordSyncedContent:(NSData *)content ofNote:(Note *)note
+{
+    NSURL *signatureURL = [self signatureURLForNote:note];
+    dispatch_async(self.syncedContentQueue, ^{
+        __autoreleasing NSError *error = nil;
+        
+        if (signatureURL)
+        {
+            GRKBlockSignature *signature = content ? [GRKBlockSignature signatureOfData:content blockSize:0] : nil;
+            if (!signature || ![signature writeToURL:signatureURL error:&error])
+            {
+                if (signature)
+                {
+                    DDLogWarn(@"Unable to write signature for note '%@'. Error: %@", note, error);
+                }
+                [[NSFileManager defaultManager] removeItemAtURL:signatureURL error:nil];
+            }
+        }
+        
+        NSString *digest = nil;
+        if (content && self.blobStore)
+        {
+            digest = [self.blobStore addData:content error:&error];
+            if (digest)
+            {
+                [self.recordedDigests addObject:digest];
+            }
+            else
+            {
+                DDLogWarn(@"Unable to store synchronized content of note '%@'. Error: %@", note, error);
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (digest)
+            {
+                [note writeSyncedMD5:digest];
+            }
+            else
+            {
+                [note removeSyncedMD5];
+            }
+        });
+    });
+}
+
+- (void)forgetSyncedContentOfNotes:(NSArray *)notes
+{
+    //The content itself is removed from the blob store by collectUnusedBlobs once no note refers to it
+    for (Note *note in notes)
+    {
+        NSURL *signatureURL = [self signatureURLForNote:note];
+        if (signatureURL)
+        {
+            dispatch_async(self.syncedContentQueue, ^{
+                [[NSFileManager defaultManager] removeItemAtURL:signatureURL error:nil];
+            });
+        }
+    }
+}
+
+- (void)forgetJournaledMetadataOfNotes:(NSArray *)notes
+{
+    //So the metadata is not applied to another file which takes the same name
+    for (Note *note in notes)
+    {
+        [self.journal forgetLocalID:note.localID];
+    }
+}
+
+/**
+ Removes content from the blob store which is no longer the synchronized content of any note.
+ Must be called on the main queue.
+ */
+- (void)collectUnusedBlobs
+{
+    if (self.blobStore)
+    {
+        NSArray *files = [[self.noteTable allNotes] valueForKey:@"file"];
+        dispatch_async(self.syncedContentQueue, ^{
+            NSMutableSet *digests = [NSMutableSet setWithSet:self.recordedDigests];
+            for (NSURL *file in files)
+            {
+                NSString *digest = [Note syncedMD5OfFile:file];
+                if (digest)
+                {
+                    [digests addObject:digest];
+                }
+            }
+            NSUInteger removed = [self.blobStore removeAllExceptDigests:digests];
+            DDLogVerbose(@"Removed %@ unused blob%@.", @(removed), removed == 1 ? @"" : @"s");
+        });
+    }
+}
+
+/**
+ Copies the content with the given checksum from the blob store, if it is there, which saves downloading it.
+ @param MD5    The checksum of the content.
+ @param name   The file name to give the copy (as with a download, the name of the copy becomes the name of the note).
+ @param folder The directory to copy the content to.
+ @return The file URL of the copy, or `nil` if the content is not in the blob store.
+ */
+- (NSURL *)copyOfContentWithMD5:(NSString *)MD5 named:(NSString *)name inFolder:(NSURL *)folder
+{
+    NSURL *retVal = nil;
+    
+    if (folder && name.length > 0 && [self.blobStore containsDigest:MD5])
+    {
+        NSURL *destination = [folder URLByAppendingPathComponent:name];
+        __autoreleasing NSError *error = nil;
+        if ([self.blobStore copyDigest:MD5 toURL:destination error:&error])
+        {
+            retVal = destination;
+        }
+        else
+        {
+            DDLogWarn(@"Unable to copy content with checksum '%@' from the blob store. Error: %@", MD5, error);
+        }
+    }
+    
+    return retVal;
+}
+
+/**
+ Merges remote changes to a note with the local changes made since the note was last synchronized, using the last synchronized content (from the blob store) as the common base (see GRKMerge).
+ If the changes merge cleanly the note takes the merged content and stays dirty, so the merge is sent to the remote. Otherwise the local content is kept as a new sibling note, and the note takes the remote content.
+ Must be called on the main queue.
+ @param file         The remote file.
+ @param remoteURL    The file URL of the downloaded remote content, which is consumed.
+ @param note         The dirty Note.
+ @param errors       Receives any errors which occur.
+ @param newNotes     Receives the sibling note, if one is created.
+ @param updatedNotes Receives the note, if it is updated.
+ @param completion   Called on the main queue once the outcome has been applied.
+ */
+- (void)mergeRemoteFile:(GTLDriveFile *)file atURL:(NSURL *)remoteURL intoNote:(Note *)note errors:(NSMutableArray *)errors newNotes:(NSMutableArray *)newNotes updatedNotes:(NSMutableArray *)updatedNotes completion:(void(^)(void))completion
+{
+    NSString *syncedMD5 = [note readSyncedMD5];
+    NSString *localMD5 = [note updateMD5];
+    NSURL *localURL = note.file;
+    
+    //Reading and merging multi-megabyte notes is kept off the main queue
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __autoreleasing NSError *readError = nil;
+        NSData *remote = [NSData dataWithContentsOfURL:remoteURL options:0 error:&readError];
+        NSError *remoteError = readError;
+        NSData *local = [NSData dataWithContentsOfURL:localURL options:0 error:nil];
+        NSData *base = syncedMD5 ? [self.blobStore dataForDigest:syncedMD5 error:nil] : nil;
+        uint64_t start = GRKMetricsTime();
+        GRKMergeResult *result = (base && local && remote) ? [GRKMerge mergeBase:base ours:local theirs:remote] : nil;
+        [[GRKMetrics sharedMetrics] recordTimeSince:start inHistogramNamed:kMetricMerge];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (note.deleted || !remote || !local)
+            {
+                DDLogWarn(@"Unable to merge remote changes into note '%@'. Ignoring update from remote. Error: %@", note, remoteError);
+                if (remoteError)
+                {
+                    [errors addObject:remoteError];
+                }
+                //Discard remote changes (still in temp dir, so we don't care if this fails)
+                [self deleteLocalFile:remoteURL];
+                completion();
+            }
+            else if (![[note updateMD5] isEqualToString:localMD5])
+            {
+                //The note was edited while we were merging, so merge again with the new local content
+                DDLogVerbose(@"Note '%@' changed during merge. Merging again.", note);
+                [self mergeRemoteFile:file atURL:remoteURL intoNote:note errors:errors newNotes:newNotes updatedNotes:updatedNotes completion:completion];
+            }
+            else
+            {
+                __autoreleasing NSError *error = nil;
+                if (result.data)
+                {
+                    DDLogVerbose(@"Merged remote changes into note '%@': %@", note, result);
+                    
+                    //Name the merged content after the note, so the local title is kept
+                    NSURL *mergedURL = [[self.grkFileManager tempDirectory] URLByAppendingPathComponent:[note.file lastPathComponent]];
+                    if ([result.data writeToURL:mergedURL options:NSDataWritingAtomic error:&error] && [self replaceFileOfNote:note withFile:mergedURL error:&error])
+                    {
+                        //The merge still has to be sent, and the remote content is now the basis of the delta
+                        [note writeDirty:YES];
+                        [self recordSyncedContent:remote ofNote:note];
+                        [updatedNotes addObject:note];
+                    }
+                    else
+                    {
+                        DDLogError(@"Unable to write merged content of note '%@'. Error: %@", note, error);
+                        if (error)
                         {
-                            //Success, so delete the local note too
-                            
-                            //Attempt to delete the local file (if this fails, we sill remove the note from our data structures)
-                            [self deleteLocalFile:note.file];
-                            
-                            //NOTE: We don't send out a notification here since the note should have already been removed from the visibleNotes which the UI cares about.
-                            
-                            [deletedNotes addObject:note];
-                            
-                            DDLogVerbose(@"Deleted note: '%@'", note);
+                            [errors addObject:error];
                         }
-                        //Exit the dispatch group
-                        dispatch_group_leave(updateGroup);
-                    }];
+                        [self deleteLocalFile:mergedURL];
+                    }
                 }
                 else
                 {
-                    //The note exists only locally, so delete it.
-                    
-                    //Attempt to delete the local file (if this fails, we sill remove the note from our data structures)
-                    [self deleteLocalFile:note.file];
-                    
-                    [deletedNotes addObject:note];
+                    DDLogWarn(@"Unable to merge remote changes into note '%@' (%@). Keeping local changes as a copy.", note, result ?: @"no synchronized content to merge from");
                     
-                    //NOTE: We don't send out a notification here since the note should have already been removed from the visibleNotes which the UI cares about.
-                    
-                    DDLogVerbose(@"Deleted note: '%@'", note);
+                    //Keep the local content as a new note, which will be sent as a new remote file
+                    NSString *baseName = [NSString stringWithFormat:@"%@ (%@)", [note.file lastPathComponent], NSLocalizedString(@"Conflicted Copy", nil)];
+                    NSURL *copyURL = [self uniqueFileInDirectory:[note.file URLByDeletingLastPathComponent] baseName:baseName content:local error:&error];
+                    if (copyURL)
+                    {
+                        Note *copy = [[Note alloc] init];
+                        copy.file = copyURL;
+                        //Before any other copy of this batch is named
+                        [self recordNamesOfNotes:@[copy]];
+                        [copy writeLocalID:[NSString UUID]];
+                        [copy writeDirty:YES];
+                        //Added to the note table with its file, so the directory watcher does not take the file for a new one (see applyDirectoryEvents:)
+                        [self.noteTable addNotes:@[copy]];
+                        [newNotes addObject:copy];
+                        DDLogVerbose(@"Created conflicted copy: '%@'", copy);
+                        
+                        //The note itself takes the remote content (and title)
+                        if ([self replaceFileOfNote:note withFile:remoteURL error:&error])
+                        {
+                            [note writeDirty:NO];
+                            [self recordSyncedContent:remote ofNote:note];
+                            [updatedNotes addObject:note];
+                        }
+                        else
+                        {
+                            //The note keeps its local changes, which are also in the copy
+                            DDLogError(@"Unable to relocate updated note file to destination directory. Error: %@", error);
+                            if (error)
+                            {
+                                [errors addObject:error];
+                            }
+                            [self deleteLocalFile:remoteURL];
+                        }
+                    }
+                    else
+                    {
+                        DDLogError(@"Unable to create conflicted copy of note '%@'. Ignoring update from remote. Error: %@", note, error);
+                        if (error)
+                        {
+                            [errors addObject:error];
+                        }
+                        [self deleteLocalFile:remoteURL];
+                    }
                 }
-            }
-        }
-        
-        DDLogVerbose(@"Waiting for all reapDeletedNotes actions to complete...");
-        dispatch_group_notify(updateGroup, dispatch_get_main_queue(), ^{
-            DDLogVerbose(@"Completed reapDeletedNotes actions.");
-            
-            if (deletedNotes.count > 0)
-            {
-                [self.notes removeObjectsInArray:deletedNotes];
-                [self.notesByRemoteID removeObjectsForKeys:[deletedNotes valueForKey:@"remoteID"]];
-                [self.notesByLocalID removeObjectsForKeys:[deletedNotes valueForKey:@"localID"]];
-                [self.mVisibleNotes removeObjectsInArray:deletedNotes];
-            }
-            
-            if (completion)
-            {
-                completion(errors.count > 0 ? errors : nil);
+                completion();
             }
         });
     });
 }
 
+/**
+ Replaces the file of a note with the given file, which gives the note the name of the new file, and carries the note's identity over to it.
+ @param note  The Note.
+ @param file  The file URL of the new file, which is consumed.
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)replaceFileOfNote:(Note *)note withFile:(NSURL *)file error:(__autoreleasing NSError **)error
+{
+    uint64_t start = GRKMetricsTime();
+    NSURL *resultingItemURL = [self.grkFileManager replaceFile:note.file withFile:file error:error];
+    if (resultingItemURL)
+    {
+        //Save the note metadata, which is associated with the old file
+        NSString *localID = note.localID;
+        NSString *remoteID = note.remoteID;
+        //Set the note's file to the new file (this will update the note's medatata with that from the file, which will not exist)
+        note.file = resultingItemURL;
+        //Repopulate the file's medatata
+        [note writeLocalID:localID];
+        [note writeRemoteID:remoteID];
+    }
+    [[GRKMetrics sharedMetrics] recordTimeSince:start inHistogramNamed:kMetricReplaceFile];
+    
+    return resultingItemURL != nil;
+}
+
 - (BOOL)deleteLocalFile:(NSURL *)file
 {
+    [[GRKDigestCache sharedCache] removeMD5ForFile:file];
+    
     __autoreleasing NSError *error = nil;
     BOOL success = [self.grkFileManager.fileManager removeItemAtURL:file error:&error];
     if (!success)
@@ -863,85 +2233,441 @@ static NSUInteger const kMaxUniqueFilenameAttempts = 1000;
     return success;
 }
 
-- (void)sortNotes:(NSMutableArray *)notes
+/**
+ Applies a batch of changes made to the documents directory to our collections of notes, and posts a notification describing the changes.
+ Many of the events are the result of our own changes (writing content, moving downloaded files into place, etc.) which are already reflected in our collections, so each event is checked against the current state of the affected note and only real differences are applied. Synchronization adds notes to, and removes notes from, the note table as it creates and deletes their files, so a batch arriving before the rest of its bookkeeping still finds them as expected.
+ The files of the batch have already been hashed in the background (see startWatching), so reading their checksums here does not read the files.
+ Must be called on the main queue.
+ @param events An NSArray of GRKDirectoryWatcherEvent objects.
+ */
+- (void)applyDirectoryEvents:(NSArray *)events
 {
-    [notes sortUsingComparator:^NSComparisonResult(Note *note1, Note *note2) {
-        //Sort by note title, and fallback to note remoteID then localID
-        NSComparisonResult retVal = [note1.title compare:note2.title];
-        if (retVal == NSOrderedSame)
+    DDLogVerbose(@"Applying %@ local change%@: %@", @(events.count), events.count == 1 ? @"" : @"s", events);
+    
+    NSMutableArray *deletedNotes = [NSMutableArray array];
+    NSMutableArray *updatedNotes = [NSMutableArray array];
+    NSMutableArray *newNotes = [NSMutableArray array];
+    
+    //Deleted files can not be identified by their metadata, so look up the affected notes by file name (only if needed)
+    NSMutableSet *deletedNames = [NSMutableSet set];
+    for (GRKDirectoryWatcherEvent *event in events)
+    {
+        if (event.type == GRKDirectoryWatcherEventDeleted)
+        {
+            [deletedNames addObject:[event.fileURL lastPathComponent]];
+        }
+    }
+    if (deletedNames.count > 0)
+    {
+        for (Note *note in [self.noteTable allNotes])
         {
-            retVal = [note1.remoteID compare:note2.remoteID];
-            if (retVal == NSOrderedSame)
+            //Notes marked as deleted are already being taken care of by reapDeletedNotes:
+            if (!note.deleted && [deletedNames containsObject:[note.file lastPathComponent]] && ![self.grkFileManager.fileManager fileExistsAtPath:[note.file path]])
             {
-                retVal = [note1.localID compare:note2.localID];
+                [deletedNotes addObject:note];
             }
         }
-        return retVal;
-    }];
+    }
+    
+    for (GRKDirectoryWatcherEvent *event in events)
+    {
+        if (event.type == GRKDirectoryWatcherEventDeleted)
+        {
+            continue;
+        }
+        
+        //Read the file's metadata to determine which note (if any) it belongs to
+        Note *candidate = [[Note alloc] init];
+        candidate.file = event.fileURL;
+        Note *note = candidate.localID ? [self.noteTable noteWithLocalID:candidate.localID] : nil;
+        
+        if (note && [[note.file lastPathComponent] isEqualToString:[event.fileURL lastPathComponent]])
+        {
+            //The file belongs to the note we know about; pick up any change in content
+            NSString *oldMD5 = note.MD5;
+            note.file = event.fileURL;
+            if (![note.MD5 isEqualToString:oldMD5])
+            {
+                if (!note.dirty)
+                {
+                    [note writeDirty:YES];
+                }
+                [updatedNotes addObject:note];
+            }
+        }
+        else if (note && event.type == GRKDirectoryWatcherEventRenamed && [[note.file lastPathComponent] isEqualToString:[event.previousFileURL lastPathComponent]])
+        {
+            //The note's file was renamed by someone else
+            note.file = event.fileURL;
+            [note writeDirty:YES];
+            [updatedNotes addObject:note];
+        }
+        else if (note && [self.grkFileManager.fileManager fileExistsAtPath:[note.file path]])
+        {
+            //A copy of a note's file (which carries the note's metadata), so it becomes a new note
+            [candidate writeLocalID:[NSString UUID]];
+            [candidate removeRemoteID];
+            [candidate writeDirty:YES];
+            [newNotes addObject:candidate];
+        }
+        else if (note)
+        {
+            //The note's file was moved here by someone else
+            note.file = event.fileURL;
+            [note writeDirty:YES];
+            [updatedNotes addObject:note];
+        }
+        else
+        {
+            //A file we have not seen before
+            if (!candidate.localID)
+            {
+                [candidate writeLocalID:[NSString UUID]];
+            }
+            [candidate writeDirty:YES];
+            [newNotes addObject:candidate];
+        }
+    }
+    
+    //Notes whose file has moved are not deleted
+    [deletedNotes removeObjectsInArray:updatedNotes];
+    
+    BOOL deletes = deletedNotes.count > 0;
+    BOOL updates = updatedNotes.count > 0;
+    BOOL additions = newNotes.count > 0;
+    
+    if (deletes)
+    {
+        for (Note *note in deletedNotes)
+        {
+            //Treat the removal of the file as the user deleting the note
+            if (note.remoteID)
+            {
+                [self trashRemoteFileWithID:note.remoteID completion:^(GTLDriveFile *file, NSError *error) {
+                    if (error)
+                    {
+                        DDLogError(@"Unable to move remote file to trash for note '%@'. Error: %@", note, error);
+                    }
+                }];
+            }
+            DDLogVerbose(@"Note file removed locally: '%@'", note);
+        }
+        [self.noteTable removeNotes:deletedNotes];
+        [self forgetSyncedContentOfNotes:deletedNotes];
+        [self unindexNotes:deletedNotes];
+        [self forgetJournaledMetadataOfNotes:deletedNotes];
+        [self forgetNamesOfNotes:deletedNotes];
+    }
+    
+    if (additions)
+    {
+        [self.noteTable addNotes:newNotes];
+    }
+    
+    if (deletes || updates || additions)
+    {
+        [self indexNotes:updatedNotes];
+        [self indexNotes:newNotes];
+        //Updated notes may have been renamed
+        [self recordNamesOfNotes:updatedNotes];
+        [self recordNamesOfNotes:newNotes];
+        
+        //Titles may have changed, so updated notes may move too
+        NSDictionary *changes = [self updateVisibleNotesWithDeletedNotes:deletedNotes updatedNotes:updatedNotes addedNotes:newNotes];
+        
+        //Post a notification informing subscribers that there are changes for the notes
+        NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:changes];
+        [userInfo setValue:deletedNotes forKey:kNoteNotificationInfoKeyDeletedNotes];
+        [userInfo setValue:updatedNotes forKey:kNoteNotificationInfoKeyUpdatedNotes];
+        [userInfo setValue:newNotes forKey:kNoteNotificationInfoKeyAddedNotes];
+        [[NSNotificationCenter defaultCenter] postNotificationName:kNoteNotificationNoteChanges object:self userInfo:userInfo];
+        
+        //Send the changes to the remote soon
+        [self.syncScheduler localChangeOccurred];
+    }
 }
 
 /**
- Fetches Note objects from the given directory.
- @param directory The directory in which to locate notes.
- @return An NSArray of Note objects (or an empty NSArray if none were found).
+ Updates the search indexes with the current title and content of the given notes, in the background.
+ @param notes An NSArray of Note objects. Can be nil.
  */
-- (NSArray *)fetchNotesFromDirectory:(NSURL *)directory
+- (void)indexNotes:(NSArray *)notes
 {
-    NSArray *retVal = nil;
-    
-    __autoreleasing NSError *error = nil;
-    NSArray *items = [self.grkFileManager.fileManager contentsOfDirectoryAtURL:directory includingPropertiesForKeys:@[NSURLIsDirectoryKey, NSURLIsReadableKey, NSURLIsWritableKey, NSURLNameKey] options:NSDirectoryEnumerationSkipsSubdirectoryDescendants | NSDirectoryEnumerationSkipsPackageDescendants | NSDirectoryEnumerationSkipsHiddenFiles error:&error];
-    
-    if (items)
+    for (Note *note in notes)
+    {
+        NSString *localID = note.localID;
+        NSURL *file = note.file;
+        NSString *title = note.title;
+        if (localID && file && !note.deleted)
+        {
+            dispatch_async(self.searchIndexingQueue, ^{
+                [self indexFile:file title:title MD5:nil localID:localID];
+            });
+        }
+    }
+}
+
+/**
+ Removes the given notes from the search indexes, in the background.
+ @param notes An NSArray of Note objects. Can be nil.
+ */
+- (void)unindexNotes:(NSArray *)notes
+{
+    for (Note *note in notes)
+    {
+        NSString *localID = note.localID;
+        if (localID)
+        {
+            dispatch_async(self.searchIndexingQueue, ^{
+                [self.searchIndex removeIdentifier:localID];
+                [self.trigramIndex removeIdentifier:localID];
+            });
+        }
+    }
+}
+
+/**
+ Reads a note's file and indexes its content, along with its title. Each index is only updated if the note differs from what it holds. Must be called on the searchIndexingQueue.
+ @param MD5 The checksum of the file, if already known (see `-[Note MD5]`), or `nil` to take it from the content read.
+ @return `YES` if either index was updated.
+ */
+- (BOOL)indexFile:(NSURL *)file title:(NSString *)title MD5:(NSString *)MD5 localID:(NSString *)localID
+{
+    BOOL retVal = NO;
+    NSData *data = [NSData dataWithContentsOfURL:file];
+    if (data)
+    {
+        NSString *content = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"";
+        NSString *text = [NSString stringWithFormat:@"%@\n%@", title ?: @"", content];
+        NSString *signature = NoteManagerSearchSignature(MD5 ?: [GRKDigestCache MD5ForData:data], title);
+        if (![[self.trigramIndex signatureForIdentifier:localID] isEqualToString:signature])
+        {
+            [self.trigramIndex setText:text signature:signature forIdentifier:localID];
+            retVal = YES;
+        }
+        if (self.searchIndex && ![[self.searchIndex signatureForIdentifier:localID] isEqualToString:signature])
+        {
+            [self.searchIndex setText:text signature:signature forIdentifier:localID];
+            retVal = YES;
+        }
+    }
+    return retVal;
+}
+
+/**
+ Brings the search indexes in line with the notes found at startup, in the background. Changes held in memory by the indexes are lost if the application ends without saving them, so notes whose title or content differ from what they hold are indexed again, and notes which no longer exist are removed.
+ The checksums found by the startup scan (see `-[Note MD5]`) are compared with those the indexes hold, so only the notes which changed are read.
+ @param notes An NSArray of the visible Note objects.
+ */
+- (void)reconcileSearchIndexWithNotes:(NSArray *)notes
+{
+    //Notes are only used on the main queue, so take what is needed of them here
+    NSMutableDictionary *files = [NSMutableDictionary dictionaryWithCapacity:notes.count];
+    NSMutableDictionary *titles = [NSMutableDictionary dictionaryWithCapacity:notes.count];
+    NSMutableDictionary *MD5s = [NSMutableDictionary dictionaryWithCapacity:notes.count];
+    for (Note *note in notes)
     {
-        NSMutableArray *notes = [NSMutableArray array];
-        for (NSURL *item in items)
+        NSString *localID = note.localID;
+        if (localID && note.file)
+        {
+            [files setObject:note.file forKey:localID];
+            [titles setValue:note.title forKey:localID];
+            [MD5s setValue:note.MD5 forKey:localID];
+        }
+    }
+    
+    GRKSearchIndex *searchIndex = self.searchIndex;
+    GRKTrigramIndex *trigramIndex = self.trigramIndex;
+    dispatch_async(self.searchIndexingQueue, ^{
+        NSMutableSet *indexed = [NSMutableSet setWithSet:[trigramIndex allIdentifiers]];
+        [indexed unionSet:[searchIndex allIdentifiers] ?: [NSSet set]];
+        NSUInteger removedCount = 0;
+        for (NSString *localID in indexed)
         {
-            NSNumber *isDirectoryValue;
-            __autoreleasing NSError *directoryError = nil;
-            BOOL directorySuccess = [item getResourceValue:&isDirectoryValue forKey:NSURLIsDirectoryKey error:&directoryError];
-            if (!directorySuccess)
+            if (![files objectForKey:localID])
             {
-                DDLogError(@"Unable to get NSURLIsDirectoryKey resource value for URL '%@'. Error: %@", item, directoryError);
-                continue;
+                [searchIndex removeIdentifier:localID];
+                [trigramIndex removeIdentifier:localID];
+                ++removedCount;
             }
-            if ([isDirectoryValue boolValue])
+        }
+        
+        NSUInteger readCount = 0;
+        NSUInteger indexedCount = 0;
+        for (NSString *localID in files)
+        {
+            NSString *MD5 = [MD5s objectForKey:localID];
+            NSString *signature = MD5 ? NoteManagerSearchSignature(MD5, [titles objectForKey:localID]) : nil;
+            BOOL current = signature && [[trigramIndex signatureForIdentifier:localID] isEqualToString:signature] && (!searchIndex || [[searchIndex signatureForIdentifier:localID] isEqualToString:signature]);
+            if (!current)
             {
-                DDLogVerbose(@"Item is a directory: '%@'", item);
-                continue;
+                ++readCount;
+                if ([self indexFile:[files objectForKey:localID] title:[titles objectForKey:localID] MD5:MD5 localID:localID])
+                {
+                    ++indexedCount;
+                }
             }
+        }
+        DDLogVerbose(@"Search indexes reconciled. Read %@ of %@ notes, of which %@ were indexed again, and removed %@.", @(readCount), @(files.count), @(indexedCount), @(removedCount));
+    });
+}
 
-            NSNumber *isReadableValue;
-            __autoreleasing NSError *readableError = nil;
-            BOOL readableSuccess = [item getResourceValue:&isReadableValue forKey:NSURLIsReadableKey error:&readableError];
-            if (!readableSuccess)
+/**
+ Brings the visible notes up to date with a batch of changes, moving only the notes involved.
+ Deleted notes are removed, added notes are inserted, and updated notes are moved if their title has changed (or removed if they have since been deleted).
+ @param deletedNotes An NSArray of the notes which were deleted. Can be nil.
+ @param updatedNotes An NSArray of the notes which were updated. Can be nil.
+ @param addedNotes   An NSArray of the notes which were added. Can be nil.
+ @return A dictionary of NSIndexSet objects describing the changes, keyed by kNoteNotificationInfoKeyDeletedIndexes, kNoteNotificationInfoKeyInsertedIndexes and kNoteNotificationInfoKeyReloadedIndexes, as suits batch updates of a UITableView, along with the newly published snapshot, keyed by kNoteNotificationInfoKeyVisibleNotes.
+ */
+- (NSDictionary *)updateVisibleNotesWithDeletedNotes:(NSArray *)deletedNotes updatedNotes:(NSArray *)updatedNotes addedNotes:(NSArray *)addedNotes
+{
+    NSMutableIndexSet *deletedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *insertedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *reloadedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableArray *removedNotes = [NSMutableArray array];
+    NSMutableArray *insertedNotes = [NSMutableArray array];
+    
+    //Removals and reloads are indexed as the notes were before the changes
+    for (Note *note in deletedNotes)
+    {
+        NSUInteger index = [self.sortedVisibleNotes indexOfObject:note];
+        if (index != NSNotFound && ![deletedIndexes containsIndex:index])
+        {
+            [deletedIndexes addIndex:index];
+            [removedNotes addObject:note];
+        }
+    }
+    for (Note *note in updatedNotes)
+    {
+        NSUInteger index = [self.sortedVisibleNotes indexOfObject:note];
+        if (index != NSNotFound && ![deletedIndexes containsIndex:index])
+        {
+            if (note.deleted)
             {
-                DDLogError(@"Unable to get NSURLIsReadableKey resource value for URL '%@'. Error: %@", item, readableError);
-                continue;
+                [deletedIndexes addIndex:index];
+                [removedNotes addObject:note];
             }
-            if (![isReadableValue boolValue])
+            else if ([self.sortedVisibleNotes keyHasChangedForObject:note])
             {
-                DDLogVerbose(@"Item is not readable: '%@'", item);
-                continue;
+                [deletedIndexes addIndex:index];
+                [removedNotes addObject:note];
+                [insertedNotes addObject:note];
             }
-            
-            NSNumber *isWritableValue;
-            __autoreleasing NSError *writableError = nil;
-            BOOL writableSuccess = [item getResourceValue:&isWritableValue forKey:NSURLIsWritableKey error:&writableError];
-            if (!writableSuccess)
+            else
             {
-                DDLogError(@"Unable to get NSURLIsWritableKey resource value for URL '%@'. Error: %@", item, writableError);
-                continue;
+                [reloadedIndexes addIndex:index];
             }
-            if (![isWritableValue boolValue])
-            {
-                DDLogVerbose(@"Item is not writable: '%@'", item);
-                continue;
+        }
+    }
+    for (Note *note in addedNotes)
+    {
+        if (!note.deleted && ![self.sortedVisibleNotes containsObject:note])
+        {
+            [insertedNotes addObject:note];
+        }
+    }
+    
+    for (Note *note in removedNotes)
+    {
+        [self.sortedVisibleNotes removeObject:note];
+    }
+    for (Note *note in insertedNotes)
+    {
+        [self.sortedVisibleNotes addObject:note];
+    }
+    
+    //Insertions are indexed as the notes are after the changes
+    for (Note *note in insertedNotes)
+    {
+        NSUInteger index = [self.sortedVisibleNotes indexOfObject:note];
+        if (index != NSNotFound)
+        {
+            [insertedIndexes addIndex:index];
+        }
+    }
+    
+    //Publish the new version for readers
+    GRKSortedSetSnapshot *snapshot = [self.sortedVisibleNotes snapshot];
+    self.visibleNotesSnapshot = snapshot;
+    
+    NSDictionary *retVal = @{kNoteNotificationInfoKeyDeletedIndexes: deletedIndexes, kNoteNotificationInfoKeyInsertedIndexes: insertedIndexes, kNoteNotificationInfoKeyReloadedIndexes: reloadedIndexes, kNoteNotificationInfoKeyVisibleNotes: snapshot};
+    
+    return retVal;
+}
+
+/**
+ Fetches Note objects from the given directory.
+ The directory is listed in a single pass, which only includes readable and writable regular files. The entries are then split into chunks which are processed concurrently, each worker building the notes for its chunk. The results are merged in directory order, so the outcome does not depend on scheduling.
+ Note metadata is taken from the note index when the index entry for a file is still valid, and is otherwise read from the file itself. Notes without a local ID are assigned one.
+ @param directory    The directory in which to locate notes.
+ @param indexedCount If not `NULL`, receives the number of notes whose metadata was taken from the note index.
+ @return An NSArray of Note objects (or an empty NSArray if none were found).
+ */
+- (NSArray *)fetchNotesFromDirectory:(NSURL *)directory indexedCount:(NSUInteger *)indexedCount
+{
+    NSArray *retVal = nil;
+    NSUInteger indexed = 0;
+    
+    __autoreleasing NSError *error = nil;
+    GRKDirectoryListingOptions options = GRKDirectoryListingSkipsHiddenFiles | GRKDirectoryListingRegularFilesOnly | GRKDirectoryListingReadableWritableOnly;
+    GRKDirectoryListing *listing = [self.grkFileManager listingOfDirectory:directory options:options error:&error];
+    
+    if (listing)
+    {
+        NSUInteger entryCount = listing.count;
+        size_t chunkCount = (entryCount + kNoteScanChunkSize - 1) / kNoteScanChunkSize;
+        
+        //One slot per chunk, filled in by the workers
+        NSMutableArray *chunkNotes = [NSMutableArray arrayWithCapacity:chunkCount];
+        NSMutableArray *chunkIndexedCounts = [NSMutableArray arrayWithCapacity:chunkCount];
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            [chunkNotes addObject:[NSNull null]];
+            [chunkIndexedCounts addObject:@0];
+        }
+        
+        dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+            @autoreleasepool {
+                NSUInteger location = chunk * kNoteScanChunkSize;
+                NSUInteger limit = MIN(location + kNoteScanChunkSize, entryCount);
+                NSMutableArray *notes = [NSMutableArray arrayWithCapacity:limit - location];
+                NSUInteger chunkIndexed = 0;
+                for (NSUInteger index = location; index < limit; ++index)
+                {
+                    const GRKDirectoryEntry *directoryEntry = [listing entryAtIndex:index];
+                    NoteIndexEntry *entry = [self.noteIndex validEntryForDirectoryEntry:directoryEntry inListing:listing];
+                    if (entry)
+                    {
+                        chunkIndexed++;
+                    }
+                    
+                    Note *note = [[Note alloc] init];
+                    [note setFile:[listing URLOfEntry:directoryEntry] indexEntry:entry];
+                    
+                    //If we don't have a local ID, then create one, since we must track this note.
+                    if (!note.localID)
+                    {
+                        [note writeLocalID:[NSString UUID]];
+                    }
+                    
+                    [notes addObject:note];
+                }
+                
+                @synchronized(chunkNotes)
+                {
+                    [chunkNotes replaceObjectAtIndex:chunk withObject:notes];
+                    [chunkIndexedCounts replaceObjectAtIndex:chunk withObject:@(chunkIndexed)];
+                }
             }
-            
-            Note *note = [[Note alloc] init];
-            note.file = item;
-            [notes addObject:note];
+        });
+        
+        //Merge the chunks in order
+        NSMutableArray *notes = [NSMutableArray arrayWithCapacity:entryCount];
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            [notes addObjectsFromArray:[chunkNotes objectAtIndex:chunk]];
+            indexed += [[chunkIndexedCounts objectAtIndex:chunk] unsignedIntegerValue];
         }
         
         retVal = notes;
@@ -951,6 +2677,11 @@ static NSUInteger const kMaxUniqueFilenameAttempts = 1000;
         DDLogError(@"Unable to list contents of directory '%@'. Error: %@", directory, error);
     }
     
+    if (indexedCount)
+    {
+        *indexedCount = indexed;
+    }
+    
     return retVal;
 }
 
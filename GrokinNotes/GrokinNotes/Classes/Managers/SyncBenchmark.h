@@ -0,0 +1,87 @@
+//
+//  SyncBenchmark.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#if DEBUG
+
+@class FakeDriveServer;
+@class NoteManager;
+
+extern NSString * const SyncBenchmarkErrorDomain;
+
+typedef NS_ENUM(NSInteger, SyncBenchmarkError) {
+    SyncBenchmarkErrorNotesExist = 1
+};
+
+/**
+ Measures synchronization end to end against a FakeDriveServer. DEBUG builds only.
+ A run creates `noteCount` notes and synchronizes them, then runs `rounds` rounds, each of which edits its share of `editCount` notes locally and makes its share of `remoteChangeCount` changes (creations, edits and trashes) on the server before synchronizing.
+ The report gives the throughput of each phase, percentiles of the synchronization durations, and percentiles of the server's request durations by kind of request.
+ Notes are created in the documents directory, so a run refuses to start if any notes exist; run it on a fresh install (i.e. in the simulator). Recurring synchronization is stopped while the benchmark runs, and the server is left running afterwards so the app keeps working against it.
+ */
+@interface SyncBenchmark : NSObject
+
+/**
+ The number of notes created and synchronized before the rounds. Defaults to 100.
+ */
+@property (nonatomic,assign) NSUInteger noteCount;
+
+/**
+ The number of local edits, spread over the rounds. Defaults to 100.
+ */
+@property (nonatomic,assign) NSUInteger editCount;
+
+/**
+ The number of remote changes, spread over the rounds. Defaults to 100.
+ */
+@property (nonatomic,assign) NSUInteger remoteChangeCount;
+
+/**
+ The number of synchronizations measured after the first. Defaults to 10.
+ */
+@property (nonatomic,assign) NSUInteger rounds;
+
+/**
+ The length, in bytes, of the content written to each note. Defaults to 2048.
+ */
+@property (nonatomic,assign) NSUInteger contentLength;
+
+/**
+ The server, whose latency, bandwidth and error rate can be set before the run.
+ */
+@property (nonatomic,strong,readonly) FakeDriveServer *server;
+
+/**
+ Creates a benchmark.
+
+ @param noteManager The note manager to measure, which must not have been started up (see `-[NoteManager startup:]`).
+ @param seed        The seed for the workload and the server's error injection, so runs can be repeated exactly.
+
+ @return A new benchmark.
+ */
+- (instancetype)initWithNoteManager:(NoteManager *)noteManager seed:(uint32_t)seed;
+
+/**
+ Starts the server, points the note manager at it, starts up the note manager and runs the workload. Call on the main queue.
+
+ @param completion Called on the main queue with the report, or error.
+ */
+- (void)run:(void(^)(NSString *report, NSError *error))completion;
+
+/**
+ Runs a benchmark with the shared note manager and logs the report, if the app was launched with `-SyncBenchmark YES`.
+ The workload and server are configured with the launch arguments `-SyncBenchmarkNotes`, `-SyncBenchmarkEdits`, `-SyncBenchmarkRemoteChanges`, `-SyncBenchmarkRounds`, `-SyncBenchmarkLatency` (in milliseconds), `-SyncBenchmarkBandwidth` (in bytes per second) and `-SyncBenchmarkErrorRate`. Call on the main queue, before anything starts up the note manager.
+
+ @return `YES` if a benchmark was started.
+ */
++ (BOOL)runIfRequested;
+
+@end
+
+#endif
@@ -0,0 +1,369 @@
+//
+//  SyncBenchmark.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "SyncBenchmark.h"
+
+#if DEBUG
+
+#import "FakeDriveServer.h"
+#import "NoteManager.h"
+#import "GoogleDriveManager.h"
+#import "SyncScheduler.h"
+#import "Note.h"
+#import "GRKMetrics.h"
+
+NSString * const SyncBenchmarkErrorDomain = @"SyncBenchmark";
+
+static NSString * const kSyncBenchmarkArgument = @"SyncBenchmark";
+static NSString * const kSyncBenchmarkArgumentNotes = @"SyncBenchmarkNotes";
+static NSString * const kSyncBenchmarkArgumentEdits = @"SyncBenchmarkEdits";
+static NSString * const kSyncBenchmarkArgumentRemoteChanges = @"SyncBenchmarkRemoteChanges";
+static NSString * const kSyncBenchmarkArgumentRounds = @"SyncBenchmarkRounds";
+static NSString * const kSyncBenchmarkArgumentLatency = @"SyncBenchmarkLatency";
+static NSString * const kSyncBenchmarkArgumentBandwidth = @"SyncBenchmarkBandwidth";
+static NSString * const kSyncBenchmarkArgumentErrorRate = @"SyncBenchmarkErrorRate";
+
+static NSUInteger const kSyncBenchmarkDefaultNoteCount = 100;
+static NSUInteger const kSyncBenchmarkDefaultEditCount = 100;
+static NSUInteger const kSyncBenchmarkDefaultRemoteChangeCount = 100;
+static NSUInteger const kSyncBenchmarkDefaultRounds = 10;
+static NSUInteger const kSyncBenchmarkDefaultContentLength = 2048;
+static uint32_t const kSyncBenchmarkDefaultSeed = 0x5EED;
+
+//The benchmark started by runIfRequested, which (with its server) lives as long as the app
+static SyncBenchmark *SyncBenchmarkRequested = nil;
+
+#pragma mark - Helpers
+
+//The share of `count` which falls to the given round, when spread evenly over `rounds` rounds
+static NSUInteger SyncBenchmarkShare(NSUInteger count, NSUInteger rounds, NSUInteger round)
+{
+    return count * (round + 1) / rounds - count * round / rounds;
+}
+
+//The nearest rank percentile of the given ascending values
+static double SyncBenchmarkPercentile(NSArray *sortedValues, double percentile)
+{
+    double retVal = 0;
+    if (sortedValues.count > 0)
+    {
+        NSUInteger rank = (NSUInteger)ceil(percentile * sortedValues.count);
+        retVal = [[sortedValues objectAtIndex:MAX(rank, 1) - 1] doubleValue];
+    }
+    return retVal;
+}
+
+static NSString *SyncBenchmarkSummary(NSArray *values, double scale, NSString *unit)
+{
+    NSArray *sortedValues = [values sortedArrayUsingSelector:@selector(compare:)];
+    return [NSString stringWithFormat:@"%lu, p50 %.1f %@, p90 %.1f %@, p99 %.1f %@, max %.1f %@", (unsigned long)sortedValues.count,
+            SyncBenchmarkPercentile(sortedValues, 0.5) * scale, unit,
+            SyncBenchmarkPercentile(sortedValues, 0.9) * scale, unit,
+            SyncBenchmarkPercentile(sortedValues, 0.99) * scale, unit,
+            SyncBenchmarkPercentile(sortedValues, 1.0) * scale, unit];
+}
+
+static NSUInteger SyncBenchmarkArgument(NSUserDefaults *defaults, NSString *key, NSUInteger defaultValue)
+{
+    return [defaults objectForKey:key] ? (NSUInteger)MAX(0, [defaults integerForKey:key]) : defaultValue;
+}
+
+@interface SyncBenchmark ()
+{
+    uint32_t _randomState;
+}
+
+@property (nonatomic,strong) NoteManager *noteManager;
+@property (nonatomic,strong,readwrite) FakeDriveServer *server;
+@property (nonatomic,assign) NSUInteger revision;
+@property (nonatomic,assign) NSUInteger remoteNoteNumber;
+@property (nonatomic,assign) NSTimeInterval initialDuration;
+@property (nonatomic,strong) NSMutableArray *roundDurations;
+@property (nonatomic,assign) NSUInteger errorCount;
+
+@end
+
+@implementation SyncBenchmark
+
+#pragma mark - Initialization
+
+- (instancetype)initWithNoteManager:(NoteManager *)noteManager seed:(uint32_t)seed
+{
+    if ((self = [super init]))
+    {
+        _randomState = seed ?: 1;
+        self.noteManager = noteManager;
+        self.server = [[FakeDriveServer alloc] initWithSeed:seed];
+        self.noteCount = kSyncBenchmarkDefaultNoteCount;
+        self.editCount = kSyncBenchmarkDefaultEditCount;
+        self.remoteChangeCount = kSyncBenchmarkDefaultRemoteChangeCount;
+        self.rounds = kSyncBenchmarkDefaultRounds;
+        self.contentLength = kSyncBenchmarkDefaultContentLength;
+        self.roundDurations = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
++ (BOOL)runIfRequested
+{
+    BOOL retVal = NO;
+
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    if ([defaults boolForKey:kSyncBenchmarkArgument] && !SyncBenchmarkRequested)
+    {
+        SyncBenchmark *benchmark = [[SyncBenchmark alloc] initWithNoteManager:[NoteManager shared] seed:kSyncBenchmarkDefaultSeed];
+        benchmark.noteCount = SyncBenchmarkArgument(defaults, kSyncBenchmarkArgumentNotes, kSyncBenchmarkDefaultNoteCount);
+        benchmark.editCount = SyncBenchmarkArgument(defaults, kSyncBenchmarkArgumentEdits, kSyncBenchmarkDefaultEditCount);
+        benchmark.remoteChangeCount = SyncBenchmarkArgument(defaults, kSyncBenchmarkArgumentRemoteChanges, kSyncBenchmarkDefaultRemoteChangeCount);
+        benchmark.rounds = SyncBenchmarkArgument(defaults, kSyncBenchmarkArgumentRounds, kSyncBenchmarkDefaultRounds);
+        benchmark.server.latency = [defaults doubleForKey:kSyncBenchmarkArgumentLatency] / 1000.0;
+        benchmark.server.bytesPerSecond = SyncBenchmarkArgument(defaults, kSyncBenchmarkArgumentBandwidth, 0);
+        benchmark.server.errorRate = [defaults doubleForKey:kSyncBenchmarkArgumentErrorRate];
+        SyncBenchmarkRequested = benchmark;
+
+        DDLogVerbose(@"Starting sync benchmark.");
+        [benchmark run:^(NSString *report, NSError *error) {
+            if (report)
+            {
+                DDLogInfo(@"%@", report);
+            }
+            else
+            {
+                DDLogError(@"Sync benchmark failed. Error: %@", error);
+            }
+        }];
+        retVal = YES;
+    }
+
+    return retVal;
+}
+
+- (void)run:(void(^)(NSString *report, NSError *error))completion
+{
+    __autoreleasing NSError *serverError = nil;
+    if ([self.server start:&serverError])
+    {
+        [self.noteManager.driveManager startupWithServiceURL:self.server.baseURL authorizer:self.server.authorizer];
+        [self.noteManager startup:^(NSError *error) {
+            if (error)
+            {
+                completion(nil, error);
+            }
+            else if (self.noteManager.visibleNotes.count > 0)
+            {
+                NSString *message = [NSString stringWithFormat:@"The sync benchmark needs an empty note store, but there are %lu notes.", (unsigned long)self.noteManager.visibleNotes.count];
+                NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+                [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+                completion(nil, [NSError errorWithDomain:SyncBenchmarkErrorDomain code:SyncBenchmarkErrorNotesExist userInfo:userInfo]);
+            }
+            else
+            {
+                [self runWorkload:completion];
+            }
+        }];
+    }
+    else
+    {
+        completion(nil, serverError);
+    }
+}
+
+#pragma mark - Helpers
+
+- (void)runWorkload:(void(^)(NSString *report, NSError *error))completion
+{
+    [self.server resetStatistics];
+    [[GRKMetrics sharedMetrics] reset];
+    [self createNotes:self.noteCount completion:^{
+        [self measureSynchronization:^(NSTimeInterval duration, NSArray *errors) {
+            self.initialDuration = duration;
+            self.errorCount += errors.count;
+            [self runRound:0 completion:^{
+                [self.noteManager.syncScheduler start];
+                completion([self report], nil);
+            }];
+        }];
+    }];
+}
+
+- (void)runRound:(NSUInteger)round completion:(void(^)(void))completion
+{
+    if (round < self.rounds)
+    {
+        NSArray *visibleNotes = self.noteManager.visibleNotes;
+        NSUInteger editCount = SyncBenchmarkShare(self.editCount, self.rounds, round);
+        NSMutableArray *notes = [NSMutableArray arrayWithCapacity:editCount];
+        for (NSUInteger i = 0; i < editCount && visibleNotes.count > 0; ++i)
+        {
+            [notes addObject:[visibleNotes objectAtIndex:[self nextRandom] % visibleNotes.count]];
+        }
+
+        [self writeNotes:notes completion:^{
+            [self makeRemoteChanges:SyncBenchmarkShare(self.remoteChangeCount, self.rounds, round)];
+            [self measureSynchronization:^(NSTimeInterval duration, NSArray *errors) {
+                [self.roundDurations addObject:[NSNumber numberWithDouble:duration]];
+                self.errorCount += errors.count;
+                [self runRound:round + 1 completion:completion];
+            }];
+        }];
+    }
+    else
+    {
+        completion();
+    }
+}
+
+- (void)measureSynchronization:(void(^)(NSTimeInterval duration, NSArray *errors))completion
+{
+    //Only the benchmark's own synchronizations should run (starting up the note manager again restarts the schedule)
+    [self.noteManager.syncScheduler stop];
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    [self.noteManager synchronize:^(NSArray *errors) {
+        completion(CFAbsoluteTimeGetCurrent() - start, errors);
+    }];
+}
+
+- (void)createNotes:(NSUInteger)count completion:(void(^)(void))completion
+{
+    if (count > 0)
+    {
+        [self.noteManager createNewUniqueNote:^(Note *note, NSError *error) {
+            if (note)
+            {
+                [self writeNotes:@[note] completion:^{
+                    [self createNotes:count - 1 completion:completion];
+                }];
+            }
+            else
+            {
+                DDLogError(@"Sync benchmark unable to create a note. Error: %@", error);
+                self.errorCount += 1;
+                [self createNotes:count - 1 completion:completion];
+            }
+        }];
+    }
+    else
+    {
+        completion();
+    }
+}
+
+//Writes new content to each of the given notes in turn, as the note editor does
+- (void)writeNotes:(NSArray *)notes completion:(void(^)(void))completion
+{
+    if (notes.count > 0)
+    {
+        Note *note = [notes firstObject];
+        [note writeContent:[self nextContent] completion:^(BOOL changed, NSString *content, NSError *error) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if (error)
+                {
+                    DDLogError(@"Sync benchmark unable to write note '%@'. Error: %@", note, error);
+                    self.errorCount += 1;
+                }
+                else if (changed)
+                {
+                    [self.noteManager noteWasModified:note];
+                }
+                [self writeNotes:[notes subarrayWithRange:NSMakeRange(1, notes.count - 1)] completion:completion];
+            });
+        }];
+    }
+    else
+    {
+        completion();
+    }
+}
+
+//Changes files on the server as another client would: a fifth are creations, a tenth are trashes, and the rest are edits
+- (void)makeRemoteChanges:(NSUInteger)count
+{
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        NSArray *fileIDs = [self.server fileIDs];
+        uint32_t choice = [self nextRandom] % 10;
+        if (fileIDs.count == 0 || choice < 2)
+        {
+            self.remoteNoteNumber += 1;
+            NSString *title = [NSString stringWithFormat:@"Remote %lu", (unsigned long)self.remoteNoteNumber];
+            [self.server insertFileWithTitle:title content:[[self nextContent] dataUsingEncoding:NSUTF8StringEncoding]];
+        }
+        else if (choice < 3)
+        {
+            [self.server trashFileWithID:[fileIDs objectAtIndex:[self nextRandom] % fileIDs.count]];
+        }
+        else
+        {
+            [self.server updateFileWithID:[fileIDs objectAtIndex:[self nextRandom] % fileIDs.count] content:[[self nextContent] dataUsingEncoding:NSUTF8StringEncoding]];
+        }
+    }
+}
+
+//Distinct content of `contentLength` bytes (at least)
+- (NSString *)nextContent
+{
+    static const char letters[] = "etaoin shrdlu";
+
+    self.revision += 1;
+    NSData *header = [[NSString stringWithFormat:@"Revision %lu\n", (unsigned long)self.revision] dataUsingEncoding:NSASCIIStringEncoding];
+    NSMutableData *content = [NSMutableData dataWithData:header];
+    NSUInteger fillLength = self.contentLength > header.length ? self.contentLength - header.length : 0;
+    [content setLength:header.length + fillLength];
+    char *fill = (char *)content.mutableBytes + header.length;
+    for (NSUInteger i = 0; i < fillLength; ++i)
+    {
+        fill[i] = letters[[self nextRandom] % (sizeof(letters) - 1)];
+    }
+    return [[NSString alloc] initWithData:content encoding:NSASCIIStringEncoding];
+}
+
+- (uint32_t)nextRandom
+{
+    //xorshift32
+    _randomState ^= _randomState << 13;
+    _randomState ^= _randomState >> 17;
+    _randomState ^= _randomState << 5;
+    return _randomState;
+}
+
+- (NSString *)report
+{
+    FakeDriveServer *server = self.server;
+    NSMutableString *retVal = [NSMutableString string];
+
+    NSString *bandwidth = server.bytesPerSecond > 0 ? [NSString stringWithFormat:@"%lu bytes/s", (unsigned long)server.bytesPerSecond] : @"unlimited";
+    [retVal appendFormat:@"Sync benchmark: %lu notes, %lu edits and %lu remote changes over %lu rounds (latency %.0f ms, bandwidth %@, error rate %.2f).\n", (unsigned long)self.noteCount, (unsigned long)self.editCount, (unsigned long)self.remoteChangeCount, (unsigned long)self.rounds, server.latency * 1000.0, bandwidth, server.errorRate];
+
+    NSTimeInterval initialDuration = self.initialDuration;
+    [retVal appendFormat:@"Initial synchronization: %lu notes in %.2f s (%.1f notes/s).\n", (unsigned long)self.noteCount, initialDuration, initialDuration > 0 ? self.noteCount / initialDuration : 0];
+
+    NSTimeInterval roundsDuration = [[self.roundDurations valueForKeyPath:@"@sum.doubleValue"] doubleValue];
+    NSUInteger roundChanges = self.editCount + self.remoteChangeCount;
+    [retVal appendFormat:@"Rounds: %lu changes in %.2f s (%.1f changes/s).\n", (unsigned long)roundChanges, roundsDuration, roundsDuration > 0 ? roundChanges / roundsDuration : 0];
+    [retVal appendFormat:@"Synchronization durations: %@.\n", SyncBenchmarkSummary(self.roundDurations, 1.0, @"s")];
+    [retVal appendFormat:@"Errors: %lu.\n", (unsigned long)self.errorCount];
+
+    NSDictionary *requestDurations = [server requestDurations];
+    [retVal appendString:@"Request durations:\n"];
+    for (NSString *kind in [[requestDurations allKeys] sortedArrayUsingSelector:@selector(compare:)])
+    {
+        [retVal appendFormat:@"  %@: %@\n", kind, SyncBenchmarkSummary([requestDurations objectForKey:kind], 1000.0, @"ms")];
+    }
+    [retVal appendFormat:@"Transferred: %llu bytes up, %llu bytes down.\n", server.bytesReceived, server.bytesSent];
+    [retVal appendFormat:@"Metrics:\n%@", [[GRKMetrics sharedMetrics] snapshot]];
+
+    return retVal;
+}
+
+@end
+
+#endif
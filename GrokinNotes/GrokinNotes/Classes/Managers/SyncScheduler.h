@@ -0,0 +1,88 @@
+//
+//  SyncScheduler.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The name of the notification which is sent when the state of a SyncScheduler changes. The notification object is the scheduler.
+ */
+extern NSString * const kSyncSchedulerNotificationStateChanged;
+
+typedef NS_ENUM(NSInteger, SyncSchedulerState) {
+    SyncSchedulerStateStopped = 0,
+    SyncSchedulerStateWaiting,
+    SyncSchedulerStateSynchronizing
+};
+
+/**
+ The block which performs a synchronization on behalf of the scheduler. It must call `completion` (on the main queue) exactly once, indicating if anything was changed by the synchronization and any errors which occurred (`nil` if none).
+ */
+typedef void (^SyncSchedulerSyncBlock)(void(^completion)(BOOL changed, NSArray *errors));
+
+/**
+ Decides when synchronization should occur.
+ Synchronizations which find nothing to do, or fail, back off exponentially from `minimumInterval` up to `maximumInterval`. Local changes cause a synchronization shortly after the changes settle (`debounceInterval`), and explicit requests cause one immediately. Only one synchronization runs at a time; requests made while one is running are coalesced into a single follow up synchronization.
+ All methods must be called on the main queue. The published properties are KVO compliant, and `kSyncSchedulerNotificationStateChanged` is posted whenever they change.
+ */
+@interface SyncScheduler : NSObject
+
+@property (nonatomic,assign,readonly) SyncSchedulerState state;
+/**
+ The time, in seconds, which will be waited before the next recurring synchronization.
+ */
+@property (nonatomic,assign,readonly) NSTimeInterval currentInterval;
+/**
+ The number of synchronizations in a row which have failed.
+ */
+@property (nonatomic,assign,readonly) NSUInteger consecutiveFailures;
+/**
+ When the next synchronization is scheduled to start, or `nil` if none is scheduled.
+ */
+@property (nonatomic,strong,readonly) NSDate *nextSynchronizationDate;
+/**
+ When the last synchronization completed, or `nil` if none has.
+ */
+@property (nonatomic,strong,readonly) NSDate *lastSynchronizationDate;
+
+@property (nonatomic,assign) NSTimeInterval minimumInterval;
+@property (nonatomic,assign) NSTimeInterval maximumInterval;
+@property (nonatomic,assign) NSTimeInterval debounceInterval;
+
+/**
+ Creates a stopped scheduler.
+
+ @param syncBlock The block which performs a synchronization.
+
+ @return A new scheduler.
+ */
+- (instancetype)initWithSyncBlock:(SyncSchedulerSyncBlock)syncBlock;
+
+/**
+ Starts recurring synchronization, with an immediate first synchronization.
+ */
+- (void)start;
+
+/**
+ Stops recurring synchronization. A synchronization in progress is allowed to finish.
+ */
+- (void)stop;
+
+/**
+ Requests a synchronization as soon as possible. If one is in progress, another will follow it.
+ This works even when the scheduler is stopped, though no recurring synchronization will follow.
+
+ @param completion Called once a synchronization which started after this request completes, with an array of NSError objects which may have occurred (the array will be `nil` if no errors occurred).
+ */
+- (void)requestSynchronization:(void(^)(NSArray *errors))completion;
+
+/**
+ Informs the scheduler of a local change which should be synchronized. A synchronization will occur once no further changes have been reported for `debounceInterval`, and the interval is reset to `minimumInterval`.
+ */
+- (void)localChangeOccurred;
+
+@end
@@ -0,0 +1,219 @@
+//
+//  SyncScheduler.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "SyncScheduler.h"
+
+NSString * const kSyncSchedulerNotificationStateChanged = @"SyncSchedulerNotificationStateChanged";
+
+static NSTimeInterval const kDefaultMinimumInterval = 5.0f;
+static NSTimeInterval const kDefaultMaximumInterval = 300.0f;
+static NSTimeInterval const kDefaultDebounceInterval = 2.0f;
+
+@interface SyncScheduler ()
+
+@property (nonatomic,assign,readwrite) SyncSchedulerState state;
+@property (nonatomic,assign,readwrite) NSTimeInterval currentInterval;
+@property (nonatomic,assign,readwrite) NSUInteger consecutiveFailures;
+@property (nonatomic,strong,readwrite) NSDate *nextSynchronizationDate;
+@property (nonatomic,strong,readwrite) NSDate *lastSynchronizationDate;
+@property (nonatomic,copy) SyncSchedulerSyncBlock syncBlock;
+@property (nonatomic,assign) BOOL started;
+@property (nonatomic,assign) BOOL synchronizing;
+//A synchronization was requested while one was in progress
+@property (nonatomic,assign) BOOL followUpRequested;
+//Completion blocks waiting for the next synchronization to complete
+@property (nonatomic,strong) NSMutableArray *pendingCompletions;
+//Incremented to invalidate previously scheduled timers
+@property (nonatomic,assign) NSUInteger timerGeneration;
+@property (nonatomic,assign) NSUInteger debounceGeneration;
+
+@end
+
+@implementation SyncScheduler
+
+#pragma mark - Initialization
+
+- (instancetype)initWithSyncBlock:(SyncSchedulerSyncBlock)syncBlock
+{
+    if ((self = [super init]))
+    {
+        self.syncBlock = syncBlock;
+        self.minimumInterval = kDefaultMinimumInterval;
+        self.maximumInterval = kDefaultMaximumInterval;
+        self.debounceInterval = kDefaultDebounceInterval;
+        self.currentInterval = kDefaultMinimumInterval;
+        self.pendingCompletions = [NSMutableArray array];
+        self.state = SyncSchedulerStateStopped;
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (void)start
+{
+    if (!self.started)
+    {
+        DDLogVerbose(@"Synchronize: Started recurring process.");
+        self.started = YES;
+        self.currentInterval = self.minimumInterval;
+        if (self.synchronizing)
+        {
+            self.followUpRequested = YES;
+        }
+        else
+        {
+            [self scheduleAfter:0];
+        }
+    }
+}
+
+- (void)stop
+{
+    if (self.started)
+    {
+        DDLogVerbose(@"Synchronize: Stopped recurring process.");
+        self.started = NO;
+        self.timerGeneration++;
+        self.debounceGeneration++;
+        self.nextSynchronizationDate = nil;
+        [self updateState];
+    }
+}
+
+- (void)requestSynchronization:(void(^)(NSArray *errors))completion
+{
+    if (completion)
+    {
+        [self.pendingCompletions addObject:[completion copy]];
+    }
+
+    if (self.synchronizing)
+    {
+        self.followUpRequested = YES;
+    }
+    else
+    {
+        [self scheduleAfter:0];
+    }
+}
+
+- (void)localChangeOccurred
+{
+    //The user is active, so return to polling frequently
+    self.currentInterval = self.minimumInterval;
+
+    if (self.started)
+    {
+        //Each change pushes the synchronization back, so a burst of edits results in one synchronization
+        NSUInteger generation = ++self.debounceGeneration;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.debounceInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            if (generation == self.debounceGeneration && self.started)
+            {
+                [self requestSynchronization:nil];
+            }
+        });
+    }
+}
+
+#pragma mark - Helpers
+
+- (void)scheduleAfter:(NSTimeInterval)delay
+{
+    NSDate *fireDate = [NSDate dateWithTimeIntervalSinceNow:delay];
+    //Never push back an earlier synchronization
+    if (self.nextSynchronizationDate && [self.nextSynchronizationDate compare:fireDate] == NSOrderedAscending)
+    {
+        return;
+    }
+
+    NSUInteger generation = ++self.timerGeneration;
+    self.nextSynchronizationDate = fireDate;
+    [self updateState];
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        if (generation == self.timerGeneration)
+        {
+            [self synchronize];
+        }
+    });
+}
+
+- (void)synchronize
+{
+    if (self.synchronizing)
+    {
+        self.followUpRequested = YES;
+        return;
+    }
+
+    //These completions are satisfied by this synchronization; any new requests wait for the next one
+    NSArray *completions = [self.pendingCompletions copy];
+    [self.pendingCompletions removeAllObjects];
+
+    self.synchronizing = YES;
+    self.followUpRequested = NO;
+    self.timerGeneration++;
+    self.nextSynchronizationDate = nil;
+    [self updateState];
+
+    self.syncBlock(^(BOOL changed, NSArray *errors) {
+        self.synchronizing = NO;
+        self.lastSynchronizationDate = [NSDate date];
+
+        if (errors)
+        {
+            self.consecutiveFailures++;
+            self.currentInterval = MIN(self.maximumInterval, self.currentInterval * 2);
+        }
+        else
+        {
+            self.consecutiveFailures = 0;
+            //Keep polling frequently while there is activity, and back off while there is none
+            self.currentInterval = changed ? self.minimumInterval : MIN(self.maximumInterval, self.currentInterval * 2);
+        }
+
+        for (void(^completion)(NSArray *errors) in completions)
+        {
+            completion(errors);
+        }
+
+        if (self.followUpRequested || self.pendingCompletions.count > 0)
+        {
+            [self scheduleAfter:0];
+        }
+        else if (self.started)
+        {
+            DDLogVerbose(@"Synchronize: Waiting (%.2f seconds) for next attempt.", self.currentInterval);
+            [self scheduleAfter:self.currentInterval];
+        }
+        else
+        {
+            [self updateState];
+        }
+    });
+}
+
+- (void)updateState
+{
+    SyncSchedulerState state = SyncSchedulerStateStopped;
+    if (self.synchronizing)
+    {
+        state = SyncSchedulerStateSynchronizing;
+    }
+    else if (self.nextSynchronizationDate)
+    {
+        state = SyncSchedulerStateWaiting;
+    }
+
+    self.state = state;
+    [[NSNotificationCenter defaultCenter] postNotificationName:kSyncSchedulerNotificationStateChanged object:self];
+}
+
+@end
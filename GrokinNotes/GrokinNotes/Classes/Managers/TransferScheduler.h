@@ -0,0 +1,107 @@
+//
+//  TransferScheduler.h
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The priority classes of transfers, from most to least urgent.
+ */
+typedef NS_ENUM(NSInteger, TransferPriority) {
+    //The note the user has open
+    TransferPriorityOpen = 0,
+    //Notes the user can see in the list
+    TransferPriorityVisible,
+    //Everything else
+    TransferPriorityBackground,
+    TransferPriorityCount
+};
+
+typedef NS_ENUM(NSInteger, TransferDirection) {
+    TransferDirectionUpload = 0,
+    TransferDirectionDownload,
+    TransferDirectionCount
+};
+
+/**
+ The block which performs a transfer. It must call `done` (on any queue) exactly once when the transfer has completed, indicating if it succeeded and the number of bytes transferred.
+ */
+typedef void (^TransferOperation)(void(^done)(BOOL success, unsigned long long bytesTransferred));
+
+/**
+ A snapshot of the statistics for one priority class of a TransferScheduler.
+ */
+@interface TransferStatistics : NSObject
+
+@property (nonatomic,assign,readonly) NSUInteger completedTransfers;
+@property (nonatomic,assign,readonly) NSUInteger failedTransfers;
+@property (nonatomic,assign,readonly) unsigned long long bytesTransferred;
+/**
+ The time, in seconds, during which at least one transfer of the class was running.
+ */
+@property (nonatomic,assign,readonly) NSTimeInterval activeTime;
+/**
+ The average time, in seconds, transfers of the class waited to start.
+ */
+@property (nonatomic,assign,readonly) NSTimeInterval averageWaitTime;
+/**
+ The number of bytes transferred per second of `activeTime`.
+ */
+@property (nonatomic,assign,readonly) double bytesPerSecond;
+
+@end
+
+/**
+ Runs transfers with at most `maximumConcurrentTransfers` in flight, choosing the next transfer to start by priority class.
+ The priority of a transfer is that of its key at the time it is started (see setKeys:forPriority:), so transfers move between classes as the user moves around. Within a class, uploads and downloads take turns, and transfers in the same direction start in the order they were enqueued.
+ All methods must be called on the main queue.
+ */
+@interface TransferScheduler : NSObject
+
+/**
+ The maximum number of transfers which run at once. Defaults to 4, which leaves room below the per host limit of the HTTP fetcher service for other requests, so that it is this scheduler, rather than the fetcher service, which orders transfers.
+ */
+@property (nonatomic,assign) NSUInteger maximumConcurrentTransfers;
+
+/**
+ The number of transfers waiting to start.
+ */
+@property (nonatomic,assign,readonly) NSUInteger pendingTransferCount;
+
+/**
+ The number of transfers in flight.
+ */
+@property (nonatomic,assign,readonly) NSUInteger activeTransferCount;
+
+/**
+ Enqueues a transfer.
+
+ @param key       Identifies what is being transferred (a note's local ID, or the remote ID of a file with no local note), which determines the priority of the transfer.
+ @param direction The direction of the transfer.
+ @param operation The block which performs the transfer.
+ */
+- (void)enqueueTransferForKey:(NSString *)key direction:(TransferDirection)direction operation:(TransferOperation)operation;
+
+/**
+ Sets the keys which belong to the given priority class, replacing those previously set for it. Keys which belong to no class are TransferPriorityBackground, and a key in more than one class takes the most urgent one.
+ Transfers waiting to start are moved to their new class.
+
+ @param keys     An NSSet of keys.
+ @param priority The priority class. Setting the keys for TransferPriorityBackground has no effect.
+ */
+- (void)setKeys:(NSSet *)keys forPriority:(TransferPriority)priority;
+
+/**
+ Gets the statistics of the given priority class since the scheduler was created.
+
+ @param priority The priority class.
+
+ @return A TransferStatistics snapshot.
+ */
+- (TransferStatistics *)statisticsForPriority:(TransferPriority)priority;
+
+@end
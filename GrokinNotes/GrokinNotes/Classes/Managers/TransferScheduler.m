@@ -0,0 +1,298 @@
+//
+//  TransferScheduler.m
+//  GrokinNotes
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "TransferScheduler.h"
+
+static NSUInteger const kDefaultMaximumConcurrentTransfers = 4;
+
+@interface TransferStatistics ()
+
+@property (nonatomic,assign,readwrite) NSUInteger completedTransfers;
+@property (nonatomic,assign,readwrite) NSUInteger failedTransfers;
+@property (nonatomic,assign,readwrite) unsigned long long bytesTransferred;
+@property (nonatomic,assign,readwrite) NSTimeInterval activeTime;
+@property (nonatomic,assign,readwrite) NSTimeInterval averageWaitTime;
+@property (nonatomic,assign,readwrite) double bytesPerSecond;
+//Bookkeeping used while collecting
+@property (nonatomic,assign) NSUInteger startedTransfers;
+@property (nonatomic,assign) NSUInteger activeTransfers;
+@property (nonatomic,assign) NSTimeInterval totalWaitTime;
+@property (nonatomic,strong) NSDate *activeSince;
+
+@end
+
+@implementation TransferStatistics
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> completed: %lu failed: %lu bytes: %llu active: %.2fs wait: %.2fs throughput: %.0f B/s", NSStringFromClass(self.class), self, (unsigned long)self.completedTransfers, (unsigned long)self.failedTransfers, self.bytesTransferred, self.activeTime, self.averageWaitTime, self.bytesPerSecond];
+}
+
+@end
+
+/**
+ A transfer waiting to start.
+ */
+@interface Transfer : NSObject
+
+@property (nonatomic,copy) NSString *key;
+@property (nonatomic,assign) TransferDirection direction;
+@property (nonatomic,assign) TransferPriority priority;
+@property (nonatomic,copy) TransferOperation operation;
+//Orders transfers by when they were enqueued
+@property (nonatomic,assign) NSUInteger sequence;
+@property (nonatomic,strong) NSDate *enqueueDate;
+
+@end
+
+@implementation Transfer
+@end
+
+@interface TransferScheduler ()
+{
+    //The direction which goes next within each priority class
+    TransferDirection _nextDirection[TransferPriorityCount];
+}
+
+@property (nonatomic,assign,readwrite) NSUInteger pendingTransferCount;
+@property (nonatomic,assign,readwrite) NSUInteger activeTransferCount;
+//Pending transfers, indexed by priority then direction, each in enqueue order
+@property (nonatomic,strong) NSArray *queues;
+//Maps a key to the array of its pending transfers
+@property (nonatomic,strong) NSMutableDictionary *pendingByKey;
+//The key sets of each priority class, indexed by priority
+@property (nonatomic,strong) NSMutableArray *prioritizedKeys;
+//The statistics of each priority class, indexed by priority
+@property (nonatomic,strong) NSArray *statistics;
+@property (nonatomic,assign) NSUInteger nextSequence;
+
+@end
+
+@implementation TransferScheduler
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    if ((self = [super init]))
+    {
+        self.maximumConcurrentTransfers = kDefaultMaximumConcurrentTransfers;
+        self.pendingByKey = [NSMutableDictionary dictionary];
+
+        NSMutableArray *queues = [NSMutableArray arrayWithCapacity:TransferPriorityCount];
+        NSMutableArray *prioritizedKeys = [NSMutableArray arrayWithCapacity:TransferPriorityCount];
+        NSMutableArray *statistics = [NSMutableArray arrayWithCapacity:TransferPriorityCount];
+        for (NSInteger priority = 0; priority < TransferPriorityCount; ++priority)
+        {
+            [queues addObject:@[[NSMutableArray array], [NSMutableArray array]]];
+            [prioritizedKeys addObject:[NSSet set]];
+            [statistics addObject:[[TransferStatistics alloc] init]];
+            _nextDirection[priority] = TransferDirectionUpload;
+        }
+        self.queues = queues;
+        self.prioritizedKeys = prioritizedKeys;
+        self.statistics = statistics;
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (void)enqueueTransferForKey:(NSString *)key direction:(TransferDirection)direction operation:(TransferOperation)operation
+{
+    Transfer *transfer = [[Transfer alloc] init];
+    transfer.key = key;
+    transfer.direction = direction;
+    transfer.priority = [self priorityForKey:key];
+    transfer.operation = operation;
+    transfer.sequence = self.nextSequence++;
+    transfer.enqueueDate = [NSDate date];
+
+    [[self queueForPriority:transfer.priority direction:direction] addObject:transfer];
+    if (key)
+    {
+        NSMutableArray *transfers = [self.pendingByKey objectForKey:key];
+        if (!transfers)
+        {
+            transfers = [NSMutableArray array];
+            [self.pendingByKey setObject:transfers forKey:key];
+        }
+        [transfers addObject:transfer];
+    }
+    self.pendingTransferCount++;
+
+    [self startTransfers];
+}
+
+- (void)setKeys:(NSSet *)keys forPriority:(TransferPriority)priority
+{
+    if (priority >= TransferPriorityBackground)
+    {
+        return;
+    }
+
+    //Only the keys which have joined or left the class can change priority
+    NSSet *oldKeys = [self.prioritizedKeys objectAtIndex:priority];
+    NSMutableSet *affectedKeys = [NSMutableSet setWithSet:oldKeys];
+    [affectedKeys unionSet:keys ?: [NSSet set]];
+    [self.prioritizedKeys replaceObjectAtIndex:priority withObject:[keys copy] ?: [NSSet set]];
+
+    for (NSString *key in affectedKeys)
+    {
+        TransferPriority newPriority = [self priorityForKey:key];
+        for (Transfer *transfer in [self.pendingByKey objectForKey:key])
+        {
+            if (transfer.priority != newPriority)
+            {
+                [[self queueForPriority:transfer.priority direction:transfer.direction] removeObjectIdenticalTo:transfer];
+                transfer.priority = newPriority;
+                //Keep the destination queue in enqueue order
+                NSMutableArray *queue = [self queueForPriority:newPriority direction:transfer.direction];
+                NSUInteger index = [queue indexOfObject:transfer inSortedRange:NSMakeRange(0, queue.count) options:NSBinarySearchingInsertionIndex usingComparator:^NSComparisonResult(Transfer *transfer1, Transfer *transfer2) {
+                    return [@(transfer1.sequence) compare:@(transfer2.sequence)];
+                }];
+                [queue insertObject:transfer atIndex:index];
+            }
+        }
+    }
+}
+
+- (TransferStatistics *)statisticsForPriority:(TransferPriority)priority
+{
+    TransferStatistics *statistics = [self.statistics objectAtIndex:priority];
+
+    TransferStatistics *retVal = [[TransferStatistics alloc] init];
+    retVal.completedTransfers = statistics.completedTransfers;
+    retVal.failedTransfers = statistics.failedTransfers;
+    retVal.bytesTransferred = statistics.bytesTransferred;
+    retVal.activeTime = statistics.activeTime;
+    if (statistics.activeSince)
+    {
+        //Include the time of the transfers still running
+        retVal.activeTime += -[statistics.activeSince timeIntervalSinceNow];
+    }
+    retVal.averageWaitTime = statistics.startedTransfers > 0 ? statistics.totalWaitTime / statistics.startedTransfers : 0;
+    retVal.bytesPerSecond = retVal.activeTime > 0 ? retVal.bytesTransferred / retVal.activeTime : 0;
+
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+- (TransferPriority)priorityForKey:(NSString *)key
+{
+    TransferPriority retVal = TransferPriorityBackground;
+
+    if (key)
+    {
+        for (NSInteger priority = 0; priority < TransferPriorityBackground; ++priority)
+        {
+            if ([[self.prioritizedKeys objectAtIndex:priority] containsObject:key])
+            {
+                retVal = priority;
+                break;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (NSMutableArray *)queueForPriority:(TransferPriority)priority direction:(TransferDirection)direction
+{
+    return [[self.queues objectAtIndex:priority] objectAtIndex:direction];
+}
+
+/**
+ Removes and returns the next transfer to start, or `nil` if there are none waiting.
+ */
+- (Transfer *)dequeueTransfer
+{
+    Transfer *retVal = nil;
+
+    for (NSInteger priority = 0; priority < TransferPriorityCount && !retVal; ++priority)
+    {
+        //Alternate directions, falling back to the other direction if there is nothing to do in this one
+        TransferDirection direction = _nextDirection[priority];
+        NSMutableArray *queue = [self queueForPriority:priority direction:direction];
+        if (queue.count == 0)
+        {
+            direction = (direction + 1) % TransferDirectionCount;
+            queue = [self queueForPriority:priority direction:direction];
+        }
+
+        retVal = [queue firstObject];
+        if (retVal)
+        {
+            [queue removeObjectAtIndex:0];
+            _nextDirection[priority] = (direction + 1) % TransferDirectionCount;
+        }
+    }
+
+    if (retVal)
+    {
+        self.pendingTransferCount--;
+        if (retVal.key)
+        {
+            NSMutableArray *transfers = [self.pendingByKey objectForKey:retVal.key];
+            [transfers removeObjectIdenticalTo:retVal];
+            if (transfers.count == 0)
+            {
+                [self.pendingByKey removeObjectForKey:retVal.key];
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (void)startTransfers
+{
+    while (self.activeTransferCount < self.maximumConcurrentTransfers)
+    {
+        Transfer *transfer = [self dequeueTransfer];
+        if (!transfer)
+        {
+            break;
+        }
+
+        TransferStatistics *statistics = [self.statistics objectAtIndex:transfer.priority];
+        statistics.startedTransfers++;
+        statistics.totalWaitTime += -[transfer.enqueueDate timeIntervalSinceNow];
+        if (statistics.activeTransfers++ == 0)
+        {
+            statistics.activeSince = [NSDate date];
+        }
+        self.activeTransferCount++;
+
+        transfer.operation(^(BOOL success, unsigned long long bytesTransferred) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if (success)
+                {
+                    statistics.completedTransfers++;
+                    statistics.bytesTransferred += bytesTransferred;
+                }
+                else
+                {
+                    statistics.failedTransfers++;
+                }
+                if (--statistics.activeTransfers == 0)
+                {
+                    statistics.activeTime += -[statistics.activeSince timeIntervalSinceNow];
+                    statistics.activeSince = nil;
+                }
+                self.activeTransferCount--;
+
+                [self startTransfers];
+            });
+        });
+    }
+}
+
+@end
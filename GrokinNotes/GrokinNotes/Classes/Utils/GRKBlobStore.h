@@ -0,0 +1,91 @@
+//
+//  GRKBlobStore.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A content addressed store of immutable blobs, keyed by the MD5 digest of their content (as a lower case hex string), so identical content is stored once.
+ Blobs are kept read only, in subdirectories named by the first two characters of the digest. Adding a blob is atomic, so a blob is either wholly present or absent.
+ All methods are safe to call from any queue.
+ */
+@interface GRKBlobStore : NSObject
+
+/**
+ The directory holding the store.
+ */
+@property (nonatomic,readonly) NSURL *directory;
+
+/**
+ Creates a store in the given directory, creating the directory if needed.
+
+ @param directory The file URL of the directory to hold the store.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A new store, or `nil` if the directory could not be created.
+ */
+- (instancetype)initWithDirectory:(NSURL *)directory error:(__autoreleasing NSError **)error;
+
+/**
+ Determines if the store holds content with the given digest.
+
+ @param digest The MD5 digest of the content.
+
+ @return `YES` if the content is held.
+ */
+- (BOOL)containsDigest:(NSString *)digest;
+
+/**
+ Adds the given content to the store, if it is not already held.
+
+ @param data  The content.
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The digest of the content, or `nil` if it could not be added.
+ */
+- (NSString *)addData:(NSData *)data error:(__autoreleasing NSError **)error;
+
+/**
+ Reads the content with the given digest.
+
+ @param digest The MD5 digest of the content.
+ @param error  A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The content, or `nil` if it is not held.
+ */
+- (NSData *)dataForDigest:(NSString *)digest error:(__autoreleasing NSError **)error;
+
+/**
+ Copies the content with the given digest to a new, writable, file.
+
+ @param digest      The MD5 digest of the content.
+ @param destination The file URL of the file to create, which must not exist.
+ @param error       A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)copyDigest:(NSString *)digest toURL:(NSURL *)destination error:(__autoreleasing NSError **)error;
+
+/**
+ Removes all content other than that with the given digests.
+
+ @param digests An NSSet of the MD5 digests of the content to keep.
+
+ @return The number of blobs removed.
+ */
+- (NSUInteger)removeAllExceptDigests:(NSSet *)digests;
+
+@end
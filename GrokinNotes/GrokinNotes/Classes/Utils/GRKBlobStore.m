@@ -0,0 +1,199 @@
+//
+//  GRKBlobStore.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKBlobStore.h"
+#import "GRKFileManager.h"
+#import "GRKDigestCache.h"
+#import "NSString+UUID.h"
+#include <CommonCrypto/CommonDigest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//Blobs are placed in subdirectories named by this many leading characters of their digest, to keep directories small
+static NSUInteger const kBlobStoreShardLength = 2;
+
+static NSError *GRKBlobStoreErrnoError(int errorNumber, NSURL *url)
+{
+    NSString *message = [NSString stringWithFormat:@"%s '%@'", strerror(errorNumber), url];
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    [userInfo setObject:[NSNumber numberWithInt:errorNumber] forKey:kGRKFileManagerErrorKeyErrno];
+    return [NSError errorWithDomain:GRKFileManagerErrorDomain code:GRKFileManagerErrorErrno userInfo:userInfo];
+}
+
+static BOOL GRKBlobStoreIsDigest(NSString *digest)
+{
+    static NSCharacterSet *nonHexCharacters = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        nonHexCharacters = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdef"] invertedSet];
+    });
+
+    return digest.length == 2 * CC_MD5_DIGEST_LENGTH && [digest rangeOfCharacterFromSet:nonHexCharacters].location == NSNotFound;
+}
+
+@interface GRKBlobStore ()
+
+@property (nonatomic,strong,readwrite) NSURL *directory;
+
+@end
+
+@implementation GRKBlobStore
+
+#pragma mark - Initialization
+
+- (instancetype)initWithDirectory:(NSURL *)directory error:(__autoreleasing NSError **)error
+{
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:error])
+    {
+        return nil;
+    }
+
+    if ((self = [super init]))
+    {
+        self.directory = directory;
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (BOOL)containsDigest:(NSString *)digest
+{
+    NSURL *url = [self URLForDigest:digest];
+    return url && access([url fileSystemRepresentation], F_OK) == 0;
+}
+
+- (NSString *)addData:(NSData *)data error:(__autoreleasing NSError **)error
+{
+    NSString *retVal = [GRKDigestCache MD5ForData:data];
+
+    NSURL *url = [self URLForDigest:retVal];
+    if (access([url fileSystemRepresentation], F_OK) != 0)
+    {
+        NSURL *shard = [url URLByDeletingLastPathComponent];
+        if ([[NSFileManager defaultManager] createDirectoryAtURL:shard withIntermediateDirectories:YES attributes:nil error:error])
+        {
+            //Write the content under a temporary name, then link it into place, so the blob appears complete or not at all (and a concurrent add of the same content is harmless)
+            NSURL *tempURL = [shard URLByAppendingPathComponent:[@"." stringByAppendingString:[NSString UUID]]];
+            if ([data writeToURL:tempURL options:0 error:error])
+            {
+                chmod([tempURL fileSystemRepresentation], S_IRUSR | S_IRGRP | S_IROTH);
+                if (link([tempURL fileSystemRepresentation], [url fileSystemRepresentation]) != 0 && errno != EEXIST)
+                {
+                    if (error)
+                    {
+                        *error = GRKBlobStoreErrnoError(errno, url);
+                    }
+                    retVal = nil;
+                }
+                unlink([tempURL fileSystemRepresentation]);
+            }
+            else
+            {
+                retVal = nil;
+            }
+        }
+        else
+        {
+            retVal = nil;
+        }
+    }
+
+    return retVal;
+}
+
+- (NSData *)dataForDigest:(NSString *)digest error:(__autoreleasing NSError **)error
+{
+    NSData *retVal = nil;
+
+    NSURL *url = [self URLForDigest:digest];
+    if (url)
+    {
+        //Blobs never change, so mapping is safe
+        retVal = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:error];
+    }
+    else if (error)
+    {
+        *error = GRKBlobStoreErrnoError(EINVAL, self.directory);
+    }
+
+    return retVal;
+}
+
+- (BOOL)copyDigest:(NSString *)digest toURL:(NSURL *)destination error:(__autoreleasing NSError **)error
+{
+    BOOL retVal = NO;
+
+    NSURL *url = [self URLForDigest:digest];
+    if (url)
+    {
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        retVal = [fileManager copyItemAtURL:url toURL:destination error:error];
+        if (retVal)
+        {
+            //The copy takes on the read only permissions of the blob
+            retVal = [fileManager setAttributes:@{NSFilePosixPermissions: @(S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)} ofItemAtPath:[destination path] error:error];
+        }
+    }
+    else if (error)
+    {
+        *error = GRKBlobStoreErrnoError(EINVAL, self.directory);
+    }
+
+    return retVal;
+}
+
+- (NSUInteger)removeAllExceptDigests:(NSSet *)digests
+{
+    NSUInteger retVal = 0;
+
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSArray *shards = [fileManager contentsOfDirectoryAtURL:self.directory includingPropertiesForKeys:nil options:0 error:nil];
+    for (NSURL *shard in shards)
+    {
+        //Also removes any temporary files left behind by an interrupted add
+        NSArray *blobs = [fileManager contentsOfDirectoryAtURL:shard includingPropertiesForKeys:nil options:0 error:nil];
+        for (NSURL *blob in blobs)
+        {
+            if (![digests containsObject:[blob lastPathComponent]] && unlink([blob fileSystemRepresentation]) == 0)
+            {
+                ++retVal;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+- (NSURL *)URLForDigest:(NSString *)digest
+{
+    NSURL *retVal = nil;
+
+    if (GRKBlobStoreIsDigest(digest))
+    {
+        NSString *shard = [digest substringToIndex:kBlobStoreShardLength];
+        retVal = [[self.directory URLByAppendingPathComponent:shard isDirectory:YES] URLByAppendingPathComponent:digest];
+    }
+
+    return retVal;
+}
+
+@end
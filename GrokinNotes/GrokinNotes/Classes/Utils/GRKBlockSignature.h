@@ -0,0 +1,142 @@
+//
+//  GRKBlockSignature.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The difference between some content and the basis content a GRKBlockSignature was computed from.
+ */
+@interface GRKBlockDelta : NSObject
+
+/**
+ The length, in bytes, of the new content.
+ */
+@property (nonatomic,assign,readonly) unsigned long long length;
+
+/**
+ The number of bytes of the new content which were found in the basis, and would not need to be sent to a receiver holding the basis.
+ */
+@property (nonatomic,assign,readonly) unsigned long long matchedBytes;
+
+/**
+ The number of bytes of the new content which were not found in the basis, and would need to be sent.
+ */
+@property (nonatomic,assign,readonly) unsigned long long literalBytes;
+
+/**
+ An NSArray of NSValue wrapped NSRange objects, in ascending order, of the new content which was not found in the basis.
+ */
+@property (nonatomic,strong,readonly) NSArray *literalRanges;
+
+/**
+ `YES` if the new content is identical to the basis.
+ */
+@property (nonatomic,assign,readonly) BOOL unchanged;
+
+@end
+
+/**
+ An rsync style signature of some basis content: a weak rolling checksum (Adler-32 style) and a strong checksum (MD5) for each fixed size block.
+ A signature is small compared to the content, and is enough to work out which parts of some new content are already present in the basis, wherever they have moved to.
+ */
+@interface GRKBlockSignature : NSObject
+
+/**
+ The size, in bytes, of each block. The last block may be shorter.
+ */
+@property (nonatomic,assign,readonly) NSUInteger blockSize;
+
+/**
+ The length, in bytes, of the basis content.
+ */
+@property (nonatomic,assign,readonly) unsigned long long length;
+
+/**
+ The number of blocks in the signature.
+ */
+@property (nonatomic,assign,readonly) NSUInteger blockCount;
+
+/**
+ Chooses a block size for content of the given length, trading the size of the signature against the precision of the delta.
+
+ @param length The length, in bytes, of the content.
+
+ @return A block size.
+ */
++ (NSUInteger)blockSizeForLength:(unsigned long long)length;
+
+/**
+ Computes the signature of the given data.
+
+ @param data      The basis content.
+ @param blockSize The size of each block. If `0` a block size is chosen based on the length of the data.
+
+ @return A new signature.
+ */
++ (instancetype)signatureOfData:(NSData *)data blockSize:(NSUInteger)blockSize;
+
+/**
+ Computes the signature of the given file.
+
+ @param fileURL   The file URL of the basis content.
+ @param blockSize The size of each block. If `0` a block size is chosen based on the length of the file.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A new signature, or `nil` if the file could not be read.
+ */
++ (instancetype)signatureOfFile:(NSURL *)fileURL blockSize:(NSUInteger)blockSize error:(__autoreleasing NSError **)error;
+
+/**
+ Reads a signature previously written with `writeToURL:error:`.
+
+ @param url   The file URL of the signature.
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The signature, or `nil` if it could not be read or is not valid.
+ */
++ (instancetype)signatureWithContentsOfURL:(NSURL *)url error:(__autoreleasing NSError **)error;
+
+/**
+ Atomically writes the signature to the given location.
+
+ @param url   The file URL to write to.
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)writeToURL:(NSURL *)url error:(__autoreleasing NSError **)error;
+
+/**
+ Computes the delta of the given data against the basis of this signature.
+
+ @param data The new content.
+
+ @return The delta.
+ */
+- (GRKBlockDelta *)deltaOfData:(NSData *)data;
+
+/**
+ Computes the delta of the given file against the basis of this signature.
+
+ @param fileURL The file URL of the new content.
+ @param error   A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The delta, or `nil` if the file could not be read.
+ */
+- (GRKBlockDelta *)deltaOfFile:(NSURL *)fileURL error:(__autoreleasing NSError **)error;
+
+@end
@@ -0,0 +1,366 @@
+//
+//  GRKBlockSignature.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKBlockSignature.h"
+#include <CommonCrypto/CommonDigest.h>
+
+static uint32_t const kBlockSignatureMagic = 0x53424B47; // "GKBS"
+static uint32_t const kBlockSignatureVersion = 1;
+
+static NSUInteger const kMinimumBlockSize = 512;
+static NSUInteger const kMaximumBlockSize = 16384;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockSize;
+    uint32_t reserved;
+    uint64_t length;
+    uint64_t count;
+} GRKBlockSignatureHeader;
+
+typedef struct {
+    uint32_t weak;
+    uint8_t strong[CC_MD5_DIGEST_LENGTH];
+} GRKBlockSignatureRecord;
+
+//An entry of the table used to look blocks up by weak checksum
+typedef struct {
+    uint32_t weak;
+    uint32_t index;
+} GRKBlockSignatureLookup;
+
+/**
+ The weak checksum of the given bytes, with its two halves also returned separately so it can be rolled.
+ */
+static uint32_t GRKBlockSignatureWeak(const uint8_t *bytes, size_t length, uint32_t *a, uint32_t *b)
+{
+    uint32_t sumA = 0;
+    uint32_t sumB = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        sumA += bytes[i];
+        sumB += (uint32_t)(length - i) * bytes[i];
+    }
+    *a = sumA & 0xffff;
+    *b = sumB & 0xffff;
+    return *a | (*b << 16);
+}
+
+/**
+ Rolls the weak checksum of a window of `length` bytes forward by one byte, removing `outByte` and adding `inByte`.
+ */
+static uint32_t GRKBlockSignatureRoll(uint32_t *a, uint32_t *b, size_t length, uint8_t outByte, uint8_t inByte)
+{
+    *a = (*a - outByte + inByte) & 0xffff;
+    *b = (*b - (uint32_t)length * outByte + *a) & 0xffff;
+    return *a | (*b << 16);
+}
+
+@interface GRKBlockDelta ()
+
+@property (nonatomic,assign,readwrite) unsigned long long length;
+@property (nonatomic,assign,readwrite) unsigned long long matchedBytes;
+@property (nonatomic,assign,readwrite) unsigned long long literalBytes;
+@property (nonatomic,strong,readwrite) NSArray *literalRanges;
+@property (nonatomic,assign,readwrite) BOOL unchanged;
+
+@end
+
+@implementation GRKBlockDelta
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> length: %llu matched: %llu literal: %llu in %lu range%@%@", NSStringFromClass(self.class), self, self.length, self.matchedBytes, self.literalBytes, (unsigned long)self.literalRanges.count, self.literalRanges.count == 1 ? @"" : @"s", self.unchanged ? @" (unchanged)" : @""];
+}
+
+@end
+
+@interface GRKBlockSignature ()
+
+@property (nonatomic,assign,readwrite) NSUInteger blockSize;
+@property (nonatomic,assign,readwrite) unsigned long long length;
+//The packed GRKBlockSignatureRecord of each block
+@property (nonatomic,strong) NSData *records;
+
+@end
+
+@implementation GRKBlockSignature
+
+#pragma mark - Initialization
+
++ (NSUInteger)blockSizeForLength:(unsigned long long)length
+{
+    //As with rsync, the square root of the length balances the number of blocks against their size
+    NSUInteger blockSize = (NSUInteger)sqrt((double)length);
+    blockSize = (blockSize + 15) & ~(NSUInteger)15;
+    return MAX(kMinimumBlockSize, MIN(kMaximumBlockSize, blockSize));
+}
+
++ (instancetype)signatureOfData:(NSData *)data blockSize:(NSUInteger)blockSize
+{
+    if (blockSize == 0)
+    {
+        blockSize = [self blockSizeForLength:data.length];
+    }
+
+    NSUInteger length = data.length;
+    NSUInteger count = (length + blockSize - 1) / blockSize;
+    NSMutableData *records = [NSMutableData dataWithLength:count * sizeof(GRKBlockSignatureRecord)];
+    GRKBlockSignatureRecord *record = [records mutableBytes];
+    const uint8_t *bytes = [data bytes];
+    for (NSUInteger offset = 0; offset < length; offset += blockSize, ++record)
+    {
+        NSUInteger size = MIN(blockSize, length - offset);
+        uint32_t a, b;
+        record->weak = GRKBlockSignatureWeak(bytes + offset, size, &a, &b);
+        CC_MD5(bytes + offset, (CC_LONG)size, record->strong);
+    }
+
+    GRKBlockSignature *retVal = [[self alloc] init];
+    retVal.blockSize = blockSize;
+    retVal.length = length;
+    retVal.records = records;
+
+    return retVal;
+}
+
++ (instancetype)signatureOfFile:(NSURL *)fileURL blockSize:(NSUInteger)blockSize error:(__autoreleasing NSError **)error
+{
+    GRKBlockSignature *retVal = nil;
+
+    NSData *data = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedIfSafe error:error];
+    if (data)
+    {
+        retVal = [self signatureOfData:data blockSize:blockSize];
+    }
+
+    return retVal;
+}
+
++ (instancetype)signatureWithContentsOfURL:(NSURL *)url error:(__autoreleasing NSError **)error
+{
+    GRKBlockSignature *retVal = nil;
+
+    NSData *data = [NSData dataWithContentsOfURL:url options:0 error:error];
+    if (data)
+    {
+        const GRKBlockSignatureHeader *header = [data bytes];
+        BOOL valid = data.length >= sizeof(GRKBlockSignatureHeader) &&
+                     header->magic == kBlockSignatureMagic &&
+                     header->version == kBlockSignatureVersion &&
+                     header->blockSize > 0 &&
+                     header->count == (header->length + header->blockSize - 1) / header->blockSize &&
+                     data.length == sizeof(GRKBlockSignatureHeader) + (header->count * sizeof(GRKBlockSignatureRecord));
+        if (valid)
+        {
+            retVal = [[self alloc] init];
+            retVal.blockSize = header->blockSize;
+            retVal.length = header->length;
+            retVal.records = [data subdataWithRange:NSMakeRange(sizeof(GRKBlockSignatureHeader), data.length - sizeof(GRKBlockSignatureHeader))];
+        }
+        else if (error)
+        {
+            NSString *message = [NSString stringWithFormat:@"Invalid block signature '%@'.", url];
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
+            [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+            [userInfo setObject:url forKey:NSURLErrorKey];
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:userInfo];
+        }
+    }
+
+    return retVal;
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)blockCount
+{
+    return self.records.length / sizeof(GRKBlockSignatureRecord);
+}
+
+#pragma mark - Implementation
+
+- (BOOL)writeToURL:(NSURL *)url error:(__autoreleasing NSError **)error
+{
+    GRKBlockSignatureHeader header = { kBlockSignatureMagic, kBlockSignatureVersion, (uint32_t)self.blockSize, 0, self.length, self.blockCount };
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + self.records.length];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:self.records];
+
+    return [data writeToURL:url options:NSDataWritingAtomic error:error];
+}
+
+- (GRKBlockDelta *)deltaOfData:(NSData *)data
+{
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = data.length;
+    NSUInteger blockSize = self.blockSize;
+    const GRKBlockSignatureRecord *records = [self.records bytes];
+    NSUInteger blockCount = self.blockCount;
+    //Only whole blocks are matched while scanning; a short last block can only match at the end of the content
+    NSUInteger fullBlockCount = (NSUInteger)(self.length / blockSize);
+    NSUInteger tailSize = (NSUInteger)(self.length % blockSize);
+
+    //Sort the whole blocks by weak checksum so they can be looked up by binary search
+    GRKBlockSignatureLookup *lookup = malloc(MAX(fullBlockCount, 1) * sizeof(GRKBlockSignatureLookup));
+    for (NSUInteger i = 0; i < fullBlockCount; ++i)
+    {
+        lookup[i].weak = records[i].weak;
+        lookup[i].index = (uint32_t)i;
+    }
+    qsort_b(lookup, fullBlockCount, sizeof(GRKBlockSignatureLookup), ^int(const void *left, const void *right) {
+        const GRKBlockSignatureLookup *l = left;
+        const GRKBlockSignatureLookup *r = right;
+        if (l->weak != r->weak)
+        {
+            return l->weak < r->weak ? -1 : 1;
+        }
+        //Prefer earlier blocks, so content which has not moved matches in order
+        return l->index < r->index ? -1 : (l->index > r->index ? 1 : 0);
+    });
+
+    NSMutableArray *literalRanges = [NSMutableArray array];
+    unsigned long long matchedBytes = 0;
+    unsigned long long literalBytes = 0;
+    //Blocks matched in their original order, at their original offsets
+    BOOL inOrder = YES;
+    NSUInteger expectedIndex = 0;
+
+    NSUInteger literalStart = 0;
+    NSUInteger position = 0;
+    uint32_t a = 0, b = 0, weak = 0;
+    BOOL rolling = NO;
+    while (fullBlockCount > 0 && position + blockSize <= length)
+    {
+        if (!rolling)
+        {
+            weak = GRKBlockSignatureWeak(bytes + position, blockSize, &a, &b);
+            rolling = YES;
+        }
+
+        //Find the first candidate with this weak checksum
+        NSUInteger low = 0;
+        NSUInteger high = fullBlockCount;
+        while (low < high)
+        {
+            NSUInteger middle = low + (high - low) / 2;
+            if (lookup[middle].weak < weak)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        NSInteger matchIndex = -1;
+        if (low < fullBlockCount && lookup[low].weak == weak)
+        {
+            uint8_t strong[CC_MD5_DIGEST_LENGTH];
+            CC_MD5(bytes + position, (CC_LONG)blockSize, strong);
+            for (NSUInteger i = low; i < fullBlockCount && lookup[i].weak == weak; ++i)
+            {
+                if (memcmp(records[lookup[i].index].strong, strong, CC_MD5_DIGEST_LENGTH) == 0)
+                {
+                    matchIndex = lookup[i].index;
+                    //Prefer the block expected next, to keep unmoved content in order
+                    if ((NSUInteger)matchIndex == expectedIndex)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (matchIndex >= 0)
+        {
+            if (position > literalStart)
+            {
+                [literalRanges addObject:[NSValue valueWithRange:NSMakeRange(literalStart, position - literalStart)]];
+                literalBytes += position - literalStart;
+            }
+            inOrder = inOrder && (NSUInteger)matchIndex == expectedIndex && position == expectedIndex * blockSize;
+            expectedIndex = matchIndex + 1;
+            matchedBytes += blockSize;
+            position += blockSize;
+            literalStart = position;
+            rolling = NO;
+        }
+        else
+        {
+            if (position + blockSize < length)
+            {
+                weak = GRKBlockSignatureRoll(&a, &b, blockSize, bytes[position], bytes[position + blockSize]);
+            }
+            ++position;
+        }
+    }
+
+    //Check for the short last block at the end of the content
+    NSUInteger end = length;
+    if (tailSize > 0 && length >= literalStart + tailSize)
+    {
+        NSUInteger tailStart = length - tailSize;
+        const GRKBlockSignatureRecord *tail = &records[blockCount - 1];
+        uint32_t tailA, tailB;
+        if (GRKBlockSignatureWeak(bytes + tailStart, tailSize, &tailA, &tailB) == tail->weak)
+        {
+            uint8_t strong[CC_MD5_DIGEST_LENGTH];
+            CC_MD5(bytes + tailStart, (CC_LONG)tailSize, strong);
+            if (memcmp(tail->strong, strong, CC_MD5_DIGEST_LENGTH) == 0)
+            {
+                inOrder = inOrder && expectedIndex == fullBlockCount && tailStart == fullBlockCount * blockSize;
+                expectedIndex = blockCount;
+                matchedBytes += tailSize;
+                end = tailStart;
+            }
+        }
+    }
+    if (end > literalStart)
+    {
+        [literalRanges addObject:[NSValue valueWithRange:NSMakeRange(literalStart, end - literalStart)]];
+        literalBytes += end - literalStart;
+    }
+
+    free(lookup);
+
+    GRKBlockDelta *retVal = [[GRKBlockDelta alloc] init];
+    retVal.length = length;
+    retVal.matchedBytes = matchedBytes;
+    retVal.literalBytes = literalBytes;
+    retVal.literalRanges = literalRanges;
+    retVal.unchanged = literalBytes == 0 && inOrder && expectedIndex == blockCount && length == self.length;
+
+    return retVal;
+}
+
+- (GRKBlockDelta *)deltaOfFile:(NSURL *)fileURL error:(__autoreleasing NSError **)error
+{
+    GRKBlockDelta *retVal = nil;
+
+    NSData *data = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedIfSafe error:error];
+    if (data)
+    {
+        retVal = [self deltaOfData:data];
+    }
+
+    return retVal;
+}
+
+@end
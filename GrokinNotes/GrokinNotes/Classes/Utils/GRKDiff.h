@@ -0,0 +1,124 @@
+//
+//  GRKDiff.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSInteger, GRKDiffTokenization) {
+    //Each line, including its line terminator, is a token
+    GRKDiffTokenizationLines = 0,
+    //Each word, including any whitespace which follows it, is a token
+    GRKDiffTokenizationWords
+};
+
+/**
+ A difference between two token sequences: `length1` tokens at `start1` in the first sequence were replaced by `length2` tokens at `start2` in the second.
+ A pure insertion has a `length1` of `0`, and a pure deletion a `length2` of `0`.
+ */
+typedef struct {
+    NSUInteger start1;
+    NSUInteger length1;
+    NSUInteger start2;
+    NSUInteger length2;
+} GRKDiffHunk;
+
+/**
+ Some content split into tokens, each of which is identified by a number which is equal for equal tokens of the same GRKDiff.
+ */
+@interface GRKTokenSequence : NSObject
+
+/**
+ The content.
+ */
+@property (nonatomic,strong,readonly) NSData *data;
+
+/**
+ The number of tokens in the content.
+ */
+@property (nonatomic,assign,readonly) NSUInteger count;
+
+/**
+ The identifiers of the tokens, as `count` packed `uint32_t` values.
+ */
+@property (nonatomic,assign,readonly) const uint32_t *identifiers;
+
+/**
+ The range of bytes of the content covered by the given range of tokens.
+
+ @param tokens A range of tokens, which may be empty.
+
+ @return The range of bytes.
+ */
+- (NSRange)byteRangeOfTokens:(NSRange)tokens;
+
+/**
+ Determines if a range of tokens of this sequence is the same as a range of tokens of another sequence of the same GRKDiff.
+
+ @param tokens        A range of tokens of this sequence.
+ @param sequence      The other sequence.
+ @param otherTokens   A range of tokens of the other sequence.
+
+ @return `YES` if the ranges hold the same tokens.
+ */
+- (BOOL)tokens:(NSRange)tokens isEqualToTokens:(NSRange)otherTokens ofSequence:(GRKTokenSequence *)sequence;
+
+@end
+
+/**
+ Computes the differences between token sequences with Myers' O(ND) algorithm, using the linear space (middle snake) refinement, so the cost grows with the size of the differences rather than the size of the content.
+ Tokens are interned as they are split, so sequences to be compared must come from the same GRKDiff. A GRKDiff is not thread safe, but separate instances may be used concurrently.
+ */
+@interface GRKDiff : NSObject
+
+/**
+ How content is split into tokens.
+ */
+@property (nonatomic,assign,readonly) GRKDiffTokenization tokenization;
+
+/**
+ A bound on the work, in steps along the edit graph, spent on one comparison. Once it is spent the remaining differences are reported as coarse replacements rather than minimal ones, which is always correct but less precise. Defaults to 2^24.
+ */
+@property (nonatomic,assign) NSUInteger maximumCost;
+
+/**
+ Creates a GRKDiff which splits content in the given way.
+
+ @param tokenization How content is split into tokens.
+
+ @return A new GRKDiff.
+ */
+- (instancetype)initWithTokenization:(GRKDiffTokenization)tokenization;
+
+/**
+ Splits the given content into tokens.
+
+ @param data The content.
+
+ @return The token sequence of the content.
+ */
+- (GRKTokenSequence *)sequenceWithData:(NSData *)data;
+
+/**
+ Computes the differences between two sequences of this GRKDiff.
+
+ @param sequence1 The first (old) sequence.
+ @param sequence2 The second (new) sequence.
+
+ @return An NSData of packed GRKDiffHunk values, in ascending order, which transform the first sequence into the second.
+ */
+- (NSData *)hunksFromSequence:(GRKTokenSequence *)sequence1 toSequence:(GRKTokenSequence *)sequence2;
+
+@end
@@ -0,0 +1,474 @@
+//
+//  GRKDiff.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKDiff.h"
+
+static NSUInteger const kDefaultMaximumCost = 1 << 24;
+static NSUInteger const kInitialInternCapacity = 1024;
+
+//A distinct token, pointing into the content it was first seen in
+typedef struct {
+    const uint8_t *bytes;
+    size_t length;
+    uint64_t hash;
+} GRKDiffToken;
+
+//The state of one comparison
+typedef struct {
+    const uint32_t *a;
+    const uint32_t *b;
+    //Set for each token which is not part of the common subsequence
+    uint8_t *changedA;
+    uint8_t *changedB;
+    //Furthest reaching paths of the forward and reverse searches
+    long *forward;
+    long *reverse;
+    //The work which remains to be spent (see maximumCost)
+    long budget;
+} GRKDiffContext;
+
+static uint64_t GRKDiffHash(const uint8_t *bytes, size_t length)
+{
+    //FNV-1a
+    uint64_t retVal = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i)
+    {
+        retVal ^= bytes[i];
+        retVal *= 1099511628211ULL;
+    }
+    return retVal;
+}
+
+static BOOL GRKDiffIsWhitespace(uint8_t byte)
+{
+    return byte == ' ' || byte == '\t' || byte == '\n' || byte == '\r';
+}
+
+/**
+ The length of the token starting at `bytes`, which is followed by `length - 1` more bytes of content.
+ */
+static size_t GRKDiffTokenLength(GRKDiffTokenization tokenization, const uint8_t *bytes, size_t length)
+{
+    size_t retVal = 0;
+
+    if (tokenization == GRKDiffTokenizationLines)
+    {
+        const uint8_t *newline = memchr(bytes, '\n', length);
+        retVal = newline ? (size_t)(newline - bytes) + 1 : length;
+    }
+    else
+    {
+        //A word and the whitespace following it, or whitespace alone at the start of the content
+        while (retVal < length && !GRKDiffIsWhitespace(bytes[retVal]))
+        {
+            ++retVal;
+        }
+        while (retVal < length && GRKDiffIsWhitespace(bytes[retVal]))
+        {
+            ++retVal;
+        }
+    }
+
+    return retVal;
+}
+
+/**
+ Marks a range of tokens as changed.
+ */
+static void GRKDiffMark(uint8_t *changed, long start, long end)
+{
+    if (end > start)
+    {
+        memset(changed + start, 1, (size_t)(end - start));
+    }
+}
+
+/**
+ Finds the middle snake of the edit graph of a[aStart, aEnd) and b[bStart, bEnd) by searching forward from the start and in reverse from the end until the paths overlap, and returns the point at which to split the problem.
+ Returns `NO` if the sequences have nothing in common, or the budget is spent.
+ */
+static BOOL GRKDiffBisect(GRKDiffContext *context, long aStart, long aEnd, long bStart, long bEnd, long *splitA, long *splitB)
+{
+    const uint32_t *a = context->a + aStart;
+    const uint32_t *b = context->b + bStart;
+    long n = aEnd - aStart;
+    long m = bEnd - bStart;
+    long maxD = (n + m + 1) / 2;
+    long offset = maxD;
+    long length = 2 * maxD;
+    long *forward = context->forward;
+    long *reverse = context->reverse;
+
+    for (long i = 0; i < length + 2; ++i)
+    {
+        forward[i] = -1;
+        reverse[i] = -1;
+    }
+    forward[offset + 1] = 0;
+    reverse[offset + 1] = 0;
+
+    long delta = n - m;
+    //If the difference in length is odd the forward path will reach the overlap first, otherwise the reverse path will
+    BOOL front = (delta % 2 != 0);
+    //Diagonals which have run off the edge of the graph no longer need to be searched
+    long forwardStart = 0;
+    long forwardEnd = 0;
+    long reverseStart = 0;
+    long reverseEnd = 0;
+
+    for (long d = 0; d < maxD && context->budget > 0; ++d)
+    {
+        for (long k1 = -d + forwardStart; k1 <= d - forwardEnd; k1 += 2)
+        {
+            long k1Offset = offset + k1;
+            long x1 = (k1 == -d || (k1 != d && forward[k1Offset - 1] < forward[k1Offset + 1])) ? forward[k1Offset + 1] : forward[k1Offset - 1] + 1;
+            long y1 = x1 - k1;
+            long snakeStart = x1;
+            while (x1 < n && y1 < m && a[x1] == b[y1])
+            {
+                ++x1;
+                ++y1;
+            }
+            context->budget -= 1 + (x1 - snakeStart);
+            forward[k1Offset] = x1;
+            if (x1 > n)
+            {
+                forwardEnd += 2;
+            }
+            else if (y1 > m)
+            {
+                forwardStart += 2;
+            }
+            else if (front)
+            {
+                long k2Offset = offset + delta - k1;
+                if (k2Offset >= 0 && k2Offset < length && reverse[k2Offset] != -1 && x1 >= n - reverse[k2Offset])
+                {
+                    *splitA = aStart + x1;
+                    *splitB = bStart + y1;
+                    return YES;
+                }
+            }
+        }
+
+        for (long k2 = -d + reverseStart; k2 <= d - reverseEnd; k2 += 2)
+        {
+            long k2Offset = offset + k2;
+            long x2 = (k2 == -d || (k2 != d && reverse[k2Offset - 1] < reverse[k2Offset + 1])) ? reverse[k2Offset + 1] : reverse[k2Offset - 1] + 1;
+            long y2 = x2 - k2;
+            long snakeStart = x2;
+            while (x2 < n && y2 < m && a[n - x2 - 1] == b[m - y2 - 1])
+            {
+                ++x2;
+                ++y2;
+            }
+            context->budget -= 1 + (x2 - snakeStart);
+            reverse[k2Offset] = x2;
+            if (x2 > n)
+            {
+                reverseEnd += 2;
+            }
+            else if (y2 > m)
+            {
+                reverseStart += 2;
+            }
+            else if (!front)
+            {
+                long k1Offset = offset + delta - k2;
+                if (k1Offset >= 0 && k1Offset < length && forward[k1Offset] != -1)
+                {
+                    long x1 = forward[k1Offset];
+                    long y1 = offset + x1 - k1Offset;
+                    if (x1 >= n - x2)
+                    {
+                        *splitA = aStart + x1;
+                        *splitB = bStart + y1;
+                        return YES;
+                    }
+                }
+            }
+        }
+    }
+
+    return NO;
+}
+
+/**
+ Marks the tokens of a[aStart, aEnd) and b[bStart, bEnd) which are not part of a longest common subsequence.
+ */
+static void GRKDiffCompare(GRKDiffContext *context, long aStart, long aEnd, long bStart, long bEnd)
+{
+    //Trim the common prefix and suffix, which is most of the content for typical edits
+    while (aStart < aEnd && bStart < bEnd && context->a[aStart] == context->b[bStart])
+    {
+        ++aStart;
+        ++bStart;
+    }
+    while (aStart < aEnd && bStart < bEnd && context->a[aEnd - 1] == context->b[bEnd - 1])
+    {
+        --aEnd;
+        --bEnd;
+    }
+
+    long splitA = 0;
+    long splitB = 0;
+    if (aStart == aEnd || bStart == bEnd)
+    {
+        GRKDiffMark(context->changedA, aStart, aEnd);
+        GRKDiffMark(context->changedB, bStart, bEnd);
+    }
+    else if (GRKDiffBisect(context, aStart, aEnd, bStart, bEnd, &splitA, &splitB))
+    {
+        GRKDiffCompare(context, aStart, splitA, bStart, splitB);
+        GRKDiffCompare(context, splitA, aEnd, splitB, bEnd);
+    }
+    else
+    {
+        GRKDiffMark(context->changedA, aStart, aEnd);
+        GRKDiffMark(context->changedB, bStart, bEnd);
+    }
+}
+
+/**
+ Collects the runs of changed tokens into hunks. Unchanged tokens of the two sequences correspond one to one, in order.
+ */
+static void GRKDiffCollectHunks(const uint8_t *changedA, long n, const uint8_t *changedB, long m, NSMutableData *hunks)
+{
+    long i = 0;
+    long j = 0;
+    while (i < n || j < m)
+    {
+        if (i < n && j < m && !changedA[i] && !changedB[j])
+        {
+            ++i;
+            ++j;
+        }
+        else
+        {
+            GRKDiffHunk hunk;
+            hunk.start1 = (NSUInteger)i;
+            hunk.start2 = (NSUInteger)j;
+            while (i < n && changedA[i])
+            {
+                ++i;
+            }
+            while (j < m && changedB[j])
+            {
+                ++j;
+            }
+            hunk.length1 = (NSUInteger)i - hunk.start1;
+            hunk.length2 = (NSUInteger)j - hunk.start2;
+            [hunks appendBytes:&hunk length:sizeof(hunk)];
+        }
+    }
+}
+
+@interface GRKTokenSequence ()
+{
+    //Byte offsets of each token, with a final entry at the end of the content (count + 1 entries)
+    NSMutableData *_offsets;
+    NSMutableData *_identifiers;
+}
+
+@property (nonatomic,strong,readwrite) NSData *data;
+@property (nonatomic,assign,readwrite) NSUInteger count;
+@property (nonatomic,weak) GRKDiff *diff;
+
+@end
+
+@implementation GRKTokenSequence
+
+- (const uint32_t *)identifiers
+{
+    return [_identifiers bytes];
+}
+
+- (NSRange)byteRangeOfTokens:(NSRange)tokens
+{
+    const NSUInteger *offsets = [_offsets bytes];
+    NSUInteger start = offsets[tokens.location];
+    return NSMakeRange(start, offsets[NSMaxRange(tokens)] - start);
+}
+
+- (BOOL)tokens:(NSRange)tokens isEqualToTokens:(NSRange)otherTokens ofSequence:(GRKTokenSequence *)sequence
+{
+    return tokens.length == otherTokens.length && memcmp(self.identifiers + tokens.location, sequence.identifiers + otherTokens.location, tokens.length * sizeof(uint32_t)) == 0;
+}
+
+@end
+
+@interface GRKDiff ()
+{
+    //Distinct tokens, indexed by identifier
+    NSMutableData *_tokens;
+    //Open addressed hash table of token identifiers plus one (zero marks an empty slot)
+    uint32_t *_table;
+    NSUInteger _tableCapacity;
+}
+
+@property (nonatomic,assign,readwrite) GRKDiffTokenization tokenization;
+//The content the distinct tokens point into
+@property (nonatomic,strong) NSMutableArray *contents;
+
+@end
+
+@implementation GRKDiff
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    return [self initWithTokenization:GRKDiffTokenizationLines];
+}
+
+- (instancetype)initWithTokenization:(GRKDiffTokenization)tokenization
+{
+    if ((self = [super init]))
+    {
+        self.tokenization = tokenization;
+        self.maximumCost = kDefaultMaximumCost;
+        self.contents = [NSMutableArray array];
+        _tokens = [NSMutableData data];
+        _tableCapacity = kInitialInternCapacity;
+        _table = calloc(_tableCapacity, sizeof(uint32_t));
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_table);
+}
+
+#pragma mark - Implementation
+
+- (GRKTokenSequence *)sequenceWithData:(NSData *)data
+{
+    GRKTokenSequence *retVal = [[GRKTokenSequence alloc] init];
+    retVal.data = [data copy] ?: [NSData data];
+    retVal.diff = self;
+    [self.contents addObject:retVal.data];
+
+    NSMutableData *offsets = [NSMutableData data];
+    NSMutableData *identifiers = [NSMutableData data];
+    const uint8_t *bytes = [retVal.data bytes];
+    NSUInteger length = retVal.data.length;
+    NSUInteger offset = 0;
+    while (offset < length)
+    {
+        size_t tokenLength = GRKDiffTokenLength(self.tokenization, bytes + offset, length - offset);
+        uint32_t identifier = [self internBytes:bytes + offset length:tokenLength];
+        [offsets appendBytes:&offset length:sizeof(offset)];
+        [identifiers appendBytes:&identifier length:sizeof(identifier)];
+        offset += tokenLength;
+    }
+    [offsets appendBytes:&offset length:sizeof(offset)];
+
+    retVal->_offsets = offsets;
+    retVal->_identifiers = identifiers;
+    retVal.count = identifiers.length / sizeof(uint32_t);
+
+    return retVal;
+}
+
+- (NSData *)hunksFromSequence:(GRKTokenSequence *)sequence1 toSequence:(GRKTokenSequence *)sequence2
+{
+    NSMutableData *retVal = [NSMutableData data];
+
+    long n = (long)sequence1.count;
+    long m = (long)sequence2.count;
+    //The search paths are bounded by the total length of the sequences
+    size_t pathLength = (size_t)(n + m + 4);
+
+    GRKDiffContext context;
+    context.a = sequence1.identifiers;
+    context.b = sequence2.identifiers;
+    context.changedA = calloc((size_t)n + 1, sizeof(uint8_t));
+    context.changedB = calloc((size_t)m + 1, sizeof(uint8_t));
+    context.forward = malloc(pathLength * sizeof(long));
+    context.reverse = malloc(pathLength * sizeof(long));
+    context.budget = (long)MIN(self.maximumCost, (NSUInteger)LONG_MAX);
+
+    GRKDiffCompare(&context, 0, n, 0, m);
+    GRKDiffCollectHunks(context.changedA, n, context.changedB, m, retVal);
+
+    free(context.changedA);
+    free(context.changedB);
+    free(context.forward);
+    free(context.reverse);
+
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+/**
+ Returns the identifier of the given token, assigning a new one if it has not been seen before.
+ */
+- (uint32_t)internBytes:(const uint8_t *)bytes length:(size_t)length
+{
+    uint64_t hash = GRKDiffHash(bytes, length);
+    NSUInteger mask = _tableCapacity - 1;
+    NSUInteger slot = (NSUInteger)hash & mask;
+    GRKDiffToken *tokens = [_tokens mutableBytes];
+    while (_table[slot] != 0)
+    {
+        GRKDiffToken *token = &tokens[_table[slot] - 1];
+        if (token->hash == hash && token->length == length && memcmp(token->bytes, bytes, length) == 0)
+        {
+            return _table[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t retVal = (uint32_t)(_tokens.length / sizeof(GRKDiffToken));
+    GRKDiffToken token = {bytes, length, hash};
+    [_tokens appendBytes:&token length:sizeof(token)];
+    _table[slot] = retVal + 1;
+
+    //Keep the table at most half full
+    if (2 * (NSUInteger)(retVal + 1) > _tableCapacity)
+    {
+        [self growTable];
+    }
+
+    return retVal;
+}
+
+- (void)growTable
+{
+    NSUInteger capacity = _tableCapacity * 2;
+    uint32_t *table = calloc(capacity, sizeof(uint32_t));
+    const GRKDiffToken *tokens = [_tokens bytes];
+    NSUInteger count = _tokens.length / sizeof(GRKDiffToken);
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        NSUInteger slot = (NSUInteger)tokens[i].hash & (capacity - 1);
+        while (table[slot] != 0)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot] = (uint32_t)i + 1;
+    }
+
+    free(_table);
+    _table = table;
+    _tableCapacity = capacity;
+}
+
+@end
@@ -0,0 +1,128 @@
+//
+//  GRKDigestCache.h
+//
+//  Created by Levi Brown on 10/16/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const kDefaultDigestCacheFileName;
+
+/**
+ A persistent cache of file MD5 digests.
+ Entries are keyed by the device and inode of a file, and are only returned while the file's size and modification time (in nanoseconds) match those recorded when the digest was computed. A mismatch invalidates the entry and the file is hashed again.
+ All methods are safe to call from any queue. Hashing is not serialized, so multiple files may be hashed concurrently.
+ */
+@interface GRKDigestCache : NSObject
+
+/**
+ The file URL where the cache is persisted.
+ */
+@property (nonatomic,readonly) NSURL *url;
+
+/**
+ The number of digest requests satisfied from the cache since the statistics were last reset.
+ */
+@property (nonatomic,readonly) NSUInteger hits;
+
+/**
+ The number of digest requests which required the file to be read and hashed since the statistics were last reset.
+ */
+@property (nonatomic,readonly) NSUInteger misses;
+
+/**
+ The shared cache, persisted in the private documents directory.
+ The persisted content is loaded when the shared cache is first accessed.
+
+ @return The common instance of the GRKDigestCache.
+ @see kDefaultDigestCacheFileName Which is used for the file name.
+ */
++ (instancetype)sharedCache;
+
+/**
+ Computes the MD5 digest of the given data.
+
+ @param data The data to hash.
+
+ @return The digest as a lower case hex string.
+ */
++ (NSString *)MD5ForData:(NSData *)data;
+
+/**
+ Creates an empty cache persisted at the given location.
+
+ @param url The file URL where the cache will be persisted.
+
+ @return A new, empty, cache. Use `load:` to read existing content.
+ */
+- (instancetype)initWithURL:(NSURL *)url;
+
+/**
+ Gets the MD5 digest of the given file, from the cache if the file is unchanged, or by hashing the file.
+
+ @param fileURL The file URL of the file to hash.
+
+ @return The digest as a lower case hex string, or `nil` if the file could not be read.
+ */
+- (NSString *)MD5ForFile:(NSURL *)fileURL;
+
+/**
+ Records a digest which is already known for the given file (for instance, the digest of content which was just written to it), so the file need not be read.
+
+ @param MD5     The digest of the file's current content, as a lower case hex string.
+ @param fileURL The file URL of the file.
+ */
+- (void)setMD5:(NSString *)MD5 forFile:(NSURL *)fileURL;
+
+/**
+ Removes any cached digest for the given file. This should be called before the file is deleted.
+
+ @param fileURL The file URL of the file.
+ */
+- (void)removeMD5ForFile:(NSURL *)fileURL;
+
+/**
+ Removes the cached digests of files which are no longer in the given directory, such as files deleted or replaced without `removeMD5ForFile:` being called first.
+ Every cached file is expected to be in the directory; entries for files elsewhere are removed as well.
+ The directory listing (without subdirectories) is read and each entry is stat'd, so this is best done as the cache is saved.
+
+ @param directoryURL The file URL of the directory holding the cached files.
+ */
+- (void)pruneFilesNotInDirectory:(NSURL *)directoryURL;
+
+/**
+ Resets the hit and miss counters to zero.
+ */
+- (void)resetStatistics;
+
+/**
+ Loads the persisted cache, replacing the current content.
+ A missing cache file is not considered an error.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)load:(__autoreleasing NSError **)error;
+
+/**
+ Atomically persists the cache.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)save:(__autoreleasing NSError **)error;
+
+@end
@@ -0,0 +1,354 @@
+//
+//  GRKDigestCache.m
+//
+//  Created by Levi Brown on 10/16/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKDigestCache.h"
+#import "GRKFileManager.h"
+#import "FileMD5Hash.h"
+#import "GRKMetrics.h"
+#include <CommonCrypto/CommonDigest.h>
+#include <sys/stat.h>
+
+NSString * const kDefaultDigestCacheFileName = @"DigestCache.bin";
+
+static uint32_t const kDigestCacheMagic = 0x43444B47; // "GKDC"
+static uint32_t const kDigestCacheVersion = 1;
+
+//The time taken by each digest computed, in microseconds, and the bytes hashed (see GRKMetrics)
+static NSString * const kMetricDigestTime = @"digest.md5";
+static NSString * const kMetricDigestBytes = @"digest.bytes";
+
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+} GRKDigestCacheKey;
+
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t modificationTime;
+    uint8_t digest[CC_MD5_DIGEST_LENGTH];
+} GRKDigestCacheRecord;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+} GRKDigestCacheHeader;
+
+static BOOL GRKDigestCacheStat(NSURL *fileURL, GRKDigestCacheRecord *record)
+{
+    struct stat fileStat;
+    BOOL retVal = fileURL && stat([fileURL fileSystemRepresentation], &fileStat) == 0;
+    if (retVal)
+    {
+        record->device = (uint64_t)fileStat.st_dev;
+        record->inode = (uint64_t)fileStat.st_ino;
+        record->size = (uint64_t)fileStat.st_size;
+        record->modificationTime = (int64_t)fileStat.st_mtimespec.tv_sec * (int64_t)NSEC_PER_SEC + (int64_t)fileStat.st_mtimespec.tv_nsec;
+    }
+    return retVal;
+}
+
+static NSData *GRKDigestCacheKeyForRecord(const GRKDigestCacheRecord *record)
+{
+    GRKDigestCacheKey key = { record->device, record->inode };
+    return [NSData dataWithBytes:&key length:sizeof(key)];
+}
+
+static NSString *GRKDigestCacheStringFromDigest(const uint8_t *digest)
+{
+    char hash[2 * CC_MD5_DIGEST_LENGTH + 1];
+    for (size_t i = 0; i < CC_MD5_DIGEST_LENGTH; ++i)
+    {
+        snprintf(hash + (2 * i), 3, "%02x", (int)(digest[i]));
+    }
+    return [[NSString alloc] initWithBytes:hash length:2 * CC_MD5_DIGEST_LENGTH encoding:NSASCIIStringEncoding];
+}
+
+static BOOL GRKDigestCacheDigestFromString(NSString *string, uint8_t *digest)
+{
+    BOOL retVal = NO;
+
+    const char *hex = [string UTF8String];
+    if (hex && strlen(hex) == 2 * CC_MD5_DIGEST_LENGTH)
+    {
+        retVal = YES;
+        for (size_t i = 0; i < CC_MD5_DIGEST_LENGTH && retVal; ++i)
+        {
+            unsigned int byte = 0;
+            retVal = sscanf(hex + (2 * i), "%2x", &byte) == 1;
+            digest[i] = (uint8_t)byte;
+        }
+    }
+
+    return retVal;
+}
+
+@interface GRKDigestCache ()
+
+@property (nonatomic,strong,readwrite) NSURL *url;
+@property (nonatomic,assign,readwrite) NSUInteger hits;
+@property (nonatomic,assign,readwrite) NSUInteger misses;
+//Maps NSData (GRKDigestCacheKey) to NSData (GRKDigestCacheRecord). Only accessed on `queue`.
+@property (nonatomic,strong) NSMutableDictionary *records;
+@property (nonatomic,strong) dispatch_queue_t queue;
+
+@end
+
+@implementation GRKDigestCache
+
+#pragma mark - Class Level
+
++ (instancetype)sharedCache
+{
+    static dispatch_once_t onceQueue;
+    static GRKDigestCache *digestCache = nil;
+
+    dispatch_once(&onceQueue, ^{
+        GRKFileManager *grkFileManager = [[GRKFileManager alloc] init];
+        NSURL *privateDir = [grkFileManager privateDocumentsDirectory];
+        NSURL *url = [privateDir URLByAppendingPathComponent:kDefaultDigestCacheFileName];
+        digestCache = [[self alloc] initWithURL:url];
+        __autoreleasing NSError *error = nil;
+        if (![digestCache load:&error])
+        {
+            DDLogWarn(@"Unable to load digest cache '%@'. Error: %@", url, error);
+        }
+    });
+    return digestCache;
+}
+
++ (NSString *)MD5ForData:(NSData *)data
+{
+    uint64_t start = GRKMetricsTime();
+    uint8_t digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5([data bytes], (CC_LONG)data.length, digest);
+    GRKMetrics *metrics = [GRKMetrics sharedMetrics];
+    [metrics recordTimeSince:start inHistogramNamed:kMetricDigestTime];
+    [metrics incrementCounterNamed:kMetricDigestBytes by:data.length];
+    return GRKDigestCacheStringFromDigest(digest);
+}
+
+#pragma mark - Initialization
+
+- (instancetype)initWithURL:(NSURL *)url
+{
+    if ((self = [super init]))
+    {
+        self.url = url;
+        self.records = [NSMutableDictionary dictionary];
+        self.queue = dispatch_queue_create("com.levigroker.digestcache", DISPATCH_QUEUE_SERIAL);
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (NSString *)MD5ForFile:(NSURL *)fileURL
+{
+    NSString *retVal = nil;
+
+    GRKDigestCacheRecord current;
+    if (GRKDigestCacheStat(fileURL, &current))
+    {
+        NSData *key = GRKDigestCacheKeyForRecord(&current);
+
+        __block BOOL hit = NO;
+        __block GRKDigestCacheRecord cached;
+        dispatch_sync(self.queue, ^{
+            NSData *recordData = [self.records objectForKey:key];
+            if (recordData)
+            {
+                [recordData getBytes:&cached length:sizeof(cached)];
+                hit = cached.size == current.size && cached.modificationTime == current.modificationTime;
+                if (!hit)
+                {
+                    //The file has changed, so the entry is no longer valid
+                    [self.records removeObjectForKey:key];
+                }
+            }
+            if (hit)
+            {
+                self.hits++;
+            }
+            else
+            {
+                self.misses++;
+            }
+        });
+
+        if (hit)
+        {
+            retVal = GRKDigestCacheStringFromDigest(cached.digest);
+        }
+        else
+        {
+            //Hash outside of the queue, so other lookups (and hashes) are not blocked
+            uint64_t start = GRKMetricsTime();
+            CFStringRef md5value = FileMD5HashCreateWithPath((__bridge CFStringRef)[fileURL path], FileHashDefaultChunkSizeForReadingData);
+            retVal = (NSString *)CFBridgingRelease(md5value);
+            GRKMetrics *metrics = [GRKMetrics sharedMetrics];
+            [metrics recordTimeSince:start inHistogramNamed:kMetricDigestTime];
+            [metrics incrementCounterNamed:kMetricDigestBytes by:current.size];
+
+            //Only cache the digest if the file did not change while we were reading it
+            GRKDigestCacheRecord after;
+            if (retVal && GRKDigestCacheStat(fileURL, &after) && memcmp(&after, &current, offsetof(GRKDigestCacheRecord, digest)) == 0)
+            {
+                [self storeMD5:retVal forRecord:&after];
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (void)setMD5:(NSString *)MD5 forFile:(NSURL *)fileURL
+{
+    GRKDigestCacheRecord current;
+    if (MD5 && GRKDigestCacheStat(fileURL, &current))
+    {
+        [self storeMD5:MD5 forRecord:&current];
+    }
+}
+
+- (void)removeMD5ForFile:(NSURL *)fileURL
+{
+    GRKDigestCacheRecord current;
+    if (GRKDigestCacheStat(fileURL, &current))
+    {
+        NSData *key = GRKDigestCacheKeyForRecord(&current);
+        dispatch_sync(self.queue, ^{
+            [self.records removeObjectForKey:key];
+        });
+    }
+}
+
+- (void)pruneFilesNotInDirectory:(NSURL *)directoryURL
+{
+    NSArray *contents = directoryURL ? [[NSFileManager defaultManager] contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:nil options:0 error:nil] : nil;
+    if (contents)
+    {
+        //Keys of the files present now
+        NSMutableSet *liveKeys = [NSMutableSet setWithCapacity:contents.count];
+        for (NSURL *fileURL in contents)
+        {
+            GRKDigestCacheRecord current;
+            if (GRKDigestCacheStat(fileURL, &current))
+            {
+                [liveKeys addObject:GRKDigestCacheKeyForRecord(&current)];
+            }
+        }
+
+        dispatch_sync(self.queue, ^{
+            NSMutableArray *staleKeys = [NSMutableArray array];
+            for (NSData *key in [self.records keyEnumerator])
+            {
+                if (![liveKeys containsObject:key])
+                {
+                    [staleKeys addObject:key];
+                }
+            }
+            [self.records removeObjectsForKeys:staleKeys];
+        });
+    }
+}
+
+- (void)resetStatistics
+{
+    dispatch_sync(self.queue, ^{
+        self.hits = 0;
+        self.misses = 0;
+    });
+}
+
+- (BOOL)load:(__autoreleasing NSError **)error
+{
+    BOOL success = YES;
+
+    if (self.url && [[NSFileManager defaultManager] fileExistsAtPath:[self.url path]])
+    {
+        NSData *data = [NSData dataWithContentsOfURL:self.url options:NSDataReadingMappedIfSafe error:error];
+        success = data != nil;
+        if (success)
+        {
+            const GRKDigestCacheHeader *header = [data bytes];
+            BOOL valid = data.length >= sizeof(GRKDigestCacheHeader) &&
+                         header->magic == kDigestCacheMagic &&
+                         header->version == kDigestCacheVersion &&
+                         data.length == sizeof(GRKDigestCacheHeader) + (header->count * sizeof(GRKDigestCacheRecord));
+            if (valid)
+            {
+                const GRKDigestCacheRecord *records = (const GRKDigestCacheRecord *)(header + 1);
+                NSMutableDictionary *loaded = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)header->count];
+                for (uint64_t i = 0; i < header->count; ++i)
+                {
+                    const GRKDigestCacheRecord *record = &records[i];
+                    [loaded setObject:[NSData dataWithBytes:record length:sizeof(GRKDigestCacheRecord)] forKey:GRKDigestCacheKeyForRecord(record)];
+                }
+                dispatch_sync(self.queue, ^{
+                    self.records = loaded;
+                });
+            }
+            else
+            {
+                //A stale or damaged cache is simply discarded; it will be rebuilt as files are hashed
+                DDLogWarn(@"Discarding invalid digest cache '%@'.", self.url);
+            }
+        }
+    }
+
+    return success;
+}
+
+- (BOOL)save:(__autoreleasing NSError **)error
+{
+    __block NSMutableData *data = nil;
+    dispatch_sync(self.queue, ^{
+        GRKDigestCacheHeader header;
+        header.magic = kDigestCacheMagic;
+        header.version = kDigestCacheVersion;
+        header.count = self.records.count;
+        data = [NSMutableData dataWithCapacity:sizeof(header) + (self.records.count * sizeof(GRKDigestCacheRecord))];
+        [data appendBytes:&header length:sizeof(header)];
+        for (NSData *recordData in [self.records objectEnumerator])
+        {
+            [data appendData:recordData];
+        }
+    });
+
+    BOOL success = self.url && [data writeToURL:self.url options:NSDataWritingAtomic error:error];
+    return success;
+}
+
+#pragma mark - Helpers
+
+- (void)storeMD5:(NSString *)MD5 forRecord:(GRKDigestCacheRecord *)record
+{
+    if (GRKDigestCacheDigestFromString(MD5, record->digest))
+    {
+        NSData *key = GRKDigestCacheKeyForRecord(record);
+        NSData *recordData = [NSData dataWithBytes:record length:sizeof(GRKDigestCacheRecord)];
+        dispatch_sync(self.queue, ^{
+            [self.records setObject:recordData forKey:key];
+        });
+    }
+}
+
+@end
@@ -0,0 +1,138 @@
+//
+//  GRKDirectoryListing.h
+//
+//  Created by Levi Brown on 10/16/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Options which control which directory entries are included in a listing.
+ */
+typedef NS_OPTIONS(NSUInteger, GRKDirectoryListingOptions) {
+    /**
+     Entries whose names begin with a period are skipped.
+     */
+    GRKDirectoryListingSkipsHiddenFiles = 1 << 0,
+    /**
+     Only regular files are included (directories, symbolic links, and special files are skipped).
+     */
+    GRKDirectoryListingRegularFilesOnly = 1 << 1,
+    /**
+     Entries which are not both readable and writable by the current process are skipped.
+     */
+    GRKDirectoryListingReadableWritableOnly = 1 << 2
+};
+
+/**
+ A single entry of a GRKDirectoryListing. Times are in nanoseconds since the epoch.
+ */
+typedef struct {
+    uint64_t inode;
+    uint64_t size;
+    int64_t modificationTime;
+    int64_t changeTime;
+    uint32_t nameOffset;
+    uint16_t nameLength;
+    uint16_t mode;
+} GRKDirectoryEntry;
+
+/**
+ The contents of a single directory, read with `readdir` and one `fstatat` per entry (or only per changed entry, given a previous listing).
+ The entries are stored in one packed array, and the names in one buffer, so no objects are created per entry unless a name or URL is asked for. Entries are also hashed by name, so an entry can be found by name without a search.
+ A listing is immutable once created, so it may be read from any queue.
+ */
+@interface GRKDirectoryListing : NSObject
+
+/**
+ The directory which was listed.
+ */
+@property (nonatomic,readonly) NSURL *directory;
+
+/**
+ The number of entries in the listing.
+ */
+@property (nonatomic,readonly) NSUInteger count;
+
+/**
+ Lists the contents of the given directory. Subdirectories are not descended into.
+
+ @param directory The file URL of the directory to list.
+ @param options   Options controlling which entries are included.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The listing, or `nil` if the directory could not be read.
+ */
++ (instancetype)listingOfDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options error:(__autoreleasing NSError **)error;
+
+/**
+ Lists the contents of the given directory, taking the attributes of entries which have not changed from a previous listing of it.
+ An entry whose name is in the previous listing with the same inode (as reported by `readdir`) is taken to be unchanged, and is not stat'ed. A file replaced under the same name (e.g. an atomic save) has a new inode, so is stat'ed again, but in place writes to an existing file are not seen.
+
+ @param directory       The file URL of the directory to list.
+ @param options         Options controlling which entries are included.
+ @param previousListing A listing of the same directory, taken with the same options. Can be nil, in which case every entry is stat'ed.
+ @param error           A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The listing, or `nil` if the directory could not be read.
+ */
++ (instancetype)listingOfDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options previousListing:(GRKDirectoryListing *)previousListing error:(__autoreleasing NSError **)error;
+
+/**
+ Gets the entry at the given index. The entries are in the order returned by the filesystem.
+
+ @param index The index of the entry, which must be less than `count`.
+
+ @return A pointer to the entry, which is valid for the lifetime of the listing.
+ */
+- (const GRKDirectoryEntry *)entryAtIndex:(NSUInteger)index;
+
+/**
+ Finds the entry with the given name.
+
+ @param name   The name, in filesystem representation.
+ @param length The length of the name, in bytes.
+
+ @return The index of the entry, or `NSNotFound` if there is no entry with the name.
+ */
+- (NSUInteger)indexOfEntryWithFileSystemName:(const char *)name length:(NSUInteger)length;
+
+/**
+ Gets the name of the given entry, in filesystem representation.
+
+ @param entry An entry of this listing.
+
+ @return The NUL terminated name, which is valid for the lifetime of the listing.
+ */
+- (const char *)fileSystemNameOfEntry:(const GRKDirectoryEntry *)entry;
+
+/**
+ Gets the name of the given entry.
+
+ @param entry An entry of this listing.
+
+ @return The name of the entry.
+ */
+- (NSString *)nameOfEntry:(const GRKDirectoryEntry *)entry;
+
+/**
+ Gets a file URL for the given entry.
+
+ @param entry An entry of this listing.
+
+ @return The file URL of the entry within `directory`.
+ */
+- (NSURL *)URLOfEntry:(const GRKDirectoryEntry *)entry;
+
+@end
@@ -0,0 +1,238 @@
+//
+//  GRKDirectoryListing.m
+//
+//  Created by Levi Brown on 10/16/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKDirectoryListing.h"
+#import "GRKFileManager.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static NSUInteger const kDirectoryListingInitialCapacity = 256;
+
+//The hash of an entry name (FNV-1a)
+static uint32_t GRKDirectoryListingNameHash(const char *name, NSUInteger length)
+{
+    uint32_t hash = 2166136261u;
+    for (NSUInteger i = 0; i < length; ++i)
+    {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int64_t GRKDirectoryListingNanoseconds(struct timespec time)
+{
+    return (int64_t)time.tv_sec * (int64_t)NSEC_PER_SEC + (int64_t)time.tv_nsec;
+}
+
+static NSError *GRKDirectoryListingErrnoError(int errorNumber, NSURL *directory)
+{
+    NSString *message = [NSString stringWithFormat:@"%s '%@'", strerror(errorNumber), directory];
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    [userInfo setObject:[NSNumber numberWithInt:errorNumber] forKey:kGRKFileManagerErrorKeyErrno];
+    return [NSError errorWithDomain:GRKFileManagerErrorDomain code:GRKFileManagerErrorErrno userInfo:userInfo];
+}
+
+@interface GRKDirectoryListing ()
+
+@property (nonatomic,strong,readwrite) NSURL *directory;
+@property (nonatomic,assign,readwrite) NSUInteger count;
+//Packed array of GRKDirectoryEntry
+@property (nonatomic,strong) NSData *entries;
+//NUL terminated entry names, referenced by GRKDirectoryEntry nameOffset
+@property (nonatomic,strong) NSData *names;
+//Open addressed table of entry indexes (plus one, so zero is an empty slot) by name hash, with a power of two number of slots
+@property (nonatomic,strong) NSData *nameTable;
+
+@end
+
+@implementation GRKDirectoryListing
+
+#pragma mark - Class Level
+
++ (instancetype)listingOfDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options error:(__autoreleasing NSError **)error
+{
+    return [self listingOfDirectory:directory options:options previousListing:nil error:error];
+}
+
++ (instancetype)listingOfDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options previousListing:(GRKDirectoryListing *)previousListing error:(__autoreleasing NSError **)error
+{
+    GRKDirectoryListing *retVal = nil;
+
+    int directoryFD = directory ? open([directory fileSystemRepresentation], O_RDONLY | O_DIRECTORY) : -1;
+    DIR *dir = directoryFD >= 0 ? fdopendir(directoryFD) : NULL;
+    if (dir)
+    {
+        NSMutableData *entries = [NSMutableData dataWithCapacity:kDirectoryListingInitialCapacity * sizeof(GRKDirectoryEntry)];
+        NSMutableData *names = [NSMutableData dataWithCapacity:kDirectoryListingInitialCapacity * 32];
+        NSUInteger count = 0;
+
+        struct dirent *dirEntry;
+        while ((dirEntry = readdir(dir)))
+        {
+            const char *name = dirEntry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            {
+                continue;
+            }
+            if ((options & GRKDirectoryListingSkipsHiddenFiles) && name[0] == '.')
+            {
+                continue;
+            }
+            //The directory entry type lets us skip non-files without a stat (some filesystems report DT_UNKNOWN, so the stat below still checks)
+            if ((options & GRKDirectoryListingRegularFilesOnly) && dirEntry->d_type != DT_REG && dirEntry->d_type != DT_UNKNOWN)
+            {
+                continue;
+            }
+
+            GRKDirectoryEntry entry;
+            //An entry still naming the same inode as before is unchanged, so needs no stat
+            NSUInteger previousIndex = previousListing ? [previousListing indexOfEntryWithFileSystemName:name length:dirEntry->d_namlen] : NSNotFound;
+            const GRKDirectoryEntry *previousEntry = previousIndex != NSNotFound ? [previousListing entryAtIndex:previousIndex] : NULL;
+            if (previousEntry && previousEntry->inode == (uint64_t)dirEntry->d_ino)
+            {
+                entry = *previousEntry;
+            }
+            else
+            {
+                struct stat fileStat;
+                if (fstatat(directoryFD, name, &fileStat, AT_SYMLINK_NOFOLLOW) != 0)
+                {
+                    DDLogVerbose(@"Unable to stat '%s' in '%@': %s", name, directory, strerror(errno));
+                    continue;
+                }
+                if ((options & GRKDirectoryListingRegularFilesOnly) && !S_ISREG(fileStat.st_mode))
+                {
+                    continue;
+                }
+                if ((options & GRKDirectoryListingReadableWritableOnly) && faccessat(directoryFD, name, R_OK | W_OK, 0) != 0)
+                {
+                    DDLogVerbose(@"Item is not readable and writable: '%s'", name);
+                    continue;
+                }
+
+                entry.inode = (uint64_t)fileStat.st_ino;
+                entry.size = (uint64_t)fileStat.st_size;
+                entry.modificationTime = GRKDirectoryListingNanoseconds(fileStat.st_mtimespec);
+                entry.changeTime = GRKDirectoryListingNanoseconds(fileStat.st_ctimespec);
+                entry.mode = (uint16_t)fileStat.st_mode;
+            }
+            entry.nameOffset = (uint32_t)names.length;
+            entry.nameLength = (uint16_t)dirEntry->d_namlen;
+            [names appendBytes:name length:entry.nameLength + 1];
+            [entries appendBytes:&entry length:sizeof(entry)];
+            count++;
+        }
+
+        //closedir also closes the descriptor
+        closedir(dir);
+
+        retVal = [[self alloc] init];
+        retVal.directory = directory;
+        retVal.count = count;
+        retVal.entries = entries;
+        retVal.names = names;
+        [retVal buildNameTable];
+    }
+    else
+    {
+        int errorNumber = directory ? errno : EINVAL;
+        if (directoryFD >= 0)
+        {
+            close(directoryFD);
+        }
+        if (error)
+        {
+            *error = GRKDirectoryListingErrnoError(errorNumber, directory);
+        }
+    }
+
+    return retVal;
+}
+
+#pragma mark - Implementation
+
+- (const GRKDirectoryEntry *)entryAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < self.count);
+    return (const GRKDirectoryEntry *)[self.entries bytes] + index;
+}
+
+- (NSUInteger)indexOfEntryWithFileSystemName:(const char *)name length:(NSUInteger)length
+{
+    NSUInteger retVal = NSNotFound;
+
+    const uint32_t *slots = [self.nameTable bytes];
+    NSUInteger mask = self.nameTable.length / sizeof(uint32_t) - 1;
+    for (NSUInteger slot = GRKDirectoryListingNameHash(name, length) & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+        const GRKDirectoryEntry *entry = [self entryAtIndex:slots[slot] - 1];
+        if (entry->nameLength == length && memcmp([self fileSystemNameOfEntry:entry], name, length) == 0)
+        {
+            retVal = slots[slot] - 1;
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+- (const char *)fileSystemNameOfEntry:(const GRKDirectoryEntry *)entry
+{
+    return (const char *)[self.names bytes] + entry->nameOffset;
+}
+
+- (NSString *)nameOfEntry:(const GRKDirectoryEntry *)entry
+{
+    return [[NSFileManager defaultManager] stringWithFileSystemRepresentation:[self fileSystemNameOfEntry:entry] length:entry->nameLength];
+}
+
+- (NSURL *)URLOfEntry:(const GRKDirectoryEntry *)entry
+{
+    return [self.directory URLByAppendingPathComponent:[self nameOfEntry:entry] isDirectory:NO];
+}
+
+#pragma mark - Helpers
+
+//Kept at most half full, so there is always an empty slot to end a probe
+- (void)buildNameTable
+{
+    NSUInteger slotCount = 2;
+    while (slotCount < self.count * 2)
+    {
+        slotCount <<= 1;
+    }
+    NSMutableData *nameTable = [NSMutableData dataWithLength:slotCount * sizeof(uint32_t)];
+    uint32_t *slots = [nameTable mutableBytes];
+    NSUInteger mask = slotCount - 1;
+    for (NSUInteger i = 0; i < self.count; ++i)
+    {
+        const GRKDirectoryEntry *entry = [self entryAtIndex:i];
+        NSUInteger slot = GRKDirectoryListingNameHash([self fileSystemNameOfEntry:entry], entry->nameLength) & mask;
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = (uint32_t)(i + 1);
+    }
+    self.nameTable = nameTable;
+}
+
+@end
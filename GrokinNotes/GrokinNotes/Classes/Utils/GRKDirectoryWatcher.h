@@ -0,0 +1,127 @@
+//
+//  GRKDirectoryWatcher.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+#import "GRKDirectoryListing.h"
+
+/**
+ The kinds of change reported by a GRKDirectoryWatcher.
+ */
+typedef NS_ENUM(NSInteger, GRKDirectoryWatcherEventType) {
+    GRKDirectoryWatcherEventCreated = 1,
+    GRKDirectoryWatcherEventModified,
+    GRKDirectoryWatcherEventRenamed,
+    GRKDirectoryWatcherEventDeleted
+};
+
+/**
+ A single change to a file in the watched directory.
+ */
+@interface GRKDirectoryWatcherEvent : NSObject
+
+@property (nonatomic,assign,readonly) GRKDirectoryWatcherEventType type;
+/**
+ The file URL of the file. For a deleted file this is where the file was.
+ */
+@property (nonatomic,strong,readonly) NSURL *fileURL;
+/**
+ The previous file URL of a renamed file, otherwise `nil`.
+ */
+@property (nonatomic,strong,readonly) NSURL *previousFileURL;
+
+@end
+
+/**
+ A source of change signals for a GRKDirectoryWatcher. The backend only needs to report that the directory may have changed; the watcher works out what changed.
+ */
+@protocol GRKDirectoryWatcherBackend <NSObject>
+
+/**
+ Starts monitoring the given directory.
+
+ @param directory The file URL of the directory to monitor.
+ @param queue     The queue on which `handler` must be called.
+ @param handler   Called whenever the directory may have changed.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)startMonitoringDirectory:(NSURL *)directory queue:(dispatch_queue_t)queue handler:(void(^)(void))handler error:(__autoreleasing NSError **)error;
+
+/**
+ Stops monitoring. The handler will not be called after this returns.
+ */
+- (void)stopMonitoring;
+
+@end
+
+/**
+ The default GRKDirectoryWatcherBackend, which uses a dispatch vnode source on the directory.
+ The directory is signalled when entries are created, removed or renamed, which includes files saved atomically. In place writes to existing files do not change the directory, so are not signalled.
+ */
+@interface GRKDispatchSourceDirectoryWatcherBackend : NSObject <GRKDirectoryWatcherBackend>
+@end
+
+/**
+ Watches a single directory (not its subdirectories) and reports batches of file changes.
+ Signals from the backend are coalesced over `latency`, then the directory is listed and compared against the previous listing. Files are matched by name, and a file which disappears under one name and appears under another with the same inode is reported as a rename.
+ Each signal still reads the whole directory (a signal does not say which entries changed), but only entries which are new or name a different inode are stat'ed (see `+[GRKDirectoryListing listingOfDirectory:options:previousListing:error:]`), so in place writes to existing files are not reported.
+ */
+@interface GRKDirectoryWatcher : NSObject
+
+/**
+ The directory being watched.
+ */
+@property (nonatomic,readonly) NSURL *directory;
+
+/**
+ The options used to list the directory, which determine which files are watched.
+ */
+@property (nonatomic,readonly) GRKDirectoryListingOptions options;
+
+/**
+ The time, in seconds, over which backend signals are coalesced into one batch. Defaults to 0.1 seconds.
+ */
+@property (nonatomic,assign) NSTimeInterval latency;
+
+/**
+ Creates a watcher for the given directory.
+
+ @param directory The file URL of the directory to watch.
+ @param options   The options used to list the directory.
+ @param backend   The source of change signals. If `nil` a GRKDispatchSourceDirectoryWatcherBackend is used.
+
+ @return A new, stopped, watcher.
+ */
+- (instancetype)initWithDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options backend:(id<GRKDirectoryWatcherBackend>)backend;
+
+/**
+ Takes a listing of the directory as the baseline, and starts watching for changes to it.
+
+ @param handler Called on the main queue with an NSArray of GRKDirectoryWatcherEvent objects for each batch of changes.
+ @param error   A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)startWithHandler:(void(^)(NSArray *events))handler error:(__autoreleasing NSError **)error;
+
+/**
+ Stops watching. No further batches will be reported.
+ */
+- (void)stop;
+
+@end
@@ -0,0 +1,308 @@
+//
+//  GRKDirectoryWatcher.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKDirectoryWatcher.h"
+#import "GRKFileManager.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+static NSTimeInterval const kDefaultDirectoryWatcherLatency = 0.1;
+
+#pragma mark - GRKDirectoryWatcherEvent
+
+@interface GRKDirectoryWatcherEvent ()
+
+@property (nonatomic,assign,readwrite) GRKDirectoryWatcherEventType type;
+@property (nonatomic,strong,readwrite) NSURL *fileURL;
+@property (nonatomic,strong,readwrite) NSURL *previousFileURL;
+
+@end
+
+@implementation GRKDirectoryWatcherEvent
+
++ (instancetype)eventWithType:(GRKDirectoryWatcherEventType)type fileURL:(NSURL *)fileURL previousFileURL:(NSURL *)previousFileURL
+{
+    GRKDirectoryWatcherEvent *retVal = [[self alloc] init];
+    retVal.type = type;
+    retVal.fileURL = fileURL;
+    retVal.previousFileURL = previousFileURL;
+    return retVal;
+}
+
+- (NSString *)description
+{
+    static NSString * const typeNames[] = { @"?", @"created", @"modified", @"renamed", @"deleted" };
+    NSString *typeName = self.type >= GRKDirectoryWatcherEventCreated && self.type <= GRKDirectoryWatcherEventDeleted ? typeNames[self.type] : typeNames[0];
+    return [NSString stringWithFormat:@"[%@ <%p> %@: \"%@\"%@]", [self class], self, typeName, [self.fileURL lastPathComponent],
+            self.previousFileURL ? [NSString stringWithFormat:@" (was \"%@\")", [self.previousFileURL lastPathComponent]] : @""];
+}
+
+@end
+
+#pragma mark - GRKDispatchSourceDirectoryWatcherBackend
+
+@interface GRKDispatchSourceDirectoryWatcherBackend ()
+
+@property (nonatomic,strong) dispatch_source_t source;
+
+@end
+
+@implementation GRKDispatchSourceDirectoryWatcherBackend
+
+- (void)dealloc
+{
+    [self stopMonitoring];
+}
+
+- (BOOL)startMonitoringDirectory:(NSURL *)directory queue:(dispatch_queue_t)queue handler:(void(^)(void))handler error:(__autoreleasing NSError **)error
+{
+    [self stopMonitoring];
+
+    int directoryFD = open([directory fileSystemRepresentation], O_EVTONLY);
+    BOOL success = directoryFD >= 0;
+    if (success)
+    {
+        dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_VNODE, (uintptr_t)directoryFD, DISPATCH_VNODE_WRITE | DISPATCH_VNODE_DELETE | DISPATCH_VNODE_RENAME, queue);
+        dispatch_source_set_event_handler(source, handler);
+        dispatch_source_set_cancel_handler(source, ^{
+            close(directoryFD);
+        });
+        self.source = source;
+        dispatch_resume(source);
+    }
+    else
+    {
+        //Handle error
+        if (error)
+        {
+            NSString *message = [NSString stringWithFormat:@"%s", strerror(errno)];
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:2];
+            [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+            [userInfo setObject:[NSNumber numberWithInt:errno] forKey:kGRKFileManagerErrorKeyErrno];
+            *error = [NSError errorWithDomain:GRKFileManagerErrorDomain code:GRKFileManagerErrorErrno userInfo:userInfo];
+        }
+    }
+
+    return success;
+}
+
+- (void)stopMonitoring
+{
+    if (self.source)
+    {
+        dispatch_source_cancel(self.source);
+        self.source = nil;
+    }
+}
+
+@end
+
+#pragma mark - GRKDirectoryWatcher
+
+@interface GRKDirectoryWatcher ()
+
+@property (nonatomic,strong,readwrite) NSURL *directory;
+@property (nonatomic,assign,readwrite) GRKDirectoryListingOptions options;
+@property (nonatomic,strong) id<GRKDirectoryWatcherBackend> backend;
+@property (nonatomic,copy) void(^handler)(NSArray *events);
+//The following are only accessed on `queue`
+@property (nonatomic,strong) dispatch_queue_t queue;
+@property (nonatomic,strong) GRKDirectoryListing *snapshot;
+@property (nonatomic,assign) BOOL scanPending;
+//Incremented on each start and stop, so batches from a previous run are dropped
+@property (atomic,assign) NSUInteger generation;
+
+@end
+
+@implementation GRKDirectoryWatcher
+
+#pragma mark - Initialization
+
+- (instancetype)initWithDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options backend:(id<GRKDirectoryWatcherBackend>)backend
+{
+    if ((self = [super init]))
+    {
+        self.directory = directory;
+        self.options = options;
+        self.backend = backend ?: [[GRKDispatchSourceDirectoryWatcherBackend alloc] init];
+        self.latency = kDefaultDirectoryWatcherLatency;
+        self.queue = dispatch_queue_create("com.levigroker.directorywatcher", DISPATCH_QUEUE_SERIAL);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [self.backend stopMonitoring];
+}
+
+#pragma mark - Implementation
+
+- (BOOL)startWithHandler:(void(^)(NSArray *events))handler error:(__autoreleasing NSError **)error
+{
+    [self stop];
+
+    GRKDirectoryListing *snapshot = [GRKDirectoryListing listingOfDirectory:self.directory options:self.options error:error];
+    BOOL success = snapshot != nil;
+    if (success)
+    {
+        self.handler = handler;
+        NSUInteger generation = ++self.generation;
+        dispatch_sync(self.queue, ^{
+            self.snapshot = snapshot;
+            self.scanPending = NO;
+        });
+
+        __weak GRKDirectoryWatcher *weakSelf = self;
+        success = [self.backend startMonitoringDirectory:self.directory queue:self.queue handler:^{
+            [weakSelf scheduleScanForGeneration:generation];
+        } error:error];
+    }
+
+    return success;
+}
+
+- (void)stop
+{
+    [self.backend stopMonitoring];
+    self.generation++;
+    dispatch_sync(self.queue, ^{
+        self.snapshot = nil;
+    });
+}
+
+#pragma mark - Helpers
+
+//Called on `queue`
+- (void)scheduleScanForGeneration:(NSUInteger)generation
+{
+    if (!self.scanPending)
+    {
+        self.scanPending = YES;
+        __weak GRKDirectoryWatcher *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.latency * NSEC_PER_SEC)), self.queue, ^{
+            [weakSelf scanForGeneration:generation];
+        });
+    }
+}
+
+//Called on `queue`
+- (void)scanForGeneration:(NSUInteger)generation
+{
+    self.scanPending = NO;
+    if (generation != self.generation || !self.snapshot)
+    {
+        return;
+    }
+
+    __autoreleasing NSError *error = nil;
+    //Only entries which are new, or name a different inode, are stat'ed
+    GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:self.options previousListing:self.snapshot error:&error];
+    if (!listing)
+    {
+        DDLogError(@"Unable to list watched directory '%@'. Error: %@", self.directory, error);
+        return;
+    }
+
+    NSArray *events = [self eventsFromListing:self.snapshot toListing:listing];
+    self.snapshot = listing;
+
+    if (events.count > 0)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (generation == self.generation && self.handler)
+            {
+                self.handler(events);
+            }
+        });
+    }
+}
+
+/**
+ Compares two listings of the directory.
+ Each entry of the new listing is looked up by name in the old one and checked for modification. Names only present on one side are then paired by inode to find renames.
+ */
+- (NSArray *)eventsFromListing:(GRKDirectoryListing *)oldListing toListing:(GRKDirectoryListing *)newListing
+{
+    NSMutableArray *modified = [NSMutableArray array];
+    NSMutableDictionary *removedByInode = [NSMutableDictionary dictionary];
+    NSMutableArray *added = [NSMutableArray array];
+
+    //The old entries which are still present
+    NSMutableIndexSet *kept = [NSMutableIndexSet indexSet];
+    for (NSUInteger j = 0; j < newListing.count; ++j)
+    {
+        const GRKDirectoryEntry *newEntry = [newListing entryAtIndex:j];
+        NSUInteger i = [oldListing indexOfEntryWithFileSystemName:[newListing fileSystemNameOfEntry:newEntry] length:newEntry->nameLength];
+        if (i == NSNotFound)
+        {
+            [added addObject:[NSValue valueWithPointer:newEntry]];
+        }
+        else
+        {
+            const GRKDirectoryEntry *oldEntry = [oldListing entryAtIndex:i];
+            //A file replaced under the same name (an atomic save) is a modification of that file
+            if (oldEntry->inode != newEntry->inode ||
+                oldEntry->size != newEntry->size ||
+                oldEntry->modificationTime != newEntry->modificationTime ||
+                oldEntry->changeTime != newEntry->changeTime)
+            {
+                [modified addObject:[GRKDirectoryWatcherEvent eventWithType:GRKDirectoryWatcherEventModified fileURL:[newListing URLOfEntry:newEntry] previousFileURL:nil]];
+            }
+            [kept addIndex:i];
+        }
+    }
+    for (NSUInteger i = 0; i < oldListing.count; ++i)
+    {
+        if (![kept containsIndex:i])
+        {
+            const GRKDirectoryEntry *oldEntry = [oldListing entryAtIndex:i];
+            [removedByInode setObject:[NSValue valueWithPointer:oldEntry] forKey:@(oldEntry->inode)];
+        }
+    }
+
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:modified.count + removedByInode.count + added.count];
+    NSMutableArray *created = [NSMutableArray array];
+    for (NSValue *value in added)
+    {
+        const GRKDirectoryEntry *newEntry = [value pointerValue];
+        NSNumber *inode = @(newEntry->inode);
+        NSValue *removedValue = [removedByInode objectForKey:inode];
+        if (removedValue)
+        {
+            const GRKDirectoryEntry *oldEntry = [removedValue pointerValue];
+            [removedByInode removeObjectForKey:inode];
+            [retVal addObject:[GRKDirectoryWatcherEvent eventWithType:GRKDirectoryWatcherEventRenamed fileURL:[newListing URLOfEntry:newEntry] previousFileURL:[oldListing URLOfEntry:oldEntry]]];
+        }
+        else
+        {
+            [created addObject:[GRKDirectoryWatcherEvent eventWithType:GRKDirectoryWatcherEventCreated fileURL:[newListing URLOfEntry:newEntry] previousFileURL:nil]];
+        }
+    }
+    for (NSValue *value in [removedByInode objectEnumerator])
+    {
+        const GRKDirectoryEntry *oldEntry = [value pointerValue];
+        [retVal addObject:[GRKDirectoryWatcherEvent eventWithType:GRKDirectoryWatcherEventDeleted fileURL:[oldListing URLOfEntry:oldEntry] previousFileURL:nil]];
+    }
+    [retVal addObjectsFromArray:created];
+    [retVal addObjectsFromArray:modified];
+
+    return retVal;
+}
+
+@end
@@ -16,6 +16,7 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "GRKDirectoryListing.h"
 
 extern NSString * const kDefaultPrivateDocumentsDirectoryName;
 
@@ -142,6 +143,16 @@ typedef NS_ENUM(NSInteger, GRKFileManagerError) {
  */
 - (NSURL *)privateDocumentsDirectoryNamed:(NSString *)dirName error:(__autoreleasing NSError **)error;
 
+/**
+ Lists the contents of the given directory using low level filesystem calls, which is considerably faster than `contentsOfDirectoryAtURL:includingPropertiesForKeys:options:error:` for large directories.
+ @param directory The fileURL representing the directory to list.
+ @param options   Options controlling which entries are included.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+ @return The listing, or `nil` if the directory could not be read.
+ @see GRKDirectoryListing
+ */
+- (GRKDirectoryListing *)listingOfDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options error:(__autoreleasing NSError **)error;
+
 /**
  Atomically replaces the given file with a new one.
  This will move the old file to a temporary location, move the new file into the old file's original location, and then delete the old file.
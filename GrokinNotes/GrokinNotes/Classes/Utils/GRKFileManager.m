@@ -17,6 +17,7 @@
 
 #import "GRKFileManager.h"
 #import "NSString+UUID.h"
+#import "GRKMetrics.h"
 #include <sys/xattr.h>
 
 NSString * const GRKFileManagerErrorDomain = @"GRKFileManagerErrorDomain";
@@ -25,6 +26,11 @@ NSString * const kGRKFileManagerErrorKeyRestoreError = @"restoreError";
 
 static NSString * const kExtendedAttributeKeyMobileBackup =  @"com.apple.MobileBackup";
 
+//Counters of extended attribute operations (see GRKMetrics)
+static NSString * const kMetricExtendedAttributeReads = @"xattr.reads";
+static NSString * const kMetricExtendedAttributeWrites = @"xattr.writes";
+static NSString * const kMetricExtendedAttributeRemoves = @"xattr.removes";
+
 NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
 
 @implementation GRKFileManager
@@ -37,6 +43,7 @@ NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
     const char *nameStr = [attributeName cStringUsingEncoding:NSUTF8StringEncoding];
     const char *valueStr = [attributeValue cStringUsingEncoding:NSUTF8StringEncoding];
     int result = setxattr(filePath, nameStr, valueStr, strlen(valueStr), 0, 0);
+    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricExtendedAttributeWrites by:1];
     BOOL success = result == 0;
     
     if (!success)
@@ -61,6 +68,7 @@ NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
     const char *nameStr = [attributeName cStringUsingEncoding:NSUTF8StringEncoding];
     u_int8_t attrValue = attributeValue ? 1 : 0;
     int result = setxattr(filePath, nameStr, &attrValue, sizeof(attrValue), 0, 0);
+    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricExtendedAttributeWrites by:1];
     BOOL success = result == 0;
     
     if (!success)
@@ -94,6 +102,7 @@ NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
     
     //Fetch the size of the buffer we need
     ssize_t bufferLength = getxattr(filePath, nameStr, NULL, 0, 0, 0);
+    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricExtendedAttributeReads by:1];
     if (bufferLength < 0)
     {
         //Handle error
@@ -145,6 +154,7 @@ NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
     
     u_int8_t attrValue = 0;
     ssize_t result = getxattr(filePath, nameStr, &attrValue, sizeof(attrValue), 0, 0);
+    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricExtendedAttributeReads by:1];
     if (result < 0)
     {
         //Handle error
@@ -171,6 +181,7 @@ NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
     const char *nameStr = [attributeName cStringUsingEncoding:NSUTF8StringEncoding];
 
     int result = removexattr(filePath, nameStr, 0);
+    [[GRKMetrics sharedMetrics] incrementCounterNamed:kMetricExtendedAttributeRemoves by:1];
     BOOL success = result == 0;
     
     if (!success)
@@ -279,6 +290,12 @@ NSString * const kDefaultPrivateDocumentsDirectoryName =  @"Private Documents";
     return retVal;
 }
 
+- (GRKDirectoryListing *)listingOfDirectory:(NSURL *)directory options:(GRKDirectoryListingOptions)options error:(__autoreleasing NSError **)error
+{
+    GRKDirectoryListing *retVal = [GRKDirectoryListing listingOfDirectory:directory options:options error:error];
+    return retVal;
+}
+
 - (NSURL *)replaceFile:(NSURL *)oldFile withFile:(NSURL *)newFile error:(__autoreleasing NSError **)error
 {
     NSURL *retVal = nil;
@@ -0,0 +1,114 @@
+//
+//  GRKHTTPServer.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+#if DEBUG
+
+/**
+ A request received by a GRKHTTPServer.
+ */
+@interface GRKHTTPRequest : NSObject
+
+@property (nonatomic,copy,readonly) NSString *method;
+/**
+ The path of the request, without the query.
+ */
+@property (nonatomic,copy,readonly) NSString *path;
+/**
+ The decoded query parameters, by name.
+ */
+@property (nonatomic,copy,readonly) NSDictionary *queryParameters;
+/**
+ The header values, by lower case header name.
+ */
+@property (nonatomic,copy,readonly) NSDictionary *headers;
+@property (nonatomic,copy,readonly) NSData *body;
+
+/**
+ The value of the named header.
+
+ @param name The header name, in any case.
+
+ @return The value, or `nil` if the request has no such header.
+ */
+- (NSString *)valueForHeader:(NSString *)name;
+
+@end
+
+/**
+ A response to a GRKHTTPRequest.
+ */
+@interface GRKHTTPResponse : NSObject
+
+@property (nonatomic,assign) NSInteger statusCode;
+/**
+ The header values, by header name. `Content-Length` and `Connection` are supplied by the server.
+ */
+@property (nonatomic,copy) NSDictionary *headers;
+@property (nonatomic,copy) NSData *body;
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary *)headers body:(NSData *)body;
+
+@end
+
+/**
+ Handles a request. `respond` must be called exactly once, from any queue, and may be called after the handler returns.
+ */
+typedef void (^GRKHTTPServerHandler)(GRKHTTPRequest *request, void (^respond)(GRKHTTPResponse *response));
+
+/**
+ A minimal HTTP/1.1 server listening on the loopback interface, for standing in for remote services in development builds. DEBUG builds only.
+ Each connection carries a single request with a `Content-Length` delimited body (chunked request bodies are refused), and is closed once the response has been written.
+ Requests are handed to the handler on a private serial queue, one at a time, but responses may be written in any order.
+ */
+@interface GRKHTTPServer : NSObject
+
+/**
+ The port the server is listening on, or `0` if it is not started.
+ */
+@property (nonatomic,assign,readonly) uint16_t port;
+
+/**
+ The URL of the root of the server (i.e. `http://127.0.0.1:<port>/`), or `nil` if it is not started.
+ */
+@property (nonatomic,readonly) NSURL *baseURL;
+
+/**
+ The largest request body accepted, in bytes. Larger requests are answered with status 413. Defaults to 32MB.
+ */
+@property (nonatomic,assign) NSUInteger maximumBodyLength;
+
+- (instancetype)initWithHandler:(GRKHTTPServerHandler)handler;
+
+/**
+ Starts listening on an unused port of the loopback interface.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)start:(__autoreleasing NSError **)error;
+
+/**
+ Stops accepting connections. Requests already received are still answered.
+ */
+- (void)stop;
+
+@end
+
+#endif
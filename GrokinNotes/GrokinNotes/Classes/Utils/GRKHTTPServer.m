@@ -0,0 +1,444 @@
+//
+//  GRKHTTPServer.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKHTTPServer.h"
+
+#if DEBUG
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static NSUInteger const kGRKHTTPServerDefaultMaximumBodyLength = 32 * 1024 * 1024;
+static NSUInteger const kGRKHTTPServerMaximumHeaderLength = 64 * 1024;
+static int const kGRKHTTPServerBacklog = 64;
+static size_t const kGRKHTTPServerReadSize = 16 * 1024;
+
+#pragma mark - Helpers
+
+static NSError *GRKHTTPServerPOSIXError(int errorNumber, NSString *message)
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    [userInfo setObject:[NSString stringWithFormat:@"%@ %s", message, strerror(errorNumber)] forKey:NSLocalizedDescriptionKey];
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:errorNumber userInfo:userInfo];
+}
+
+static NSString *GRKHTTPServerReasonPhrase(NSInteger statusCode)
+{
+    NSString *retVal;
+    switch (statusCode)
+    {
+        case 200: retVal = @"OK"; break;
+        case 201: retVal = @"Created"; break;
+        case 204: retVal = @"No Content"; break;
+        case 308: retVal = @"Resume Incomplete"; break;
+        case 400: retVal = @"Bad Request"; break;
+        case 401: retVal = @"Unauthorized"; break;
+        case 403: retVal = @"Forbidden"; break;
+        case 404: retVal = @"Not Found"; break;
+        case 405: retVal = @"Method Not Allowed"; break;
+        case 413: retVal = @"Payload Too Large"; break;
+        case 431: retVal = @"Request Header Fields Too Large"; break;
+        case 500: retVal = @"Internal Server Error"; break;
+        case 501: retVal = @"Not Implemented"; break;
+        case 503: retVal = @"Service Unavailable"; break;
+        default: retVal = @"Status"; break;
+    }
+    return retVal;
+}
+
+static NSString *GRKHTTPServerDecode(NSString *string)
+{
+    return [[string stringByReplacingOccurrencesOfString:@"+" withString:@" "] stringByRemovingPercentEncoding] ?: string;
+}
+
+@interface GRKHTTPRequest ()
+
+@property (nonatomic,copy,readwrite) NSString *method;
+@property (nonatomic,copy,readwrite) NSString *path;
+@property (nonatomic,copy,readwrite) NSDictionary *queryParameters;
+@property (nonatomic,copy,readwrite) NSDictionary *headers;
+@property (nonatomic,copy,readwrite) NSData *body;
+
+@end
+
+@implementation GRKHTTPRequest
+
+- (NSString *)valueForHeader:(NSString *)name
+{
+    return [self.headers objectForKey:[name lowercaseString]];
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> %@ %@ (%lu bytes)", NSStringFromClass([self class]), self, self.method, self.path, (unsigned long)self.body.length];
+}
+
+@end
+
+@implementation GRKHTTPResponse
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary *)headers body:(NSData *)body
+{
+    GRKHTTPResponse *retVal = [[self alloc] init];
+    retVal.statusCode = statusCode;
+    retVal.headers = headers;
+    retVal.body = body;
+    return retVal;
+}
+
+@end
+
+//A single connection, which is only used on the server's queue
+@interface GRKHTTPConnection : NSObject
+
+@property (nonatomic,assign) int fd;
+@property (nonatomic,strong) dispatch_source_t readSource;
+@property (nonatomic,strong) NSMutableData *buffer;
+//Set once the read source has been cancelled
+@property (nonatomic,assign) BOOL readingStopped;
+//Set once a complete request has been read, after which the connection is kept open for the response
+@property (nonatomic,assign) BOOL responding;
+//Set once the response has been written, or the connection has been abandoned
+@property (nonatomic,assign) BOOL finished;
+
+@end
+
+@implementation GRKHTTPConnection
+
+@end
+
+@interface GRKHTTPServer ()
+
+@property (nonatomic,copy) GRKHTTPServerHandler handler;
+@property (nonatomic,strong) dispatch_queue_t queue;
+@property (nonatomic,strong) dispatch_source_t acceptSource;
+@property (nonatomic,assign,readwrite) uint16_t port;
+@property (nonatomic,strong) NSMutableSet *connections;
+
+@end
+
+@implementation GRKHTTPServer
+
+#pragma mark - Initialization
+
+- (instancetype)initWithHandler:(GRKHTTPServerHandler)handler
+{
+    if ((self = [super init]))
+    {
+        self.handler = handler;
+        self.queue = dispatch_queue_create("com.levigroker.httpserver", DISPATCH_QUEUE_SERIAL);
+        self.connections = [NSMutableSet set];
+        self.maximumBodyLength = kGRKHTTPServerDefaultMaximumBodyLength;
+    }
+
+    return self;
+}
+
+- (id)init
+{
+    return [self initWithHandler:nil];
+}
+
+- (void)dealloc
+{
+    if (_acceptSource)
+    {
+        dispatch_source_cancel(_acceptSource);
+    }
+}
+
+#pragma mark - Implementation
+
+- (NSURL *)baseURL
+{
+    return self.port > 0 ? [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%u/", (unsigned int)self.port]] : nil;
+}
+
+- (BOOL)start:(__autoreleasing NSError **)error
+{
+    BOOL retVal = NO;
+
+    if (self.acceptSource)
+    {
+        retVal = YES;
+    }
+    else
+    {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_len = sizeof(address);
+        address.sin_family = AF_INET;
+        address.sin_port = 0;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addressLength = sizeof(address);
+        int yes = 1;
+
+        int listenFD = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFD >= 0
+            && setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) == 0
+            && bind(listenFD, (struct sockaddr *)&address, sizeof(address)) == 0
+            && listen(listenFD, kGRKHTTPServerBacklog) == 0
+            && getsockname(listenFD, (struct sockaddr *)&address, &addressLength) == 0
+            && fcntl(listenFD, F_SETFL, O_NONBLOCK) == 0)
+        {
+            dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)listenFD, 0, self.queue);
+            __weak GRKHTTPServer *weakSelf = self;
+            dispatch_source_set_event_handler(source, ^{
+                [weakSelf acceptConnectionsOnSocket:listenFD];
+            });
+            dispatch_source_set_cancel_handler(source, ^{
+                close(listenFD);
+            });
+            self.acceptSource = source;
+            self.port = ntohs(address.sin_port);
+            dispatch_resume(source);
+            retVal = YES;
+        }
+        else
+        {
+            int errorNumber = errno;
+            if (listenFD >= 0)
+            {
+                close(listenFD);
+            }
+            if (error)
+            {
+                *error = GRKHTTPServerPOSIXError(errorNumber, @"Unable to listen on the loopback interface.");
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (void)stop
+{
+    if (self.acceptSource)
+    {
+        dispatch_source_cancel(self.acceptSource);
+        self.acceptSource = nil;
+        self.port = 0;
+    }
+}
+
+#pragma mark - Helpers
+
+- (void)acceptConnectionsOnSocket:(int)listenFD
+{
+    int fd;
+    while ((fd = accept(listenFD, NULL, NULL)) >= 0)
+    {
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        GRKHTTPConnection *connection = [[GRKHTTPConnection alloc] init];
+        connection.fd = fd;
+        connection.buffer = [NSMutableData data];
+
+        dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, self.queue);
+        __weak GRKHTTPServer *weakSelf = self;
+        __weak GRKHTTPConnection *weakConnection = connection;
+        dispatch_source_set_event_handler(source, ^{
+            [weakSelf readFromConnection:weakConnection];
+        });
+        //The descriptor must outlive the source, so it is closed once both reading and any response are done
+        dispatch_source_set_cancel_handler(source, ^{
+            weakConnection.readingStopped = YES;
+            [weakSelf closeConnectionIfDone:weakConnection];
+        });
+        connection.readSource = source;
+        [self.connections addObject:connection];
+        dispatch_resume(source);
+    }
+}
+
+- (void)readFromConnection:(GRKHTTPConnection *)connection
+{
+    if (connection && !connection.responding && !connection.finished)
+    {
+        uint8_t bytes[kGRKHTTPServerReadSize];
+        ssize_t count;
+        while ((count = read(connection.fd, bytes, sizeof(bytes))) > 0)
+        {
+            [connection.buffer appendBytes:bytes length:(NSUInteger)count];
+        }
+        BOOL closed = count == 0 || (errno != EAGAIN && errno != EINTR);
+
+        GRKHTTPResponse *failure = nil;
+        GRKHTTPRequest *request = [self requestFromData:connection.buffer failure:&failure];
+        if (request || failure)
+        {
+            connection.responding = YES;
+            connection.buffer = nil;
+            dispatch_source_cancel(connection.readSource);
+
+            if (request && self.handler)
+            {
+                //Keeps the server and connection until the response is written
+                void (^respond)(GRKHTTPResponse *response) = ^(GRKHTTPResponse *response) {
+                    dispatch_async(self.queue, ^{
+                        [self writeResponse:response toConnection:connection];
+                    });
+                };
+                self.handler(request, respond);
+            }
+            else
+            {
+                [self writeResponse:(failure ?: [GRKHTTPResponse responseWithStatusCode:501 headers:nil body:nil]) toConnection:connection];
+            }
+        }
+        else if (closed)
+        {
+            //The client went away before sending a whole request
+            connection.finished = YES;
+            dispatch_source_cancel(connection.readSource);
+        }
+    }
+}
+
+/**
+ Parses a request.
+ @param data    The bytes received so far.
+ @param failure Set to a response to send instead, if the request is unacceptable.
+ @return The request, or `nil` if it is incomplete or unacceptable.
+ */
+- (GRKHTTPRequest *)requestFromData:(NSData *)data failure:(GRKHTTPResponse * __autoreleasing *)failure
+{
+    GRKHTTPRequest *retVal = nil;
+
+    NSData *separator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    NSRange separatorRange = [data rangeOfData:separator options:0 range:NSMakeRange(0, MIN(data.length, kGRKHTTPServerMaximumHeaderLength))];
+    if (separatorRange.location == NSNotFound)
+    {
+        if (data.length >= kGRKHTTPServerMaximumHeaderLength)
+        {
+            *failure = [GRKHTTPResponse responseWithStatusCode:431 headers:nil body:nil];
+        }
+    }
+    else
+    {
+        NSString *head = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(0, separatorRange.location)] encoding:NSISOLatin1StringEncoding];
+        NSArray *lines = [head componentsSeparatedByString:@"\r\n"];
+        NSArray *requestLine = [[lines firstObject] componentsSeparatedByString:@" "];
+
+        NSMutableDictionary *headers = [NSMutableDictionary dictionaryWithCapacity:lines.count];
+        for (NSUInteger i = 1; i < lines.count; ++i)
+        {
+            NSString *line = [lines objectAtIndex:i];
+            NSRange colon = [line rangeOfString:@":"];
+            if (colon.location != NSNotFound)
+            {
+                NSString *name = [[line substringToIndex:colon.location] lowercaseString];
+                NSString *value = [[line substringFromIndex:colon.location + 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+                NSString *existing = [headers objectForKey:name];
+                [headers setObject:(existing ? [NSString stringWithFormat:@"%@, %@", existing, value] : value) forKey:name];
+            }
+        }
+
+        NSString *contentLength = [headers objectForKey:@"content-length"] ?: @"0";
+        NSString *transferEncoding = [headers objectForKey:@"transfer-encoding"];
+        BOOL lengthValid = contentLength.length > 0 && contentLength.length < 20 && [contentLength rangeOfCharacterFromSet:[[NSCharacterSet decimalDigitCharacterSet] invertedSet]].location == NSNotFound;
+        unsigned long long bodyLength = lengthValid ? strtoull([contentLength UTF8String], NULL, 10) : 0;
+        NSUInteger bodyStart = NSMaxRange(separatorRange);
+
+        if (requestLine.count != 3 || !lengthValid)
+        {
+            *failure = [GRKHTTPResponse responseWithStatusCode:400 headers:nil body:nil];
+        }
+        else if (transferEncoding && ![transferEncoding isEqualToString:@"identity"])
+        {
+            *failure = [GRKHTTPResponse responseWithStatusCode:501 headers:nil body:nil];
+        }
+        else if (bodyLength > self.maximumBodyLength)
+        {
+            *failure = [GRKHTTPResponse responseWithStatusCode:413 headers:nil body:nil];
+        }
+        else if (data.length - bodyStart >= bodyLength)
+        {
+            NSString *target = [requestLine objectAtIndex:1];
+            NSRange queryStart = [target rangeOfString:@"?"];
+            NSString *path = queryStart.location == NSNotFound ? target : [target substringToIndex:queryStart.location];
+            NSMutableDictionary *queryParameters = [NSMutableDictionary dictionary];
+            if (queryStart.location != NSNotFound)
+            {
+                for (NSString *pair in [[target substringFromIndex:NSMaxRange(queryStart)] componentsSeparatedByString:@"&"])
+                {
+                    NSRange equals = [pair rangeOfString:@"="];
+                    if (pair.length > 0)
+                    {
+                        NSString *name = equals.location == NSNotFound ? pair : [pair substringToIndex:equals.location];
+                        NSString *value = equals.location == NSNotFound ? @"" : [pair substringFromIndex:NSMaxRange(equals)];
+                        [queryParameters setObject:GRKHTTPServerDecode(value) forKey:GRKHTTPServerDecode(name)];
+                    }
+                }
+            }
+
+            retVal = [[GRKHTTPRequest alloc] init];
+            retVal.method = [requestLine objectAtIndex:0];
+            retVal.path = [path stringByRemovingPercentEncoding] ?: path;
+            retVal.queryParameters = queryParameters;
+            retVal.headers = headers;
+            retVal.body = [data subdataWithRange:NSMakeRange(bodyStart, (NSUInteger)bodyLength)];
+        }
+    }
+
+    return retVal;
+}
+
+- (void)writeResponse:(GRKHTTPResponse *)response toConnection:(GRKHTTPConnection *)connection
+{
+    NSData *body = response.body ?: [NSData data];
+    NSMutableString *head = [NSMutableString stringWithFormat:@"HTTP/1.1 %ld %@\r\n", (long)response.statusCode, GRKHTTPServerReasonPhrase(response.statusCode)];
+    for (NSString *name in response.headers)
+    {
+        NSString *lowercaseName = [name lowercaseString];
+        if (![lowercaseName isEqualToString:@"content-length"] && ![lowercaseName isEqualToString:@"connection"])
+        {
+            [head appendFormat:@"%@: %@\r\n", name, [response.headers objectForKey:name]];
+        }
+    }
+    [head appendFormat:@"Content-Length: %lu\r\nConnection: close\r\n\r\n", (unsigned long)body.length];
+
+    NSMutableData *message = [NSMutableData dataWithData:[head dataUsingEncoding:NSISOLatin1StringEncoding]];
+    [message appendData:body];
+    dispatch_data_t messageData = dispatch_data_create(message.bytes, message.length, self.queue, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    dispatch_write(connection.fd, messageData, self.queue, ^(dispatch_data_t remaining, int error) {
+        if (error)
+        {
+            DDLogWarn(@"Unable to write HTTP response. %s", strerror(error));
+        }
+        connection.finished = YES;
+        [self closeConnectionIfDone:connection];
+    });
+}
+
+- (void)closeConnectionIfDone:(GRKHTTPConnection *)connection
+{
+    if (connection.readingStopped && connection.finished && [self.connections containsObject:connection])
+    {
+        close(connection.fd);
+        connection.readSource = nil;
+        [self.connections removeObject:connection];
+    }
+}
+
+@end
+
+#endif
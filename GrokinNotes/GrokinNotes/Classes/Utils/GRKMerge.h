@@ -0,0 +1,59 @@
+//
+//  GRKMerge.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The outcome of a three way merge.
+ */
+@interface GRKMergeResult : NSObject
+
+/**
+ The merged content, or `nil` if there were conflicts.
+ */
+@property (nonatomic,strong,readonly) NSData *data;
+
+/**
+ The number of regions changed differently on both sides, which could not be merged.
+ */
+@property (nonatomic,assign,readonly) NSUInteger conflictCount;
+
+/**
+ The number of regions changed on one or both sides which were merged.
+ */
+@property (nonatomic,assign,readonly) NSUInteger mergedCount;
+
+@end
+
+/**
+ Merges two versions of some content which were each derived from a common base version (diff3 style).
+ Each side is compared against the base by line (see GRKDiff). A region changed on only one side takes that change, and a region changed identically on both sides takes it once. Where both sides changed the same lines differently, the lines are merged again by word, so that edits to different parts of the same line still merge; anything left is a conflict.
+ */
+@interface GRKMerge : NSObject
+
+/**
+ Merges two versions of some content.
+
+ @param base   The common base version.
+ @param ours   One version derived from the base.
+ @param theirs Another version derived from the base.
+
+ @return The result of the merge.
+ */
++ (GRKMergeResult *)mergeBase:(NSData *)base ours:(NSData *)ours theirs:(NSData *)theirs;
+
+@end
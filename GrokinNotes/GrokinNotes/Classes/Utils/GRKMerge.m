@@ -0,0 +1,183 @@
+//
+//  GRKMerge.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKMerge.h"
+#import "GRKDiff.h"
+
+/**
+ The range of the derived sequence which corresponds to the base range [lo, hi), given the hunks [first, end) of that side which fall within it.
+ Base tokens outside the hunks are unchanged on that side, so map one to one.
+ */
+static NSRange GRKMergeRange(const GRKDiffHunk *hunks, NSUInteger first, NSUInteger end, NSUInteger lo, NSUInteger hi)
+{
+    const GRKDiffHunk *firstHunk = &hunks[first];
+    const GRKDiffHunk *lastHunk = &hunks[end - 1];
+    NSUInteger start = firstHunk->start2 - (firstHunk->start1 - lo);
+    NSUInteger stop = lastHunk->start2 + lastHunk->length2 + (hi - (lastHunk->start1 + lastHunk->length1));
+    return NSMakeRange(start, stop - start);
+}
+
+@interface GRKMergeResult ()
+
+@property (nonatomic,strong,readwrite) NSData *data;
+@property (nonatomic,assign,readwrite) NSUInteger conflictCount;
+@property (nonatomic,assign,readwrite) NSUInteger mergedCount;
+
+@end
+
+@implementation GRKMergeResult
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> merged: %lu conflicts: %lu length: %lu", NSStringFromClass(self.class), self, (unsigned long)self.mergedCount, (unsigned long)self.conflictCount, (unsigned long)self.data.length];
+}
+
+@end
+
+@implementation GRKMerge
+
+#pragma mark - Implementation
+
++ (GRKMergeResult *)mergeBase:(NSData *)base ours:(NSData *)ours theirs:(NSData *)theirs
+{
+    GRKMergeResult *retVal = [[GRKMergeResult alloc] init];
+
+    NSMutableData *output = [NSMutableData dataWithCapacity:MAX(ours.length, theirs.length)];
+    [self mergeBase:base ours:ours theirs:theirs tokenization:GRKDiffTokenizationLines into:output result:retVal];
+    if (retVal.conflictCount == 0)
+    {
+        retVal.data = output;
+    }
+
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+/**
+ Merges the given content split in the given way, appending the merged content to `output` and counting merged and conflicting regions in `result`.
+ Conflicting regions take the content of `theirs`, so the output is complete (but not a merge) when there are conflicts.
+ */
++ (void)mergeBase:(NSData *)base ours:(NSData *)ours theirs:(NSData *)theirs tokenization:(GRKDiffTokenization)tokenization into:(NSMutableData *)output result:(GRKMergeResult *)result
+{
+    GRKDiff *diff = [[GRKDiff alloc] initWithTokenization:tokenization];
+    GRKTokenSequence *baseSequence = [diff sequenceWithData:base];
+    GRKTokenSequence *oursSequence = [diff sequenceWithData:ours];
+    GRKTokenSequence *theirsSequence = [diff sequenceWithData:theirs];
+
+    NSData *oursHunkData = [diff hunksFromSequence:baseSequence toSequence:oursSequence];
+    NSData *theirsHunkData = [diff hunksFromSequence:baseSequence toSequence:theirsSequence];
+    const GRKDiffHunk *oursHunks = [oursHunkData bytes];
+    const GRKDiffHunk *theirsHunks = [theirsHunkData bytes];
+    NSUInteger oursCount = oursHunkData.length / sizeof(GRKDiffHunk);
+    NSUInteger theirsCount = theirsHunkData.length / sizeof(GRKDiffHunk);
+
+    //The next base token to be copied to the output
+    NSUInteger cursor = 0;
+    NSUInteger oursIndex = 0;
+    NSUInteger theirsIndex = 0;
+    while (oursIndex < oursCount || theirsIndex < theirsCount)
+    {
+        //Start a group with the earliest hunk, then take in every hunk of either side which overlaps or touches the group, until the group stops growing
+        NSUInteger oursFirst = oursIndex;
+        NSUInteger theirsFirst = theirsIndex;
+        NSUInteger lo = 0;
+        NSUInteger hi = 0;
+        if (theirsIndex >= theirsCount || (oursIndex < oursCount && oursHunks[oursIndex].start1 <= theirsHunks[theirsIndex].start1))
+        {
+            lo = oursHunks[oursIndex].start1;
+            hi = lo + oursHunks[oursIndex].length1;
+            ++oursIndex;
+        }
+        else
+        {
+            lo = theirsHunks[theirsIndex].start1;
+            hi = lo + theirsHunks[theirsIndex].length1;
+            ++theirsIndex;
+        }
+
+        BOOL grew = YES;
+        while (grew)
+        {
+            grew = NO;
+            if (oursIndex < oursCount && oursHunks[oursIndex].start1 <= hi)
+            {
+                hi = MAX(hi, oursHunks[oursIndex].start1 + oursHunks[oursIndex].length1);
+                ++oursIndex;
+                grew = YES;
+            }
+            if (theirsIndex < theirsCount && theirsHunks[theirsIndex].start1 <= hi)
+            {
+                hi = MAX(hi, theirsHunks[theirsIndex].start1 + theirsHunks[theirsIndex].length1);
+                ++theirsIndex;
+                grew = YES;
+            }
+        }
+
+        //Copy the unchanged content before the group
+        [output appendData:[base subdataWithRange:[baseSequence byteRangeOfTokens:NSMakeRange(cursor, lo - cursor)]]];
+        cursor = hi;
+
+        BOOL oursChanged = oursIndex > oursFirst;
+        BOOL theirsChanged = theirsIndex > theirsFirst;
+        NSRange oursRange = oursChanged ? GRKMergeRange(oursHunks, oursFirst, oursIndex, lo, hi) : NSMakeRange(0, 0);
+        NSRange theirsRange = theirsChanged ? GRKMergeRange(theirsHunks, theirsFirst, theirsIndex, lo, hi) : NSMakeRange(0, 0);
+        NSData *oursContent = [ours subdataWithRange:[oursSequence byteRangeOfTokens:oursRange]];
+        NSData *theirsContent = [theirs subdataWithRange:[theirsSequence byteRangeOfTokens:theirsRange]];
+
+        if (!theirsChanged || (oursChanged && [oursSequence tokens:oursRange isEqualToTokens:theirsRange ofSequence:theirsSequence]))
+        {
+            //Changed on our side only, or identically on both sides
+            [output appendData:oursContent];
+            result.mergedCount++;
+        }
+        else if (!oursChanged)
+        {
+            [output appendData:theirsContent];
+            result.mergedCount++;
+        }
+        else
+        {
+            //Both sides changed the same lines, so try again with finer grained tokens
+            GRKMergeResult *wordResult = nil;
+            NSMutableData *words = nil;
+            if (tokenization == GRKDiffTokenizationLines)
+            {
+                NSData *baseContent = [base subdataWithRange:[baseSequence byteRangeOfTokens:NSMakeRange(lo, hi - lo)]];
+                wordResult = [[GRKMergeResult alloc] init];
+                words = [NSMutableData dataWithCapacity:MAX(oursContent.length, theirsContent.length)];
+                [self mergeBase:baseContent ours:oursContent theirs:theirsContent tokenization:GRKDiffTokenizationWords into:words result:wordResult];
+            }
+
+            if (wordResult && wordResult.conflictCount == 0)
+            {
+                [output appendData:words];
+                result.mergedCount++;
+            }
+            else
+            {
+                [output appendData:theirsContent];
+                result.conflictCount++;
+            }
+        }
+    }
+
+    //Copy the unchanged content after the last group
+    [output appendData:[base subdataWithRange:[baseSequence byteRangeOfTokens:NSMakeRange(cursor, baseSequence.count - cursor)]]];
+}
+
+@end
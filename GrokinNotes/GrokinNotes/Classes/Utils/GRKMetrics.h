@@ -0,0 +1,146 @@
+//
+//  GRKMetrics.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ The current time of a monotonic clock, in microseconds. Use with `-[GRKMetrics recordTimeSince:inHistogramNamed:]` to record durations.
+ 
+ @return The current time in microseconds.
+ */
+extern uint64_t GRKMetricsTime(void);
+
+/**
+ An immutable snapshot of a histogram of recorded values.
+ Values are held in buckets whose width grows with their magnitude (as in an HDR histogram), so percentiles are accurate to within 1/32 (about 3%) of the value, at any magnitude, while recording takes constant time and space. Values are clamped at 2^40 - 1.
+ */
+@interface GRKMetricsHistogram : NSObject
+
+/**
+ The number of values recorded.
+ */
+@property (nonatomic,assign,readonly) uint64_t count;
+
+/**
+ The sum of the values recorded.
+ */
+@property (nonatomic,assign,readonly) uint64_t sum;
+
+/**
+ The smallest value recorded, or 0 if none were.
+ */
+@property (nonatomic,assign,readonly) uint64_t minimum;
+
+/**
+ The largest value recorded, or 0 if none were.
+ */
+@property (nonatomic,assign,readonly) uint64_t maximum;
+
+/**
+ The mean of the values recorded, or 0 if none were.
+ */
+@property (nonatomic,assign,readonly) double mean;
+
+/**
+ The value at the given percentile, by nearest rank.
+ 
+ @param percentile The percentile, from 0 to 100.
+ 
+ @return The largest value which may be in the bucket holding the value at the given percentile (but no more than `maximum`), or 0 if no values were recorded.
+ */
+- (uint64_t)valueAtPercentile:(double)percentile;
+
+/**
+ A representation of the histogram suitable for JSON export, with the count, sum, minimum, maximum, mean, and 50th, 90th, 99th and 99.9th percentiles.
+ */
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
+
+/**
+ An immutable snapshot of the values of all metrics of a GRKMetrics registry.
+ */
+@interface GRKMetricsSnapshot : NSObject
+
+/**
+ Maps the name of each counter to its value (an NSNumber).
+ */
+@property (nonatomic,strong,readonly) NSDictionary *counters;
+
+/**
+ Maps the name of each histogram to its GRKMetricsHistogram.
+ */
+@property (nonatomic,strong,readonly) NSDictionary *histograms;
+
+/**
+ A representation of the snapshot suitable for JSON export, with `counters` and `histograms` keys (see `-[GRKMetricsHistogram dictionaryRepresentation]`).
+ */
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
+
+/**
+ A registry of named counters and histograms.
+ Metrics are created when first recorded to. Each thread accumulates into its own storage, guarded by a lock which is only ever contended by a snapshot or reset, so recording from many threads at once does not serialize them. The storage of a thread is folded into the registry when the thread exits.
+ All methods are safe to call from any queue.
+ */
+@interface GRKMetrics : NSObject
+
+/**
+ The shared registry, which lives for the life of the app.
+ 
+ @return The common instance of GRKMetrics.
+ */
++ (instancetype)sharedMetrics;
+
+/**
+ Adds to the counter with the given name.
+ 
+ @param name   The name of the counter.
+ @param amount The amount to add.
+ */
+- (void)incrementCounterNamed:(NSString *)name by:(uint64_t)amount;
+
+/**
+ Records a value in the histogram with the given name.
+ 
+ @param value The value to record.
+ @param name  The name of the histogram.
+ */
+- (void)recordValue:(uint64_t)value inHistogramNamed:(NSString *)name;
+
+/**
+ Records the time elapsed since the given time, in microseconds, in the histogram with the given name.
+ 
+ @param start A time previously returned by `GRKMetricsTime()`.
+ @param name  The name of the histogram.
+ */
+- (void)recordTimeSince:(uint64_t)start inHistogramNamed:(NSString *)name;
+
+/**
+ Takes a snapshot of all metrics, totalled over all threads.
+ 
+ @return The snapshot.
+ */
+- (GRKMetricsSnapshot *)snapshot;
+
+/**
+ Discards all metrics.
+ */
+- (void)reset;
+
+@end
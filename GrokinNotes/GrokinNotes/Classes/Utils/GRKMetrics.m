@@ -0,0 +1,456 @@
+//
+//  GRKMetrics.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKMetrics.h"
+#include <mach/mach_time.h>
+#include <pthread.h>
+
+//Each power of two range of values is split into half this many buckets (values below it get a bucket each)
+static NSUInteger const kGRKMetricsSubBucketBits = 6;
+static NSUInteger const kGRKMetricsSubBucketCount = 1 << kGRKMetricsSubBucketBits;
+static NSUInteger const kGRKMetricsHalfSubBucketCount = kGRKMetricsSubBucketCount / 2;
+static NSUInteger const kGRKMetricsValueBits = 40;
+static uint64_t const kGRKMetricsMaximumValue = (1ULL << kGRKMetricsValueBits) - 1;
+#define kGRKMetricsBucketCount (kGRKMetricsSubBucketCount + (kGRKMetricsValueBits - kGRKMetricsSubBucketBits) * kGRKMetricsHalfSubBucketCount)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t minimum;
+    uint64_t maximum;
+    uint32_t buckets[kGRKMetricsBucketCount];
+} GRKMetricsHistogramData;
+
+static NSUInteger GRKMetricsBucketIndex(uint64_t value)
+{
+    NSUInteger retVal = (NSUInteger)value;
+    if (value >= kGRKMetricsSubBucketCount)
+    {
+        NSUInteger shift = (NSUInteger)(63 - __builtin_clzll(value)) - (kGRKMetricsSubBucketBits - 1);
+        retVal = kGRKMetricsSubBucketCount + (shift - 1) * kGRKMetricsHalfSubBucketCount + (NSUInteger)(value >> shift) - kGRKMetricsHalfSubBucketCount;
+    }
+    return retVal;
+}
+
+//The largest value which falls in the bucket with the given index
+static uint64_t GRKMetricsBucketHighestValue(NSUInteger index)
+{
+    uint64_t retVal = index;
+    if (index >= kGRKMetricsSubBucketCount)
+    {
+        NSUInteger shift = (index - kGRKMetricsSubBucketCount) / kGRKMetricsHalfSubBucketCount + 1;
+        uint64_t subBucket = (index - kGRKMetricsSubBucketCount) % kGRKMetricsHalfSubBucketCount + kGRKMetricsHalfSubBucketCount;
+        retVal = ((subBucket + 1) << shift) - 1;
+    }
+    return retVal;
+}
+
+static void GRKMetricsHistogramRecord(GRKMetricsHistogramData *histogram, uint64_t value)
+{
+    value = MIN(value, kGRKMetricsMaximumValue);
+    histogram->minimum = histogram->count == 0 ? value : MIN(histogram->minimum, value);
+    histogram->maximum = MAX(histogram->maximum, value);
+    histogram->count += 1;
+    histogram->sum += value;
+    histogram->buckets[GRKMetricsBucketIndex(value)] += 1;
+}
+
+static void GRKMetricsHistogramMerge(GRKMetricsHistogramData *histogram, const GRKMetricsHistogramData *other)
+{
+    if (other->count > 0)
+    {
+        histogram->minimum = histogram->count == 0 ? other->minimum : MIN(histogram->minimum, other->minimum);
+        histogram->maximum = MAX(histogram->maximum, other->maximum);
+        histogram->count += other->count;
+        histogram->sum += other->sum;
+        for (NSUInteger i = 0; i < kGRKMetricsBucketCount; ++i)
+        {
+            histogram->buckets[i] += other->buckets[i];
+        }
+    }
+}
+
+//The storage in the given dictionary for the metric with the given name, created (zeroed) if needed
+static void *GRKMetricsStorage(NSMutableDictionary *storage, NSString *name, NSUInteger length)
+{
+    NSMutableData *data = [storage objectForKey:name];
+    if (!data)
+    {
+        data = [NSMutableData dataWithLength:length];
+        [storage setObject:data forKey:name];
+    }
+    return data.mutableBytes;
+}
+
+uint64_t GRKMetricsTime(void)
+{
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
+    return mach_absolute_time() * timebase.numer / timebase.denom / NSEC_PER_USEC;
+}
+
+/**
+ The metrics recorded by a single thread. The lock is held by the thread while it records, and by the registry while it reads or resets the metrics.
+ */
+@interface GRKMetricsShard : NSObject
+{
+    @public
+    pthread_mutex_t _lock;
+}
+
+@property (nonatomic,weak) GRKMetrics *metrics;
+//Maps the name of each counter to an NSMutableData holding its uint64_t value
+@property (nonatomic,strong) NSMutableDictionary *counters;
+//Maps the name of each histogram to an NSMutableData holding its GRKMetricsHistogramData
+@property (nonatomic,strong) NSMutableDictionary *histograms;
+
+@end
+
+@implementation GRKMetricsShard
+
+- (id)init
+{
+    if ((self = [super init]))
+    {
+        pthread_mutex_init(&_lock, NULL);
+        self.counters = [NSMutableDictionary dictionary];
+        self.histograms = [NSMutableDictionary dictionary];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+//Adds the metrics of the given shard to this one
+- (void)mergeShard:(GRKMetricsShard *)shard
+{
+    pthread_mutex_lock(&shard->_lock);
+    pthread_mutex_lock(&_lock);
+    for (NSString *name in shard.counters)
+    {
+        uint64_t *counter = GRKMetricsStorage(self.counters, name, sizeof(uint64_t));
+        *counter += *(const uint64_t *)[[shard.counters objectForKey:name] bytes];
+    }
+    for (NSString *name in shard.histograms)
+    {
+        GRKMetricsHistogramData *histogram = GRKMetricsStorage(self.histograms, name, sizeof(GRKMetricsHistogramData));
+        GRKMetricsHistogramMerge(histogram, [[shard.histograms objectForKey:name] bytes]);
+    }
+    pthread_mutex_unlock(&_lock);
+    pthread_mutex_unlock(&shard->_lock);
+}
+
+- (void)removeAll
+{
+    pthread_mutex_lock(&_lock);
+    [self.counters removeAllObjects];
+    [self.histograms removeAllObjects];
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
+
+@interface GRKMetricsHistogram ()
+
+@property (nonatomic,strong) NSData *data;
+
+@end
+
+@implementation GRKMetricsHistogram
+
+#pragma mark - Initialization
+
+- (instancetype)initWithData:(NSData *)data
+{
+    if ((self = [super init]))
+    {
+        self.data = data;
+    }
+    
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (uint64_t)count
+{
+    return ((const GRKMetricsHistogramData *)[self.data bytes])->count;
+}
+
+- (uint64_t)sum
+{
+    return ((const GRKMetricsHistogramData *)[self.data bytes])->sum;
+}
+
+- (uint64_t)minimum
+{
+    return ((const GRKMetricsHistogramData *)[self.data bytes])->minimum;
+}
+
+- (uint64_t)maximum
+{
+    return ((const GRKMetricsHistogramData *)[self.data bytes])->maximum;
+}
+
+- (double)mean
+{
+    uint64_t count = self.count;
+    return count > 0 ? (double)self.sum / count : 0;
+}
+
+- (uint64_t)valueAtPercentile:(double)percentile
+{
+    uint64_t retVal = 0;
+    
+    const GRKMetricsHistogramData *histogram = [self.data bytes];
+    if (histogram->count > 0)
+    {
+        uint64_t rank = (uint64_t)ceil(MIN(MAX(percentile, 0), 100) / 100.0 * histogram->count);
+        rank = MIN(MAX(rank, 1), histogram->count);
+        uint64_t seen = 0;
+        for (NSUInteger i = 0; i < kGRKMetricsBucketCount; ++i)
+        {
+            seen += histogram->buckets[i];
+            if (seen >= rank)
+            {
+                retVal = MIN(GRKMetricsBucketHighestValue(i), histogram->maximum);
+                break;
+            }
+        }
+    }
+    
+    return retVal;
+}
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    return @{@"count": @(self.count),
+             @"sum": @(self.sum),
+             @"min": @(self.minimum),
+             @"max": @(self.maximum),
+             @"mean": @(self.mean),
+             @"p50": @([self valueAtPercentile:50]),
+             @"p90": @([self valueAtPercentile:90]),
+             @"p99": @([self valueAtPercentile:99]),
+             @"p999": @([self valueAtPercentile:99.9])};
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"count %llu, min %llu, p50 %llu, p90 %llu, p99 %llu, max %llu, mean %.1f", self.count, self.minimum, [self valueAtPercentile:50], [self valueAtPercentile:90], [self valueAtPercentile:99], self.maximum, self.mean];
+}
+
+@end
+
+@interface GRKMetricsSnapshot ()
+
+@property (nonatomic,strong,readwrite) NSDictionary *counters;
+@property (nonatomic,strong,readwrite) NSDictionary *histograms;
+
+@end
+
+@implementation GRKMetricsSnapshot
+
+#pragma mark - Implementation
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *histograms = [NSMutableDictionary dictionaryWithCapacity:self.histograms.count];
+    for (NSString *name in self.histograms)
+    {
+        [histograms setObject:[[self.histograms objectForKey:name] dictionaryRepresentation] forKey:name];
+    }
+    return @{@"counters": self.counters, @"histograms": histograms};
+}
+
+- (NSString *)description
+{
+    NSMutableString *retVal = [NSMutableString string];
+    for (NSString *name in [[self.counters allKeys] sortedArrayUsingSelector:@selector(compare:)])
+    {
+        [retVal appendFormat:@"%@: %@\n", name, [self.counters objectForKey:name]];
+    }
+    for (NSString *name in [[self.histograms allKeys] sortedArrayUsingSelector:@selector(compare:)])
+    {
+        [retVal appendFormat:@"%@: %@\n", name, [self.histograms objectForKey:name]];
+    }
+    return retVal;
+}
+
+@end
+
+static void GRKMetricsShardDestructor(void *value);
+
+@interface GRKMetrics ()
+
+@property (nonatomic,assign) pthread_key_t shardKey;
+//The shards of live threads, and the metrics of threads which have exited (confined to queue)
+@property (nonatomic,strong) NSMutableArray *shards;
+@property (nonatomic,strong) GRKMetricsShard *retiredShard;
+@property (nonatomic,strong) dispatch_queue_t queue;
+
+@end
+
+@implementation GRKMetrics
+
+#pragma mark - Class Level
+
++ (instancetype)sharedMetrics
+{
+    static GRKMetrics *sharedMetrics = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedMetrics = [[self alloc] init];
+    });
+    return sharedMetrics;
+}
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    if ((self = [super init]))
+    {
+        pthread_key_t shardKey;
+        pthread_key_create(&shardKey, GRKMetricsShardDestructor);
+        self.shardKey = shardKey;
+        self.shards = [NSMutableArray array];
+        self.retiredShard = [[GRKMetricsShard alloc] init];
+        self.queue = dispatch_queue_create("com.levigroker.metrics", DISPATCH_QUEUE_SERIAL);
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    //NOTE: The shards of threads which are still running are not released, since their destructors no longer run
+    pthread_key_delete(self.shardKey);
+}
+
+#pragma mark - Implementation
+
+- (void)incrementCounterNamed:(NSString *)name by:(uint64_t)amount
+{
+    if (name)
+    {
+        GRKMetricsShard *shard = [self currentShard];
+        pthread_mutex_lock(&shard->_lock);
+        uint64_t *counter = GRKMetricsStorage(shard.counters, name, sizeof(uint64_t));
+        *counter += amount;
+        pthread_mutex_unlock(&shard->_lock);
+    }
+}
+
+- (void)recordValue:(uint64_t)value inHistogramNamed:(NSString *)name
+{
+    if (name)
+    {
+        GRKMetricsShard *shard = [self currentShard];
+        pthread_mutex_lock(&shard->_lock);
+        GRKMetricsHistogramRecord(GRKMetricsStorage(shard.histograms, name, sizeof(GRKMetricsHistogramData)), value);
+        pthread_mutex_unlock(&shard->_lock);
+    }
+}
+
+- (void)recordTimeSince:(uint64_t)start inHistogramNamed:(NSString *)name
+{
+    uint64_t now = GRKMetricsTime();
+    [self recordValue:(now > start ? now - start : 0) inHistogramNamed:name];
+}
+
+- (GRKMetricsSnapshot *)snapshot
+{
+    GRKMetricsShard *total = [[GRKMetricsShard alloc] init];
+    dispatch_sync(self.queue, ^{
+        [total mergeShard:self.retiredShard];
+        for (GRKMetricsShard *shard in self.shards)
+        {
+            [total mergeShard:shard];
+        }
+    });
+    
+    NSMutableDictionary *counters = [NSMutableDictionary dictionaryWithCapacity:total.counters.count];
+    for (NSString *name in total.counters)
+    {
+        [counters setObject:[NSNumber numberWithUnsignedLongLong:*(const uint64_t *)[[total.counters objectForKey:name] bytes]] forKey:name];
+    }
+    NSMutableDictionary *histograms = [NSMutableDictionary dictionaryWithCapacity:total.histograms.count];
+    for (NSString *name in total.histograms)
+    {
+        [histograms setObject:[[GRKMetricsHistogram alloc] initWithData:[total.histograms objectForKey:name]] forKey:name];
+    }
+    
+    GRKMetricsSnapshot *retVal = [[GRKMetricsSnapshot alloc] init];
+    retVal.counters = counters;
+    retVal.histograms = histograms;
+    return retVal;
+}
+
+- (void)reset
+{
+    dispatch_sync(self.queue, ^{
+        [self.retiredShard removeAll];
+        for (GRKMetricsShard *shard in self.shards)
+        {
+            [shard removeAll];
+        }
+    });
+}
+
+#pragma mark - Helpers
+
+- (GRKMetricsShard *)currentShard
+{
+    GRKMetricsShard *retVal = (__bridge GRKMetricsShard *)pthread_getspecific(self.shardKey);
+    if (!retVal)
+    {
+        retVal = [[GRKMetricsShard alloc] init];
+        retVal.metrics = self;
+        //Released by GRKMetricsShardDestructor when the thread exits
+        pthread_setspecific(self.shardKey, CFBridgingRetain(retVal));
+        dispatch_sync(self.queue, ^{
+            [self.shards addObject:retVal];
+        });
+    }
+    return retVal;
+}
+
+- (void)retireShard:(GRKMetricsShard *)shard
+{
+    dispatch_sync(self.queue, ^{
+        [self.retiredShard mergeShard:shard];
+        [self.shards removeObjectIdenticalTo:shard];
+    });
+}
+
+@end
+
+static void GRKMetricsShardDestructor(void *value)
+{
+    @autoreleasepool {
+        GRKMetricsShard *shard = CFBridgingRelease(value);
+        [shard.metrics retireShard:shard];
+    }
+}
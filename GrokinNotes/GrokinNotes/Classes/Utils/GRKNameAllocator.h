@@ -0,0 +1,50 @@
+//
+//  GRKNameAllocator.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Finds names which are not in use, of the form "Base", "Base 2", "Base 3", and so on.
+ Each name in use is recorded along with the object using it, so a name is freed when its object takes another name or is forgotten. The numbers in use with each base name are held in an index set, so the lowest free number is found directly rather than by trying each name in turn.
+ Not thread safe.
+ */
+@interface GRKNameAllocator : NSObject
+
+/**
+ Records the name used by an object, replacing any name it used before.
+
+ @param name   The name, or `nil` to forget the object.
+ @param object The object using the name. Objects are compared by identity.
+ */
+- (void)setName:(NSString *)name forObject:(id)object;
+
+/**
+ Forgets every recorded name.
+ */
+- (void)removeAllNames;
+
+/**
+ The first name with the given base name which is not in use: the base name itself, or the base name followed by a space and the lowest free number from 2 on. The name is not recorded as being in use.
+
+ @param baseName      The base name.
+ @param excludedNames An NSSet of names which are not to be returned, such as names in use which are not recorded. Can be nil.
+
+ @return The name.
+ */
+- (NSString *)unusedNameWithBaseName:(NSString *)baseName excludingNames:(NSSet *)excludedNames;
+
+@end
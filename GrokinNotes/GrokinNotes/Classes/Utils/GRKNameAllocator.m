@@ -0,0 +1,161 @@
+//
+//  GRKNameAllocator.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKNameAllocator.h"
+
+@interface GRKNameAllocator ()
+
+//NSString names by object
+@property (nonatomic,strong) NSMapTable *namesByObject;
+//Every name in use, counted by the number of objects using it
+@property (nonatomic,strong) NSCountedSet *names;
+//NSMutableIndexSet of the numbers in use by base name (the base name alone being number 1)
+@property (nonatomic,strong) NSMutableDictionary *numbersByBaseName;
+
+@end
+
+@implementation GRKNameAllocator
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    if ((self = [super init]))
+    {
+        self.namesByObject = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory capacity:0];
+        self.names = [NSCountedSet set];
+        self.numbersByBaseName = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (void)setName:(NSString *)name forObject:(id)object
+{
+    if (object)
+    {
+        NSString *oldName = [self.namesByObject objectForKey:object];
+        if (!(name == oldName || [name isEqualToString:oldName]))
+        {
+            if (oldName)
+            {
+                [self.namesByObject removeObjectForKey:object];
+                [self.names removeObject:oldName];
+                if ([self.names countForObject:oldName] == 0)
+                {
+                    NSUInteger number = 0;
+                    NSString *baseName = [self baseNameOfName:oldName number:&number];
+                    NSMutableIndexSet *numbers = [self.numbersByBaseName objectForKey:baseName];
+                    [numbers removeIndex:number];
+                    if (numbers.count == 0)
+                    {
+                        [self.numbersByBaseName removeObjectForKey:baseName];
+                    }
+                }
+            }
+
+            if (name)
+            {
+                [self.namesByObject setObject:name forKey:object];
+                [self.names addObject:name];
+                NSUInteger number = 0;
+                NSString *baseName = [self baseNameOfName:name number:&number];
+                NSMutableIndexSet *numbers = [self.numbersByBaseName objectForKey:baseName];
+                if (!numbers)
+                {
+                    numbers = [NSMutableIndexSet indexSet];
+                    [self.numbersByBaseName setObject:numbers forKey:baseName];
+                }
+                [numbers addIndex:number];
+            }
+        }
+    }
+}
+
+- (void)removeAllNames
+{
+    [self.namesByObject removeAllObjects];
+    [self.names removeAllObjects];
+    [self.numbersByBaseName removeAllObjects];
+}
+
+- (NSString *)unusedNameWithBaseName:(NSString *)baseName excludingNames:(NSSet *)excludedNames
+{
+    NSString *retVal = nil;
+
+    NSIndexSet *numbers = [self.numbersByBaseName objectForKey:baseName];
+    NSUInteger number = 1;
+    while (!retVal)
+    {
+        //Skip past the run of numbers in use starting at this number, if there is one
+        __block NSRange range = NSMakeRange(number, NSNotFound - number);
+        [numbers enumerateRangesInRange:range options:0 usingBlock:^(NSRange usedRange, BOOL *stop) {
+            range = usedRange;
+            *stop = YES;
+        }];
+        if (range.location == number)
+        {
+            number = NSMaxRange(range);
+        }
+
+        //A name may also be in use under another base name (e.g. "Base 2" with the base name "Base 2" is recorded as "Base" number 2)
+        NSString *name = number == 1 ? baseName : [NSString stringWithFormat:@"%@ %@", baseName, @(number)];
+        if ([self.names containsObject:name] || [excludedNames containsObject:name])
+        {
+            ++number;
+        }
+        else
+        {
+            retVal = name;
+        }
+    }
+
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+/**
+ Splits a name into its base name and number. A name which does not end with a space and a number of 2 or more (without leading zeros) is a base name, and is number 1.
+ */
+- (NSString *)baseNameOfName:(NSString *)name number:(NSUInteger *)number
+{
+    NSString *retVal = name;
+    *number = 1;
+
+    NSRange space = [name rangeOfString:@" " options:NSBackwardsSearch];
+    if (space.location != NSNotFound && space.location > 0)
+    {
+        NSString *suffix = [name substringFromIndex:NSMaxRange(space)];
+        NSCharacterSet *nonDigits = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789"] invertedSet];
+        if (suffix.length > 0 && suffix.length <= 9 && [suffix characterAtIndex:0] != '0' && [suffix rangeOfCharacterFromSet:nonDigits].location == NSNotFound)
+        {
+            NSInteger value = [suffix integerValue];
+            if (value >= 2)
+            {
+                retVal = [name substringToIndex:space.location];
+                *number = (NSUInteger)value;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+@end
@@ -0,0 +1,106 @@
+//
+//  GRKSearchIndex.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const GRKSearchIndexErrorDomain;
+
+typedef NS_ENUM(NSInteger, GRKSearchIndexError) {
+    GRKSearchIndexErrorBadFormat = 1,
+    GRKSearchIndexErrorBadVersion
+};
+
+/**
+ A full text index of documents, identified by strings, which finds the documents matching a query ranked by relevance (BM25).
+ Text is split into words which are folded to ignore case and diacritics. Each word maps to a posting list of the documents containing it, stored as delta and varint encoded document numbers with term frequencies.
+ Changes are collected in memory and sealed into immutable segment files, which are memory mapped and searched in place. Segments are merged in the background as they accumulate, dropping replaced and removed documents. Changes since the last seal are lost if the process ends without a `save:`, so each document carries a signature (e.g. a checksum of its content) with which the caller can find documents needing to be indexed again.
+ All methods are safe to call from any queue. Changes are applied asynchronously, in the order they are made.
+ */
+@interface GRKSearchIndex : NSObject
+
+/**
+ The directory holding the index.
+ */
+@property (nonatomic,readonly) NSURL *directory;
+
+/**
+ The number of documents in the index.
+ */
+@property (nonatomic,assign,readonly) NSUInteger documentCount;
+
+/**
+ Opens the index in the given directory, creating the directory if needed. Segments which can not be read are discarded (and their documents are no longer indexed).
+
+ @param directory The file URL of the directory to hold the index.
+ @param error     A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return The index, or `nil` if the directory could not be created.
+ */
+- (instancetype)initWithDirectory:(NSURL *)directory error:(__autoreleasing NSError **)error;
+
+/**
+ Indexes the given text as the content of a document, replacing any previous content of the document.
+
+ @param text       The text of the document.
+ @param signature  Identifies the version of the text, as returned by `signatureForIdentifier:`. Can be nil.
+ @param identifier The identifier of the document.
+ */
+- (void)setText:(NSString *)text signature:(NSString *)signature forIdentifier:(NSString *)identifier;
+
+/**
+ Removes a document from the index.
+
+ @param identifier The identifier of the document.
+ */
+- (void)removeIdentifier:(NSString *)identifier;
+
+/**
+ The signature given when a document was last indexed.
+
+ @param identifier The identifier of the document.
+
+ @return The signature, or `nil` if the document is not indexed (or was indexed without a signature).
+ */
+- (NSString *)signatureForIdentifier:(NSString *)identifier;
+
+/**
+ The identifiers of all indexed documents.
+
+ @return An NSSet of NSString identifiers.
+ */
+- (NSSet *)allIdentifiers;
+
+/**
+ Finds the documents containing any word of the query, best match first. The last word of the query also matches words which begin with it (unless the query ends with whitespace), so words can be found as they are typed.
+
+ @param query The query.
+ @param limit The maximum number of documents to return.
+
+ @return An NSArray of the NSString identifiers of the matching documents.
+ */
+- (NSArray *)identifiersMatchingQuery:(NSString *)query limit:(NSUInteger)limit;
+
+/**
+ Writes the changes held in memory to a new segment, so they persist.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)save:(__autoreleasing NSError **)error;
+
+@end
@@ -0,0 +1,1247 @@
+//
+//  GRKSearchIndex.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKSearchIndex.h"
+#include <float.h>
+#include <math.h>
+
+NSString * const GRKSearchIndexErrorDomain = @"GRKSearchIndexErrorDomain";
+
+static uint32_t const kSearchSegmentMagic = 0x58495347; // "GSIX"
+static uint32_t const kSearchSegmentVersion = 1;
+static NSString * const kSearchSegmentExtension = @"seg";
+
+static NSString * const kSearchManifestFileName = @"Manifest.plist";
+static NSInteger const kSearchManifestVersion = 2;
+//The deleted documents were held as a bitmap of every document number
+static NSInteger const kSearchManifestVersionDeletedBitmap = 1;
+static NSString * const kSearchManifestKeyVersion = @"version";
+static NSString * const kSearchManifestKeySegments = @"segments";
+static NSString * const kSearchManifestKeyNextDocument = @"nextDocument";
+static NSString * const kSearchManifestKeyNextSegment = @"nextSegment";
+static NSString * const kSearchManifestKeyDeleted = @"deleted";
+
+//The number of documents held in memory before they are sealed into a segment
+static NSUInteger const kSearchSealThreshold = 1024;
+//Segments of about the same size are merged once this many of them accumulate, so there are O(log n) segments
+static NSUInteger const kSearchMergeFactor = 8;
+//Longer words are not indexed
+static NSUInteger const kSearchMaximumTermLength = 64;
+//The most words a partial word of a query is expanded to, in each segment
+static NSUInteger const kSearchMaximumPrefixExpansions = 64;
+//BM25 parameters
+static double const kSearchK1 = 1.2;
+static double const kSearchB = 0.75;
+
+/**
+ The segment file layout is: header | documents (by document number) | terms (sorted by term bytes) | postings | strings
+ A posting list is a sequence of varint pairs: the difference between the document number and the previous one (the first is relative to zero), then the number of times the term occurs in the document.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t documentCount;
+    uint32_t termCount;
+    uint32_t postingsLength;
+    uint32_t stringsLength;
+    uint32_t reserved[2];
+} GRKSearchSegmentHeader;
+
+typedef struct {
+    uint32_t document;
+    //The number of words in the document
+    uint32_t length;
+    uint32_t identifierOffset;
+    uint32_t identifierLength;
+    uint32_t signatureOffset;
+    uint32_t signatureLength;
+} GRKSearchSegmentDocument;
+
+typedef struct {
+    uint32_t termOffset;
+    uint32_t termLength;
+    uint32_t postingsOffset;
+    uint32_t postingsLength;
+    uint32_t documentFrequency;
+} GRKSearchSegmentTerm;
+
+//A term and its posting list, wherever they are held
+typedef struct {
+    const uint8_t *term;
+    NSUInteger termLength;
+    const uint8_t *postings;
+    NSUInteger postingsLength;
+} GRKSearchTermPostings;
+
+//A candidate result of a search
+typedef struct {
+    double score;
+    uint32_t document;
+} GRKSearchHit;
+
+//A document in the posting lists of a search, held in an open addressing hash table sized to those posting lists
+typedef struct {
+    uint32_t document;
+    //The number of words in the document
+    uint32_t length;
+    BOOL used;
+    BOOL live;
+    double score;
+} GRKSearchMatch;
+
+#pragma mark - Helpers
+
+static NSError *GRKSearchIndexMakeError(GRKSearchIndexError code, NSString *message)
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    return [NSError errorWithDomain:GRKSearchIndexErrorDomain code:code userInfo:userInfo];
+}
+
+static int GRKSearchCompareBytes(const uint8_t *bytes1, NSUInteger length1, const uint8_t *bytes2, NSUInteger length2)
+{
+    int retVal = memcmp(bytes1, bytes2, MIN(length1, length2));
+    if (retVal == 0)
+    {
+        retVal = length1 < length2 ? -1 : (length1 > length2 ? 1 : 0);
+    }
+    return retVal;
+}
+
+static void GRKSearchAppendVarint(NSMutableData *data, uint32_t value)
+{
+    uint8_t bytes[5];
+    NSUInteger length = 0;
+    while (value >= 0x80)
+    {
+        bytes[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (uint8_t)value;
+    [data appendBytes:bytes length:length];
+}
+
+static BOOL GRKSearchReadVarint(const uint8_t **cursor, const uint8_t *end, uint32_t *value)
+{
+    BOOL retVal = NO;
+    uint32_t result = 0;
+    NSUInteger shift = 0;
+    while (*cursor < end && shift < 35 && !retVal)
+    {
+        uint8_t byte = **cursor;
+        *cursor += 1;
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+        retVal = (byte & 0x80) == 0;
+    }
+    *value = result;
+    return retVal;
+}
+
+/**
+ Calls the block with each document number and term frequency of a posting list, stopping early if the list is malformed.
+ */
+static void GRKSearchEnumeratePostings(const uint8_t *postings, NSUInteger length, void (^block)(uint32_t document, uint32_t frequency))
+{
+    const uint8_t *cursor = postings;
+    const uint8_t *end = postings + length;
+    uint32_t document = 0;
+    uint32_t delta = 0;
+    uint32_t frequency = 0;
+    while (cursor < end && GRKSearchReadVarint(&cursor, end, &delta) && GRKSearchReadVarint(&cursor, end, &frequency) && UINT32_MAX - document >= delta)
+    {
+        document += delta;
+        block(document, frequency);
+    }
+}
+
+//Finds the match of the given document, or the unused entry where it belongs. The table must have an unused entry.
+static GRKSearchMatch *GRKSearchFindMatch(GRKSearchMatch *matches, NSUInteger mask, uint32_t document)
+{
+    NSUInteger slot = (uint32_t)(document * 2654435761u) & mask;
+    while (matches[slot].used && matches[slot].document != document)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return &matches[slot];
+}
+
+//The deleted document numbers are persisted as an array of uint32_t
+static NSData *GRKSearchDataFromDeleted(NSIndexSet *deleted)
+{
+    NSMutableData *retVal = [NSMutableData dataWithCapacity:deleted.count * sizeof(uint32_t)];
+    [deleted enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        uint32_t document = (uint32_t)index;
+        [retVal appendBytes:&document length:sizeof(document)];
+    }];
+    return retVal;
+}
+
+static NSMutableIndexSet *GRKSearchDeletedFromData(NSData *data, BOOL bitmap)
+{
+    NSMutableIndexSet *retVal = [NSMutableIndexSet indexSet];
+    const uint8_t *bytes = [data bytes];
+    if (bitmap)
+    {
+        for (NSUInteger byte = 0; byte < data.length; ++byte)
+        {
+            for (NSUInteger bit = 0; bit < 8; ++bit)
+            {
+                if (bytes[byte] & (1 << bit))
+                {
+                    [retVal addIndex:byte * 8 + bit];
+                }
+            }
+        }
+    }
+    else
+    {
+        for (NSUInteger offset = 0; offset + sizeof(uint32_t) <= data.length; offset += sizeof(uint32_t))
+        {
+            uint32_t document;
+            memcpy(&document, bytes + offset, sizeof(document));
+            [retVal addIndex:document];
+        }
+    }
+    return retVal;
+}
+
+//Keeps the `limit` best hits in a min heap, so the worst of them is at the root
+static void GRKSearchHeapPush(GRKSearchHit *heap, NSUInteger *count, NSUInteger limit, GRKSearchHit hit)
+{
+    if (*count < limit)
+    {
+        NSUInteger child = (*count)++;
+        while (child > 0 && heap[(child - 1) / 2].score > hit.score)
+        {
+            heap[child] = heap[(child - 1) / 2];
+            child = (child - 1) / 2;
+        }
+        heap[child] = hit;
+    }
+    else if (limit > 0 && hit.score > heap[0].score)
+    {
+        NSUInteger parent = 0;
+        BOOL placed = NO;
+        while (!placed)
+        {
+            NSUInteger child = parent * 2 + 1;
+            if (child + 1 < limit && heap[child + 1].score < heap[child].score)
+            {
+                ++child;
+            }
+            if (child < limit && heap[child].score < hit.score)
+            {
+                heap[parent] = heap[child];
+                parent = child;
+            }
+            else
+            {
+                placed = YES;
+            }
+        }
+        heap[parent] = hit;
+    }
+}
+
+static int GRKSearchCompareHits(const void *hit1, const void *hit2)
+{
+    double score1 = ((const GRKSearchHit *)hit1)->score;
+    double score2 = ((const GRKSearchHit *)hit2)->score;
+    return score1 > score2 ? -1 : (score1 < score2 ? 1 : 0);
+}
+
+#pragma mark - GRKSearchDocumentInfo
+
+@interface GRKSearchDocumentInfo : NSObject
+
+@property (nonatomic,assign) uint32_t document;
+@property (nonatomic,assign) uint32_t length;
+@property (nonatomic,copy) NSString *identifier;
+@property (nonatomic,copy) NSString *signature;
+
+@end
+
+@implementation GRKSearchDocumentInfo
+
+@end
+
+#pragma mark - Segments
+
+/**
+ A set of documents and the posting lists of their terms.
+ */
+@protocol GRKSearchPostingsSource <NSObject>
+
+//The documents, in ascending order of document number
+- (NSArray *)documentInfos;
+- (NSUInteger)termCount;
+//The terms in ascending byte order
+- (GRKSearchTermPostings)termPostingsAtIndex:(NSUInteger)index;
+//Calls the block with the posting list of the given term, or of each term beginning with it
+- (void)enumerateTerm:(NSData *)term prefix:(BOOL)prefix usingBlock:(void (^)(GRKSearchTermPostings termPostings))block;
+
+@end
+
+@interface GRKSearchMemoryPostings : NSObject
+
+@property (nonatomic,strong) NSMutableData *data;
+@property (nonatomic,assign) uint32_t lastDocument;
+
+@end
+
+@implementation GRKSearchMemoryPostings
+
+@end
+
+/**
+ The documents indexed since the last seal, which are searched in place until they are written to a segment.
+ */
+@interface GRKSearchMemorySegment : NSObject <GRKSearchPostingsSource>
+
+//Maps the UTF-8 data of each term to its GRKSearchMemoryPostings
+@property (nonatomic,strong) NSMutableDictionary *postings;
+@property (nonatomic,strong) NSMutableArray *documents;
+//The terms in byte order, prepared for sealing
+@property (nonatomic,strong) NSArray *sortedTerms;
+
+- (void)addDocument:(GRKSearchDocumentInfo *)info terms:(NSCountedSet *)terms;
+
+@end
+
+@implementation GRKSearchMemorySegment
+
+- (id)init
+{
+    if ((self = [super init]))
+    {
+        self.postings = [NSMutableDictionary dictionary];
+        self.documents = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (void)addDocument:(GRKSearchDocumentInfo *)info terms:(NSCountedSet *)terms
+{
+    [self.documents addObject:info];
+    for (NSData *term in terms)
+    {
+        GRKSearchMemoryPostings *postings = [self.postings objectForKey:term];
+        if (!postings)
+        {
+            postings = [[GRKSearchMemoryPostings alloc] init];
+            postings.data = [NSMutableData data];
+            [self.postings setObject:postings forKey:term];
+        }
+        GRKSearchAppendVarint(postings.data, info.document - postings.lastDocument);
+        GRKSearchAppendVarint(postings.data, (uint32_t)[terms countForObject:term]);
+        postings.lastDocument = info.document;
+    }
+    self.sortedTerms = nil;
+}
+
+- (NSArray *)documentInfos
+{
+    return self.documents;
+}
+
+- (NSUInteger)termCount
+{
+    return self.postings.count;
+}
+
+- (GRKSearchTermPostings)termPostingsAtIndex:(NSUInteger)index
+{
+    if (!self.sortedTerms)
+    {
+        self.sortedTerms = [[self.postings allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSData *term1, NSData *term2) {
+            int order = GRKSearchCompareBytes([term1 bytes], term1.length, [term2 bytes], term2.length);
+            return order < 0 ? NSOrderedAscending : (order > 0 ? NSOrderedDescending : NSOrderedSame);
+        }];
+    }
+
+    NSData *term = [self.sortedTerms objectAtIndex:index];
+    NSData *data = ((GRKSearchMemoryPostings *)[self.postings objectForKey:term]).data;
+    GRKSearchTermPostings retVal = {[term bytes], term.length, [data bytes], data.length};
+    return retVal;
+}
+
+- (void)enumerateTerm:(NSData *)term prefix:(BOOL)prefix usingBlock:(void (^)(GRKSearchTermPostings termPostings))block
+{
+    if (prefix)
+    {
+        NSUInteger expansions = 0;
+        for (NSData *candidate in self.postings)
+        {
+            if (expansions < kSearchMaximumPrefixExpansions && candidate.length >= term.length && memcmp([candidate bytes], [term bytes], term.length) == 0)
+            {
+                NSData *data = ((GRKSearchMemoryPostings *)[self.postings objectForKey:candidate]).data;
+                GRKSearchTermPostings termPostings = {[candidate bytes], candidate.length, [data bytes], data.length};
+                block(termPostings);
+                ++expansions;
+            }
+        }
+    }
+    else
+    {
+        NSData *data = ((GRKSearchMemoryPostings *)[self.postings objectForKey:term]).data;
+        if (data)
+        {
+            GRKSearchTermPostings termPostings = {[term bytes], term.length, [data bytes], data.length};
+            block(termPostings);
+        }
+    }
+}
+
+@end
+
+/**
+ An immutable, memory mapped, segment file.
+ */
+@interface GRKSearchSegment : NSObject <GRKSearchPostingsSource>
+
+@property (nonatomic,strong) NSURL *url;
+@property (nonatomic,strong) NSData *data;
+@property (nonatomic,assign) NSUInteger documentCount;
+@property (nonatomic,assign) const GRKSearchSegmentDocument *documents;
+@property (nonatomic,assign) const GRKSearchSegmentTerm *terms;
+@property (nonatomic,assign) NSUInteger count;
+@property (nonatomic,assign) const uint8_t *postingsBase;
+@property (nonatomic,assign) const uint8_t *strings;
+
++ (instancetype)segmentWithURL:(NSURL *)url error:(__autoreleasing NSError **)error;
+//Writes the live documents of the sources, which must be in ascending order of document number, to a new segment file
++ (instancetype)segmentWithSources:(NSArray *)sources deleted:(NSIndexSet *)deleted url:(NSURL *)url error:(__autoreleasing NSError **)error;
+
+@end
+
+@implementation GRKSearchSegment
+
++ (instancetype)segmentWithURL:(NSURL *)url error:(__autoreleasing NSError **)error
+{
+    GRKSearchSegment *retVal = nil;
+
+    NSData *data = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:error];
+    if (data)
+    {
+        GRKSearchSegment *segment = [[GRKSearchSegment alloc] init];
+        segment.url = url;
+        segment.data = data;
+        NSError *validationError = [segment validate];
+        if (validationError)
+        {
+            if (error)
+            {
+                *error = validationError;
+            }
+        }
+        else
+        {
+            retVal = segment;
+        }
+    }
+
+    return retVal;
+}
+
++ (instancetype)segmentWithSources:(NSArray *)sources deleted:(NSIndexSet *)deleted url:(NSURL *)url error:(__autoreleasing NSError **)error
+{
+    GRKSearchSegment *retVal = nil;
+
+    NSMutableData *documents = [NSMutableData data];
+    NSMutableData *terms = [NSMutableData data];
+    NSMutableData *postings = [NSMutableData data];
+    NSMutableData *strings = [NSMutableData data];
+
+    for (id<GRKSearchPostingsSource> source in sources)
+    {
+        for (GRKSearchDocumentInfo *info in [source documentInfos])
+        {
+            if (![deleted containsIndex:info.document])
+            {
+                NSData *identifier = [info.identifier dataUsingEncoding:NSUTF8StringEncoding];
+                NSData *signature = [info.signature dataUsingEncoding:NSUTF8StringEncoding];
+                GRKSearchSegmentDocument document = {info.document, info.length, (uint32_t)strings.length, (uint32_t)identifier.length, (uint32_t)(strings.length + identifier.length), (uint32_t)signature.length};
+                [strings appendData:identifier];
+                [strings appendData:signature];
+                [documents appendBytes:&document length:sizeof(document)];
+            }
+        }
+    }
+
+    //Merge the sorted terms of the sources, concatenating the posting lists of equal terms (the sources hold ascending, disjoint, ranges of documents) without the deleted documents
+    NSUInteger sourceCount = sources.count;
+    NSUInteger *cursors = calloc(MAX(sourceCount, 1), sizeof(NSUInteger));
+    GRKSearchTermPostings *current = calloc(MAX(sourceCount, 1), sizeof(GRKSearchTermPostings));
+    BOOL more = YES;
+    while (more)
+    {
+        const GRKSearchTermPostings *lowest = NULL;
+        for (NSUInteger i = 0; i < sourceCount; ++i)
+        {
+            id<GRKSearchPostingsSource> source = [sources objectAtIndex:i];
+            if (cursors[i] < [source termCount])
+            {
+                current[i] = [source termPostingsAtIndex:cursors[i]];
+                if (!lowest || GRKSearchCompareBytes(current[i].term, current[i].termLength, lowest->term, lowest->termLength) < 0)
+                {
+                    lowest = &current[i];
+                }
+            }
+        }
+
+        more = lowest != NULL;
+        if (more)
+        {
+            GRKSearchTermPostings term = *lowest;
+            NSUInteger start = postings.length;
+            __block uint32_t frequency = 0;
+            __block uint32_t lastDocument = 0;
+            for (NSUInteger i = 0; i < sourceCount; ++i)
+            {
+                if (cursors[i] < [[sources objectAtIndex:i] termCount] && GRKSearchCompareBytes(current[i].term, current[i].termLength, term.term, term.termLength) == 0)
+                {
+                    GRKSearchEnumeratePostings(current[i].postings, current[i].postingsLength, ^(uint32_t document, uint32_t count) {
+                        if (![deleted containsIndex:document] && (frequency == 0 || document > lastDocument))
+                        {
+                            GRKSearchAppendVarint(postings, document - lastDocument);
+                            GRKSearchAppendVarint(postings, count);
+                            lastDocument = document;
+                            ++frequency;
+                        }
+                    });
+                    cursors[i] += 1;
+                }
+            }
+
+            if (frequency > 0)
+            {
+                GRKSearchSegmentTerm entry = {(uint32_t)strings.length, (uint32_t)term.termLength, (uint32_t)start, (uint32_t)(postings.length - start), frequency};
+                [strings appendBytes:term.term length:term.termLength];
+                [terms appendBytes:&entry length:sizeof(entry)];
+            }
+        }
+    }
+    free(current);
+    free(cursors);
+
+    GRKSearchSegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kSearchSegmentMagic;
+    header.version = kSearchSegmentVersion;
+    header.documentCount = (uint32_t)(documents.length / sizeof(GRKSearchSegmentDocument));
+    header.termCount = (uint32_t)(terms.length / sizeof(GRKSearchSegmentTerm));
+    header.postingsLength = (uint32_t)postings.length;
+    header.stringsLength = (uint32_t)strings.length;
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + documents.length + terms.length + postings.length + strings.length];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:documents];
+    [data appendData:terms];
+    [data appendData:postings];
+    [data appendData:strings];
+
+    if ((unsigned long long)data.length > UINT32_MAX)
+    {
+        if (error)
+        {
+            *error = GRKSearchIndexMakeError(GRKSearchIndexErrorBadFormat, @"Segment is too large.");
+        }
+    }
+    else if ([data writeToURL:url options:NSDataWritingAtomic error:error])
+    {
+        retVal = [self segmentWithURL:url error:error];
+    }
+
+    return retVal;
+}
+
+- (NSError *)validate
+{
+    NSError *retVal = nil;
+
+    const uint8_t *bytes = [self.data bytes];
+    const GRKSearchSegmentHeader *header = (const GRKSearchSegmentHeader *)bytes;
+    if (self.data.length < sizeof(GRKSearchSegmentHeader))
+    {
+        retVal = GRKSearchIndexMakeError(GRKSearchIndexErrorBadFormat, @"Segment is truncated.");
+    }
+    else if (header->magic != kSearchSegmentMagic)
+    {
+        retVal = GRKSearchIndexMakeError(GRKSearchIndexErrorBadFormat, @"Segment has an unexpected signature.");
+    }
+    else if (header->version != kSearchSegmentVersion)
+    {
+        retVal = GRKSearchIndexMakeError(GRKSearchIndexErrorBadVersion, [NSString stringWithFormat:@"Segment version %@ is not supported (expecting %@).", @(header->version), @(kSearchSegmentVersion)]);
+    }
+    else
+    {
+        unsigned long long documentsLength = (unsigned long long)header->documentCount * sizeof(GRKSearchSegmentDocument);
+        unsigned long long termsLength = (unsigned long long)header->termCount * sizeof(GRKSearchSegmentTerm);
+        unsigned long long expectedLength = sizeof(GRKSearchSegmentHeader) + documentsLength + termsLength + header->postingsLength + header->stringsLength;
+        if (expectedLength != self.data.length)
+        {
+            retVal = GRKSearchIndexMakeError(GRKSearchIndexErrorBadFormat, @"Segment length does not match its header.");
+        }
+        else
+        {
+            self.documentCount = header->documentCount;
+            self.count = header->termCount;
+            self.documents = (const GRKSearchSegmentDocument *)(header + 1);
+            self.terms = (const GRKSearchSegmentTerm *)(self.documents + header->documentCount);
+            self.postingsBase = (const uint8_t *)(self.terms + header->termCount);
+            self.strings = self.postingsBase + header->postingsLength;
+
+            //Bounds check every entry, so lookups may trust the offsets
+            unsigned long long stringsLength = header->stringsLength;
+            for (uint32_t i = 0; i < header->documentCount && !retVal; ++i)
+            {
+                const GRKSearchSegmentDocument *document = &self.documents[i];
+                BOOL valid = (unsigned long long)document->identifierOffset + document->identifierLength <= stringsLength &&
+                             (unsigned long long)document->signatureOffset + document->signatureLength <= stringsLength;
+                if (!valid)
+                {
+                    retVal = GRKSearchIndexMakeError(GRKSearchIndexErrorBadFormat, [NSString stringWithFormat:@"Segment document %@ is out of bounds.", @(i)]);
+                }
+            }
+            for (uint32_t i = 0; i < header->termCount && !retVal; ++i)
+            {
+                const GRKSearchSegmentTerm *term = &self.terms[i];
+                BOOL valid = (unsigned long long)term->termOffset + term->termLength <= stringsLength &&
+                             (unsigned long long)term->postingsOffset + term->postingsLength <= header->postingsLength;
+                if (!valid)
+                {
+                    retVal = GRKSearchIndexMakeError(GRKSearchIndexErrorBadFormat, [NSString stringWithFormat:@"Segment term %@ is out of bounds.", @(i)]);
+                }
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (NSArray *)documentInfos
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:self.documentCount];
+    for (NSUInteger i = 0; i < self.documentCount; ++i)
+    {
+        const GRKSearchSegmentDocument *document = &self.documents[i];
+        GRKSearchDocumentInfo *info = [[GRKSearchDocumentInfo alloc] init];
+        info.document = document->document;
+        info.length = document->length;
+        info.identifier = [[NSString alloc] initWithBytes:self.strings + document->identifierOffset length:document->identifierLength encoding:NSUTF8StringEncoding];
+        if (document->signatureLength > 0)
+        {
+            info.signature = [[NSString alloc] initWithBytes:self.strings + document->signatureOffset length:document->signatureLength encoding:NSUTF8StringEncoding];
+        }
+        [retVal addObject:info];
+    }
+    return retVal;
+}
+
+- (NSUInteger)termCount
+{
+    return self.count;
+}
+
+- (GRKSearchTermPostings)termPostingsAtIndex:(NSUInteger)index
+{
+    const GRKSearchSegmentTerm *term = &self.terms[index];
+    GRKSearchTermPostings retVal = {self.strings + term->termOffset, term->termLength, self.postingsBase + term->postingsOffset, term->postingsLength};
+    return retVal;
+}
+
+- (void)enumerateTerm:(NSData *)term prefix:(BOOL)prefix usingBlock:(void (^)(GRKSearchTermPostings termPostings))block
+{
+    //Find the first term which is not less than the given term
+    NSUInteger lo = 0;
+    NSUInteger hi = self.count;
+    while (lo < hi)
+    {
+        NSUInteger middle = lo + (hi - lo) / 2;
+        const GRKSearchSegmentTerm *candidate = &self.terms[middle];
+        if (GRKSearchCompareBytes(self.strings + candidate->termOffset, candidate->termLength, [term bytes], term.length) < 0)
+        {
+            lo = middle + 1;
+        }
+        else
+        {
+            hi = middle;
+        }
+    }
+
+    //Terms beginning with the given term follow it
+    BOOL matches = YES;
+    for (NSUInteger index = lo; index < self.count && index - lo < kSearchMaximumPrefixExpansions && matches; ++index)
+    {
+        GRKSearchTermPostings termPostings = [self termPostingsAtIndex:index];
+        if (prefix)
+        {
+            matches = termPostings.termLength >= term.length && memcmp(termPostings.term, [term bytes], term.length) == 0;
+        }
+        else
+        {
+            matches = GRKSearchCompareBytes(termPostings.term, termPostings.termLength, [term bytes], term.length) == 0;
+        }
+        if (matches)
+        {
+            block(termPostings);
+        }
+        //An exact term has at most one match
+        matches = matches && prefix;
+    }
+}
+
+@end
+
+#pragma mark - GRKSearchIndex
+
+@interface GRKSearchIndex ()
+
+@property (nonatomic,strong,readwrite) NSURL *directory;
+//Confines all of the following state
+@property (nonatomic,strong) dispatch_queue_t queue;
+//Sealed segments, in ascending order of their documents
+@property (nonatomic,strong) NSMutableArray *segments;
+@property (nonatomic,strong) GRKSearchMemorySegment *memorySegment;
+//Maps the identifier of each live document to its GRKSearchDocumentInfo
+@property (nonatomic,strong) NSMutableDictionary *documentInfos;
+//Maps the document number (NSNumber) of each live document to its GRKSearchDocumentInfo
+@property (nonatomic,strong) NSMutableDictionary *documentsByNumber;
+//The total length of the live documents
+@property (nonatomic,assign) unsigned long long totalLength;
+//The numbers of the replaced or removed documents which are still held by a segment. Documents leave the set as seals and merges drop them, so it is sized by the segments, not by the documents ever indexed.
+@property (nonatomic,strong) NSMutableIndexSet *deleted;
+@property (nonatomic,assign) uint32_t nextDocument;
+@property (nonatomic,assign) NSUInteger nextSegment;
+@property (nonatomic,assign) BOOL merging;
+
+@end
+
+@implementation GRKSearchIndex
+
+#pragma mark - Initialization
+
+- (instancetype)initWithDirectory:(NSURL *)directory error:(__autoreleasing NSError **)error
+{
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:error])
+    {
+        return nil;
+    }
+
+    if ((self = [super init]))
+    {
+        self.directory = directory;
+        self.queue = dispatch_queue_create("com.levigroker.searchindex", DISPATCH_QUEUE_SERIAL);
+        self.segments = [NSMutableArray array];
+        self.memorySegment = [[GRKSearchMemorySegment alloc] init];
+        self.documentInfos = [NSMutableDictionary dictionary];
+        self.documentsByNumber = [NSMutableDictionary dictionary];
+        self.deleted = [NSMutableIndexSet indexSet];
+        [self load];
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (NSUInteger)documentCount
+{
+    __block NSUInteger retVal = 0;
+    dispatch_sync(self.queue, ^{
+        retVal = self.documentInfos.count;
+    });
+    return retVal;
+}
+
+- (void)setText:(NSString *)text signature:(NSString *)signature forIdentifier:(NSString *)identifier
+{
+    if (identifier)
+    {
+        dispatch_async(self.queue, ^{
+            [self removeDocumentWithIdentifier:identifier];
+
+            NSUInteger length = 0;
+            NSCountedSet *terms = [NSCountedSet set];
+            for (NSData *term in [self termsOfText:text])
+            {
+                [terms addObject:term];
+                ++length;
+            }
+
+            GRKSearchDocumentInfo *info = [[GRKSearchDocumentInfo alloc] init];
+            info.document = self.nextDocument;
+            info.length = (uint32_t)MIN(length, (NSUInteger)UINT32_MAX);
+            info.identifier = identifier;
+            info.signature = signature;
+            self.nextDocument += 1;
+            [self.memorySegment addDocument:info terms:terms];
+            [self addLiveDocument:info];
+
+            if (self.memorySegment.documents.count >= kSearchSealThreshold)
+            {
+                __autoreleasing NSError *error = nil;
+                if (![self seal:&error])
+                {
+                    DDLogError(@"Unable to seal search index segment. Error: %@", error);
+                }
+            }
+        });
+    }
+}
+
+- (void)removeIdentifier:(NSString *)identifier
+{
+    if (identifier)
+    {
+        dispatch_async(self.queue, ^{
+            [self removeDocumentWithIdentifier:identifier];
+        });
+    }
+}
+
+- (NSString *)signatureForIdentifier:(NSString *)identifier
+{
+    __block NSString *retVal = nil;
+    if (identifier)
+    {
+        dispatch_sync(self.queue, ^{
+            retVal = ((GRKSearchDocumentInfo *)[self.documentInfos objectForKey:identifier]).signature;
+        });
+    }
+    return retVal;
+}
+
+- (NSSet *)allIdentifiers
+{
+    __block NSSet *retVal = nil;
+    dispatch_sync(self.queue, ^{
+        retVal = [NSSet setWithArray:[self.documentInfos allKeys]];
+    });
+    return retVal;
+}
+
+- (NSArray *)identifiersMatchingQuery:(NSString *)query limit:(NSUInteger)limit
+{
+    NSMutableArray *retVal = [NSMutableArray array];
+
+    //Words are looked up as they were indexed; a partial last word matches the words it begins
+    NSMutableOrderedSet *terms = [NSMutableOrderedSet orderedSetWithArray:[self termsOfText:query]];
+    NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+    BOOL prefix = query.length > 0 && ![whitespace characterIsMember:[query characterAtIndex:query.length - 1]];
+
+    if (terms.count > 0 && limit > 0)
+    {
+        dispatch_sync(self.queue, ^{
+            NSMutableArray *sources = [NSMutableArray arrayWithArray:self.segments];
+            [sources addObject:self.memorySegment];
+
+            //Gather the posting lists of each matching term, across the segments
+            NSMutableDictionary *postingsByTerm = [NSMutableDictionary dictionary];
+            [terms enumerateObjectsUsingBlock:^(NSData *term, NSUInteger index, BOOL *stop) {
+                BOOL isPrefix = prefix && index == terms.count - 1;
+                for (id<GRKSearchPostingsSource> source in sources)
+                {
+                    [source enumerateTerm:term prefix:isPrefix usingBlock:^(GRKSearchTermPostings termPostings) {
+                        NSData *matched = [NSData dataWithBytes:termPostings.term length:termPostings.termLength];
+                        NSMutableArray *lists = [postingsByTerm objectForKey:matched];
+                        if (!lists)
+                        {
+                            lists = [NSMutableArray array];
+                            [postingsByTerm setObject:lists forKey:matched];
+                        }
+                        [lists addObject:[NSData dataWithBytesNoCopy:(void *)termPostings.postings length:termPostings.postingsLength freeWhenDone:NO]];
+                    }];
+                }
+            }];
+
+            //Score the documents with BM25. Only the documents in the posting lists are scored, so the table of matches is sized to them rather than to every document number ever assigned.
+            NSDictionary *documentsByNumber = self.documentsByNumber;
+            NSUInteger documentCount = documentsByNumber.count;
+            double averageLength = documentCount > 0 ? MAX((double)self.totalLength / (double)documentCount, 1.0) : 1.0;
+            NSUInteger postingsLength = 0;
+            for (NSArray *lists in [postingsByTerm objectEnumerator])
+            {
+                for (NSData *list in lists)
+                {
+                    postingsLength += list.length;
+                }
+            }
+            //Each posting takes at least two bytes, so the table is at most half full
+            NSUInteger capacity = 1;
+            while (capacity < postingsLength)
+            {
+                capacity <<= 1;
+            }
+            NSUInteger mask = capacity - 1;
+            GRKSearchMatch *matches = calloc(capacity, sizeof(GRKSearchMatch));
+
+            for (NSData *term in postingsByTerm)
+            {
+                NSArray *lists = [postingsByTerm objectForKey:term];
+                __block NSUInteger frequency = 0;
+                for (NSData *list in lists)
+                {
+                    GRKSearchEnumeratePostings([list bytes], list.length, ^(uint32_t document, uint32_t count) {
+                        GRKSearchMatch *match = GRKSearchFindMatch(matches, mask, document);
+                        if (!match->used)
+                        {
+                            //Replaced and removed documents are no longer numbered
+                            GRKSearchDocumentInfo *info = [documentsByNumber objectForKey:@(document)];
+                            match->used = YES;
+                            match->document = document;
+                            match->live = info != nil;
+                            match->length = info.length;
+                        }
+                        if (match->live)
+                        {
+                            ++frequency;
+                        }
+                    });
+                }
+
+                if (frequency > 0)
+                {
+                    double idf = log(1.0 + ((double)documentCount - (double)frequency + 0.5) / ((double)frequency + 0.5));
+                    for (NSData *list in lists)
+                    {
+                        GRKSearchEnumeratePostings([list bytes], list.length, ^(uint32_t document, uint32_t count) {
+                            GRKSearchMatch *match = GRKSearchFindMatch(matches, mask, document);
+                            if (match->live)
+                            {
+                                double tf = count;
+                                double norm = kSearchK1 * (1.0 - kSearchB + kSearchB * (double)match->length / averageLength);
+                                //Every match counts for something, even for a word in most documents
+                                match->score += MAX(idf, DBL_EPSILON) * (tf * (kSearchK1 + 1.0)) / (tf + norm);
+                            }
+                        });
+                    }
+                }
+            }
+
+            //Keep the best
+            NSUInteger hitCount = 0;
+            GRKSearchHit *hits = calloc(limit, sizeof(GRKSearchHit));
+            for (NSUInteger i = 0; i < capacity; ++i)
+            {
+                if (matches[i].live && matches[i].score > 0.0)
+                {
+                    GRKSearchHit hit = {matches[i].score, matches[i].document};
+                    GRKSearchHeapPush(hits, &hitCount, limit, hit);
+                }
+            }
+            qsort(hits, hitCount, sizeof(GRKSearchHit), GRKSearchCompareHits);
+            for (NSUInteger i = 0; i < hitCount; ++i)
+            {
+                NSString *identifier = ((GRKSearchDocumentInfo *)[documentsByNumber objectForKey:@(hits[i].document)]).identifier;
+                if (identifier)
+                {
+                    [retVal addObject:identifier];
+                }
+            }
+            free(hits);
+            free(matches);
+        });
+    }
+
+    return retVal;
+}
+
+- (BOOL)save:(__autoreleasing NSError **)error
+{
+    __block BOOL retVal = NO;
+    __block NSError *saveError = nil;
+    dispatch_sync(self.queue, ^{
+        __autoreleasing NSError *sealError = nil;
+        retVal = [self seal:&sealError];
+        saveError = sealError;
+    });
+    if (error)
+    {
+        *error = saveError;
+    }
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+/**
+ Splits text into words, folded to ignore case and diacritics.
+ @return An NSArray of the UTF-8 NSData of each word, in order.
+ */
+- (NSArray *)termsOfText:(NSString *)text
+{
+    NSMutableArray *retVal = [NSMutableArray array];
+    NSString *folded = [text stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch locale:nil];
+    [folded enumerateSubstringsInRange:NSMakeRange(0, folded.length) options:NSStringEnumerationByWords usingBlock:^(NSString *word, NSRange wordRange, NSRange enclosingRange, BOOL *stop) {
+        NSData *term = [word dataUsingEncoding:NSUTF8StringEncoding];
+        if (term.length > 0 && term.length <= kSearchMaximumTermLength)
+        {
+            [retVal addObject:term];
+        }
+    }];
+    return retVal;
+}
+
+//Must be called on the queue
+- (void)addLiveDocument:(GRKSearchDocumentInfo *)info
+{
+    [self.documentInfos setObject:info forKey:info.identifier];
+    [self.documentsByNumber setObject:info forKey:@(info.document)];
+    self.totalLength += info.length;
+}
+
+//Must be called on the queue
+- (void)removeDocumentWithIdentifier:(NSString *)identifier
+{
+    GRKSearchDocumentInfo *info = [self.documentInfos objectForKey:identifier];
+    if (info)
+    {
+        [self.deleted addIndex:info.document];
+        [self.documentInfos removeObjectForKey:identifier];
+        [self.documentsByNumber removeObjectForKey:@(info.document)];
+        self.totalLength -= MIN(self.totalLength, (unsigned long long)info.length);
+    }
+}
+
+- (NSURL *)manifestURL
+{
+    return [self.directory URLByAppendingPathComponent:kSearchManifestFileName];
+}
+
+//Reads the manifest and the segments it names, and discards any other segment files. Called from init.
+- (void)load
+{
+    NSArray *segmentNames = @[];
+    NSData *manifestData = [NSData dataWithContentsOfURL:[self manifestURL]];
+    if (manifestData)
+    {
+        __autoreleasing NSError *error = nil;
+        NSDictionary *manifest = [NSPropertyListSerialization propertyListWithData:manifestData options:NSPropertyListImmutable format:NULL error:&error];
+        NSInteger version = [manifest isKindOfClass:NSDictionary.class] ? [[manifest objectForKey:kSearchManifestKeyVersion] integerValue] : 0;
+        if (version == kSearchManifestVersion || version == kSearchManifestVersionDeletedBitmap)
+        {
+            segmentNames = [manifest objectForKey:kSearchManifestKeySegments] ?: @[];
+            self.nextDocument = (uint32_t)[[manifest objectForKey:kSearchManifestKeyNextDocument] unsignedIntValue];
+            self.nextSegment = [[manifest objectForKey:kSearchManifestKeyNextSegment] unsignedIntegerValue];
+            NSData *deleted = [manifest objectForKey:kSearchManifestKeyDeleted];
+            if ([deleted isKindOfClass:NSData.class])
+            {
+                self.deleted = GRKSearchDeletedFromData(deleted, version == kSearchManifestVersionDeletedBitmap);
+            }
+        }
+        else
+        {
+            DDLogWarn(@"Discarding invalid search index manifest '%@'. Error: %@", [self manifestURL], error);
+        }
+    }
+
+    //Only the deleted documents held by the segments read are kept
+    NSMutableIndexSet *deleted = self.deleted;
+    self.deleted = [NSMutableIndexSet indexSet];
+    for (NSString *name in segmentNames)
+    {
+        __autoreleasing NSError *error = nil;
+        GRKSearchSegment *segment = [GRKSearchSegment segmentWithURL:[self.directory URLByAppendingPathComponent:name] error:&error];
+        if (segment)
+        {
+            [self.segments addObject:segment];
+            for (GRKSearchDocumentInfo *info in [segment documentInfos])
+            {
+                if ([deleted containsIndex:info.document])
+                {
+                    [self.deleted addIndex:info.document];
+                }
+                else if (info.document < self.nextDocument)
+                {
+                    [self removeDocumentWithIdentifier:info.identifier];
+                    [self addLiveDocument:info];
+                }
+            }
+        }
+        else
+        {
+            DDLogWarn(@"Discarding unreadable search index segment '%@'. Error: %@", name, error);
+        }
+    }
+
+    //Remove segments left behind by an interrupted seal or merge
+    NSSet *names = [NSSet setWithArray:[self.segments valueForKeyPath:@"url.lastPathComponent"]];
+    NSArray *contents = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.directory includingPropertiesForKeys:nil options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    for (NSURL *url in contents)
+    {
+        if ([[url pathExtension] isEqualToString:kSearchSegmentExtension] && ![names containsObject:[url lastPathComponent]])
+        {
+            [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+        }
+    }
+}
+
+//Must be called on the queue
+- (BOOL)writeManifest:(__autoreleasing NSError **)error
+{
+    NSMutableDictionary *manifest = [NSMutableDictionary dictionaryWithCapacity:5];
+    [manifest setObject:@(kSearchManifestVersion) forKey:kSearchManifestKeyVersion];
+    [manifest setObject:[self.segments valueForKeyPath:@"url.lastPathComponent"] forKey:kSearchManifestKeySegments];
+    [manifest setObject:@(self.nextDocument) forKey:kSearchManifestKeyNextDocument];
+    [manifest setObject:@(self.nextSegment) forKey:kSearchManifestKeyNextSegment];
+    [manifest setObject:GRKSearchDataFromDeleted(self.deleted) forKey:kSearchManifestKeyDeleted];
+
+    BOOL retVal = NO;
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:manifest format:NSPropertyListBinaryFormat_v1_0 options:0 error:error];
+    if (data)
+    {
+        retVal = [data writeToURL:[self manifestURL] options:NSDataWritingAtomic error:error];
+    }
+    return retVal;
+}
+
+//Must be called on the queue
+- (NSURL *)nextSegmentURL
+{
+    NSString *name = [NSString stringWithFormat:@"%lu.%@", (unsigned long)self.nextSegment, kSearchSegmentExtension];
+    self.nextSegment += 1;
+    return [self.directory URLByAppendingPathComponent:name];
+}
+
+/**
+ Writes the documents held in memory to a new segment, then records the segments and deletions in the manifest.
+ Must be called on the queue.
+ */
+- (BOOL)seal:(__autoreleasing NSError **)error
+{
+    BOOL retVal = YES;
+
+    GRKSearchMemorySegment *memorySegment = self.memorySegment;
+    BOOL live = NO;
+    for (GRKSearchDocumentInfo *info in memorySegment.documents)
+    {
+        live = live || ![self.deleted containsIndex:info.document];
+    }
+
+    if (live)
+    {
+        GRKSearchSegment *segment = [GRKSearchSegment segmentWithSources:@[memorySegment] deleted:self.deleted url:[self nextSegmentURL] error:error];
+        retVal = segment != nil;
+        if (segment)
+        {
+            [self.segments addObject:segment];
+        }
+    }
+
+    if (retVal)
+    {
+        //The deleted documents held in memory were not written, so no longer need to be remembered
+        for (GRKSearchDocumentInfo *info in memorySegment.documents)
+        {
+            [self.deleted removeIndex:info.document];
+        }
+        self.memorySegment = [[GRKSearchMemorySegment alloc] init];
+        retVal = [self writeManifest:error];
+        [self mergeIfNeeded];
+    }
+
+    return retVal;
+}
+
+/**
+ Merges the newest segments into one, in the background, if enough segments of about the same size have accumulated.
+ Must be called on the queue.
+ */
+- (void)mergeIfNeeded
+{
+    //Place segments into levels by size, each level holding segments kSearchMergeFactor times the size of the level below
+    NSUInteger (^level)(GRKSearchSegment *) = ^NSUInteger(GRKSearchSegment *segment) {
+        NSUInteger retVal = 0;
+        unsigned long long size = kSearchSealThreshold;
+        while (segment.documentCount > size)
+        {
+            size *= kSearchMergeFactor;
+            ++retVal;
+        }
+        return retVal;
+    };
+
+    NSUInteger count = self.segments.count;
+    NSUInteger runLength = 0;
+    if (count > 0)
+    {
+        NSUInteger lastLevel = level([self.segments lastObject]);
+        while (runLength < count && level([self.segments objectAtIndex:count - runLength - 1]) <= lastLevel)
+        {
+            ++runLength;
+        }
+    }
+
+    if (!self.merging && runLength >= kSearchMergeFactor)
+    {
+        self.merging = YES;
+        NSArray *sources = [self.segments subarrayWithRange:NSMakeRange(count - runLength, runLength)];
+        NSIndexSet *deleted = [self.deleted copy];
+        NSURL *url = [self nextSegmentURL];
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+            __autoreleasing NSError *error = nil;
+            GRKSearchSegment *merged = [GRKSearchSegment segmentWithSources:sources deleted:deleted url:url error:&error];
+            dispatch_async(self.queue, ^{
+                self.merging = NO;
+                if (merged)
+                {
+                    //Only merges remove segments, so the sources are still together, with any newer segments after them
+                    NSUInteger index = [self.segments indexOfObjectIdenticalTo:[sources firstObject]];
+                    [self.segments replaceObjectsInRange:NSMakeRange(index, sources.count) withObjectsFromArray:merged.documentCount > 0 ? @[merged] : @[]];
+                    //The documents which were deleted when the merge began were dropped from it, so no longer need to be remembered
+                    for (GRKSearchSegment *source in sources)
+                    {
+                        for (NSUInteger i = 0; i < source.documentCount; ++i)
+                        {
+                            uint32_t document = source.documents[i].document;
+                            if ([deleted containsIndex:document])
+                            {
+                                [self.deleted removeIndex:document];
+                            }
+                        }
+                    }
+                    if (merged.documentCount == 0)
+                    {
+                        [[NSFileManager defaultManager] removeItemAtURL:merged.url error:nil];
+                    }
+                    __autoreleasing NSError *manifestError = nil;
+                    if ([self writeManifest:&manifestError])
+                    {
+                        for (GRKSearchSegment *source in sources)
+                        {
+                            [[NSFileManager defaultManager] removeItemAtURL:source.url error:nil];
+                        }
+                    }
+                    else
+                    {
+                        DDLogError(@"Unable to write search index manifest. Error: %@", manifestError);
+                    }
+                    [self mergeIfNeeded];
+                }
+                else
+                {
+                    DDLogError(@"Unable to merge search index segments. Error: %@", error);
+                }
+            });
+        });
+    }
+}
+
+@end
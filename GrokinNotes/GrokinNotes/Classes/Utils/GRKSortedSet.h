@@ -0,0 +1,174 @@
+//
+//  GRKSortedSet.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Derives the sort key of an object. The key must not change while the object is in the set, so it should be a snapshot (e.g. a copy of a string) rather than a live property.
+ */
+typedef id (^GRKSortedSetKeyBlock)(id object);
+
+/**
+ An immutable view of a GRKSortedSet as it was when the snapshot was taken, which is unaffected by later changes to the set.
+ Snapshots share their structure with the set, so taking one is O(1), and they are safe to read from any thread.
+ */
+@interface GRKSortedSetSnapshot : NSObject
+
+/**
+ The version of the set the snapshot was taken of. Later versions of the same set have greater numbers.
+ */
+@property (nonatomic,assign,readonly) uint64_t version;
+
+/**
+ The number of objects in the snapshot.
+ */
+@property (nonatomic,assign,readonly) NSUInteger count;
+
+/**
+ The object at an index, in O(log n) time. Raises an NSRangeException if the index is beyond the end of the snapshot.
+
+ @param index The index.
+
+ @return The object.
+ */
+- (id)objectAtIndex:(NSUInteger)index;
+
+/**
+ Calls the given block with each object in order, until the block sets `stop` to `YES`.
+
+ @param block The block to call with each object and its index.
+ */
+- (void)enumerateObjectsUsingBlock:(void (^)(id object, NSUInteger index, BOOL *stop))block;
+
+/**
+ All the objects in the snapshot, in order.
+
+ @return An NSArray of the objects.
+ */
+- (NSArray *)allObjects;
+
+@end
+
+/**
+ A collection of distinct objects kept in sorted order, which supports adding and removing objects, and finding objects by index and indexes by object, in O(log n) time.
+ Objects are ordered by a key taken from each object as it is added. Since the key is kept with the object, an object whose sort properties change while it is in the set can still be found and removed, after which it can be added again under its new key (see `keyHasChangedForObject:`). Objects with equal keys are ordered by identity, so every object has a distinct position.
+ The tree is persistent: a change copies only the O(log n) nodes on the path to it, and shares the rest with earlier versions, so snapshots of any version can be handed out cheaply (see `snapshot`).
+ Objects are compared by identity rather than with `isEqual:`. A GRKSortedSet is not thread safe, but its snapshots are.
+ */
+@interface GRKSortedSet : NSObject
+
+/**
+ The number of objects in the set.
+ */
+@property (nonatomic,assign,readonly) NSUInteger count;
+
+/**
+ The version of the set, which increases with every change.
+ */
+@property (nonatomic,assign,readonly) uint64_t version;
+
+/**
+ Creates an empty sorted set.
+
+ @param keyBlock   Derives the sort key of an object.
+ @param comparator Compares two sort keys.
+
+ @return A new, empty, sorted set.
+ */
+- (instancetype)initWithKeyBlock:(GRKSortedSetKeyBlock)keyBlock comparator:(NSComparator)comparator;
+
+/**
+ Adds an object to the set.
+
+ @param object The object to add.
+
+ @return The index at which the object was placed, or `NSNotFound` if the object was already in the set (in which case it is left where it is).
+ */
+- (NSUInteger)addObject:(id)object;
+
+/**
+ Removes an object from the set.
+
+ @param object The object to remove.
+
+ @return The index the object had, or `NSNotFound` if the object was not in the set.
+ */
+- (NSUInteger)removeObject:(id)object;
+
+/**
+ Replaces the contents of the set with the given objects, in O(n log n) time.
+
+ @param objects An NSArray of distinct objects.
+ */
+- (void)setObjects:(NSArray *)objects;
+
+/**
+ Removes all objects from the set.
+ */
+- (void)removeAllObjects;
+
+/**
+ Determines if an object is in the set.
+
+ @param object The object.
+
+ @return `YES` if the object is in the set.
+ */
+- (BOOL)containsObject:(id)object;
+
+/**
+ The index of an object.
+
+ @param object The object.
+
+ @return The index of the object, or `NSNotFound` if the object is not in the set.
+ */
+- (NSUInteger)indexOfObject:(id)object;
+
+/**
+ The object at an index. Raises an NSRangeException if the index is beyond the end of the set.
+
+ @param index The index.
+
+ @return The object.
+ */
+- (id)objectAtIndex:(NSUInteger)index;
+
+/**
+ Determines if the sort key of an object in the set differs from the key the object would have if it were added now, in which case it should be removed and added again to take its new position.
+
+ @param object An object in the set.
+
+ @return `YES` if the key of the object has changed, or `NO` if it has not or the object is not in the set.
+ */
+- (BOOL)keyHasChangedForObject:(id)object;
+
+/**
+ All the objects in the set, in order.
+
+ @return An NSArray of the objects.
+ */
+- (NSArray *)allObjects;
+
+/**
+ An immutable snapshot of the current version of the set, in O(1) time. The same snapshot is returned until the set changes.
+
+ @return The snapshot.
+ */
+- (GRKSortedSetSnapshot *)snapshot;
+
+@end
@@ -0,0 +1,531 @@
+//
+//  GRKSortedSet.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKSortedSet.h"
+
+/**
+ A node of the AVL tree which holds the objects of a GRKSortedSet, which also tracks the size of its subtree so objects can be found by index.
+ Nodes are never changed once they are part of a tree, since they may be shared by snapshots. Changes are made to copies of the nodes along the path to the change.
+ */
+@interface GRKSortedSetNode : NSObject
+{
+@public
+    id _object;
+    id _key;
+    GRKSortedSetNode *_left;
+    GRKSortedSetNode *_right;
+    //The number of nodes in this subtree
+    NSUInteger _count;
+    NSInteger _height;
+}
+
+@end
+
+@implementation GRKSortedSetNode
+
+@end
+
+static inline NSUInteger GRKSortedSetNodeCount(GRKSortedSetNode *node)
+{
+    return node ? node->_count : 0;
+}
+
+static inline NSInteger GRKSortedSetNodeHeight(GRKSortedSetNode *node)
+{
+    return node ? node->_height : 0;
+}
+
+static inline void GRKSortedSetNodeUpdate(GRKSortedSetNode *node)
+{
+    node->_count = 1 + GRKSortedSetNodeCount(node->_left) + GRKSortedSetNodeCount(node->_right);
+    node->_height = 1 + MAX(GRKSortedSetNodeHeight(node->_left), GRKSortedSetNodeHeight(node->_right));
+}
+
+static GRKSortedSetNode *GRKSortedSetNodeCopy(GRKSortedSetNode *node)
+{
+    GRKSortedSetNode *retVal = [[GRKSortedSetNode alloc] init];
+    retVal->_object = node->_object;
+    retVal->_key = node->_key;
+    retVal->_left = node->_left;
+    retVal->_right = node->_right;
+    retVal->_count = node->_count;
+    retVal->_height = node->_height;
+    return retVal;
+}
+
+/**
+ Rotates a subtree whose root is a new node, copying the child which takes its place.
+ */
+static GRKSortedSetNode *GRKSortedSetNodeRotateRight(GRKSortedSetNode *node)
+{
+    GRKSortedSetNode *retVal = GRKSortedSetNodeCopy(node->_left);
+    node->_left = retVal->_right;
+    retVal->_right = node;
+    GRKSortedSetNodeUpdate(node);
+    GRKSortedSetNodeUpdate(retVal);
+    return retVal;
+}
+
+static GRKSortedSetNode *GRKSortedSetNodeRotateLeft(GRKSortedSetNode *node)
+{
+    GRKSortedSetNode *retVal = GRKSortedSetNodeCopy(node->_right);
+    node->_right = retVal->_left;
+    retVal->_left = node;
+    GRKSortedSetNodeUpdate(node);
+    GRKSortedSetNodeUpdate(retVal);
+    return retVal;
+}
+
+/**
+ Restores the balance of a subtree, whose root is a new node and whose children differ in height by at most two, and brings its count and height up to date.
+ */
+static GRKSortedSetNode *GRKSortedSetNodeBalance(GRKSortedSetNode *node)
+{
+    GRKSortedSetNode *retVal = node;
+    GRKSortedSetNodeUpdate(node);
+    NSInteger balance = GRKSortedSetNodeHeight(node->_left) - GRKSortedSetNodeHeight(node->_right);
+    if (balance > 1)
+    {
+        if (GRKSortedSetNodeHeight(node->_left->_left) < GRKSortedSetNodeHeight(node->_left->_right))
+        {
+            node->_left = GRKSortedSetNodeRotateLeft(GRKSortedSetNodeCopy(node->_left));
+        }
+        retVal = GRKSortedSetNodeRotateRight(node);
+    }
+    else if (balance < -1)
+    {
+        if (GRKSortedSetNodeHeight(node->_right->_right) < GRKSortedSetNodeHeight(node->_right->_left))
+        {
+            node->_right = GRKSortedSetNodeRotateRight(GRKSortedSetNodeCopy(node->_right));
+        }
+        retVal = GRKSortedSetNodeRotateLeft(node);
+    }
+    return retVal;
+}
+
+/**
+ Compares an object and its key to another, ordering objects with equal keys by identity.
+ */
+static inline NSComparisonResult GRKSortedSetCompare(NSComparator comparator, id key1, id object1, id key2, id object2)
+{
+    NSComparisonResult retVal = comparator(key1, key2);
+    if (retVal == NSOrderedSame && object1 != object2)
+    {
+        retVal = (uintptr_t)(__bridge void *)object1 < (uintptr_t)(__bridge void *)object2 ? NSOrderedAscending : NSOrderedDescending;
+    }
+    return retVal;
+}
+
+/**
+ Inserts a new node into a subtree, adding the number of nodes which precede it in the subtree to `index`.
+ */
+static GRKSortedSetNode *GRKSortedSetNodeInsert(GRKSortedSetNode *node, GRKSortedSetNode *newNode, NSComparator comparator, NSUInteger *index)
+{
+    GRKSortedSetNode *retVal = newNode;
+    if (node)
+    {
+        node = GRKSortedSetNodeCopy(node);
+        if (GRKSortedSetCompare(comparator, newNode->_key, newNode->_object, node->_key, node->_object) == NSOrderedAscending)
+        {
+            node->_left = GRKSortedSetNodeInsert(node->_left, newNode, comparator, index);
+        }
+        else
+        {
+            *index += GRKSortedSetNodeCount(node->_left) + 1;
+            node->_right = GRKSortedSetNodeInsert(node->_right, newNode, comparator, index);
+        }
+        retVal = GRKSortedSetNodeBalance(node);
+    }
+    return retVal;
+}
+
+/**
+ Removes the leftmost node of a subtree, handing a copy of it back through `minimum`.
+ */
+static GRKSortedSetNode *GRKSortedSetNodeRemoveMinimum(GRKSortedSetNode *node, GRKSortedSetNode * __strong *minimum)
+{
+    GRKSortedSetNode *retVal = nil;
+    if (node->_left)
+    {
+        node = GRKSortedSetNodeCopy(node);
+        node->_left = GRKSortedSetNodeRemoveMinimum(node->_left, minimum);
+        retVal = GRKSortedSetNodeBalance(node);
+    }
+    else
+    {
+        *minimum = GRKSortedSetNodeCopy(node);
+        retVal = node->_right;
+    }
+    return retVal;
+}
+
+/**
+ Removes the node holding the given object and key, which must be in the subtree, adding the number of nodes which preceded it in the subtree to `index`.
+ */
+static GRKSortedSetNode *GRKSortedSetNodeRemove(GRKSortedSetNode *node, id key, id object, NSComparator comparator, NSUInteger *index)
+{
+    GRKSortedSetNode *retVal = nil;
+    if (node)
+    {
+        NSComparisonResult order = GRKSortedSetCompare(comparator, key, object, node->_key, node->_object);
+        if (order == NSOrderedAscending)
+        {
+            node = GRKSortedSetNodeCopy(node);
+            node->_left = GRKSortedSetNodeRemove(node->_left, key, object, comparator, index);
+            retVal = GRKSortedSetNodeBalance(node);
+        }
+        else if (order == NSOrderedDescending)
+        {
+            *index += GRKSortedSetNodeCount(node->_left) + 1;
+            node = GRKSortedSetNodeCopy(node);
+            node->_right = GRKSortedSetNodeRemove(node->_right, key, object, comparator, index);
+            retVal = GRKSortedSetNodeBalance(node);
+        }
+        else
+        {
+            *index += GRKSortedSetNodeCount(node->_left);
+            if (!node->_left)
+            {
+                retVal = node->_right;
+            }
+            else if (!node->_right)
+            {
+                retVal = node->_left;
+            }
+            else
+            {
+                //Take the place of the node with its successor
+                GRKSortedSetNode *successor = nil;
+                GRKSortedSetNode *right = GRKSortedSetNodeRemoveMinimum(node->_right, &successor);
+                successor->_left = node->_left;
+                successor->_right = right;
+                retVal = GRKSortedSetNodeBalance(successor);
+            }
+        }
+    }
+    return retVal;
+}
+
+/**
+ Builds a balanced subtree of the nodes in the range [lo, hi) of a sorted array of new nodes.
+ */
+static GRKSortedSetNode *GRKSortedSetNodeBuild(NSArray *nodes, NSUInteger lo, NSUInteger hi)
+{
+    GRKSortedSetNode *retVal = nil;
+    if (lo < hi)
+    {
+        NSUInteger middle = lo + (hi - lo) / 2;
+        retVal = [nodes objectAtIndex:middle];
+        retVal->_left = GRKSortedSetNodeBuild(nodes, lo, middle);
+        retVal->_right = GRKSortedSetNodeBuild(nodes, middle + 1, hi);
+        GRKSortedSetNodeUpdate(retVal);
+    }
+    return retVal;
+}
+
+static id GRKSortedSetNodeObjectAtIndex(GRKSortedSetNode *node, NSUInteger index)
+{
+    id retVal = nil;
+    while (!retVal)
+    {
+        NSUInteger leftCount = GRKSortedSetNodeCount(node->_left);
+        if (index < leftCount)
+        {
+            node = node->_left;
+        }
+        else if (index == leftCount)
+        {
+            retVal = node->_object;
+        }
+        else
+        {
+            index -= leftCount + 1;
+            node = node->_right;
+        }
+    }
+    return retVal;
+}
+
+/**
+ Calls the block for each object of a subtree in order, starting from `*index`, until the block sets `*stop`.
+ */
+static void GRKSortedSetNodeEnumerate(GRKSortedSetNode *node, NSUInteger *index, BOOL *stop, void (^block)(id object, NSUInteger index, BOOL *stop))
+{
+    if (node && !*stop)
+    {
+        GRKSortedSetNodeEnumerate(node->_left, index, stop, block);
+        if (!*stop)
+        {
+            block(node->_object, *index, stop);
+            *index += 1;
+            GRKSortedSetNodeEnumerate(node->_right, index, stop, block);
+        }
+    }
+}
+
+static void GRKSortedSetNodeCollect(GRKSortedSetNode *node, NSMutableArray *objects)
+{
+    if (node)
+    {
+        GRKSortedSetNodeCollect(node->_left, objects);
+        [objects addObject:node->_object];
+        GRKSortedSetNodeCollect(node->_right, objects);
+    }
+}
+
+static void GRKSortedSetRaiseRangeException(id collection, NSUInteger index, NSUInteger count)
+{
+    [NSException raise:NSRangeException format:@"Index %lu beyond bounds of %@ with %lu objects", (unsigned long)index, NSStringFromClass([collection class]), (unsigned long)count];
+}
+
+#pragma mark - GRKSortedSetSnapshot
+
+@interface GRKSortedSetSnapshot ()
+
+@property (nonatomic,strong) GRKSortedSetNode *root;
+@property (nonatomic,assign,readwrite) uint64_t version;
+
+@end
+
+@implementation GRKSortedSetSnapshot
+
+- (NSUInteger)count
+{
+    return GRKSortedSetNodeCount(self.root);
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= self.count)
+    {
+        GRKSortedSetRaiseRangeException(self, index, self.count);
+    }
+    return GRKSortedSetNodeObjectAtIndex(self.root, index);
+}
+
+- (void)enumerateObjectsUsingBlock:(void (^)(id object, NSUInteger index, BOOL *stop))block
+{
+    NSUInteger index = 0;
+    BOOL stop = NO;
+    GRKSortedSetNodeEnumerate(self.root, &index, &stop, block);
+}
+
+- (NSArray *)allObjects
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:self.count];
+    GRKSortedSetNodeCollect(self.root, retVal);
+    return retVal;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> version: %llu count: %lu", NSStringFromClass(self.class), self, self.version, (unsigned long)self.count];
+}
+
+@end
+
+#pragma mark - GRKSortedSet
+
+@interface GRKSortedSet ()
+
+@property (nonatomic,copy) GRKSortedSetKeyBlock keyBlock;
+@property (nonatomic,copy) NSComparator comparator;
+@property (nonatomic,strong) GRKSortedSetNode *root;
+//Maps each object (by identity) to the key it was added with
+@property (nonatomic,strong) NSMapTable *keys;
+@property (nonatomic,assign,readwrite) uint64_t version;
+//The snapshot of the current version, once one has been taken
+@property (nonatomic,strong) GRKSortedSetSnapshot *currentSnapshot;
+
+@end
+
+@implementation GRKSortedSet
+
+#pragma mark - Initialization
+
+- (instancetype)initWithKeyBlock:(GRKSortedSetKeyBlock)keyBlock comparator:(NSComparator)comparator
+{
+    if ((self = [super init]))
+    {
+        self.keyBlock = keyBlock;
+        self.comparator = comparator;
+        self.keys = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory capacity:0];
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (NSUInteger)addObject:(id)object
+{
+    NSUInteger retVal = NSNotFound;
+
+    if (![self.keys objectForKey:object])
+    {
+        GRKSortedSetNode *node = [[GRKSortedSetNode alloc] init];
+        node->_object = object;
+        node->_key = self.keyBlock(object) ?: [NSNull null];
+        node->_count = 1;
+        node->_height = 1;
+        [self.keys setObject:node->_key forKey:object];
+
+        retVal = 0;
+        self.root = GRKSortedSetNodeInsert(self.root, node, self.comparator, &retVal);
+    }
+
+    return retVal;
+}
+
+- (NSUInteger)removeObject:(id)object
+{
+    NSUInteger retVal = NSNotFound;
+
+    id key = [self.keys objectForKey:object];
+    if (key)
+    {
+        retVal = 0;
+        self.root = GRKSortedSetNodeRemove(self.root, key, object, self.comparator, &retVal);
+        [self.keys removeObjectForKey:object];
+    }
+
+    return retVal;
+}
+
+- (void)setObjects:(NSArray *)objects
+{
+    [self.keys removeAllObjects];
+
+    NSMutableArray *nodes = [NSMutableArray arrayWithCapacity:objects.count];
+    for (id object in objects)
+    {
+        GRKSortedSetNode *node = [[GRKSortedSetNode alloc] init];
+        node->_object = object;
+        node->_key = self.keyBlock(object) ?: [NSNull null];
+        [self.keys setObject:node->_key forKey:object];
+        [nodes addObject:node];
+    }
+
+    NSComparator comparator = self.comparator;
+    [nodes sortUsingComparator:^NSComparisonResult(GRKSortedSetNode *node1, GRKSortedSetNode *node2) {
+        return GRKSortedSetCompare(comparator, node1->_key, node1->_object, node2->_key, node2->_object);
+    }];
+
+    self.root = GRKSortedSetNodeBuild(nodes, 0, nodes.count);
+}
+
+- (void)removeAllObjects
+{
+    [self.keys removeAllObjects];
+    self.root = nil;
+}
+
+- (BOOL)containsObject:(id)object
+{
+    return [self.keys objectForKey:object] != nil;
+}
+
+- (NSUInteger)indexOfObject:(id)object
+{
+    NSUInteger retVal = NSNotFound;
+
+    id key = [self.keys objectForKey:object];
+    if (key)
+    {
+        NSUInteger index = 0;
+        GRKSortedSetNode *node = self.root;
+        while (node && retVal == NSNotFound)
+        {
+            NSComparisonResult order = GRKSortedSetCompare(self.comparator, key, object, node->_key, node->_object);
+            if (order == NSOrderedAscending)
+            {
+                node = node->_left;
+            }
+            else if (order == NSOrderedDescending)
+            {
+                index += GRKSortedSetNodeCount(node->_left) + 1;
+                node = node->_right;
+            }
+            else
+            {
+                retVal = index + GRKSortedSetNodeCount(node->_left);
+            }
+        }
+    }
+
+    return retVal;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= self.count)
+    {
+        GRKSortedSetRaiseRangeException(self, index, self.count);
+    }
+    return GRKSortedSetNodeObjectAtIndex(self.root, index);
+}
+
+- (BOOL)keyHasChangedForObject:(id)object
+{
+    BOOL retVal = NO;
+
+    id key = [self.keys objectForKey:object];
+    if (key)
+    {
+        id currentKey = self.keyBlock(object) ?: [NSNull null];
+        retVal = self.comparator(key, currentKey) != NSOrderedSame;
+    }
+
+    return retVal;
+}
+
+- (NSArray *)allObjects
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:self.count];
+    GRKSortedSetNodeCollect(self.root, retVal);
+    return retVal;
+}
+
+- (GRKSortedSetSnapshot *)snapshot
+{
+    if (!self.currentSnapshot)
+    {
+        GRKSortedSetSnapshot *snapshot = [[GRKSortedSetSnapshot alloc] init];
+        snapshot.root = self.root;
+        snapshot.version = self.version;
+        self.currentSnapshot = snapshot;
+    }
+
+    return self.currentSnapshot;
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)count
+{
+    return GRKSortedSetNodeCount(self.root);
+}
+
+- (void)setRoot:(GRKSortedSetNode *)root
+{
+    //Every change makes a new version, whose nodes are not shared with earlier snapshots other than those left untouched
+    _root = root;
+    self.version += 1;
+    self.currentSnapshot = nil;
+}
+
+@end
@@ -0,0 +1,119 @@
+//
+//  GRKTrigramIndex.h
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import <Foundation/Foundation.h>
+
+extern NSString * const GRKTrigramIndexErrorDomain;
+
+typedef NS_ENUM(NSInteger, GRKTrigramIndexError) {
+    GRKTrigramIndexErrorBadFormat = 1,
+    GRKTrigramIndexErrorBadVersion
+};
+
+/**
+ An index of documents, identified by strings, which finds the documents containing the query as a substring, or containing a close match of it (a few typing errors away).
+ Text is folded to ignore case and diacritics, and split into trigrams: each run of three bytes of its UTF-8 encoding. Each trigram maps to a compressed bitmap of the documents containing it, in the manner of Roaring bitmaps; document numbers are partitioned by their upper 16 bits into containers, which hold the lower 16 bits as a sorted array while sparse, and as a bitmap once dense.
+ The documents sharing enough trigrams with the query are then verified against their text: a word parallel scan finds exact matches, and the bit parallel algorithm of Myers finds approximate ones.
+ The folded text and the distinct trigrams of each document are persisted to a single file, which is memory mapped when loaded or saved, so the text is read from the file (only as far as queries touch it) rather than held in memory. The bitmaps are rebuilt from the trigrams as the index is loaded. Each document carries a signature (e.g. a checksum of its content) with which the caller can find documents needing to be indexed again, as changes since the last `save:` are lost.
+ All methods are safe to call from any queue. Changes are applied asynchronously, in the order they are made, and are reflected by any query made after they are made.
+ */
+@interface GRKTrigramIndex : NSObject
+
+/**
+ The file URL where the index is persisted, or `nil` if it is held only in memory.
+ */
+@property (nonatomic,readonly) NSURL *url;
+
+/**
+ The number of documents in the index.
+ */
+@property (nonatomic,assign,readonly) NSUInteger documentCount;
+
+/**
+ Creates an empty index persisted at the given location.
+
+ @param url The file URL where the index will be persisted, or `nil` to hold the index only in memory.
+
+ @return A new, empty, index. Use `load:` to read existing content.
+ */
+- (instancetype)initWithURL:(NSURL *)url;
+
+/**
+ Indexes the given text as the content of a document, replacing any previous content of the document. Only the trigrams which differ from the previous content are updated, so small edits are cheap.
+ The folded text of a document is held in memory until the index is saved.
+
+ @param text       The text of the document.
+ @param signature  Identifies the version of the text, as returned by `signatureForIdentifier:`. Can be nil.
+ @param identifier The identifier of the document.
+ */
+- (void)setText:(NSString *)text signature:(NSString *)signature forIdentifier:(NSString *)identifier;
+
+/**
+ Removes a document from the index.
+
+ @param identifier The identifier of the document.
+ */
+- (void)removeIdentifier:(NSString *)identifier;
+
+/**
+ The signature given when a document was last indexed.
+
+ @param identifier The identifier of the document.
+
+ @return The signature, or `nil` if the document is not indexed (or was indexed without a signature).
+ */
+- (NSString *)signatureForIdentifier:(NSString *)identifier;
+
+/**
+ The identifiers of all indexed documents.
+
+ @return An NSSet of NSString identifiers.
+ */
+- (NSSet *)allIdentifiers;
+
+/**
+ Finds the documents containing the query, or a close match of it, best match first. Matches with fewer errors come first, then matches found earlier in the text.
+ An error is an inserted, deleted or substituted byte (of the folded UTF-8 text). One error is tolerated for every four bytes of the query, up to `maximumErrors`, while the query is long enough for its trigrams to narrow the search (and no longer than 64 bytes). Shorter queries, and longer ones, must match exactly.
+
+ @param query         The query.
+ @param maximumErrors The most errors to tolerate in a match.
+ @param limit         The maximum number of documents to return.
+
+ @return An NSArray of the NSString identifiers of the matching documents.
+ */
+- (NSArray *)identifiersMatchingQuery:(NSString *)query maximumErrors:(NSUInteger)maximumErrors limit:(NSUInteger)limit;
+
+/**
+ Loads the persisted index, replacing the current content.
+ A missing index file is not considered an error.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)load:(__autoreleasing NSError **)error;
+
+/**
+ Atomically persists the index. The text of the documents is then read from the file written, rather than held in memory.
+
+ @param error A handle to an NSError object to recieve any error resulting from the operation. Can be nil.
+
+ @return A boolean indicating if the operation was successful or not.
+ */
+- (BOOL)save:(__autoreleasing NSError **)error;
+
+@end
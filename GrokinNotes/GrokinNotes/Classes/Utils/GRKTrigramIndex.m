@@ -0,0 +1,1066 @@
+//
+//  GRKTrigramIndex.m
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown <mailto:levigroker@gmail.com>
+//  This work is licensed under the Creative Commons Attribution 3.0
+//  Unported License. To view a copy of this license, visit
+//  http://creativecommons.org/licenses/by/3.0/ or send a letter to Creative
+//  Commons, 444 Castro Street, Suite 900, Mountain View, California, 94041,
+//  USA.
+//
+//  The above attribution and the included license must accompany any version
+//  of the source code. Visible attribution in any binary distributable
+//  including this work (or derivatives) is not required, but would be
+//  appreciated.
+//
+
+#import "GRKTrigramIndex.h"
+#include <libkern/OSByteOrder.h>
+
+NSString * const GRKTrigramIndexErrorDomain = @"GRKTrigramIndexErrorDomain";
+
+static uint32_t const kTrigramIndexMagic = 0x47544B47; // "GKTG"
+static uint32_t const kTrigramIndexVersion = 1;
+
+//An array container holding this many values becomes a bitmap container when one more is added, as the bitmap is then the smaller of the two
+static uint32_t const kTrigramArrayContainerMaximum = 4096;
+//A bitmap container holding fewer values than this becomes an array container again (lower than the maximum, so containers at the boundary do not change form on every change)
+static uint32_t const kTrigramBitmapContainerMinimum = 2048;
+//The number of 64 bit words of a bitmap container
+static NSUInteger const kTrigramBitmapWords = 1024;
+//Longer queries must match exactly, as the approximate matcher holds the query in a single 64 bit word
+static NSUInteger const kTrigramMaximumApproximateLength = 64;
+//One error is tolerated for every this many bytes of a query
+static NSUInteger const kTrigramBytesPerError = 4;
+
+/**
+ The values of a GRKTrigramBitmap which share the same upper 16 bits (the key). The lower 16 bits of the values are held either in `values`, a sorted array of `capacity`, or in `words`, a bitmap of `kTrigramBitmapWords`.
+ */
+typedef struct {
+    uint16_t key;
+    uint32_t cardinality;
+    uint32_t capacity;
+    uint16_t *values;
+    uint64_t *words;
+} GRKTrigramContainer;
+
+/**
+ The index file layout is: header | documents | data, where the data holds the trigrams of every document (as uint32_t values, first so they stay aligned), then the folded text, identifier and signature of every document. Offsets are from the start of the data.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t documentCount;
+    uint32_t dataLength;
+} GRKTrigramIndexHeader;
+
+typedef struct {
+    uint32_t trigramsOffset;
+    uint32_t trigramCount;
+    uint32_t textOffset;
+    uint32_t textLength;
+    uint32_t identifierOffset;
+    uint32_t identifierLength;
+    uint32_t signatureOffset;
+    uint32_t signatureLength;
+} GRKTrigramIndexRecord;
+
+//A match of a query in a document
+typedef struct {
+    NSUInteger errors;
+    //The offset of the end of the match in the folded text
+    NSUInteger end;
+    uint32_t document;
+} GRKTrigramHit;
+
+#pragma mark - Helpers
+
+static NSError *GRKTrigramIndexMakeError(GRKTrigramIndexError code, NSString *message)
+{
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithCapacity:1];
+    [userInfo setObject:message forKey:NSLocalizedDescriptionKey];
+    return [NSError errorWithDomain:GRKTrigramIndexErrorDomain code:code userInfo:userInfo];
+}
+
+//The index of the given value in a sorted array of values, or of where it would be inserted
+static uint32_t GRKTrigramArrayIndex(const uint16_t *values, uint32_t count, uint16_t value)
+{
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (values[middle] < value)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static BOOL GRKTrigramContainerContains(const GRKTrigramContainer *container, uint16_t value)
+{
+    BOOL retVal = NO;
+    if (container->words)
+    {
+        retVal = (container->words[value >> 6] >> (value & 63)) & 1;
+    }
+    else
+    {
+        uint32_t index = GRKTrigramArrayIndex(container->values, container->cardinality, value);
+        retVal = index < container->cardinality && container->values[index] == value;
+    }
+    return retVal;
+}
+
+static void GRKTrigramContainerAdd(GRKTrigramContainer *container, uint16_t value)
+{
+    if (container->words)
+    {
+        uint64_t bit = 1ULL << (value & 63);
+        if (!(container->words[value >> 6] & bit))
+        {
+            container->words[value >> 6] |= bit;
+            container->cardinality += 1;
+        }
+    }
+    else
+    {
+        uint32_t index = GRKTrigramArrayIndex(container->values, container->cardinality, value);
+        if (index == container->cardinality || container->values[index] != value)
+        {
+            if (container->cardinality == kTrigramArrayContainerMaximum)
+            {
+                //Dense enough to be held as a bitmap
+                uint64_t *words = calloc(kTrigramBitmapWords, sizeof(uint64_t));
+                for (uint32_t i = 0; i < container->cardinality; ++i)
+                {
+                    words[container->values[i] >> 6] |= 1ULL << (container->values[i] & 63);
+                }
+                words[value >> 6] |= 1ULL << (value & 63);
+                free(container->values);
+                container->values = NULL;
+                container->capacity = 0;
+                container->words = words;
+            }
+            else
+            {
+                if (container->cardinality == container->capacity)
+                {
+                    container->capacity = MIN(MAX(container->capacity * 2, 4), kTrigramArrayContainerMaximum);
+                    container->values = realloc(container->values, container->capacity * sizeof(uint16_t));
+                }
+                memmove(&container->values[index + 1], &container->values[index], (container->cardinality - index) * sizeof(uint16_t));
+                container->values[index] = value;
+            }
+            container->cardinality += 1;
+        }
+    }
+}
+
+static void GRKTrigramContainerRemove(GRKTrigramContainer *container, uint16_t value)
+{
+    if (container->words)
+    {
+        uint64_t bit = 1ULL << (value & 63);
+        if (container->words[value >> 6] & bit)
+        {
+            container->words[value >> 6] &= ~bit;
+            container->cardinality -= 1;
+
+            if (container->cardinality < kTrigramBitmapContainerMinimum)
+            {
+                //Sparse enough to be held as an array
+                container->capacity = MAX(container->cardinality, 4);
+                container->values = malloc(container->capacity * sizeof(uint16_t));
+                uint32_t count = 0;
+                for (NSUInteger i = 0; i < kTrigramBitmapWords; ++i)
+                {
+                    uint64_t word = container->words[i];
+                    while (word)
+                    {
+                        container->values[count++] = (uint16_t)((i << 6) | (NSUInteger)__builtin_ctzll(word));
+                        word &= word - 1;
+                    }
+                }
+                free(container->words);
+                container->words = NULL;
+            }
+        }
+    }
+    else
+    {
+        uint32_t index = GRKTrigramArrayIndex(container->values, container->cardinality, value);
+        if (index < container->cardinality && container->values[index] == value)
+        {
+            memmove(&container->values[index], &container->values[index + 1], (container->cardinality - index - 1) * sizeof(uint16_t));
+            container->cardinality -= 1;
+        }
+    }
+}
+
+/**
+ Calls the block with each value of the container, in ascending order.
+ */
+static inline void GRKTrigramContainerEnumerate(const GRKTrigramContainer *container, void (^block)(uint32_t value))
+{
+    uint32_t high = (uint32_t)container->key << 16;
+    if (container->words)
+    {
+        for (NSUInteger i = 0; i < kTrigramBitmapWords; ++i)
+        {
+            uint64_t word = container->words[i];
+            while (word)
+            {
+                block(high | (uint32_t)((i << 6) | (NSUInteger)__builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < container->cardinality; ++i)
+        {
+            block(high | container->values[i]);
+        }
+    }
+}
+
+/**
+ Finds the first occurrence of a pattern in a text. Positions are tested eight at a time, by comparing the first and last bytes of the pattern with a 64 bit word of the text at each end (a portable form of the SIMD search of Muła), and only the positions flagged are compared in full.
+
+ @return The offset of the occurrence, or NSNotFound.
+ */
+static NSUInteger GRKTrigramFind(const uint8_t *text, NSUInteger textLength, const uint8_t *pattern, NSUInteger patternLength)
+{
+    NSUInteger retVal = NSNotFound;
+    if (patternLength == 1)
+    {
+        const uint8_t *found = memchr(text, pattern[0], textLength);
+        retVal = found ? (NSUInteger)(found - text) : NSNotFound;
+    }
+    else if (patternLength > 1 && patternLength <= textLength)
+    {
+        uint64_t const ones = 0x0101010101010101ULL;
+        uint64_t const highs = 0x8080808080808080ULL;
+        uint64_t first = ones * pattern[0];
+        uint64_t last = ones * pattern[patternLength - 1];
+        NSUInteger lastPosition = textLength - patternLength;
+        NSUInteger position = 0;
+        while (retVal == NSNotFound && position + 8 <= lastPosition + 1)
+        {
+            //A zero byte wherever both the first and the last byte match
+            uint64_t difference = (OSReadLittleInt64(text, position) ^ first) | (OSReadLittleInt64(text, position + patternLength - 1) ^ last);
+            //Flags every zero byte, and possibly some bytes following one, which the comparison rules out
+            uint64_t candidates = (difference - ones) & ~difference & highs;
+            while (candidates && retVal == NSNotFound)
+            {
+                NSUInteger candidate = position + ((NSUInteger)__builtin_ctzll(candidates) >> 3);
+                if (memcmp(text + candidate, pattern, patternLength) == 0)
+                {
+                    retVal = candidate;
+                }
+                candidates &= candidates - 1;
+            }
+            position += 8;
+        }
+        while (retVal == NSNotFound && position <= lastPosition)
+        {
+            if (text[position] == pattern[0] && memcmp(text + position + 1, pattern + 1, patternLength - 1) == 0)
+            {
+                retVal = position;
+            }
+            ++position;
+        }
+    }
+    return retVal;
+}
+
+/**
+ Finds the closest match of a pattern of at most 64 bytes in a text, with the bit parallel algorithm of Myers ("A fast bit-vector algorithm for approximate string matching based on dynamic programming", 1999), which advances a whole column of the edit distance matrix with a few word operations for each byte of the text.
+
+ @param end Set to the offset of the end of the match.
+
+ @return The number of errors (inserted, deleted or substituted bytes) of the match. The search stops at the first exact match.
+ */
+static NSUInteger GRKTrigramApproximateFind(const uint8_t *text, NSUInteger textLength, const uint8_t *pattern, NSUInteger patternLength, NSUInteger *end)
+{
+    uint64_t equal[256];
+    memset(equal, 0, sizeof(equal));
+    for (NSUInteger i = 0; i < patternLength; ++i)
+    {
+        equal[pattern[i]] |= 1ULL << i;
+    }
+
+    uint64_t high = 1ULL << (patternLength - 1);
+    uint64_t positive = ~0ULL;
+    uint64_t negative = 0;
+    NSUInteger score = patternLength;
+    NSUInteger retVal = patternLength;
+    *end = 0;
+    for (NSUInteger i = 0; i < textLength && retVal > 0; ++i)
+    {
+        uint64_t eq = equal[text[i]];
+        uint64_t xv = eq | negative;
+        uint64_t xh = (((eq & positive) + positive) ^ positive) | eq;
+        uint64_t horizontalPositive = negative | ~(xh | positive);
+        uint64_t horizontalNegative = positive & xh;
+        if (horizontalPositive & high)
+        {
+            ++score;
+        }
+        else if (horizontalNegative & high)
+        {
+            --score;
+        }
+        //A match may begin anywhere in the text, so nothing is shifted in
+        horizontalPositive <<= 1;
+        horizontalNegative <<= 1;
+        positive = horizontalNegative | ~(xv | horizontalPositive);
+        negative = horizontalPositive & xv;
+
+        if (score < retVal)
+        {
+            retVal = score;
+            *end = i + 1;
+        }
+    }
+    return retVal;
+}
+
+#pragma mark - GRKTrigramBitmap
+
+/**
+ A compressed set of 32 bit values, in the manner of a Roaring bitmap.
+ */
+@interface GRKTrigramBitmap : NSObject
+{
+@public
+    //Sorted by key
+    GRKTrigramContainer *_containers;
+    NSUInteger _count;
+    NSUInteger _capacity;
+    NSUInteger _cardinality;
+}
+
+- (void)addValue:(uint32_t)value;
+- (void)removeValue:(uint32_t)value;
+- (BOOL)containsValue:(uint32_t)value;
+- (void)enumerateValuesUsingBlock:(void (^)(uint32_t value))block;
+
+@end
+
+@implementation GRKTrigramBitmap
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < _count; ++i)
+    {
+        free(_containers[i].values);
+        free(_containers[i].words);
+    }
+    free(_containers);
+}
+
+//The index of the container with the given key, or of where it would be inserted
+- (NSUInteger)indexOfContainerWithKey:(uint16_t)key
+{
+    NSUInteger low = 0;
+    NSUInteger high = _count;
+    while (low < high)
+    {
+        NSUInteger middle = low + (high - low) / 2;
+        if (_containers[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+- (void)addValue:(uint32_t)value
+{
+    uint16_t key = (uint16_t)(value >> 16);
+    NSUInteger index = [self indexOfContainerWithKey:key];
+    if (index == _count || _containers[index].key != key)
+    {
+        if (_count == _capacity)
+        {
+            _capacity = MAX(_capacity * 2, 1);
+            _containers = realloc(_containers, _capacity * sizeof(GRKTrigramContainer));
+        }
+        memmove(&_containers[index + 1], &_containers[index], (_count - index) * sizeof(GRKTrigramContainer));
+        memset(&_containers[index], 0, sizeof(GRKTrigramContainer));
+        _containers[index].key = key;
+        _count += 1;
+    }
+
+    GRKTrigramContainer *container = &_containers[index];
+    uint32_t cardinality = container->cardinality;
+    GRKTrigramContainerAdd(container, (uint16_t)value);
+    _cardinality += container->cardinality - cardinality;
+}
+
+- (void)removeValue:(uint32_t)value
+{
+    uint16_t key = (uint16_t)(value >> 16);
+    NSUInteger index = [self indexOfContainerWithKey:key];
+    if (index < _count && _containers[index].key == key)
+    {
+        GRKTrigramContainer *container = &_containers[index];
+        uint32_t cardinality = container->cardinality;
+        GRKTrigramContainerRemove(container, (uint16_t)value);
+        _cardinality -= cardinality - container->cardinality;
+
+        if (container->cardinality == 0)
+        {
+            free(container->values);
+            free(container->words);
+            memmove(&_containers[index], &_containers[index + 1], (_count - index - 1) * sizeof(GRKTrigramContainer));
+            _count -= 1;
+        }
+    }
+}
+
+- (BOOL)containsValue:(uint32_t)value
+{
+    uint16_t key = (uint16_t)(value >> 16);
+    NSUInteger index = [self indexOfContainerWithKey:key];
+    return index < _count && _containers[index].key == key && GRKTrigramContainerContains(&_containers[index], (uint16_t)value);
+}
+
+- (void)enumerateValuesUsingBlock:(void (^)(uint32_t value))block
+{
+    for (NSUInteger i = 0; i < _count; ++i)
+    {
+        GRKTrigramContainerEnumerate(&_containers[i], block);
+    }
+}
+
+@end
+
+#pragma mark - GRKTrigramDocument
+
+@interface GRKTrigramDocument : NSObject
+
+@property (nonatomic,copy) NSString *identifier;
+@property (nonatomic,copy) NSString *signature;
+//The folded UTF-8 text
+@property (nonatomic,strong) NSData *text;
+//The distinct trigrams of the text, as sorted uint32_t values
+@property (nonatomic,strong) NSData *trigrams;
+//The mapped index file which `text` and `trigrams` point into, if they were read from it
+@property (nonatomic,strong) NSData *backing;
+
+@end
+
+@implementation GRKTrigramDocument
+
+@end
+
+#pragma mark - GRKTrigramIndex
+
+@interface GRKTrigramIndex ()
+
+@property (nonatomic,strong,readwrite) NSURL *url;
+//Readers run concurrently, and changes are barriers
+@property (nonatomic,strong) dispatch_queue_t queue;
+//GRKTrigramDocument objects by document number, with NSNull for unused numbers
+@property (nonatomic,strong) NSMutableArray *documents;
+//NSNumber document numbers by identifier
+@property (nonatomic,strong) NSMutableDictionary *documentNumbers;
+//The numbers of removed documents, which are taken before new ones so document numbers stay dense
+@property (nonatomic,strong) NSMutableIndexSet *unusedDocumentNumbers;
+//GRKTrigramBitmap objects of document numbers, by NSNumber trigram
+@property (nonatomic,strong) NSMutableDictionary *bitmaps;
+
+@end
+
+@implementation GRKTrigramIndex
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    return [self initWithURL:nil];
+}
+
+- (instancetype)initWithURL:(NSURL *)url
+{
+    if ((self = [super init]))
+    {
+        self.url = url;
+        self.queue = dispatch_queue_create("com.levigroker.trigramindex", DISPATCH_QUEUE_CONCURRENT);
+        self.documents = [NSMutableArray array];
+        self.documentNumbers = [NSMutableDictionary dictionary];
+        self.unusedDocumentNumbers = [NSMutableIndexSet indexSet];
+        self.bitmaps = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (NSUInteger)documentCount
+{
+    __block NSUInteger retVal = 0;
+    dispatch_sync(self.queue, ^{
+        retVal = self.documentNumbers.count;
+    });
+    return retVal;
+}
+
+- (void)setText:(NSString *)text signature:(NSString *)signature forIdentifier:(NSString *)identifier
+{
+    if (identifier)
+    {
+        //Folded and split here, so the index is only held for the changed trigrams
+        GRKTrigramDocument *document = [[GRKTrigramDocument alloc] init];
+        document.identifier = identifier;
+        document.signature = signature;
+        document.text = [self foldedBytesOfString:text];
+        document.trigrams = [self trigramsOfBytes:document.text];
+        dispatch_barrier_async(self.queue, ^{
+            [self storeDocument:document];
+        });
+    }
+}
+
+- (void)removeIdentifier:(NSString *)identifier
+{
+    if (identifier)
+    {
+        dispatch_barrier_async(self.queue, ^{
+            NSNumber *existingNumber = [self.documentNumbers objectForKey:identifier];
+            if (existingNumber)
+            {
+                NSUInteger documentNumber = [existingNumber unsignedIntegerValue];
+                GRKTrigramDocument *document = [self.documents objectAtIndex:documentNumber];
+                [self updateDocument:(uint32_t)documentNumber fromTrigrams:document.trigrams toTrigrams:nil];
+                [self.documents replaceObjectAtIndex:documentNumber withObject:[NSNull null]];
+                [self.unusedDocumentNumbers addIndex:documentNumber];
+                [self.documentNumbers removeObjectForKey:identifier];
+            }
+        });
+    }
+}
+
+- (NSString *)signatureForIdentifier:(NSString *)identifier
+{
+    __block NSString *retVal = nil;
+    if (identifier)
+    {
+        dispatch_sync(self.queue, ^{
+            NSNumber *documentNumber = [self.documentNumbers objectForKey:identifier];
+            if (documentNumber)
+            {
+                retVal = ((GRKTrigramDocument *)[self.documents objectAtIndex:[documentNumber unsignedIntegerValue]]).signature;
+            }
+        });
+    }
+    return retVal;
+}
+
+- (NSSet *)allIdentifiers
+{
+    __block NSSet *retVal = nil;
+    dispatch_sync(self.queue, ^{
+        retVal = [NSSet setWithArray:[self.documentNumbers allKeys]];
+    });
+    return retVal;
+}
+
+- (NSArray *)identifiersMatchingQuery:(NSString *)query maximumErrors:(NSUInteger)maximumErrors limit:(NSUInteger)limit
+{
+    NSMutableArray *retVal = [NSMutableArray array];
+
+    NSData *pattern = [self foldedBytesOfString:query];
+    if (pattern.length > 0 && limit > 0)
+    {
+        NSData *trigrams = [self trigramsOfBytes:pattern];
+        NSUInteger trigramCount = trigrams.length / sizeof(uint32_t);
+
+        //Each error changes at most three trigrams of a match, so a document holding a match with some errors still has all but three times as many of the distinct trigrams of the query (the q-gram lemma). Errors are only tolerated while that leaves trigrams to look for.
+        NSUInteger errors = 0;
+        if (pattern.length <= kTrigramMaximumApproximateLength)
+        {
+            errors = MIN(maximumErrors, pattern.length / kTrigramBytesPerError);
+            while (errors > 0 && trigramCount <= errors * 3)
+            {
+                --errors;
+            }
+        }
+
+        dispatch_sync(self.queue, ^{
+            NSData *candidates = [self documentsSharingTrigrams:trigrams minimumCount:trigramCount - errors * 3];
+            const uint32_t *candidateNumbers = candidates.bytes;
+            NSUInteger candidateCount = candidates.length / sizeof(uint32_t);
+
+            GRKTrigramHit *hits = malloc(MAX(candidateCount, 1) * sizeof(GRKTrigramHit));
+            NSUInteger hitCount = 0;
+            for (NSUInteger i = 0; i < candidateCount; ++i)
+            {
+                GRKTrigramDocument *document = [self.documents objectAtIndex:candidateNumbers[i]];
+                NSUInteger end = 0;
+                NSUInteger found = NSNotFound;
+                if (errors == 0)
+                {
+                    NSUInteger position = GRKTrigramFind(document.text.bytes, document.text.length, pattern.bytes, pattern.length);
+                    if (position != NSNotFound)
+                    {
+                        found = 0;
+                        end = position + pattern.length;
+                    }
+                }
+                else
+                {
+                    found = GRKTrigramApproximateFind(document.text.bytes, document.text.length, pattern.bytes, pattern.length, &end);
+                }
+
+                if (found <= errors)
+                {
+                    hits[hitCount].errors = found;
+                    hits[hitCount].end = end;
+                    hits[hitCount].document = candidateNumbers[i];
+                    ++hitCount;
+                }
+            }
+
+            qsort_b(hits, hitCount, sizeof(GRKTrigramHit), ^int(const void *value1, const void *value2) {
+                const GRKTrigramHit *hit1 = value1;
+                const GRKTrigramHit *hit2 = value2;
+                int result = hit1->errors < hit2->errors ? -1 : (hit1->errors > hit2->errors ? 1 : 0);
+                if (result == 0)
+                {
+                    result = hit1->end < hit2->end ? -1 : (hit1->end > hit2->end ? 1 : 0);
+                }
+                if (result == 0)
+                {
+                    result = hit1->document < hit2->document ? -1 : (hit1->document > hit2->document ? 1 : 0);
+                }
+                return result;
+            });
+
+            for (NSUInteger i = 0; i < MIN(hitCount, limit); ++i)
+            {
+                GRKTrigramDocument *document = [self.documents objectAtIndex:hits[i].document];
+                [retVal addObject:document.identifier];
+            }
+            free(hits);
+        });
+    }
+
+    return retVal;
+}
+
+- (BOOL)load:(__autoreleasing NSError **)error
+{
+    BOOL success = YES;
+
+    if (self.url && [[NSFileManager defaultManager] fileExistsAtPath:[self.url path]])
+    {
+        NSData *data = [NSData dataWithContentsOfURL:self.url options:NSDataReadingMappedIfSafe error:error];
+        success = data != nil;
+        if (success)
+        {
+            NSArray *documents = [self documentsOfData:data error:error];
+            success = documents != nil;
+            dispatch_barrier_sync(self.queue, ^{
+                [self.documents removeAllObjects];
+                [self.documentNumbers removeAllObjects];
+                [self.unusedDocumentNumbers removeAllIndexes];
+                [self.bitmaps removeAllObjects];
+                for (GRKTrigramDocument *document in documents)
+                {
+                    [self storeDocument:document];
+                }
+            });
+        }
+    }
+
+    return success;
+}
+
+- (BOOL)save:(__autoreleasing NSError **)error
+{
+    __block BOOL success = NO;
+    __block NSError *saveError = nil;
+
+    if (self.url)
+    {
+        //A barrier, as the documents read their text from the new file once it is written
+        dispatch_barrier_sync(self.queue, ^{
+            NSMutableArray *documents = [NSMutableArray arrayWithCapacity:self.documentNumbers.count];
+            for (id document in self.documents)
+            {
+                if (document != [NSNull null])
+                {
+                    [documents addObject:document];
+                }
+            }
+
+            __autoreleasing NSError *writeError = nil;
+            NSData *data = [self dataOfDocuments:documents error:&writeError];
+            NSData *mapped = nil;
+            if (data && [data writeToURL:self.url options:NSDataWritingAtomic error:&writeError])
+            {
+                mapped = [NSData dataWithContentsOfURL:self.url options:NSDataReadingMappedIfSafe error:&writeError];
+            }
+            NSArray *saved = mapped ? [self documentsOfData:mapped error:&writeError] : nil;
+            success = saved != nil && saved.count == documents.count;
+            if (success)
+            {
+                //Let go of the copies held in memory
+                [saved enumerateObjectsUsingBlock:^(GRKTrigramDocument *savedDocument, NSUInteger index, BOOL *stop) {
+                    GRKTrigramDocument *document = [documents objectAtIndex:index];
+                    document.text = savedDocument.text;
+                    document.trigrams = savedDocument.trigrams;
+                    document.backing = savedDocument.backing;
+                }];
+            }
+            saveError = writeError;
+        });
+    }
+
+    if (error)
+    {
+        *error = saveError;
+    }
+    return success;
+}
+
+#pragma mark - Helpers
+
+/**
+ Adds a document, or replaces the document with the same identifier, updating the bitmaps of the trigrams which differ. Must be called as a barrier on the queue.
+ */
+- (void)storeDocument:(GRKTrigramDocument *)document
+{
+    NSUInteger documentNumber = NSNotFound;
+    NSData *oldTrigrams = nil;
+    NSNumber *existingNumber = [self.documentNumbers objectForKey:document.identifier];
+    if (existingNumber)
+    {
+        documentNumber = [existingNumber unsignedIntegerValue];
+        oldTrigrams = ((GRKTrigramDocument *)[self.documents objectAtIndex:documentNumber]).trigrams;
+        [self.documents replaceObjectAtIndex:documentNumber withObject:document];
+    }
+    else
+    {
+        documentNumber = [self.unusedDocumentNumbers firstIndex];
+        if (documentNumber == NSNotFound)
+        {
+            documentNumber = self.documents.count;
+            [self.documents addObject:document];
+        }
+        else
+        {
+            [self.unusedDocumentNumbers removeIndex:documentNumber];
+            [self.documents replaceObjectAtIndex:documentNumber withObject:document];
+        }
+        [self.documentNumbers setObject:@(documentNumber) forKey:document.identifier];
+    }
+
+    [self updateDocument:(uint32_t)documentNumber fromTrigrams:oldTrigrams toTrigrams:document.trigrams];
+}
+
+/**
+ Lays out the given documents as an index file.
+ @return The file content, or `nil` if the documents are too large to be held.
+ */
+- (NSData *)dataOfDocuments:(NSArray *)documents error:(__autoreleasing NSError **)error
+{
+    NSData *retVal = nil;
+
+    unsigned long long trigramsLength = 0;
+    for (GRKTrigramDocument *document in documents)
+    {
+        trigramsLength += document.trigrams.length;
+    }
+
+    NSMutableData *records = [NSMutableData dataWithCapacity:documents.count * sizeof(GRKTrigramIndexRecord)];
+    NSMutableData *trigrams = [NSMutableData dataWithCapacity:(NSUInteger)trigramsLength];
+    NSMutableData *strings = [NSMutableData data];
+    for (GRKTrigramDocument *document in documents)
+    {
+        NSData *identifier = [document.identifier dataUsingEncoding:NSUTF8StringEncoding];
+        NSData *signature = [document.signature dataUsingEncoding:NSUTF8StringEncoding];
+        unsigned long long stringsOffset = trigramsLength + strings.length;
+        GRKTrigramIndexRecord record = {
+            (uint32_t)trigrams.length, (uint32_t)(document.trigrams.length / sizeof(uint32_t)),
+            (uint32_t)stringsOffset, (uint32_t)document.text.length,
+            (uint32_t)(stringsOffset + document.text.length), (uint32_t)identifier.length,
+            (uint32_t)(stringsOffset + document.text.length + identifier.length), (uint32_t)signature.length
+        };
+        [records appendBytes:&record length:sizeof(record)];
+        [trigrams appendData:document.trigrams];
+        [strings appendData:document.text];
+        [strings appendData:identifier];
+        [strings appendData:signature];
+    }
+
+    if ((unsigned long long)trigrams.length + strings.length > UINT32_MAX)
+    {
+        if (error)
+        {
+            *error = GRKTrigramIndexMakeError(GRKTrigramIndexErrorBadFormat, @"Index is too large.");
+        }
+    }
+    else
+    {
+        GRKTrigramIndexHeader header = {kTrigramIndexMagic, kTrigramIndexVersion, (uint32_t)documents.count, (uint32_t)(trigrams.length + strings.length)};
+        NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + records.length + trigrams.length + strings.length];
+        [data appendBytes:&header length:sizeof(header)];
+        [data appendData:records];
+        [data appendData:trigrams];
+        [data appendData:strings];
+        retVal = data;
+    }
+
+    return retVal;
+}
+
+/**
+ Reads the documents of an index file, pointing into the file content rather than copying from it.
+ @return An NSArray of GRKTrigramDocument objects, or `nil` if the content is not a valid index.
+ */
+- (NSArray *)documentsOfData:(NSData *)data error:(__autoreleasing NSError **)error
+{
+    NSMutableArray *retVal = nil;
+    NSError *formatError = nil;
+
+    const GRKTrigramIndexHeader *header = data.bytes;
+    if (data.length < sizeof(GRKTrigramIndexHeader) || header->magic != kTrigramIndexMagic)
+    {
+        formatError = GRKTrigramIndexMakeError(GRKTrigramIndexErrorBadFormat, @"Index has an unexpected signature.");
+    }
+    else if (header->version != kTrigramIndexVersion)
+    {
+        formatError = GRKTrigramIndexMakeError(GRKTrigramIndexErrorBadVersion, [NSString stringWithFormat:@"Index version %@ is not supported (expecting %@).", @(header->version), @(kTrigramIndexVersion)]);
+    }
+    else if (sizeof(GRKTrigramIndexHeader) + (unsigned long long)header->documentCount * sizeof(GRKTrigramIndexRecord) + header->dataLength != data.length)
+    {
+        formatError = GRKTrigramIndexMakeError(GRKTrigramIndexErrorBadFormat, @"Index length does not match its header.");
+    }
+    else
+    {
+        const GRKTrigramIndexRecord *records = (const GRKTrigramIndexRecord *)(header + 1);
+        const uint8_t *base = (const uint8_t *)(records + header->documentCount);
+        unsigned long long dataLength = header->dataLength;
+        retVal = [NSMutableArray arrayWithCapacity:header->documentCount];
+        for (uint32_t i = 0; i < header->documentCount && retVal; ++i)
+        {
+            //Bounds check every entry, so the documents may trust their text and trigrams
+            const GRKTrigramIndexRecord *record = &records[i];
+            BOOL valid = record->trigramsOffset % sizeof(uint32_t) == 0 &&
+                         (unsigned long long)record->trigramsOffset + (unsigned long long)record->trigramCount * sizeof(uint32_t) <= dataLength &&
+                         (unsigned long long)record->textOffset + record->textLength <= dataLength &&
+                         (unsigned long long)record->identifierOffset + record->identifierLength <= dataLength &&
+                         (unsigned long long)record->signatureOffset + record->signatureLength <= dataLength;
+            NSString *identifier = valid ? [[NSString alloc] initWithBytes:base + record->identifierOffset length:record->identifierLength encoding:NSUTF8StringEncoding] : nil;
+            if (identifier)
+            {
+                GRKTrigramDocument *document = [[GRKTrigramDocument alloc] init];
+                document.identifier = identifier;
+                if (record->signatureLength > 0)
+                {
+                    document.signature = [[NSString alloc] initWithBytes:base + record->signatureOffset length:record->signatureLength encoding:NSUTF8StringEncoding];
+                }
+                document.text = [NSData dataWithBytesNoCopy:(void *)(base + record->textOffset) length:record->textLength freeWhenDone:NO];
+                document.trigrams = [NSData dataWithBytesNoCopy:(void *)(base + record->trigramsOffset) length:record->trigramCount * sizeof(uint32_t) freeWhenDone:NO];
+                document.backing = data;
+                [retVal addObject:document];
+            }
+            else
+            {
+                formatError = GRKTrigramIndexMakeError(GRKTrigramIndexErrorBadFormat, [NSString stringWithFormat:@"Index document %@ is out of bounds.", @(i)]);
+                retVal = nil;
+            }
+        }
+    }
+
+    if (formatError && error)
+    {
+        *error = formatError;
+    }
+    return retVal;
+}
+
+- (NSData *)foldedBytesOfString:(NSString *)string
+{
+    NSString *folded = [string ?: @"" stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch locale:nil];
+    return [folded dataUsingEncoding:NSUTF8StringEncoding] ?: [NSData data];
+}
+
+/**
+ The distinct trigrams of the given bytes.
+ @return An NSData of sorted uint32_t values, each of three bytes.
+ */
+- (NSData *)trigramsOfBytes:(NSData *)bytes
+{
+    const uint8_t *text = bytes.bytes;
+    NSUInteger count = bytes.length >= 3 ? bytes.length - 2 : 0;
+    NSMutableData *retVal = [NSMutableData dataWithLength:count * sizeof(uint32_t)];
+    uint32_t *trigrams = retVal.mutableBytes;
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        trigrams[i] = ((uint32_t)text[i] << 16) | ((uint32_t)text[i + 1] << 8) | (uint32_t)text[i + 2];
+    }
+
+    qsort_b(trigrams, count, sizeof(uint32_t), ^int(const void *value1, const void *value2) {
+        uint32_t trigram1 = *(const uint32_t *)value1;
+        uint32_t trigram2 = *(const uint32_t *)value2;
+        return trigram1 < trigram2 ? -1 : (trigram1 > trigram2 ? 1 : 0);
+    });
+    NSUInteger distinctCount = 0;
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        if (distinctCount == 0 || trigrams[distinctCount - 1] != trigrams[i])
+        {
+            trigrams[distinctCount++] = trigrams[i];
+        }
+    }
+    [retVal setLength:distinctCount * sizeof(uint32_t)];
+
+    return retVal;
+}
+
+/**
+ Moves a document from the bitmaps of the trigrams it no longer has to the bitmaps of the trigrams it now has. Must be called as a barrier on the queue.
+ @param oldTrigrams The sorted trigrams the document had, or nil.
+ @param newTrigrams The sorted trigrams the document has, or nil.
+ */
+- (void)updateDocument:(uint32_t)document fromTrigrams:(NSData *)oldTrigrams toTrigrams:(NSData *)newTrigrams
+{
+    const uint32_t *oldValues = oldTrigrams.bytes;
+    NSUInteger oldCount = oldTrigrams.length / sizeof(uint32_t);
+    const uint32_t *newValues = newTrigrams.bytes;
+    NSUInteger newCount = newTrigrams.length / sizeof(uint32_t);
+    NSUInteger oldIndex = 0;
+    NSUInteger newIndex = 0;
+    while (oldIndex < oldCount || newIndex < newCount)
+    {
+        if (newIndex == newCount || (oldIndex < oldCount && oldValues[oldIndex] < newValues[newIndex]))
+        {
+            NSNumber *trigram = @(oldValues[oldIndex]);
+            GRKTrigramBitmap *bitmap = [self.bitmaps objectForKey:trigram];
+            [bitmap removeValue:document];
+            if (bitmap && bitmap->_cardinality == 0)
+            {
+                [self.bitmaps removeObjectForKey:trigram];
+            }
+            ++oldIndex;
+        }
+        else if (oldIndex == oldCount || newValues[newIndex] < oldValues[oldIndex])
+        {
+            NSNumber *trigram = @(newValues[newIndex]);
+            GRKTrigramBitmap *bitmap = [self.bitmaps objectForKey:trigram];
+            if (!bitmap)
+            {
+                bitmap = [[GRKTrigramBitmap alloc] init];
+                [self.bitmaps setObject:bitmap forKey:trigram];
+            }
+            [bitmap addValue:document];
+            ++newIndex;
+        }
+        else
+        {
+            ++oldIndex;
+            ++newIndex;
+        }
+    }
+}
+
+/**
+ The documents having at least the given number of the given trigrams. Must be called on the queue.
+ @param trigrams     The sorted distinct trigrams.
+ @param minimumCount The number of the trigrams a document must have. When it is the number of trigrams their bitmaps are intersected, otherwise the trigrams of each document are counted. When it is zero every document is returned.
+ @return An NSData of uint32_t document numbers.
+ */
+- (NSData *)documentsSharingTrigrams:(NSData *)trigrams minimumCount:(NSUInteger)minimumCount
+{
+    NSMutableData *retVal = [NSMutableData data];
+    const uint32_t *values = trigrams.bytes;
+    NSUInteger trigramCount = trigrams.length / sizeof(uint32_t);
+    NSUInteger documentCount = self.documents.count;
+
+    if (minimumCount == 0)
+    {
+        for (NSUInteger document = 0; document < documentCount; ++document)
+        {
+            if (![self.unusedDocumentNumbers containsIndex:document])
+            {
+                uint32_t value = (uint32_t)document;
+                [retVal appendBytes:&value length:sizeof(uint32_t)];
+            }
+        }
+    }
+    else if (minimumCount == trigramCount)
+    {
+        //Intersect the bitmaps, starting with the smallest
+        NSMutableArray *bitmaps = [NSMutableArray arrayWithCapacity:trigramCount];
+        for (NSUInteger i = 0; i < trigramCount && bitmaps; ++i)
+        {
+            GRKTrigramBitmap *bitmap = [self.bitmaps objectForKey:@(values[i])];
+            if (bitmap)
+            {
+                [bitmaps addObject:bitmap];
+            }
+            else
+            {
+                bitmaps = nil;
+            }
+        }
+        [bitmaps sortUsingComparator:^NSComparisonResult(GRKTrigramBitmap *bitmap1, GRKTrigramBitmap *bitmap2) {
+            return bitmap1->_cardinality < bitmap2->_cardinality ? NSOrderedAscending : (bitmap1->_cardinality > bitmap2->_cardinality ? NSOrderedDescending : NSOrderedSame);
+        }];
+
+        GRKTrigramBitmap *smallest = [bitmaps firstObject];
+        [smallest enumerateValuesUsingBlock:^(uint32_t document) {
+            BOOL containsAll = YES;
+            for (NSUInteger i = 1; i < bitmaps.count && containsAll; ++i)
+            {
+                containsAll = [(GRKTrigramBitmap *)[bitmaps objectAtIndex:i] containsValue:document];
+            }
+            if (containsAll)
+            {
+                [retVal appendBytes:&document length:sizeof(uint32_t)];
+            }
+        }];
+    }
+    else
+    {
+        //Queries of at most 64 bytes have at most 62 trigrams, so the counts fit a byte
+        uint8_t *counts = calloc(MAX(documentCount, 1), sizeof(uint8_t));
+        for (NSUInteger i = 0; i < trigramCount; ++i)
+        {
+            GRKTrigramBitmap *bitmap = [self.bitmaps objectForKey:@(values[i])];
+            [bitmap enumerateValuesUsingBlock:^(uint32_t document) {
+                counts[document] += 1;
+            }];
+        }
+        for (NSUInteger document = 0; document < documentCount; ++document)
+        {
+            if (counts[document] >= minimumCount)
+            {
+                uint32_t value = (uint32_t)document;
+                [retVal appendBytes:&value length:sizeof(uint32_t)];
+            }
+        }
+        free(counts);
+    }
+
+    return retVal;
+}
+
+@end
@@ -14,11 +14,15 @@
 
 static NSString * const kSegueNoteDetail = @"note_detail";
 
-@interface MainViewController ()
+@interface MainViewController () <UISearchBarDelegate>
 
 @property (nonatomic,weak) IBOutlet UITableView *tableView;
 @property (nonatomic,strong) UIRefreshControl *refreshControl;
-@property (nonatomic,strong) NSMutableArray *notes;
+//The version of the visible notes the table view is showing
+@property (nonatomic,strong) GRKSortedSetSnapshot *notes;
+@property (nonatomic,strong) UISearchBar *searchBar;
+//The notes matching the search, best match first, which are shown in place of all notes while there is a search
+@property (nonatomic,strong) NSArray *searchResults;
 @property (nonatomic,strong) Note *currentNote;
 @property (nonatomic,assign) BOOL shouldEditNote;
 
@@ -46,7 +50,13 @@ static NSString * const kSegueNoteDetail = @"note_detail";
     [self.refreshControl addTarget:self action:@selector(refreshTableView) forControlEvents:UIControlEventValueChanged];
     [self.tableView addSubview:self.refreshControl];
     self.tableView.alwaysBounceVertical = YES;
-    self.notes = [NSMutableArray array];
+    
+    //Add the search bar above the notes
+    self.searchBar = [[UISearchBar alloc] initWithFrame:CGRectMake(0.0f, 0.0f, CGRectGetWidth(self.tableView.bounds), 44.0f)];
+    self.searchBar.autoresizingMask = UIViewAutoresizingFlexibleWidth;
+    self.searchBar.placeholder = NSLocalizedString(@"Search", nil);
+    self.searchBar.delegate = self;
+    self.tableView.tableHeaderView = self.searchBar;
     
     NoteManager *noteManager = [NoteManager shared];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(notificationNoteChanges:) name:kNoteNotificationNoteChanges object:noteManager];
@@ -77,10 +87,9 @@ static NSString * const kSegueNoteDetail = @"note_detail";
         }
         else
         {
-            [self.notes removeAllObjects];
-            NSArray *visibleNotes = [noteManager visibleNotes];
-            [self.notes addObjectsFromArray:visibleNotes];
+            self.notes = noteManager.visibleNotesSnapshot;
             [self.tableView reloadData];
+            [self updateDisplayedNotes];
         }
     }];
 }
@@ -169,18 +178,35 @@ static NSString * const kSegueNoteDetail = @"note_detail";
 {
     DDLogVerbose(@"notificationNoteCreated: %@", notification);
     
-    //TODO: Handle dynamic updates rather than brute force
-    //NSDictionary *userInfo = notification.userInfo;
-    //NSArray *deletedNotes = [userInfo objectForKey:kNoteNotificationInfoKeyDeletedNotes];
-    //NSArray *updatedNotes = [userInfo objectForKey:kNoteNotificationInfoKeyUpdatedNotes];
-    //NSArray *newNotes = [userInfo objectForKey:kNoteNotificationInfoKeyAddedNotes];
-
-    NoteManager *noteManager = [NoteManager shared];
-    [self.notes removeAllObjects];
-    NSArray *visibleNotes = [noteManager visibleNotes];
-    [self.notes addObjectsFromArray:visibleNotes];
+    NSDictionary *userInfo = notification.userInfo;
+    NSIndexSet *deletedIndexes = [userInfo objectForKey:kNoteNotificationInfoKeyDeletedIndexes];
+    NSIndexSet *insertedIndexes = [userInfo objectForKey:kNoteNotificationInfoKeyInsertedIndexes];
+    NSIndexSet *reloadedIndexes = [userInfo objectForKey:kNoteNotificationInfoKeyReloadedIndexes];
+    GRKSortedSetSnapshot *notes = [userInfo objectForKey:kNoteNotificationInfoKeyVisibleNotes];
     
-    [self.tableView reloadData];
+    if (self.searchResults)
+    {
+        //The rows are search results, so search again
+        self.notes = [NoteManager shared].visibleNotesSnapshot;
+        [self updateSearchResults];
+    }
+    //Apply just the rows which changed, as long as the changes account for the difference between what we show and the visible notes
+    else if (notes && deletedIndexes && insertedIndexes && self.notes.count + insertedIndexes.count == notes.count + deletedIndexes.count)
+    {
+        self.notes = notes;
+        [self.tableView beginUpdates];
+        [self.tableView deleteRowsAtIndexPaths:[self indexPathsForIndexes:deletedIndexes] withRowAnimation:UITableViewRowAnimationAutomatic];
+        [self.tableView insertRowsAtIndexPaths:[self indexPathsForIndexes:insertedIndexes] withRowAnimation:UITableViewRowAnimationAutomatic];
+        [self.tableView reloadRowsAtIndexPaths:[self indexPathsForIndexes:reloadedIndexes] withRowAnimation:UITableViewRowAnimationNone];
+        [self.tableView endUpdates];
+    }
+    else
+    {
+        self.notes = [NoteManager shared].visibleNotesSnapshot;
+        [self.tableView reloadData];
+    }
+    
+    [self updateDisplayedNotes];
 }
 
 #pragma mark - Table View
@@ -196,11 +222,68 @@ static NSString * const kSegueNoteDetail = @"note_detail";
     }];
 }
 
+- (NSUInteger)displayedNoteCount
+{
+    return self.searchResults ? self.searchResults.count : self.notes.count;
+}
+
+- (Note *)displayedNoteAtIndex:(NSUInteger)index
+{
+    return self.searchResults ? [self.searchResults objectAtIndex:index] : [self.notes objectAtIndex:index];
+}
+
+//Runs the search in the search bar, showing all notes again if there is none
+- (void)updateSearchResults
+{
+    NSString *query = [self.searchBar.text stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]].length > 0 ? self.searchBar.text : nil;
+    if (query)
+    {
+        [[NoteManager shared] searchNotes:query completion:^(NSArray *notes) {
+            //Results of a search which has since been replaced are of no interest
+            if ([self.searchBar.text isEqualToString:query])
+            {
+                self.searchResults = notes;
+                [self.tableView reloadData];
+                [self updateDisplayedNotes];
+            }
+        }];
+    }
+    else if (self.searchResults)
+    {
+        self.searchResults = nil;
+        [self.tableView reloadData];
+        [self updateDisplayedNotes];
+    }
+}
+
+//Tells the note manager which notes are on screen, so their content is synchronized first
+- (void)updateDisplayedNotes
+{
+    NSMutableArray *displayedNotes = [NSMutableArray array];
+    for (NSIndexPath *indexPath in [self.tableView indexPathsForVisibleRows])
+    {
+        if (indexPath.row < [self displayedNoteCount])
+        {
+            [displayedNotes addObject:[self displayedNoteAtIndex:indexPath.row]];
+        }
+    }
+    [[NoteManager shared] notesWereDisplayed:displayedNotes];
+}
+
+- (NSArray *)indexPathsForIndexes:(NSIndexSet *)indexes
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:indexes.count];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [retVal addObject:[NSIndexPath indexPathForRow:index inSection:0]];
+    }];
+    return retVal;
+}
+
 #pragma mark - UITableViewDataSource
 
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
 {
-    NSInteger count = self.notes.count;
+    NSInteger count = [self displayedNoteCount];
     return count;
 }
 
@@ -208,7 +291,7 @@ static NSString * const kSegueNoteDetail = @"note_detail";
 {
     NoteCell *cell = [tableView dequeueReusableCellWithIdentifier:NSStringFromClass(NoteCell.class) forIndexPath:indexPath];
     
-    Note *note = [self.notes objectAtIndex:indexPath.row];
+    Note *note = [self displayedNoteAtIndex:indexPath.row];
     
     //Configure cell
     cell.textLabel.text = note.title;
@@ -222,12 +305,10 @@ static NSString * const kSegueNoteDetail = @"note_detail";
         case UITableViewCellEditingStyleDelete:
         {
             //Handle delete
-            Note *note = [self.notes objectAtIndex:indexPath.row];
+            Note *note = [self displayedNoteAtIndex:indexPath.row];
             //Remove the note from the manager
             NoteManager *noteManager = [NoteManager shared];
             [noteManager markNoteAsDeleted:note];
-            //Remove the note from our local array
-            [self.notes removeObject:note];
             //The table view will be updated by a notification the note was deleted.
             break;
         }
@@ -242,10 +323,54 @@ static NSString * const kSegueNoteDetail = @"note_detail";
 - (void)tableView:(UITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath
 {
     DDLogVerbose(@"tableView:didSelectRowAtIndexPath: %@", indexPath);
-    self.currentNote = [self.notes objectAtIndex:indexPath.row];
+    self.currentNote = [self displayedNoteAtIndex:indexPath.row];
     self.shouldEditNote = NO;
     [self performSegueWithIdentifier:kSegueNoteDetail sender:self];
 }
 
+#pragma mark - UISearchBarDelegate
+
+- (void)searchBar:(UISearchBar *)searchBar textDidChange:(NSString *)searchText
+{
+    [self updateSearchResults];
+}
+
+- (void)searchBarTextDidBeginEditing:(UISearchBar *)searchBar
+{
+    [searchBar setShowsCancelButton:YES animated:YES];
+}
+
+- (void)searchBarTextDidEndEditing:(UISearchBar *)searchBar
+{
+    [searchBar setShowsCancelButton:NO animated:YES];
+}
+
+- (void)searchBarSearchButtonClicked:(UISearchBar *)searchBar
+{
+    [searchBar resignFirstResponder];
+}
+
+- (void)searchBarCancelButtonClicked:(UISearchBar *)searchBar
+{
+    searchBar.text = nil;
+    [searchBar resignFirstResponder];
+    [self updateSearchResults];
+}
+
+#pragma mark - UIScrollViewDelegate
+
+- (void)scrollViewDidEndDragging:(UIScrollView *)scrollView willDecelerate:(BOOL)decelerate
+{
+    if (!decelerate)
+    {
+        [self updateDisplayedNotes];
+    }
+}
+
+- (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView
+{
+    [self updateDisplayedNotes];
+}
+
 @end
 
@@ -46,6 +46,12 @@ static NSTimeInterval const kContentAnimationDuration = 0.25f;
 {
     [super viewWillAppear:animated];
     
+    [[NoteManager shared] noteWasOpened:self.note];
+    
+    //Show the remote folders holding the note, unless it is at the root
+    NSArray *folderPath = [[NoteManager shared] folderPathOfNote:self.note];
+    self.navigationItem.prompt = folderPath.count > 0 ? [folderPath componentsJoinedByString:@" / "] : nil;
+    
     [self.note readContent:^(NSString *content, NSError *error) {
         [UIView transitionWithView:self.view duration:kContentAnimationDuration options:UIViewAnimationOptionTransitionCrossDissolve animations:^{
             self.titleTextField.text = self.note.title;
@@ -68,6 +74,8 @@ static NSTimeInterval const kContentAnimationDuration = 0.25f;
     [super viewWillDisappear:animated];
     
     [self.view endEditing:YES];
+    
+    [[NoteManager shared] noteWasOpened:nil];
 }
 
 #pragma mark - Notifications
@@ -186,6 +194,10 @@ static NSTimeInterval const kContentAnimationDuration = 0.25f;
             [alert addButtonWithTitle:NSLocalizedString(@"Drat!", nil) handler:nil];
             [alert show];
         }
+        else
+        {
+            [[NoteManager shared] noteWasModified:self.note];
+        }
     }
 }
 
@@ -216,6 +228,10 @@ static NSTimeInterval const kContentAnimationDuration = 0.25f;
             else
             {
                 DDLogVerbose(@"Content saved for note '%@'", self.note);
+                if (changed)
+                {
+                    [[NoteManager shared] noteWasModified:self.note];
+                }
             }
             dispatch_group_leave(group);
         }];
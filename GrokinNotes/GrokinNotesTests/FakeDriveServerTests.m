@@ -0,0 +1,231 @@
+//
+//  FakeDriveServerTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#if DEBUG
+
+#import "GoogleDriveManager.h"
+#import "FakeDriveServer.h"
+
+static NSUInteger const kDriveBenchmarkFileCount = 50;
+static NSTimeInterval const kRequestTimeout = 30;
+
+/**
+ Exercises the FakeDriveServer through the GoogleDriveManager, as the sync benchmark does, so the round trips the benchmark measures are known to behave as Drive does.
+ */
+@interface FakeDriveServerTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+@property (nonatomic,strong) FakeDriveServer *server;
+@property (nonatomic,strong) GoogleDriveManager *driveManager;
+
+@end
+
+@implementation FakeDriveServerTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.server = [[FakeDriveServer alloc] initWithSeed:1];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([self.server start:&error], @"The server failed to start: %@", error);
+    self.driveManager = [[GoogleDriveManager alloc] init];
+    [self.driveManager startupWithServiceURL:self.server.baseURL authorizer:self.server.authorizer];
+}
+
+- (void)tearDown
+{
+    [self.server stop];
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testUploadedContentIsDownloaded
+{
+    GTLDriveFile *created = [self createFileNamed:@"Note" content:@"Uploaded content"];
+    XCTAssertNotNil(created.identifier, @"The created file should have an ID.");
+    XCTAssertEqualObjects(created.title, @"Note", @"The created file should keep its title.");
+    XCTAssertEqualObjects(self.server.fileIDs, @[created.identifier], @"The server should hold the file.");
+
+    XCTAssertEqualObjects([self downloadFile:created], @"Uploaded content", @"The downloaded content should be that uploaded.");
+
+    //Replace the content, as a local edit does
+    NSURL *fileURL = [self.directory URLByAppendingPathComponent:@"Note"];
+    [@"Edited content" writeToURL:fileURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    __block GTLDriveFile *updated = nil;
+    __block BOOL finished = NO;
+    [self.driveManager updateDriveFile:created fromFileURL:fileURL completion:^(GTLDriveFile *updatedFile, NSError *error) {
+        XCTAssertNil(error, @"Updating the file failed: %@", error);
+        updated = updatedFile;
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    XCTAssertNotEqualObjects(updated.md5Checksum, created.md5Checksum, @"The checksum should follow the content.");
+    XCTAssertEqualObjects([self downloadFile:updated], @"Edited content", @"The downloaded content should be the edit.");
+}
+
+- (void)testTrashedFilesAreRestored
+{
+    NSString *first = [self.server insertFileWithTitle:@"First" content:[NSData data]];
+    NSString *second = [self.server insertFileWithTitle:@"Second" content:[NSData data]];
+
+    __block NSDictionary *trashed = nil;
+    __block BOOL finished = NO;
+    [self.driveManager trashFilesWithIDs:@[first, second, @"missing"] completion:^(NSDictionary *files, NSDictionary *errors) {
+        trashed = files;
+        XCTAssertNotNil([errors objectForKey:@"missing"], @"A missing file should not be trashed.");
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    XCTAssertEqual(trashed.count, (NSUInteger)2, @"Both files should be trashed in one batch.");
+    XCTAssertEqual(self.server.fileIDs.count, (NSUInteger)0, @"The server should hold no files outside the trash.");
+
+    finished = NO;
+    [self.driveManager restoreFilesWithIDs:@[first] completion:^(NSDictionary *files, NSDictionary *errors) {
+        XCTAssertEqual(errors.count, (NSUInteger)0, @"Restoring the file failed: %@", errors);
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    XCTAssertEqualObjects(self.server.fileIDs, @[first], @"The restored file should be out of the trash.");
+}
+
+- (void)testChangesArePaged
+{
+    for (NSUInteger i = 0; i < 25; ++i)
+    {
+        [self.server insertFileWithTitle:[NSString stringWithFormat:@"Note %lu", (unsigned long)i] content:[NSData data]];
+    }
+
+    __block NSUInteger pageCount = 0;
+    __block NSUInteger changeCount = 0;
+    __block BOOL sawLastPage = NO;
+    __block BOOL finished = NO;
+    [self.driveManager enumerateChangesSinceChangeID:nil pageSize:10 pageHandler:^(NSArray *changes, NSNumber *checkpointChangeID, BOOL lastPage, void (^next)(BOOL proceed)) {
+        XCTAssertFalse(sawLastPage, @"No page should follow the last.");
+        XCTAssertTrue(changes.count <= 10, @"A page should hold no more than the page size.");
+        pageCount += 1;
+        changeCount += changes.count;
+        sawLastPage = lastPage;
+        next(YES);
+    } completion:^(NSNumber *largestChangeID, NSError *error) {
+        XCTAssertNil(error, @"Enumerating the changes failed: %@", error);
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    XCTAssertEqual(pageCount, (NSUInteger)3, @"The changes should span three pages.");
+    XCTAssertEqual(changeCount, (NSUInteger)25, @"Every change should be enumerated.");
+    XCTAssertTrue(sawLastPage, @"The last page should be marked.");
+}
+
+- (void)testInjectedErrorsAndLatency
+{
+    NSString *fileID = [self.server insertFileWithTitle:@"Note" content:[NSData data]];
+    //An error which is not retried
+    self.server.injectedErrorCode = 404;
+    self.server.errorRate = 1;
+
+    __block BOOL finished = NO;
+    [self.driveManager retrieveFilesWithIDs:@[fileID] completion:^(NSDictionary *files, NSDictionary *errors) {
+        XCTAssertEqual(files.count, (NSUInteger)0, @"No file should be retrieved.");
+        XCTAssertEqual([(NSError *)[errors objectForKey:fileID] code], (NSInteger)404, @"The injected error should be reported.");
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+
+    self.server.errorRate = 0;
+    self.server.latency = 0.2;
+    [self.server resetStatistics];
+    finished = NO;
+    [self.driveManager retrieveFilesWithIDs:@[fileID] completion:^(NSDictionary *files, NSDictionary *errors) {
+        XCTAssertNotNil([files objectForKey:fileID], @"The file should be retrieved once errors stop.");
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    NSArray *durations = [[[self.server requestDurations] allValues] valueForKeyPath:@"@unionOfArrays.self"];
+    XCTAssertTrue(durations.count > 0, @"The request should be recorded.");
+    XCTAssertTrue([[durations valueForKeyPath:@"@min.self"] doubleValue] >= 0.2, @"The latency should delay every response.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testUploadAndDownloadPerformance
+{
+    NSString *content = [@"" stringByPaddingToLength:4096 withString:@"Some content of the note. " startingAtIndex:0];
+
+    [self measureBlock:^{
+        NSMutableArray *files = [NSMutableArray arrayWithCapacity:kDriveBenchmarkFileCount];
+        for (NSUInteger i = 0; i < kDriveBenchmarkFileCount; ++i)
+        {
+            [files addObject:[self createFileNamed:[NSString stringWithFormat:@"Note %05lu", (unsigned long)i] content:content]];
+        }
+        for (GTLDriveFile *file in files)
+        {
+            XCTAssertEqualObjects([self downloadFile:file], content, @"The downloaded content should be that uploaded.");
+        }
+        DDLogInfo(@"Round trip of %@ files: %@ bytes sent, %@ bytes received.", @(kDriveBenchmarkFileCount), @(self.server.bytesReceived), @(self.server.bytesSent));
+        [self.server resetStatistics];
+    }];
+}
+
+#pragma mark - Helpers
+
+- (void)waitFor:(BOOL *)finished
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:kRequestTimeout];
+    while (!*finished && [timeout timeIntervalSinceNow] > 0)
+    {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    XCTAssertTrue(*finished, @"The request timed out.");
+}
+
+- (GTLDriveFile *)createFileNamed:(NSString *)name content:(NSString *)content
+{
+    NSURL *fileURL = [self.directory URLByAppendingPathComponent:name];
+    [content writeToURL:fileURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    __block GTLDriveFile *retVal = nil;
+    __block BOOL finished = NO;
+    [self.driveManager createFile:fileURL withMIMEType:kMIMETypeTextPlain inFolder:nil completion:^(GTLDriveFile *createdFile, NSError *error) {
+        XCTAssertNil(error, @"Creating the file failed: %@", error);
+        retVal = createdFile;
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    return retVal;
+}
+
+- (NSString *)downloadFile:(GTLDriveFile *)file
+{
+    NSURL *folder = [self.directory URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createDirectoryAtURL:folder withIntermediateDirectories:YES attributes:nil error:nil];
+
+    __block NSString *retVal = nil;
+    __block BOOL finished = NO;
+    [self.driveManager downloadFile:file toFolder:folder completion:^(GTLDriveFile *downloadedFile, NSURL *fileURL, NSError *error) {
+        XCTAssertNil(error, @"Downloading the file failed: %@", error);
+        retVal = [NSString stringWithContentsOfURL:fileURL encoding:NSUTF8StringEncoding error:nil];
+        finished = YES;
+    }];
+    [self waitFor:&finished];
+    [[NSFileManager defaultManager] removeItemAtURL:folder error:nil];
+    return retVal;
+}
+
+@end
+
+#endif
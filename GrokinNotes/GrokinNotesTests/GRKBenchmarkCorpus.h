@@ -0,0 +1,61 @@
+//
+//  GRKBenchmarkCorpus.h
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Generates the text of synthetic notes for the search benchmarks.
+ Words are made of syllables, so they share the substrings real words do. They are drawn from a fixed vocabulary with a Zipf-like distribution: a word's frequency falls with its rank, so a few words are in most notes and most words are in few.
+ Generation is seeded, so the same corpus is generated on every run.
+ */
+@interface GRKBenchmarkCorpus : NSObject
+
+/**
+ The number of distinct words notes are made of.
+ */
+@property (nonatomic,assign,readonly) NSUInteger vocabularySize;
+
+/**
+ Creates a corpus generator.
+
+ @param seed           The seed of the generator.
+ @param vocabularySize The number of distinct words.
+
+ @return A new generator.
+ */
+- (instancetype)initWithSeed:(uint32_t)seed vocabularySize:(NSUInteger)vocabularySize;
+
+/**
+ The word of a rank in the vocabulary.
+
+ @param rank The rank, from `0` (the most common word) to `vocabularySize - 1`.
+
+ @return The word.
+ */
+- (NSString *)wordOfRank:(NSUInteger)rank;
+
+/**
+ Generates the text of the next note.
+
+ @param wordCount The number of words in the note.
+
+ @return The text, of words separated by spaces.
+ */
+- (NSString *)nextTextWithWordCount:(NSUInteger)wordCount;
+
+/**
+ Generates the texts of the next notes.
+
+ @param count     The number of notes.
+ @param wordCount The number of words in each note.
+
+ @return An NSArray of the texts.
+ */
+- (NSArray *)nextTexts:(NSUInteger)count wordCount:(NSUInteger)wordCount;
+
+@end
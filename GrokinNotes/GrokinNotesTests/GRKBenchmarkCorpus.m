@@ -0,0 +1,102 @@
+//
+//  GRKBenchmarkCorpus.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import "GRKBenchmarkCorpus.h"
+
+static const char * const kCorpusSyllables[] = {
+    "ka", "lo", "mi", "ne", "su", "ta", "ri", "po", "ven", "dor", "al", "is", "tra", "mel", "quo", "ber",
+    "sa", "fi", "ro", "nu", "ge", "pla", "tor", "ex", "an", "hu", "bi", "co", "dre", "lim", "vo", "zen"
+};
+static NSUInteger const kCorpusSyllableCount = sizeof(kCorpusSyllables) / sizeof(kCorpusSyllables[0]);
+
+@interface GRKBenchmarkCorpus ()
+
+@property (nonatomic,assign,readwrite) NSUInteger vocabularySize;
+@property (nonatomic,assign) uint32_t state;
+@property (nonatomic,strong) NSArray *words;
+
+@end
+
+@implementation GRKBenchmarkCorpus
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    return [self initWithSeed:1 vocabularySize:10000];
+}
+
+- (instancetype)initWithSeed:(uint32_t)seed vocabularySize:(NSUInteger)vocabularySize
+{
+    if ((self = [super init]))
+    {
+        self.state = seed;
+        self.vocabularySize = MAX(vocabularySize, (NSUInteger)1);
+
+        NSMutableArray *words = [NSMutableArray arrayWithCapacity:self.vocabularySize];
+        for (NSUInteger rank = 0; rank < self.vocabularySize; ++rank)
+        {
+            //The rank in base kCorpusSyllableCount, offset so every word has at least two syllables
+            NSMutableString *word = [NSMutableString string];
+            for (NSUInteger value = rank + kCorpusSyllableCount; value > 0; value /= kCorpusSyllableCount)
+            {
+                [word appendFormat:@"%s", kCorpusSyllables[value % kCorpusSyllableCount]];
+            }
+            [words addObject:word];
+        }
+        self.words = words;
+    }
+
+    return self;
+}
+
+#pragma mark - Implementation
+
+- (NSString *)wordOfRank:(NSUInteger)rank
+{
+    return [self.words objectAtIndex:rank];
+}
+
+- (NSString *)nextTextWithWordCount:(NSUInteger)wordCount
+{
+    NSMutableString *retVal = [NSMutableString string];
+    for (NSUInteger i = 0; i < wordCount; ++i)
+    {
+        if (i > 0)
+        {
+            [retVal appendString:@" "];
+        }
+        [retVal appendString:[self.words objectAtIndex:[self nextRank]]];
+    }
+    return retVal;
+}
+
+- (NSArray *)nextTexts:(NSUInteger)count wordCount:(NSUInteger)wordCount
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        @autoreleasepool {
+            [retVal addObject:[self nextTextWithWordCount:wordCount]];
+        }
+    }
+    return retVal;
+}
+
+#pragma mark - Helpers
+
+//A rank drawn log-uniformly, which gives each rank a probability roughly proportional to 1 / (rank + 1), as Zipf's law has it
+- (NSUInteger)nextRank
+{
+    self.state = self.state * 1664525u + 1013904223u;
+    double uniform = (self.state >> 8) / 16777216.0;
+    NSUInteger retVal = (NSUInteger)floor(pow((double)(self.vocabularySize + 1), uniform)) - 1;
+    return MIN(retVal, self.vocabularySize - 1);
+}
+
+@end
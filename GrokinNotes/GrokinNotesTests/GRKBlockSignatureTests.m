@@ -0,0 +1,177 @@
+//
+//  GRKBlockSignatureTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "GRKBlockSignature.h"
+
+static NSUInteger const kSignatureBenchmarkLength = 4 * 1024 * 1024;
+
+@interface GRKBlockSignatureTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+
+@end
+
+@implementation GRKBlockSignatureTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testIdenticalContentIsUnchanged
+{
+    NSData *basis = [self contentOfLength:100000 seed:1];
+    GRKBlockDelta *delta = [[GRKBlockSignature signatureOfData:basis blockSize:0] deltaOfData:basis];
+    XCTAssertTrue(delta.unchanged, @"The basis itself should be unchanged.");
+    XCTAssertEqual(delta.literalBytes, 0ULL, @"Nothing should need to be sent.");
+    XCTAssertEqual(delta.matchedBytes, (unsigned long long)basis.length, @"Every byte should be matched.");
+}
+
+- (void)testInsertionIsTheOnlyLiteral
+{
+    NSUInteger blockSize = 512;
+    NSData *basis = [self contentOfLength:100 * blockSize seed:2];
+    NSData *insertion = [@"An edit in the middle of the note." dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *edited = [basis mutableCopy];
+    NSUInteger location = 37 * blockSize + 100;
+    [edited replaceBytesInRange:NSMakeRange(location, 0) withBytes:insertion.bytes length:insertion.length];
+
+    GRKBlockDelta *delta = [[GRKBlockSignature signatureOfData:basis blockSize:blockSize] deltaOfData:edited];
+    [self assertDelta:delta coversData:edited];
+    XCTAssertFalse(delta.unchanged, @"The edited content should differ.");
+    //The insertion splits one block, so no more than that block and the insertion need be sent
+    XCTAssertTrue(delta.literalBytes <= blockSize + insertion.length, @"Only the edited block should be sent, not %@ bytes.", @(delta.literalBytes));
+    for (NSValue *value in delta.literalRanges)
+    {
+        NSRange range = [value rangeValue];
+        XCTAssertTrue(NSIntersectionRange(range, NSMakeRange(location, insertion.length)).length > 0, @"Literal range %@ should hold the insertion.", NSStringFromRange(range));
+    }
+}
+
+- (void)testMovedBlocksAreMatched
+{
+    NSUInteger blockSize = 256;
+    NSData *basis = [self contentOfLength:20 * blockSize seed:3];
+    //Swap the two halves
+    NSMutableData *moved = [[basis subdataWithRange:NSMakeRange(10 * blockSize, 10 * blockSize)] mutableCopy];
+    [moved appendData:[basis subdataWithRange:NSMakeRange(0, 10 * blockSize)]];
+
+    GRKBlockDelta *delta = [[GRKBlockSignature signatureOfData:basis blockSize:blockSize] deltaOfData:moved];
+    [self assertDelta:delta coversData:moved];
+    XCTAssertEqual(delta.literalBytes, 0ULL, @"Moved blocks should be found wherever they are.");
+}
+
+- (void)testSignatureRoundTripsThroughFile
+{
+    NSData *basis = [self contentOfLength:50000 seed:4];
+    NSMutableData *edited = [basis mutableCopy];
+    [edited appendData:[self contentOfLength:1000 seed:5]];
+    GRKBlockSignature *signature = [GRKBlockSignature signatureOfData:basis blockSize:0];
+
+    NSURL *url = [self.directory URLByAppendingPathComponent:@"signature"];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([signature writeToURL:url error:&error], @"Writing the signature failed: %@", error);
+    GRKBlockSignature *read = [GRKBlockSignature signatureWithContentsOfURL:url error:&error];
+    XCTAssertNotNil(read, @"Reading the signature failed: %@", error);
+    XCTAssertEqual(read.blockSize, signature.blockSize, @"The block size should be kept.");
+    XCTAssertEqual(read.length, signature.length, @"The basis length should be kept.");
+    XCTAssertEqual(read.blockCount, signature.blockCount, @"Every block should be kept.");
+
+    GRKBlockDelta *delta = [signature deltaOfData:edited];
+    GRKBlockDelta *readDelta = [read deltaOfData:edited];
+    XCTAssertEqualObjects(readDelta.literalRanges, delta.literalRanges, @"The signature read back should give the same delta.");
+    XCTAssertEqual(readDelta.literalBytes, delta.literalBytes, @"The signature read back should give the same delta.");
+}
+
+- (void)testDamagedSignatureIsRejected
+{
+    NSURL *url = [self.directory URLByAppendingPathComponent:@"signature"];
+    [[GRKBlockSignature signatureOfData:[self contentOfLength:50000 seed:6] blockSize:0] writeToURL:url error:nil];
+
+    NSMutableData *damaged = [NSMutableData dataWithContentsOfURL:url];
+    [damaged setLength:damaged.length - 7];
+    [damaged writeToURL:url atomically:YES];
+    XCTAssertNil([GRKBlockSignature signatureWithContentsOfURL:url error:nil], @"A truncated signature should not be read.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testSignaturePerformance
+{
+    NSData *basis = [self contentOfLength:kSignatureBenchmarkLength seed:7];
+
+    [self measureBlock:^{
+        GRKBlockSignature *signature = [GRKBlockSignature signatureOfData:basis blockSize:0];
+        XCTAssertEqual(signature.length, (unsigned long long)kSignatureBenchmarkLength, @"The whole basis should be signed.");
+    }];
+}
+
+- (void)testDeltaPerformance
+{
+    NSData *basis = [self contentOfLength:kSignatureBenchmarkLength seed:8];
+    GRKBlockSignature *signature = [GRKBlockSignature signatureOfData:basis blockSize:0];
+    //A small edit in the middle of a large note, which shifts everything after it
+    NSMutableData *edited = [basis mutableCopy];
+    [edited replaceBytesInRange:NSMakeRange(kSignatureBenchmarkLength / 2, 0) withBytes:"edit" length:4];
+
+    [self measureBlock:^{
+        GRKBlockDelta *delta = [signature deltaOfData:edited];
+        XCTAssertTrue(delta.literalBytes < kSignatureBenchmarkLength / 100, @"Most of the content should be matched.");
+    }];
+}
+
+#pragma mark - Helpers
+
+//Pseudo random printable content, so blocks do not repeat
+- (NSData *)contentOfLength:(NSUInteger)length seed:(uint32_t)seed
+{
+    NSMutableData *retVal = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = [retVal mutableBytes];
+    uint32_t state = seed;
+    for (NSUInteger i = 0; i < length; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        bytes[i] = (uint8_t)(' ' + (state >> 24) % 95);
+    }
+    return retVal;
+}
+
+//The literal ranges must lie within the content, in order, and account for the literal bytes
+- (void)assertDelta:(GRKBlockDelta *)delta coversData:(NSData *)data
+{
+    XCTAssertEqual(delta.length, (unsigned long long)data.length, @"The delta should describe all of the content.");
+    XCTAssertEqual(delta.matchedBytes + delta.literalBytes, delta.length, @"Every byte should be either matched or literal.");
+
+    unsigned long long literalBytes = 0;
+    NSUInteger previousEnd = 0;
+    for (NSValue *value in delta.literalRanges)
+    {
+        NSRange range = [value rangeValue];
+        XCTAssertTrue(range.location >= previousEnd, @"Literal ranges should be in order, and not overlap.");
+        XCTAssertTrue(NSMaxRange(range) <= data.length, @"Literal ranges should lie within the content.");
+        literalBytes += range.length;
+        previousEnd = NSMaxRange(range);
+    }
+    XCTAssertEqual(literalBytes, delta.literalBytes, @"The literal ranges should account for the literal bytes.");
+}
+
+@end
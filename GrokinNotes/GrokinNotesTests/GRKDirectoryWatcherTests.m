@@ -0,0 +1,229 @@
+//
+//  GRKDirectoryWatcherTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "GRKDirectoryWatcher.h"
+#import "GRKDirectoryListing.h"
+
+static NSUInteger const kWatcherBenchmarkFileCount = 2000;
+
+/**
+ A backend which signals only when told to, so the tests decide when the watcher scans.
+ */
+@interface GRKManualDirectoryWatcherBackend : NSObject <GRKDirectoryWatcherBackend>
+
+- (void)signal;
+
+@end
+
+@interface GRKManualDirectoryWatcherBackend ()
+
+@property (nonatomic,strong) dispatch_queue_t queue;
+@property (nonatomic,copy) void(^handler)(void);
+
+@end
+
+@implementation GRKManualDirectoryWatcherBackend
+
+- (BOOL)startMonitoringDirectory:(NSURL *)directory queue:(dispatch_queue_t)queue handler:(void(^)(void))handler error:(__autoreleasing NSError **)error
+{
+    self.queue = queue;
+    self.handler = handler;
+    return YES;
+}
+
+- (void)stopMonitoring
+{
+    self.handler = nil;
+}
+
+- (void)signal
+{
+    void(^handler)(void) = self.handler;
+    if (handler)
+    {
+        dispatch_async(self.queue, handler);
+    }
+}
+
+@end
+
+@interface GRKDirectoryWatcherTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+@property (nonatomic,strong) GRKManualDirectoryWatcherBackend *backend;
+@property (nonatomic,strong) GRKDirectoryWatcher *watcher;
+@property (nonatomic,strong) NSMutableArray *events;
+
+@end
+
+@implementation GRKDirectoryWatcherTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.backend = [[GRKManualDirectoryWatcherBackend alloc] init];
+    self.watcher = [[GRKDirectoryWatcher alloc] initWithDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles | GRKDirectoryListingRegularFilesOnly backend:self.backend];
+    self.watcher.latency = 0;
+    self.events = [NSMutableArray array];
+}
+
+- (void)tearDown
+{
+    [self.watcher stop];
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testCreatedModifiedRenamedAndDeletedFilesAreReported
+{
+    [self writeFile:@"Modified" content:@"before"];
+    [self writeFile:@"Renamed" content:@"renamed"];
+    [self writeFile:@"Deleted" content:@"deleted"];
+    [self writeFile:@"Unchanged" content:@"unchanged"];
+    [self startWatcher];
+
+    [self writeFile:@"Created" content:@"created"];
+    [self writeFile:@"Modified" content:@"after, which is longer"];
+    [[NSFileManager defaultManager] moveItemAtURL:[self.directory URLByAppendingPathComponent:@"Renamed"] toURL:[self.directory URLByAppendingPathComponent:@"Now Renamed"] error:nil];
+    [[NSFileManager defaultManager] removeItemAtURL:[self.directory URLByAppendingPathComponent:@"Deleted"] error:nil];
+
+    NSDictionary *events = [self eventsBySignalling];
+    XCTAssertEqual(events.count, (NSUInteger)4, @"Only the changed files should be reported: %@", events);
+    XCTAssertEqual(((GRKDirectoryWatcherEvent *)[events objectForKey:@"Created"]).type, GRKDirectoryWatcherEventCreated, @"The new file should be reported as created.");
+    XCTAssertEqual(((GRKDirectoryWatcherEvent *)[events objectForKey:@"Modified"]).type, GRKDirectoryWatcherEventModified, @"The replaced file should be reported as modified.");
+    XCTAssertEqual(((GRKDirectoryWatcherEvent *)[events objectForKey:@"Deleted"]).type, GRKDirectoryWatcherEventDeleted, @"The removed file should be reported as deleted.");
+    GRKDirectoryWatcherEvent *renamed = [events objectForKey:@"Now Renamed"];
+    XCTAssertEqual(renamed.type, GRKDirectoryWatcherEventRenamed, @"The moved file should be reported as renamed.");
+    XCTAssertEqualObjects([renamed.previousFileURL lastPathComponent], @"Renamed", @"The rename should carry the previous name.");
+}
+
+- (void)testSignalWithoutChangesReportsNothing
+{
+    [self writeFile:@"Unchanged" content:@"unchanged"];
+    [self startWatcher];
+
+    [self writeFile:@"Created" content:@"created"];
+    XCTAssertEqual([self eventsBySignalling].count, (NSUInteger)1, @"The new file should be reported.");
+
+    //The batch is delivered on the main queue, so wait a while for one which should not come
+    [self.backend signal];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertEqual(self.events.count, (NSUInteger)0, @"Nothing should be reported when nothing changed: %@", self.events);
+}
+
+- (void)testListingTakesUnchangedEntriesFromPreviousListing
+{
+    [self writeFile:@"Unchanged" content:@"unchanged"];
+    [self writeFile:@"Replaced" content:@"before"];
+    GRKDirectoryListing *previous = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles error:nil];
+
+    [self writeFile:@"Replaced" content:@"after, which is longer"];
+    [self writeFile:@"Created" content:@"created"];
+    GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles previousListing:previous error:nil];
+    GRKDirectoryListing *fresh = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles error:nil];
+    XCTAssertEqual(listing.count, (NSUInteger)3, @"Every file should be listed.");
+
+    //Every entry of the incremental listing must describe the file as a full listing does
+    for (NSUInteger i = 0; i < listing.count; ++i)
+    {
+        const GRKDirectoryEntry *entry = [listing entryAtIndex:i];
+        NSString *name = [listing nameOfEntry:entry];
+        NSUInteger freshIndex = [fresh indexOfEntryWithFileSystemName:[listing fileSystemNameOfEntry:entry] length:entry->nameLength];
+        XCTAssertNotEqual(freshIndex, (NSUInteger)NSNotFound, @"'%@' should be in both listings.", name);
+        const GRKDirectoryEntry *freshEntry = [fresh entryAtIndex:freshIndex];
+        XCTAssertEqual(entry->inode, freshEntry->inode, @"The inode of '%@' should match.", name);
+        XCTAssertEqual(entry->size, freshEntry->size, @"The size of '%@' should match.", name);
+        XCTAssertEqual(entry->modificationTime, freshEntry->modificationTime, @"The modification time of '%@' should match.", name);
+    }
+    XCTAssertEqual([listing indexOfEntryWithFileSystemName:"Missing" length:7], (NSUInteger)NSNotFound, @"A missing name should not be found.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testFullListingPerformance
+{
+    [self writeFiles:kWatcherBenchmarkFileCount];
+
+    [self measureBlock:^{
+        GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles error:nil];
+        XCTAssertEqual(listing.count, kWatcherBenchmarkFileCount, @"Every file should be listed.");
+    }];
+}
+
+- (void)testIncrementalListingPerformance
+{
+    [self writeFiles:kWatcherBenchmarkFileCount];
+    GRKDirectoryListing *previous = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles error:nil];
+    //A single change, as a typical watcher signal follows
+    [self writeFile:@"File 00000" content:@"changed"];
+
+    [self measureBlock:^{
+        GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles previousListing:previous error:nil];
+        XCTAssertEqual(listing.count, kWatcherBenchmarkFileCount, @"Every file should be listed.");
+    }];
+}
+
+#pragma mark - Helpers
+
+- (void)writeFile:(NSString *)name content:(NSString *)content
+{
+    [content writeToURL:[self.directory URLByAppendingPathComponent:name] atomically:YES encoding:NSUTF8StringEncoding error:nil];
+}
+
+- (void)writeFiles:(NSUInteger)count
+{
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        NSString *name = [NSString stringWithFormat:@"File %05lu", (unsigned long)i];
+        [self writeFile:name content:name];
+    }
+}
+
+- (void)startWatcher
+{
+    __weak GRKDirectoryWatcherTests *weakSelf = self;
+    __autoreleasing NSError *error = nil;
+    BOOL success = [self.watcher startWithHandler:^(NSArray *events) {
+        [weakSelf.events addObjectsFromArray:events];
+    } error:&error];
+    XCTAssertTrue(success, @"The watcher failed to start: %@", error);
+}
+
+/**
+ Signals the watcher, and waits for the batch it reports.
+ @return The events of the batch, by the name of their file.
+ */
+- (NSDictionary *)eventsBySignalling
+{
+    [self.events removeAllObjects];
+    [self.backend signal];
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+    while (self.events.count == 0 && [timeout timeIntervalSinceNow] > 0)
+    {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+
+    NSMutableDictionary *retVal = [NSMutableDictionary dictionaryWithCapacity:self.events.count];
+    for (GRKDirectoryWatcherEvent *event in self.events)
+    {
+        [retVal setObject:event forKey:[event.fileURL lastPathComponent]];
+    }
+    [self.events removeAllObjects];
+    return retVal;
+}
+
+@end
@@ -0,0 +1,162 @@
+//
+//  GRKMergeTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "GRKMerge.h"
+#import "GRKDiff.h"
+
+//About 5 MB a side
+static NSUInteger const kMergeBenchmarkLineCount = 100000;
+//Merges of multi-megabyte notes are to take well under this
+static NSTimeInterval const kMergeBenchmarkTimeLimit = 0.1;
+
+@interface GRKMergeTests : XCTestCase
+
+@end
+
+@implementation GRKMergeTests
+
+#pragma mark - Tests
+
+- (void)testEditsToDifferentLinesMerge
+{
+    GRKMergeResult *result = [self mergeBase:@"one\ntwo\nthree\nfour\nfive\n"
+                                        ours:@"ONE\ntwo\nthree\nfour\nfive\n"
+                                      theirs:@"one\ntwo\nthree\nFOUR\nfive\n"];
+    XCTAssertEqual(result.conflictCount, (NSUInteger)0, @"Edits to different lines should not conflict.");
+    XCTAssertEqual(result.mergedCount, (NSUInteger)2, @"Each edit should be merged.");
+    XCTAssertEqualObjects([self stringOfResult:result], @"ONE\ntwo\nthree\nFOUR\nfive\n", @"Both edits should be kept.");
+}
+
+- (void)testIdenticalEditsMergeOnce
+{
+    GRKMergeResult *result = [self mergeBase:@"one\ntwo\nthree\n"
+                                        ours:@"one\nTWO\nthree\nfour\n"
+                                      theirs:@"one\nTWO\nthree\nfour\n"];
+    XCTAssertEqual(result.conflictCount, (NSUInteger)0, @"The same edit on both sides should not conflict.");
+    XCTAssertEqualObjects([self stringOfResult:result], @"one\nTWO\nthree\nfour\n", @"The edit should be taken once.");
+}
+
+- (void)testEditsToDifferentWordsOfALineMerge
+{
+    GRKMergeResult *result = [self mergeBase:@"first\nThe quick brown fox jumps over the lazy dog.\nlast\n"
+                                        ours:@"first\nThe slow brown fox jumps over the lazy dog.\nlast\n"
+                                      theirs:@"first\nThe quick brown fox jumps over the lazy cat.\nlast\n"];
+    XCTAssertEqual(result.conflictCount, (NSUInteger)0, @"Edits to different words of a line should not conflict.");
+    XCTAssertEqualObjects([self stringOfResult:result], @"first\nThe slow brown fox jumps over the lazy cat.\nlast\n", @"Both edits to the line should be kept.");
+}
+
+- (void)testDeletionMergesWithEditElsewhere
+{
+    GRKMergeResult *result = [self mergeBase:@"one\ntwo\nthree\nfour\nfive\n"
+                                        ours:@"one\nthree\nfour\nfive\n"
+                                      theirs:@"one\ntwo\nthree\nfour\nFIVE\n"];
+    XCTAssertEqual(result.conflictCount, (NSUInteger)0, @"A deletion and an edit of different lines should not conflict.");
+    XCTAssertEqualObjects([self stringOfResult:result], @"one\nthree\nfour\nFIVE\n", @"The deletion and the edit should both be kept.");
+}
+
+- (void)testConflictingEditsAreReported
+{
+    GRKMergeResult *result = [self mergeBase:@"one\nThe lazy dog.\nthree\nfour\nfive\n"
+                                        ours:@"one\nThe lazy cat.\nthree\nfour\nFIVE\n"
+                                      theirs:@"one\nThe lazy cow.\nthree\nfour\nfive\n"];
+    XCTAssertNil(result.data, @"A conflicting merge should have no content.");
+    XCTAssertEqual(result.conflictCount, (NSUInteger)1, @"Only the word changed on both sides should conflict.");
+    XCTAssertEqual(result.mergedCount, (NSUInteger)1, @"The edit to the last line should still be merged.");
+}
+
+- (void)testEditAgainstDeletionConflicts
+{
+    GRKMergeResult *result = [self mergeBase:@"one\ntwo\nthree\n"
+                                        ours:@"one\nthree\n"
+                                      theirs:@"one\nTWO\nthree\n"];
+    XCTAssertNil(result.data, @"Editing a line the other side deleted should conflict.");
+    XCTAssertEqual(result.conflictCount, (NSUInteger)1, @"There should be one conflict.");
+}
+
+- (void)testDiffHunksTransformFirstSequenceIntoSecond
+{
+    GRKDiff *diff = [[GRKDiff alloc] initWithTokenization:GRKDiffTokenizationLines];
+    GRKTokenSequence *old = [diff sequenceWithData:[@"a\nb\nc\nd\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    GRKTokenSequence *updated = [diff sequenceWithData:[@"a\nc\nd\ne\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    NSData *hunkData = [diff hunksFromSequence:old toSequence:updated];
+    const GRKDiffHunk *hunks = [hunkData bytes];
+    XCTAssertEqual(hunkData.length / sizeof(GRKDiffHunk), (NSUInteger)2, @"There should be a deletion and an insertion.");
+    XCTAssertTrue(hunks[0].start1 == 1 && hunks[0].length1 == 1 && hunks[0].length2 == 0, @"The second line should be deleted.");
+    XCTAssertTrue(hunks[1].start1 == 4 && hunks[1].length1 == 0 && hunks[1].start2 == 3 && hunks[1].length2 == 1, @"A line should be added at the end.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testMergePerformance
+{
+    NSData *base = nil;
+    NSData *ours = nil;
+    NSData *theirs = nil;
+    [self benchmarkBase:&base ours:&ours theirs:&theirs];
+
+    [self measureBlock:^{
+        GRKMergeResult *result = [GRKMerge mergeBase:base ours:ours theirs:theirs];
+        XCTAssertEqual(result.conflictCount, (NSUInteger)0, @"The edits should not conflict.");
+        XCTAssertEqual(result.mergedCount, kMergeBenchmarkLineCount / 50, @"Every edit should be merged.");
+    }];
+}
+
+- (void)testMergeTimeLimit
+{
+    NSData *base = nil;
+    NSData *ours = nil;
+    NSData *theirs = nil;
+    [self benchmarkBase:&base ours:&ours theirs:&theirs];
+
+    //The best of a few runs, so a stall of the machine is not taken for the merge
+    NSTimeInterval best = DBL_MAX;
+    for (NSUInteger i = 0; i < 5; ++i)
+    {
+        NSDate *start = [NSDate date];
+        GRKMergeResult *result = [GRKMerge mergeBase:base ours:ours theirs:theirs];
+        best = MIN(best, -[start timeIntervalSinceNow]);
+        XCTAssertEqual(result.conflictCount, (NSUInteger)0, @"The edits should not conflict.");
+    }
+    DDLogInfo(@"Merge of %@ bytes with %@ edits a side: %.1f ms.", @(base.length), @(kMergeBenchmarkLineCount / 100), best * 1000);
+    XCTAssertTrue(best < kMergeBenchmarkTimeLimit, @"Merging %@ bytes took %.1f ms, more than the %.0f ms allowed.", @(base.length), best * 1000, kMergeBenchmarkTimeLimit * 1000);
+}
+
+#pragma mark - Helpers
+
+//A large note, with edits spread through it on both sides, none of which conflict
+- (void)benchmarkBase:(NSData **)base ours:(NSData **)ours theirs:(NSData **)theirs
+{
+    NSMutableArray *baseLines = [NSMutableArray arrayWithCapacity:kMergeBenchmarkLineCount];
+    for (NSUInteger i = 0; i < kMergeBenchmarkLineCount; ++i)
+    {
+        [baseLines addObject:[NSString stringWithFormat:@"Line %lu of the note, with a few words on it.\n", (unsigned long)i]];
+    }
+    NSMutableArray *oursLines = [baseLines mutableCopy];
+    NSMutableArray *theirsLines = [baseLines mutableCopy];
+    for (NSUInteger i = 0; i < kMergeBenchmarkLineCount; i += 100)
+    {
+        [oursLines replaceObjectAtIndex:i withObject:@"Our edit.\n"];
+        [theirsLines replaceObjectAtIndex:i + 50 withObject:@"Their edit.\n"];
+    }
+    *base = [[baseLines componentsJoinedByString:@""] dataUsingEncoding:NSUTF8StringEncoding];
+    *ours = [[oursLines componentsJoinedByString:@""] dataUsingEncoding:NSUTF8StringEncoding];
+    *theirs = [[theirsLines componentsJoinedByString:@""] dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (GRKMergeResult *)mergeBase:(NSString *)base ours:(NSString *)ours theirs:(NSString *)theirs
+{
+    return [GRKMerge mergeBase:[base dataUsingEncoding:NSUTF8StringEncoding] ours:[ours dataUsingEncoding:NSUTF8StringEncoding] theirs:[theirs dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (NSString *)stringOfResult:(GRKMergeResult *)result
+{
+    return result.data ? [[NSString alloc] initWithData:result.data encoding:NSUTF8StringEncoding] : nil;
+}
+
+@end
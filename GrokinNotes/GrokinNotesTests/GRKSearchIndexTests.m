@@ -0,0 +1,234 @@
+//
+//  GRKSearchIndexTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "GRKSearchIndex.h"
+#import "GRKBenchmarkCorpus.h"
+
+//Queries are measured against the largest note stores expected, and indexing against a smaller one, since it is measured from scratch on every run
+static NSUInteger const kSearchBenchmarkDocumentCount = 100000;
+static NSUInteger const kSearchIndexingBenchmarkDocumentCount = 10000;
+static NSUInteger const kSearchBenchmarkWordsPerDocument = 100;
+static NSUInteger const kSearchBenchmarkVocabularySize = 20000;
+//The median time a query may take against the largest note store
+static NSTimeInterval const kSearchQueryTimeLimit = 0.001;
+
+@interface GRKSearchIndexTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+
+@end
+
+@implementation GRKSearchIndexTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testBestMatchIsFirst
+{
+    GRKSearchIndex *index = [self openIndex];
+    [index setText:@"Shopping list: apples, bread and milk." signature:nil forIdentifier:@"shopping"];
+    [index setText:@"Apples, apples, apples. A recipe for apple pie needs apples." signature:nil forIdentifier:@"recipe"];
+    [index setText:@"Meeting notes about the budget." signature:nil forIdentifier:@"meeting"];
+
+    NSArray *identifiers = [index identifiersMatchingQuery:@"apples " limit:10];
+    XCTAssertEqualObjects(identifiers, (@[@"recipe", @"shopping"]), @"The document with the most mentions should be first.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"apples " limit:1], @[@"recipe"], @"The limit should keep only the best matches.");
+    XCTAssertEqual([index identifiersMatchingQuery:@"oranges " limit:10].count, (NSUInteger)0, @"A missing word should match nothing.");
+}
+
+- (void)testCaseAndDiacriticsAreIgnored
+{
+    GRKSearchIndex *index = [self openIndex];
+    [index setText:@"Lunch at the Café Français" signature:nil forIdentifier:@"lunch"];
+
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"cafe " limit:10], @[@"lunch"], @"Diacritics should be ignored.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"FRANÇAIS " limit:10], @[@"lunch"], @"Case should be ignored.");
+}
+
+- (void)testLastWordMatchesAsPrefix
+{
+    GRKSearchIndex *index = [self openIndex];
+    [index setText:@"The quick brown fox" signature:nil forIdentifier:@"fox"];
+
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"brown qui" limit:10], @[@"fox"], @"A partial last word should match the words it begins.");
+    XCTAssertEqual([index identifiersMatchingQuery:@"qui " limit:10].count, (NSUInteger)0, @"A complete word should only match itself.");
+}
+
+- (void)testReplacedAndRemovedDocumentsNoLongerMatch
+{
+    GRKSearchIndex *index = [self openIndex];
+    [index setText:@"An old draft" signature:@"1" forIdentifier:@"draft"];
+    [index setText:@"Something to forget" signature:@"1" forIdentifier:@"forgotten"];
+    [index save:nil];
+
+    [index setText:@"A new version" signature:@"2" forIdentifier:@"draft"];
+    [index removeIdentifier:@"forgotten"];
+
+    XCTAssertEqual([index identifiersMatchingQuery:@"old " limit:10].count, (NSUInteger)0, @"The replaced text should no longer match.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"version " limit:10], @[@"draft"], @"The new text should match.");
+    XCTAssertEqual([index identifiersMatchingQuery:@"forget " limit:10].count, (NSUInteger)0, @"The removed document should no longer match.");
+    XCTAssertEqual(index.documentCount, (NSUInteger)1, @"Only the replaced document should be counted.");
+    XCTAssertEqualObjects([index signatureForIdentifier:@"draft"], @"2", @"The signature should be that of the new text.");
+    XCTAssertNil([index signatureForIdentifier:@"forgotten"], @"The removed document should have no signature.");
+    XCTAssertEqualObjects([index allIdentifiers], [NSSet setWithObject:@"draft"], @"Only the replaced document should be indexed.");
+}
+
+- (void)testSavedIndexIsReopened
+{
+    GRKSearchIndex *index = [self openIndex];
+    [index setText:@"Kept across launches" signature:@"kept" forIdentifier:@"kept"];
+    [index setText:@"Removed before saving" signature:@"removed" forIdentifier:@"removed"];
+    [index save:nil];
+    [index removeIdentifier:@"removed"];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([index save:&error], @"Saving the index failed: %@", error);
+
+    GRKSearchIndex *reopened = [self openIndex];
+    XCTAssertEqual(reopened.documentCount, (NSUInteger)1, @"The saved documents should be reopened.");
+    XCTAssertEqualObjects([reopened signatureForIdentifier:@"kept"], @"kept", @"The signature should be kept.");
+    XCTAssertEqualObjects([reopened identifiersMatchingQuery:@"launches " limit:10], @[@"kept"], @"The saved document should match.");
+    XCTAssertEqual([reopened identifiersMatchingQuery:@"saving " limit:10].count, (NSUInteger)0, @"The removal should be kept.");
+}
+
+- (void)testDamagedSegmentIsDiscarded
+{
+    GRKSearchIndex *index = [self openIndex];
+    [index setText:@"Soon to be damaged" signature:nil forIdentifier:@"damaged"];
+    [index save:nil];
+
+    for (NSURL *url in [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.directory includingPropertiesForKeys:nil options:0 error:nil])
+    {
+        if ([[url pathExtension] isEqualToString:@"seg"])
+        {
+            NSMutableData *data = [NSMutableData dataWithContentsOfURL:url];
+            [data setLength:data.length / 2];
+            [data writeToURL:url atomically:YES];
+        }
+    }
+
+    GRKSearchIndex *reopened = [self openIndex];
+    XCTAssertEqual(reopened.documentCount, (NSUInteger)0, @"The documents of the damaged segment should no longer be indexed.");
+    XCTAssertNil([reopened signatureForIdentifier:@"damaged"], @"The damaged document should have no signature, so it is indexed again.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testIndexingPerformance
+{
+    NSArray *texts = [[self benchmarkCorpus] nextTexts:kSearchIndexingBenchmarkDocumentCount wordCount:kSearchBenchmarkWordsPerDocument];
+
+    [self measureBlock:^{
+        [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+        GRKSearchIndex *index = [self openIndex];
+        [texts enumerateObjectsUsingBlock:^(NSString *text, NSUInteger i, BOOL *stop) {
+            [index setText:text signature:nil forIdentifier:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+        }];
+        [index save:nil];
+        XCTAssertEqual(index.documentCount, kSearchIndexingBenchmarkDocumentCount, @"Every document should be indexed.");
+    }];
+}
+
+- (void)testQueryPerformance
+{
+    GRKSearchIndex *index = [self benchmarkIndex];
+    NSArray *queries = [self benchmarkQueries];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 20; ++i)
+        {
+            for (NSString *query in queries)
+            {
+                XCTAssertTrue([index identifiersMatchingQuery:query limit:50].count > 0, @"'%@' should match.", query);
+            }
+        }
+    }];
+}
+
+- (void)testQueryTimeLimit
+{
+    GRKSearchIndex *index = [self benchmarkIndex];
+    NSArray *queries = [self benchmarkQueries];
+
+    //Each query is timed on its own, and the median taken, so a stall of the machine is not taken for the index
+    NSMutableArray *durations = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 20; ++i)
+    {
+        for (NSString *query in queries)
+        {
+            NSDate *start = [NSDate date];
+            [index identifiersMatchingQuery:query limit:50];
+            [durations addObject:@(-[start timeIntervalSinceNow])];
+        }
+    }
+    [durations sortUsingSelector:@selector(compare:)];
+    NSTimeInterval median = [[durations objectAtIndex:durations.count / 2] doubleValue];
+    NSTimeInterval slowest = [[durations lastObject] doubleValue];
+    DDLogInfo(@"Queries of %@ documents: %.3f ms median, %.3f ms slowest.", @(kSearchBenchmarkDocumentCount), median * 1000, slowest * 1000);
+    XCTAssertTrue(median < kSearchQueryTimeLimit, @"The median query took %.3f ms, more than the %.0f ms allowed.", median * 1000, kSearchQueryTimeLimit * 1000);
+}
+
+#pragma mark - Helpers
+
+- (GRKSearchIndex *)openIndex
+{
+    __autoreleasing NSError *error = nil;
+    GRKSearchIndex *retVal = [[GRKSearchIndex alloc] initWithDirectory:self.directory error:&error];
+    XCTAssertNotNil(retVal, @"Opening the index failed: %@", error);
+    return retVal;
+}
+
+- (GRKBenchmarkCorpus *)benchmarkCorpus
+{
+    return [[GRKBenchmarkCorpus alloc] initWithSeed:1 vocabularySize:kSearchBenchmarkVocabularySize];
+}
+
+//An index of the benchmark corpus, saved, as it is once the notes have been indexed
+- (GRKSearchIndex *)benchmarkIndex
+{
+    GRKBenchmarkCorpus *corpus = [self benchmarkCorpus];
+    GRKSearchIndex *retVal = [self openIndex];
+    for (NSUInteger i = 0; i < kSearchBenchmarkDocumentCount; ++i)
+    {
+        @autoreleasepool {
+            [retVal setText:[corpus nextTextWithWordCount:kSearchBenchmarkWordsPerDocument] signature:nil forIdentifier:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+        }
+    }
+    [retVal save:nil];
+    return retVal;
+}
+
+//Common, uncommon and rare whole words, and the partial words of a query being typed
+- (NSArray *)benchmarkQueries
+{
+    GRKBenchmarkCorpus *corpus = [self benchmarkCorpus];
+    NSString *common = [corpus wordOfRank:3];
+    NSString *uncommon = [corpus wordOfRank:400];
+    NSString *rare = [corpus wordOfRank:5000];
+    return @[[NSString stringWithFormat:@"%@ %@ ", common, uncommon],
+             [NSString stringWithFormat:@"%@ ", rare],
+             [NSString stringWithFormat:@"%@ %@", uncommon, [rare substringToIndex:3]],
+             [common substringToIndex:2],
+             [NSString stringWithFormat:@"%@ ", common]];
+}
+
+@end
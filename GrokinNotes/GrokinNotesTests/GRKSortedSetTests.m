@@ -0,0 +1,268 @@
+//
+//  GRKSortedSetTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "GRKSortedSet.h"
+
+static NSUInteger const kSortedSetBenchmarkCount = 10000;
+static NSUInteger const kSortedSetStressChangeCount = 20000;
+static NSUInteger const kSortedSetStressReaderCount = 4;
+
+@interface GRKSortedSetTests : XCTestCase
+
+//Published by the writer and read concurrently, as NoteManager publishes visibleNotesSnapshot
+@property (atomic,strong) GRKSortedSetSnapshot *publishedSnapshot;
+@property (atomic,assign) BOOL writing;
+
+@end
+
+@implementation GRKSortedSetTests
+
+#pragma mark - Tests
+
+- (void)testChangesKeepTheSetInOrder
+{
+    //Random adds and removes, checked against a sorted array
+    GRKSortedSet *set = [self stringSet];
+    NSMutableArray *expected = [NSMutableArray array];
+    uint32_t state = 1;
+    for (NSUInteger i = 0; i < 2000; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        if (expected.count > 0 && (state >> 16) % 3 == 0)
+        {
+            id object = [expected objectAtIndex:(state >> 8) % expected.count];
+            NSUInteger index = [expected indexOfObjectIdenticalTo:object];
+            XCTAssertEqual([set removeObject:object], index, @"Removal should report the index the object had.");
+            [expected removeObjectAtIndex:index];
+        }
+        else
+        {
+            NSMutableString *object = [NSMutableString stringWithFormat:@"%05u", (state >> 8) % 1000];
+            [expected addObject:object];
+            [self sortStrings:expected];
+            XCTAssertEqual([set addObject:object], [expected indexOfObjectIdenticalTo:object], @"Adding should report the index the object was placed at.");
+        }
+    }
+
+    XCTAssertEqual(set.count, expected.count, @"The set should hold every object added and not removed.");
+    XCTAssertEqualObjects([set allObjects], expected, @"The set should be in order.");
+    for (NSUInteger i = 0; i < expected.count; ++i)
+    {
+        XCTAssertTrue([set objectAtIndex:i] == [expected objectAtIndex:i], @"The object at %@ should match.", @(i));
+        XCTAssertEqual([set indexOfObject:[expected objectAtIndex:i]], i, @"The index of the object at %@ should match.", @(i));
+    }
+}
+
+- (void)testObjectsAreDistinctByIdentity
+{
+    GRKSortedSet *set = [self stringSet];
+    NSMutableString *first = [NSMutableString stringWithString:@"Same"];
+    NSMutableString *second = [NSMutableString stringWithString:@"Same"];
+    XCTAssertNotEqual([set addObject:first], (NSUInteger)NSNotFound, @"The first object should be added.");
+    XCTAssertNotEqual([set addObject:second], (NSUInteger)NSNotFound, @"An equal but distinct object should be added.");
+    XCTAssertEqual([set addObject:first], (NSUInteger)NSNotFound, @"An object already in the set should not be added again.");
+    XCTAssertEqual(set.count, (NSUInteger)2, @"Both objects should be in the set.");
+
+    XCTAssertNotEqual([set removeObject:second], (NSUInteger)NSNotFound, @"The second object should be removed.");
+    XCTAssertTrue([set containsObject:first], @"Removing an equal object should leave the other.");
+    XCTAssertEqual([set removeObject:second], (NSUInteger)NSNotFound, @"An object not in the set should not be removed.");
+}
+
+- (void)testChangedKeyIsFoundAndRepositioned
+{
+    GRKSortedSet *set = [self stringSet];
+    NSMutableString *moved = [NSMutableString stringWithString:@"B"];
+    [set setObjects:@[[NSMutableString stringWithString:@"A"], moved, [NSMutableString stringWithString:@"C"]]];
+    XCTAssertFalse([set keyHasChangedForObject:moved], @"The key should not have changed yet.");
+
+    [moved setString:@"D"];
+    XCTAssertTrue([set keyHasChangedForObject:moved], @"The changed key should be noticed.");
+    XCTAssertEqual([set removeObject:moved], (NSUInteger)1, @"The object should be found under its old key.");
+    XCTAssertEqual([set addObject:moved], (NSUInteger)2, @"The object should be added under its new key.");
+    XCTAssertEqualObjects([set allObjects], (@[@"A", @"C", @"D"]), @"The set should be in order of the new key.");
+}
+
+- (void)testSnapshotsAreUnaffectedByLaterChanges
+{
+    GRKSortedSet *set = [self stringSet];
+    [set setObjects:@[[NSMutableString stringWithString:@"B"], [NSMutableString stringWithString:@"A"]]];
+    GRKSortedSetSnapshot *snapshot = [set snapshot];
+    XCTAssertTrue([set snapshot] == snapshot, @"The same snapshot should be returned until the set changes.");
+    XCTAssertEqual(snapshot.version, set.version, @"The snapshot should be of the current version.");
+
+    [set addObject:[NSMutableString stringWithString:@"C"]];
+    [set removeObject:[set objectAtIndex:0]];
+    XCTAssertTrue(set.version > snapshot.version, @"Changes should advance the version.");
+    XCTAssertEqual(snapshot.count, (NSUInteger)2, @"The snapshot should keep its count.");
+    XCTAssertEqualObjects([snapshot allObjects], (@[@"A", @"B"]), @"The snapshot should keep its objects.");
+    XCTAssertEqualObjects([[set snapshot] allObjects], (@[@"B", @"C"]), @"A new snapshot should show the changes.");
+
+    NSMutableArray *enumerated = [NSMutableArray array];
+    [snapshot enumerateObjectsUsingBlock:^(id object, NSUInteger index, BOOL *stop) {
+        XCTAssertEqual(index, enumerated.count, @"Objects should be enumerated in order.");
+        [enumerated addObject:object];
+    }];
+    XCTAssertEqualObjects(enumerated, [snapshot allObjects], @"Enumeration should visit every object.");
+    XCTAssertThrowsSpecificNamed([snapshot objectAtIndex:2], NSException, NSRangeException, @"An index beyond the end should raise.");
+}
+
+- (void)testConcurrentReadersSeeConsistentSnapshots
+{
+    NSUInteger readCount = 0;
+    NSUInteger violationCount = [self runWriterWithChanges:kSortedSetStressChangeCount readCount:&readCount];
+    XCTAssertTrue(readCount > 0, @"The readers should have read snapshots while the set changed.");
+    XCTAssertEqual(violationCount, (NSUInteger)0, @"Every snapshot read should be complete, in order, and no older than one read before it.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testIncrementalChangePerformance
+{
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:kSortedSetBenchmarkCount];
+    uint32_t state = 2;
+    for (NSUInteger i = 0; i < kSortedSetBenchmarkCount; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        [objects addObject:[NSMutableString stringWithFormat:@"Note %010u", state]];
+    }
+
+    //Each change is followed by a snapshot, as the note list takes one per change
+    [self measureBlock:^{
+        GRKSortedSet *set = [self stringSet];
+        for (id object in objects)
+        {
+            [set addObject:object];
+            [set snapshot];
+        }
+        for (id object in objects)
+        {
+            [set removeObject:object];
+            [set snapshot];
+        }
+        XCTAssertEqual(set.count, (NSUInteger)0, @"Every object should be removed.");
+    }];
+}
+
+- (void)testPublishingWithConcurrentReadersPerformance
+{
+    [self measureBlock:^{
+        NSUInteger readCount = 0;
+        [self runWriterWithChanges:kSortedSetStressChangeCount readCount:&readCount];
+        DDLogInfo(@"%@ changes published while %@ readers read %@ snapshots.", @(kSortedSetStressChangeCount), @(kSortedSetStressReaderCount), @(readCount));
+    }];
+}
+
+#pragma mark - Helpers
+
+/**
+ Changes a set on the calling thread, publishing a snapshot after every change, while readers on other threads walk the published snapshots.
+ @param changeCount The number of changes to make.
+ @param readCount   Receives the number of snapshots the readers walked.
+ @return The number of snapshots found to be inconsistent: out of order, with a count which does not match their objects, or older than one the same reader read before.
+ */
+- (NSUInteger)runWriterWithChanges:(NSUInteger)changeCount readCount:(NSUInteger *)readCount
+{
+    __block NSUInteger retVal = 0;
+    __block NSUInteger reads = 0;
+
+    GRKSortedSet *set = [self stringSet];
+    NSMutableArray *present = [NSMutableArray array];
+    self.publishedSnapshot = [set snapshot];
+    self.writing = YES;
+
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_queue_t resultQueue = dispatch_queue_create("com.levigroker.GrokinNotesTests.results", DISPATCH_QUEUE_SERIAL);
+    for (NSUInteger i = 0; i < kSortedSetStressReaderCount; ++i)
+    {
+        dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSUInteger violations = 0;
+            NSUInteger snapshots = 0;
+            uint64_t lastVersion = 0;
+            while (self.writing)
+            {
+                GRKSortedSetSnapshot *snapshot = self.publishedSnapshot;
+                __block NSString *previous = nil;
+                __block NSUInteger count = 0;
+                [snapshot enumerateObjectsUsingBlock:^(NSString *object, NSUInteger index, BOOL *stop) {
+                    count += 1;
+                    previous = object;
+                }];
+                NSArray *objects = [snapshot allObjects];
+                BOOL sorted = YES;
+                for (NSUInteger j = 1; j < objects.count && sorted; ++j)
+                {
+                    sorted = [[objects objectAtIndex:j - 1] compare:[objects objectAtIndex:j]] != NSOrderedDescending;
+                }
+                if (!sorted || count != snapshot.count || objects.count != snapshot.count || snapshot.version < lastVersion || (count > 0 && previous != [snapshot objectAtIndex:count - 1]))
+                {
+                    violations += 1;
+                }
+                lastVersion = snapshot.version;
+                snapshots += 1;
+            }
+            dispatch_sync(resultQueue, ^{
+                retVal += violations;
+                reads += snapshots;
+            });
+        });
+    }
+
+    uint32_t state = 3;
+    for (NSUInteger i = 0; i < changeCount; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        if (present.count > 1000 || (present.count > 0 && (state >> 16) % 3 == 0))
+        {
+            NSUInteger index = (state >> 8) % present.count;
+            [set removeObject:[present objectAtIndex:index]];
+            [present removeObjectAtIndex:index];
+        }
+        else
+        {
+            NSString *object = [NSString stringWithFormat:@"Note %010u", state];
+            [set addObject:object];
+            [present addObject:object];
+        }
+        self.publishedSnapshot = [set snapshot];
+    }
+
+    self.writing = NO;
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    if (readCount)
+    {
+        *readCount = reads;
+    }
+    return retVal;
+}
+
+
+- (GRKSortedSet *)stringSet
+{
+    return [[GRKSortedSet alloc] initWithKeyBlock:^id(id object) {
+        return [object copy];
+    } comparator:^NSComparisonResult(id key1, id key2) {
+        return [key1 compare:key2];
+    }];
+}
+
+//Sorts as the set does: by value, then by identity
+- (void)sortStrings:(NSMutableArray *)strings
+{
+    [strings sortUsingComparator:^NSComparisonResult(id string1, id string2) {
+        NSComparisonResult retVal = [string1 compare:string2];
+        if (retVal == NSOrderedSame && string1 != string2)
+        {
+            retVal = (uintptr_t)(__bridge void *)string1 < (uintptr_t)(__bridge void *)string2 ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return retVal;
+    }];
+}
+
+@end
@@ -0,0 +1,184 @@
+//
+//  GRKTrigramIndexTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "GRKTrigramIndex.h"
+#import "GRKBenchmarkCorpus.h"
+
+static NSUInteger const kTrigramBenchmarkDocumentCount = 2000;
+static NSUInteger const kTrigramBenchmarkWordsPerDocument = 150;
+static NSUInteger const kTrigramBenchmarkVocabularySize = 2000;
+
+@interface GRKTrigramIndexTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+@property (nonatomic,strong) NSURL *url;
+
+@end
+
+@implementation GRKTrigramIndexTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+    self.url = [self.directory URLByAppendingPathComponent:@"TrigramIndex.bin"];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testSubstringsMatch
+{
+    GRKTrigramIndex *index = [[GRKTrigramIndex alloc] initWithURL:nil];
+    [index setText:@"The ingredients of an apple pie" signature:nil forIdentifier:@"pie"];
+    [index setText:@"Meeting notes" signature:nil forIdentifier:@"meeting"];
+
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"gredie" maximumErrors:0 limit:10], @[@"pie"], @"Part of a word should match.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"an apple" maximumErrors:0 limit:10], @[@"pie"], @"Text spanning words should match.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"pi" maximumErrors:2 limit:10], @[@"pie"], @"A query too short for trigrams should still match.");
+    XCTAssertEqual([index identifiersMatchingQuery:@"banana" maximumErrors:0 limit:10].count, (NSUInteger)0, @"Missing text should match nothing.");
+}
+
+- (void)testCaseAndDiacriticsAreIgnored
+{
+    GRKTrigramIndex *index = [[GRKTrigramIndex alloc] initWithURL:nil];
+    [index setText:@"Lunch at the café" signature:nil forIdentifier:@"lunch"];
+
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"CAFE" maximumErrors:0 limit:10], @[@"lunch"], @"Case and diacritics should be ignored.");
+}
+
+- (void)testCloseMatchesFollowExactOnes
+{
+    GRKTrigramIndex *index = [[GRKTrigramIndex alloc] initWithURL:nil];
+    [index setText:@"It is definately the plan" signature:nil forIdentifier:@"misspelled"];
+    [index setText:@"It is definitely the plan" signature:nil forIdentifier:@"exact"];
+    [index setText:@"It is undefined" signature:nil forIdentifier:@"unrelated"];
+
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"definitely" maximumErrors:2 limit:10], (@[@"exact", @"misspelled"]), @"The exact match should come before the close one.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"definitely" maximumErrors:0 limit:10], @[@"exact"], @"Without errors only the exact match should be found.");
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"definitely" maximumErrors:2 limit:1], @[@"exact"], @"The limit should keep only the best match.");
+}
+
+- (void)testReplacedAndRemovedDocumentsNoLongerMatch
+{
+    GRKTrigramIndex *index = [[GRKTrigramIndex alloc] initWithURL:nil];
+    [index setText:@"An old draft" signature:@"1" forIdentifier:@"draft"];
+    [index setText:@"Something to forget" signature:@"1" forIdentifier:@"forgotten"];
+    [index setText:@"An old draft, revised" signature:@"2" forIdentifier:@"draft"];
+    [index removeIdentifier:@"forgotten"];
+
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"revised" maximumErrors:0 limit:10], @[@"draft"], @"The edit should match.");
+    XCTAssertEqual([index identifiersMatchingQuery:@"forget" maximumErrors:0 limit:10].count, (NSUInteger)0, @"The removed document should no longer match.");
+    XCTAssertEqual(index.documentCount, (NSUInteger)1, @"Only the replaced document should be counted.");
+    XCTAssertEqualObjects([index signatureForIdentifier:@"draft"], @"2", @"The signature should be that of the new text.");
+    XCTAssertNil([index signatureForIdentifier:@"forgotten"], @"The removed document should have no signature.");
+}
+
+- (void)testSavedIndexIsLoaded
+{
+    GRKTrigramIndex *index = [[GRKTrigramIndex alloc] initWithURL:self.url];
+    [index setText:@"Kept across launches" signature:@"kept" forIdentifier:@"kept"];
+    [index setText:@"Another note" signature:nil forIdentifier:@"another"];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([index save:&error], @"Saving the index failed: %@", error);
+    //Read back from the file just written
+    XCTAssertEqualObjects([index identifiersMatchingQuery:@"launch" maximumErrors:0 limit:10], @[@"kept"], @"The saved index should still match.");
+
+    GRKTrigramIndex *loaded = [[GRKTrigramIndex alloc] initWithURL:self.url];
+    XCTAssertTrue([loaded load:&error], @"Loading the index failed: %@", error);
+    XCTAssertEqualObjects([loaded allIdentifiers], ([NSSet setWithObjects:@"kept", @"another", nil]), @"Every document should be loaded.");
+    XCTAssertEqualObjects([loaded signatureForIdentifier:@"kept"], @"kept", @"The signature should be loaded.");
+    XCTAssertNil([loaded signatureForIdentifier:@"another"], @"A missing signature should stay missing.");
+    XCTAssertEqualObjects([loaded identifiersMatchingQuery:@"acros launches" maximumErrors:2 limit:10], @[@"kept"], @"The loaded index should find close matches.");
+}
+
+- (void)testDamagedIndexIsRejected
+{
+    GRKTrigramIndex *index = [[GRKTrigramIndex alloc] initWithURL:self.url];
+    [index setText:@"Soon to be damaged" signature:nil forIdentifier:@"damaged"];
+    [index save:nil];
+
+    NSMutableData *data = [NSMutableData dataWithContentsOfURL:self.url];
+    [data setLength:data.length - 5];
+    [data writeToURL:self.url atomically:YES];
+
+    GRKTrigramIndex *loaded = [[GRKTrigramIndex alloc] initWithURL:self.url];
+    __autoreleasing NSError *error = nil;
+    XCTAssertFalse([loaded load:&error], @"A truncated index should not be loaded.");
+    XCTAssertEqualObjects(error.domain, GRKTrigramIndexErrorDomain, @"The error should be an index error.");
+    XCTAssertEqual(loaded.documentCount, (NSUInteger)0, @"Nothing should be loaded from a damaged index.");
+
+    [@"Not an index" writeToURL:self.url atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertFalse([loaded load:&error], @"A file which is not an index should not be loaded.");
+    XCTAssertEqual(error.code, (NSInteger)GRKTrigramIndexErrorBadFormat, @"The format should be reported as bad.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testQueryPerformance
+{
+    GRKTrigramIndex *index = [self benchmarkIndex];
+
+    //Exact, misspelled and partial queries, as typed in the search field
+    GRKBenchmarkCorpus *corpus = [self benchmarkCorpus];
+    NSString *common = [corpus wordOfRank:2];
+    NSString *uncommon = [corpus wordOfRank:300];
+    NSString *misspelled = [uncommon stringByReplacingCharactersInRange:NSMakeRange(2, 1) withString:@""];
+    NSArray *queries = @[common, uncommon, misspelled, [uncommon substringToIndex:uncommon.length - 1], [corpus wordOfRank:1000]];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10; ++i)
+        {
+            for (NSString *query in queries)
+            {
+                XCTAssertTrue([index identifiersMatchingQuery:query maximumErrors:2 limit:50].count > 0, @"'%@' should match.", query);
+            }
+        }
+    }];
+}
+
+- (void)testLoadPerformance
+{
+    GRKTrigramIndex *index = [self benchmarkIndex];
+    [index save:nil];
+
+    [self measureBlock:^{
+        GRKTrigramIndex *loaded = [[GRKTrigramIndex alloc] initWithURL:self.url];
+        [loaded load:nil];
+        XCTAssertEqual(loaded.documentCount, kTrigramBenchmarkDocumentCount, @"Every document should be loaded.");
+    }];
+}
+
+#pragma mark - Helpers
+
+- (GRKBenchmarkCorpus *)benchmarkCorpus
+{
+    return [[GRKBenchmarkCorpus alloc] initWithSeed:1 vocabularySize:kTrigramBenchmarkVocabularySize];
+}
+
+- (GRKTrigramIndex *)benchmarkIndex
+{
+    GRKBenchmarkCorpus *corpus = [self benchmarkCorpus];
+    GRKTrigramIndex *retVal = [[GRKTrigramIndex alloc] initWithURL:self.url];
+    for (NSUInteger i = 0; i < kTrigramBenchmarkDocumentCount; ++i)
+    {
+        [retVal setText:[corpus nextTextWithWordCount:kTrigramBenchmarkWordsPerDocument] signature:nil forIdentifier:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+    }
+    return retVal;
+}
+
+@end
@@ -0,0 +1,171 @@
+//
+//  GoogleDriveManagerTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#if DEBUG
+
+#import "GoogleDriveManager.h"
+#import "FakeDriveServer.h"
+
+//A large Drive: many files of other kinds, among which are a few notes
+static NSUInteger const kChangeFeedBenchmarkUnrelatedFileCount = 100000;
+static NSUInteger const kChangeFeedBenchmarkNoteCount = 100;
+static NSTimeInterval const kRequestTimeout = 30;
+//Reading the change feed of the large Drive takes many pages
+static NSTimeInterval const kChangeFeedBenchmarkTimeout = 600;
+
+/**
+ Exercises the change feed against a FakeDriveServer, which honors partial response field selections as Drive does.
+ */
+@interface GoogleDriveManagerTests : XCTestCase
+
+@property (nonatomic,strong) FakeDriveServer *server;
+@property (nonatomic,strong) GoogleDriveManager *driveManager;
+
+@end
+
+@implementation GoogleDriveManagerTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    self.server = [[FakeDriveServer alloc] initWithSeed:1];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([self.server start:&error], @"The server failed to start: %@", error);
+    self.driveManager = [[GoogleDriveManager alloc] init];
+    [self.driveManager startupWithServiceURL:self.server.baseURL authorizer:self.server.authorizer];
+}
+
+- (void)tearDown
+{
+    [self.server stop];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testOnlyNamedPlainTextFilesAreNotes
+{
+    GTLDriveFile *file = [GTLDriveFile object];
+    file.identifier = @"file";
+    file.title = @"Note";
+    file.mimeType = kMIMETypeTextPlain;
+    XCTAssertTrue([self.driveManager isNoteFile:file], @"A named plain text file should be a note.");
+
+    file.mimeType = @"application/pdf";
+    XCTAssertFalse([self.driveManager isNoteFile:file], @"Other types of file should not be notes.");
+
+    file.mimeType = kMIMETypeTextPlain;
+    file.title = nil;
+    XCTAssertFalse([self.driveManager isNoteFile:file], @"A file without a title should not be a note.");
+
+    XCTAssertFalse([self.driveManager isNoteFile:nil], @"A missing file should not be a note.");
+}
+
+- (void)testChangeFeedHoldsOnlyTheFieldsNotesNeed
+{
+    NSData *content = [@"Some content" dataUsingEncoding:NSUTF8StringEncoding];
+    NSString *fileID = [self.server insertFileWithTitle:@"Note" content:content];
+
+    NSArray *changes = [self retrieveAllChanges];
+    XCTAssertEqual(changes.count, (NSUInteger)1, @"There should be one change per file.");
+    GTLDriveChange *change = [changes firstObject];
+    XCTAssertEqualObjects(change.fileId, fileID, @"The change should name its file.");
+    XCTAssertEqualObjects(change.file.title, @"Note", @"The title should be included.");
+    XCTAssertEqualObjects(change.file.mimeType, kMIMETypeTextPlain, @"The MIME type should be included.");
+    XCTAssertNotNil(change.file.md5Checksum, @"The checksum should be included.");
+    XCTAssertNotNil(change.file.downloadUrl, @"The download URL should be included.");
+    XCTAssertNotNil(change.file.labels.trashed, @"The trashed label should be included.");
+    XCTAssertTrue(change.file.parents.count > 0, @"The parents should be included.");
+
+    //Fields the server holds, but which are not asked for
+    XCTAssertNil(change.file.fileSize, @"The file size should not be included.");
+    XCTAssertNil(change.file.modifiedDate, @"The modification date should not be included.");
+    XCTAssertNil(change.file.editable, @"The editable flag should not be included.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testChangeFeedPerformance
+{
+    NSArray *mimeTypes = @[@"application/pdf", @"image/jpeg", @"application/vnd.google-apps.spreadsheet", @"application/vnd.google-apps.folder", @"video/mp4"];
+    NSData *content = [@"Not a note" dataUsingEncoding:NSUTF8StringEncoding];
+    for (NSUInteger i = 0; i < kChangeFeedBenchmarkUnrelatedFileCount; ++i)
+    {
+        @autoreleasepool {
+            NSString *title = [NSString stringWithFormat:@"File %06lu", (unsigned long)i];
+            [self.server insertFileWithTitle:title mimeType:[mimeTypes objectAtIndex:i % mimeTypes.count] content:content];
+            //The notes are spread among the other files
+            if (i % (kChangeFeedBenchmarkUnrelatedFileCount / kChangeFeedBenchmarkNoteCount) == 0)
+            {
+                title = [NSString stringWithFormat:@"Note %06lu", (unsigned long)i];
+                [self.server insertFileWithTitle:title content:[title dataUsingEncoding:NSUTF8StringEncoding]];
+            }
+        }
+    }
+
+    //A page at a time, with the notes picked out locally, as refreshFromRemote: does
+    [self measureBlock:^{
+        [self.server resetStatistics];
+        __block NSUInteger changeCount = 0;
+        __block NSUInteger noteCount = 0;
+        __block BOOL finished = NO;
+        [self.driveManager enumerateChangesSinceChangeID:nil pageSize:0 pageHandler:^(NSArray *changes, NSNumber *checkpointChangeID, BOOL lastPage, void (^next)(BOOL proceed)) {
+            changeCount += changes.count;
+            for (GTLDriveChange *change in changes)
+            {
+                if ([self.driveManager isNoteFile:change.file])
+                {
+                    noteCount += 1;
+                }
+            }
+            next(YES);
+        } completion:^(NSNumber *largestChangeID, NSError *error) {
+            XCTAssertNil(error, @"Enumerating the changes failed: %@", error);
+            finished = YES;
+        }];
+        [self waitFor:&finished timeout:kChangeFeedBenchmarkTimeout];
+
+        XCTAssertEqual(changeCount, kChangeFeedBenchmarkUnrelatedFileCount + kChangeFeedBenchmarkNoteCount, @"There should be one change per file.");
+        XCTAssertEqual(noteCount, kChangeFeedBenchmarkNoteCount, @"Only the notes should be picked out.");
+        DDLogInfo(@"Change feed of %@ files, %@ of them notes: %@ bytes received.", @(changeCount), @(noteCount), @(self.server.bytesSent));
+    }];
+}
+
+#pragma mark - Helpers
+
+- (NSArray *)retrieveAllChanges
+{
+    __block BOOL finished = NO;
+    __block NSArray *retVal = nil;
+    [self.driveManager retrieveAllChangesSinceChangeID:nil completion:^(NSArray *changes, NSNumber *largestChangeID, NSError *error) {
+        XCTAssertNil(error, @"Retrieving the changes failed: %@", error);
+        retVal = changes;
+        finished = YES;
+    }];
+    [self waitFor:&finished timeout:kRequestTimeout];
+
+    return retVal;
+}
+
+- (void)waitFor:(BOOL *)finished timeout:(NSTimeInterval)timeout
+{
+    NSDate *limit = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (!*finished && [limit timeIntervalSinceNow] > 0)
+    {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    XCTAssertTrue(*finished, @"Retrieving the changes timed out.");
+}
+
+@end
+
+#endif
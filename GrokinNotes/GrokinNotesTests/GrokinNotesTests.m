@@ -7,9 +7,31 @@
 //
 
 #import <XCTest/XCTest.h>
+#import "NoteManager.h"
+#import "Note.h"
+#import "NoteIndex.h"
+#import "NoteJournal.h"
+#import "GRKDirectoryListing.h"
 
+//The note stores the startup scan is measured with: a large one, and one well beyond what most users have
+static NSUInteger const kScanBenchmarkNoteCount = 10000;
+static NSUInteger const kScanLargeBenchmarkNoteCount = 100000;
+
+//The startup scan, which is private to the NoteManager
+@interface NoteManager (StartupScan)
+
+- (NSArray *)fetchNotesFromDirectory:(NSURL *)directory indexedCount:(NSUInteger *)indexedCount;
+
+@end
+
+/**
+ Exercises the startup scan of the notes directory (see `-[NoteManager updateNotesWithCompletion:]`), which lists the directory, validates the note index against the listing, and builds the notes concurrently.
+ */
 @interface GrokinNotesTests : XCTestCase
 
+@property (nonatomic,strong) NSURL *directory;
+@property (nonatomic,strong) NoteJournal *journal;
+
 @end
 
 @implementation GrokinNotesTests
@@ -17,18 +39,205 @@
 - (void)setUp
 {
     [super setUp];
-    // Put setup code here. This method is called before the invocation of each test method in the class.
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    //Notes in the scratch directory keep their metadata in extended attributes, rather than the application's journal
+    self.journal = [Note journal];
+    [Note setJournal:nil];
 }
 
 - (void)tearDown
 {
-    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    [Note setJournal:self.journal];
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
     [super tearDown];
 }
 
-- (void)testExample
+#pragma mark - Tests
+
+- (void)testListingIncludesOnlyVisibleRegularFiles
+{
+    [self writeNoteFiles:3];
+    [@"hidden" writeToURL:[self.directory URLByAppendingPathComponent:@".hidden"] atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    [[NSFileManager defaultManager] createDirectoryAtURL:[self.directory URLByAppendingPathComponent:@"Folder"] withIntermediateDirectories:NO attributes:nil error:nil];
+
+    GRKDirectoryListingOptions options = GRKDirectoryListingSkipsHiddenFiles | GRKDirectoryListingRegularFilesOnly | GRKDirectoryListingReadableWritableOnly;
+    __autoreleasing NSError *error = nil;
+    GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:options error:&error];
+    XCTAssertNotNil(listing, @"Listing failed: %@", error);
+    XCTAssertEqual(listing.count, (NSUInteger)3, @"Only the note files should be listed.");
+
+    NSMutableSet *names = [NSMutableSet set];
+    for (NSUInteger i = 0; i < listing.count; ++i)
+    {
+        const GRKDirectoryEntry *entry = [listing entryAtIndex:i];
+        NSString *name = [listing nameOfEntry:entry];
+        [names addObject:name];
+        XCTAssertEqual([listing indexOfEntryWithFileSystemName:[listing fileSystemNameOfEntry:entry] length:entry->nameLength], i, @"Entry '%@' should be found by name.", name);
+    }
+    XCTAssertEqualObjects(names, [NSSet setWithArray:[self noteNames:3]], @"The listed names should be those of the note files.");
+}
+
+- (void)testScanAssignsStableLocalIDs
+{
+    [self writeNoteFiles:500];
+
+    NSArray *notes = [[NoteManager shared] fetchNotesFromDirectory:self.directory indexedCount:NULL];
+    XCTAssertEqual(notes.count, (NSUInteger)500, @"There should be one note per file.");
+    NSMutableDictionary *localIDs = [NSMutableDictionary dictionaryWithCapacity:notes.count];
+    for (Note *note in notes)
+    {
+        XCTAssertNotNil(note.localID, @"Every note should be given a local ID.");
+        [localIDs setValue:note.localID forKey:note.title];
+    }
+    XCTAssertEqual(localIDs.count, notes.count, @"Every note should have its own title.");
+    XCTAssertEqual([NSSet setWithArray:[localIDs allValues]].count, notes.count, @"Every note should have its own local ID.");
+
+    //The concurrent scan must produce the same notes on every run
+    NSArray *rescanned = [[NoteManager shared] fetchNotesFromDirectory:self.directory indexedCount:NULL];
+    XCTAssertEqual(rescanned.count, notes.count, @"A second scan should find the same notes.");
+    for (Note *note in rescanned)
+    {
+        XCTAssertEqualObjects(note.localID, [localIDs objectForKey:note.title], @"Local IDs should be kept between scans.");
+    }
+}
+
+- (void)testIndexEntriesAreOnlyValidForUnchangedFiles
+{
+    [self writeNoteFiles:10];
+    NSArray *notes = [[NoteManager shared] fetchNotesFromDirectory:self.directory indexedCount:NULL];
+    NoteIndex *index = [self savedIndexOfNotes:notes];
+
+    //Rewrite one note, which gives it a new inode and modification time
+    Note *changed = [notes firstObject];
+    [@"changed" writeToURL:changed.file atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:GRKDirectoryListingSkipsHiddenFiles error:nil];
+    NSUInteger validCount = 0;
+    for (NSUInteger i = 0; i < listing.count; ++i)
+    {
+        const GRKDirectoryEntry *directoryEntry = [listing entryAtIndex:i];
+        NoteIndexEntry *entry = [index validEntryForDirectoryEntry:directoryEntry inListing:listing];
+        if ([[listing nameOfEntry:directoryEntry] isEqualToString:changed.title])
+        {
+            XCTAssertNil(entry, @"The entry of a changed file should not be valid.");
+        }
+        else if (entry)
+        {
+            validCount++;
+        }
+    }
+    XCTAssertEqual(validCount, notes.count - 1, @"The entries of unchanged files should be valid.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testListingPerformance
+{
+    [self measureListingOfNoteCount:kScanBenchmarkNoteCount];
+}
+
+- (void)testLargeListingPerformance
+{
+    [self measureListingOfNoteCount:kScanLargeBenchmarkNoteCount];
+}
+
+- (void)testScanPerformance
+{
+    [self measureScanOfNoteCount:kScanBenchmarkNoteCount];
+}
+
+- (void)testLargeScanPerformance
+{
+    [self measureScanOfNoteCount:kScanLargeBenchmarkNoteCount];
+}
+
+- (void)testIndexValidationPerformance
+{
+    [self measureIndexValidationOfNoteCount:kScanBenchmarkNoteCount];
+}
+
+- (void)testLargeIndexValidationPerformance
+{
+    [self measureIndexValidationOfNoteCount:kScanLargeBenchmarkNoteCount];
+}
+
+#pragma mark - Helpers
+
+- (void)measureListingOfNoteCount:(NSUInteger)count
+{
+    [self writeNoteFiles:count];
+
+    GRKDirectoryListingOptions options = GRKDirectoryListingSkipsHiddenFiles | GRKDirectoryListingRegularFilesOnly | GRKDirectoryListingReadableWritableOnly;
+    [self measureBlock:^{
+        GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:options error:nil];
+        XCTAssertEqual(listing.count, count, @"Every note file should be listed.");
+    }];
+}
+
+- (void)measureScanOfNoteCount:(NSUInteger)count
+{
+    [self writeNoteFiles:count];
+    //The first scan gives every note a local ID, which later scans read back
+    [[NoteManager shared] fetchNotesFromDirectory:self.directory indexedCount:NULL];
+
+    [self measureBlock:^{
+        NSArray *notes = [[NoteManager shared] fetchNotesFromDirectory:self.directory indexedCount:NULL];
+        XCTAssertEqual(notes.count, count, @"There should be one note per file.");
+    }];
+}
+
+- (void)measureIndexValidationOfNoteCount:(NSUInteger)count
+{
+    [self writeNoteFiles:count];
+    NoteIndex *index = [self savedIndexOfNotes:[[NoteManager shared] fetchNotesFromDirectory:self.directory indexedCount:NULL]];
+
+    GRKDirectoryListingOptions options = GRKDirectoryListingSkipsHiddenFiles | GRKDirectoryListingRegularFilesOnly | GRKDirectoryListingReadableWritableOnly;
+    [self measureBlock:^{
+        GRKDirectoryListing *listing = [GRKDirectoryListing listingOfDirectory:self.directory options:options error:nil];
+        NSUInteger validCount = 0;
+        for (NSUInteger i = 0; i < listing.count; ++i)
+        {
+            if ([index validEntryForDirectoryEntry:[listing entryAtIndex:i] inListing:listing])
+            {
+                validCount++;
+            }
+        }
+        XCTAssertEqual(validCount, count, @"Every entry should be valid.");
+    }];
+}
+
+- (NSArray *)noteNames:(NSUInteger)count
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        [retVal addObject:[NSString stringWithFormat:@"Note %06lu", (unsigned long)i]];
+    }
+    return retVal;
+}
+
+- (void)writeNoteFiles:(NSUInteger)count
+{
+    for (NSString *name in [self noteNames:count])
+    {
+        @autoreleasepool {
+            NSString *content = [NSString stringWithFormat:@"%@\nSome content of the note.\n", name];
+            [content writeToURL:[self.directory URLByAppendingPathComponent:name] atomically:NO encoding:NSUTF8StringEncoding error:nil];
+        }
+    }
+}
+
+- (NoteIndex *)savedIndexOfNotes:(NSArray *)notes
 {
-    XCTFail(@"No implementation for \"%s\"", __PRETTY_FUNCTION__);
+    NoteIndex *retVal = [[NoteIndex alloc] initWithURL:[self.directory URLByAppendingPathComponent:@".NoteIndex"]];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([retVal saveNotes:notes error:&error], @"Saving the index failed: %@", error);
+    return retVal;
 }
 
 @end
@@ -0,0 +1,247 @@
+//
+//  NoteJournalTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "NoteJournal.h"
+#import "Note.h"
+
+static NSUInteger const kJournalBenchmarkNoteCount = 100;
+static NSUInteger const kJournalBenchmarkRecordsPerNote = 100;
+
+@interface NoteJournalTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+@property (nonatomic,strong) NSURL *journalURL;
+@property (nonatomic,strong) NoteJournal *journal;
+
+@end
+
+@implementation NoteJournalTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+    self.journalURL = [self.directory URLByAppendingPathComponent:@".NoteJournal"];
+
+    //The notes of the tests are recorded explicitly, rather than through the application's journal
+    self.journal = [Note journal];
+    [Note setJournal:nil];
+}
+
+- (void)tearDown
+{
+    [Note setJournal:self.journal];
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testReplayRestoresRecordedState
+{
+    NoteJournal *journal = [self emptyJournal];
+    Note *note = [self noteNamed:@"First" localID:@"local-1"];
+    [note writeRemoteID:@"remote-1"];
+    [note writeDirty:YES];
+    [journal recordNote:note syncedMD5:@"md5"];
+    [journal recordNote:[self noteNamed:@"Second" localID:@"local-2"] syncedMD5:nil];
+    [journal flush];
+
+    NoteJournal *replayed = [self replayedJournal];
+    NoteJournalState *state = [replayed stateForFileName:@"First"];
+    XCTAssertEqualObjects(state.localID, @"local-1", @"The local ID should be replayed.");
+    XCTAssertEqualObjects(state.remoteID, @"remote-1", @"The remote ID should be replayed.");
+    XCTAssertEqualObjects(state.syncedMD5, @"md5", @"The synced checksum should be replayed.");
+    XCTAssertTrue(state.dirty, @"The dirty flag should be replayed.");
+    XCTAssertFalse(state.deleted, @"The deleted flag should be replayed.");
+
+    state = [replayed stateForFileName:@"Second"];
+    XCTAssertEqualObjects(state.localID, @"local-2", @"Every note should be replayed.");
+    XCTAssertNil(state.remoteID, @"A missing remote ID should stay missing.");
+    XCTAssertNil(state.syncedMD5, @"A missing synced checksum should stay missing.");
+}
+
+- (void)testTornTailIsDiscarded
+{
+    NoteJournal *journal = [self emptyJournal];
+    [journal recordNote:[self noteNamed:@"Kept" localID:@"local-1"] syncedMD5:nil];
+    [journal flush];
+    unsigned long long goodLength = [self journalLength];
+    [journal recordNote:[self noteNamed:@"Torn" localID:@"local-2"] syncedMD5:nil];
+    [journal flush];
+
+    //A crash part way through writing the last record
+    [self truncateJournalToLength:[self journalLength] - 3];
+
+    NoteJournal *replayed = [self replayedJournal];
+    XCTAssertEqualObjects([replayed stateForFileName:@"Kept"].localID, @"local-1", @"The records before the torn one should be kept.");
+    XCTAssertNil([replayed stateForFileName:@"Torn"], @"The torn record should be discarded.");
+    XCTAssertEqual([self journalLength], goodLength, @"The journal should be truncated to the last good record.");
+
+    //Later records follow the last good one, so they survive the next replay
+    [replayed recordNote:[self noteNamed:@"Later" localID:@"local-3"] syncedMD5:nil];
+    [replayed flush];
+    NoteJournal *again = [self replayedJournal];
+    XCTAssertNotNil([again stateForFileName:@"Kept"], @"The good record should still be replayed.");
+    XCTAssertEqualObjects([again stateForFileName:@"Later"].localID, @"local-3", @"A record appended after the truncation should be replayed.");
+}
+
+- (void)testCorruptRecordIsDiscarded
+{
+    NoteJournal *journal = [self emptyJournal];
+    [journal recordNote:[self noteNamed:@"Kept" localID:@"local-1"] syncedMD5:nil];
+    [journal recordNote:[self noteNamed:@"Corrupt" localID:@"local-2"] syncedMD5:nil];
+    [journal flush];
+
+    //Damage the file name of the last record, which its checksum covers
+    NSMutableData *data = [NSMutableData dataWithContentsOfURL:self.journalURL];
+    ((uint8_t *)[data mutableBytes])[data.length - 1] ^= 0xFF;
+    [data writeToURL:self.journalURL atomically:YES];
+
+    NoteJournal *replayed = [self replayedJournal];
+    XCTAssertNotNil([replayed stateForFileName:@"Kept"], @"The records before the corrupt one should be kept.");
+    XCTAssertNil([replayed stateForFileName:@"Corrupt"], @"The corrupt record should be discarded.");
+}
+
+- (void)testJournalOfAnotherFormatIsRejected
+{
+    [@"Not a journal" writeToURL:self.journalURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    NoteJournal *journal = [self emptyJournal];
+    __autoreleasing NSError *error = nil;
+    XCTAssertFalse([journal replay:&error], @"A file which is not a journal should not be replayed.");
+    XCTAssertEqualObjects(error.domain, NoteJournalErrorDomain, @"The error should be a journal error.");
+    XCTAssertEqual(error.code, (NSInteger)NoteJournalErrorBadFormat, @"The format should be reported as bad.");
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self.journalURL path]], @"The bad journal should be discarded.");
+}
+
+- (void)testForgottenNoteIsNotReplayed
+{
+    NoteJournal *journal = [self emptyJournal];
+    [journal recordNote:[self noteNamed:@"Forgotten" localID:@"local-1"] syncedMD5:nil];
+    [journal forgetLocalID:@"local-1"];
+    [journal flush];
+    XCTAssertNil([journal stateForFileName:@"Forgotten"], @"A forgotten note should have no state.");
+    XCTAssertNil([[self replayedJournal] stateForFileName:@"Forgotten"], @"A forgotten note should not be replayed.");
+}
+
+- (void)testCompactionWritesExtendedAttributes
+{
+    NoteJournal *journal = [self emptyJournal];
+    Note *note = [self noteNamed:@"Compacted" localID:@"local-1"];
+    [journal recordNote:note syncedMD5:@"md5"];
+    [journal flush];
+    XCTAssertNotNil([journal stateForFileName:@"Compacted"], @"The note should be recorded.");
+
+    XCTAssertEqual([journal compact], (NSUInteger)1, @"The metadata of the note should be written.");
+    XCTAssertNil([journal stateForFileName:@"Compacted"], @"The journal should be empty after compaction.");
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self.journalURL path]], @"The journal file should be removed.");
+
+    Note *read = [[Note alloc] init];
+    read.file = note.file;
+    XCTAssertEqualObjects(read.localID, @"local-1", @"The local ID should be read from the file.");
+    XCTAssertEqualObjects([read readSyncedMD5], @"md5", @"The synced checksum should be read from the file.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testRecordPerformance
+{
+    NSArray *notes = [self benchmarkNotes];
+
+    [self measureBlock:^{
+        NoteJournal *journal = [self emptyJournal];
+        for (NSUInteger i = 0; i < kJournalBenchmarkRecordsPerNote; ++i)
+        {
+            for (Note *note in notes)
+            {
+                [journal recordNote:note syncedMD5:@"d41d8cd98f00b204e9800998ecf8427e"];
+            }
+        }
+        [journal flush];
+        [[NSFileManager defaultManager] removeItemAtURL:self.journalURL error:nil];
+    }];
+}
+
+- (void)testReplayPerformance
+{
+    NSArray *notes = [self benchmarkNotes];
+    NoteJournal *journal = [self emptyJournal];
+    for (NSUInteger i = 0; i < kJournalBenchmarkRecordsPerNote; ++i)
+    {
+        for (Note *note in notes)
+        {
+            [journal recordNote:note syncedMD5:@"d41d8cd98f00b204e9800998ecf8427e"];
+        }
+    }
+    [journal flush];
+
+    [self measureBlock:^{
+        NoteJournal *replayed = [self replayedJournal];
+        XCTAssertNotNil([replayed stateForFileName:[((Note *)[notes lastObject]).file lastPathComponent]], @"Every note should be replayed.");
+    }];
+}
+
+#pragma mark - Helpers
+
+- (NoteJournal *)emptyJournal
+{
+    NoteJournal *retVal = [[NoteJournal alloc] initWithURL:self.journalURL directory:self.directory];
+    //Commits and compactions happen only when the tests ask for them
+    retVal.commitInterval = 60;
+    retVal.compactionThreshold = ULLONG_MAX;
+    return retVal;
+}
+
+- (NoteJournal *)replayedJournal
+{
+    NoteJournal *retVal = [self emptyJournal];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([retVal replay:&error], @"Replaying the journal failed: %@", error);
+    return retVal;
+}
+
+- (Note *)noteNamed:(NSString *)name localID:(NSString *)localID
+{
+    NSURL *file = [self.directory URLByAppendingPathComponent:name];
+    [name writeToURL:file atomically:NO encoding:NSUTF8StringEncoding error:nil];
+    Note *retVal = [[Note alloc] init];
+    retVal.file = file;
+    [retVal writeLocalID:localID];
+    return retVal;
+}
+
+- (NSArray *)benchmarkNotes
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:kJournalBenchmarkNoteCount];
+    for (NSUInteger i = 0; i < kJournalBenchmarkNoteCount; ++i)
+    {
+        NSString *name = [NSString stringWithFormat:@"Note %05lu", (unsigned long)i];
+        [retVal addObject:[self noteNamed:name localID:[[NSUUID UUID] UUIDString]]];
+    }
+    return retVal;
+}
+
+- (unsigned long long)journalLength
+{
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:[self.journalURL path] error:nil] fileSize];
+}
+
+- (void)truncateJournalToLength:(unsigned long long)length
+{
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:self.journalURL error:nil];
+    [handle truncateFileAtOffset:length];
+    [handle closeFile];
+}
+
+@end
@@ -0,0 +1,246 @@
+//
+//  NoteTableTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "NoteTable.h"
+#import "Note.h"
+
+static NSUInteger const kTableBenchmarkNoteCount = 5000;
+
+//The metadata setters, which are private to the Note, so the tests need no note files
+@interface Note (NoteTableTests)
+
+- (void)setLocalID:(NSString *)localID;
+- (void)setRemoteID:(NSString *)remoteID;
+- (void)setDeleted:(BOOL)deleted;
+- (void)setDirty:(BOOL)dirty;
+
+@end
+
+@interface NoteTableTests : XCTestCase
+
+@end
+
+@implementation NoteTableTests
+
+#pragma mark - Tests
+
+- (void)testNotesAreFoundByIdentifiers
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    NSArray *notes = [self notes:100];
+    [table addNotes:notes];
+    XCTAssertEqual(table.count, notes.count, @"Every note should be added.");
+    [table addNotes:@[[notes firstObject]]];
+    XCTAssertEqual(table.count, notes.count, @"A note already in the table should be ignored.");
+
+    for (Note *note in notes)
+    {
+        XCTAssertTrue([table noteWithLocalID:note.localID] == note, @"The note should be found by its local ID.");
+        XCTAssertTrue([table noteWithRemoteID:note.remoteID] == note, @"The note should be found by its remote ID.");
+    }
+    XCTAssertNil([table noteWithLocalID:@"missing"], @"A missing local ID should find nothing.");
+    XCTAssertNil([table noteWithRemoteID:nil], @"No remote ID should find nothing.");
+}
+
+- (void)testChangedIdentifiersAreReindexed
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    Note *note = [[self notes:1] firstObject];
+    [table addNotes:@[note]];
+    NSString *oldRemoteID = note.remoteID;
+
+    [note setRemoteID:@"uploaded"];
+    XCTAssertNil([table noteWithRemoteID:oldRemoteID], @"The old remote ID should no longer be indexed.");
+    XCTAssertTrue([table noteWithRemoteID:@"uploaded"] == note, @"The new remote ID should be indexed.");
+
+    [note setRemoteID:nil];
+    XCTAssertNil([table noteWithRemoteID:@"uploaded"], @"A removed remote ID should no longer be indexed.");
+
+    //A later note with the same local ID takes the place of the earlier one
+    Note *duplicate = [[Note alloc] init];
+    [duplicate setLocalID:note.localID];
+    [table addNotes:@[duplicate]];
+    XCTAssertTrue([table noteWithLocalID:note.localID] == duplicate, @"The later note should be found.");
+    [table removeNotes:@[note]];
+    XCTAssertTrue([table noteWithLocalID:duplicate.localID] == duplicate, @"Removing the earlier note should leave the later one indexed.");
+}
+
+- (void)testFlagsAreFoundByScanning
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    NSArray *notes = [self notes:200];
+    [table addNotes:notes];
+    XCTAssertFalse([table containsNotesWithAnyFlags:NoteTableFlagDirty | NoteTableFlagDeleted], @"No note should be flagged yet.");
+
+    //Either side of a bitmap word boundary
+    Note *dirty = [notes objectAtIndex:63];
+    Note *deleted = [notes objectAtIndex:64];
+    Note *both = [notes objectAtIndex:199];
+    [dirty setDirty:YES];
+    [deleted setDeleted:YES];
+    [both setDirty:YES];
+    [both setDeleted:YES];
+
+    XCTAssertEqualObjects([table notesWithAnyFlags:NoteTableFlagDirty], (@[dirty, both]), @"The dirty notes should be found, in row order.");
+    XCTAssertEqualObjects([table notesWithAnyFlags:NoteTableFlagDeleted], (@[deleted, both]), @"The deleted notes should be found, in row order.");
+    XCTAssertEqual([table notesWithAnyFlags:NoteTableFlagDirty | NoteTableFlagDeleted].count, (NSUInteger)3, @"Notes with either flag should be found once each.");
+
+    [dirty setDirty:NO];
+    [table removeNotes:@[both]];
+    XCTAssertEqual([table notesWithAnyFlags:NoteTableFlagDirty].count, (NSUInteger)0, @"Cleared and removed notes should no longer be found.");
+    XCTAssertTrue([table containsNotesWithAnyFlags:NoteTableFlagDeleted], @"The deleted note should still be found.");
+}
+
+- (void)testRemovedRowsAndSlotsAreReused
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    NSMutableArray *present = [[self notes:200] mutableCopy];
+    NSMutableArray *absent = [[self notes:100] mutableCopy];
+    [table addNotes:present];
+
+    //Churn, which leaves removed slots in the indexes until they are rebuilt
+    uint32_t state = 1;
+    for (NSUInteger round = 0; round < 50; ++round)
+    {
+        NSMutableArray *removed = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 100; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            Note *note = [present objectAtIndex:(state >> 8) % present.count];
+            [present removeObjectIdenticalTo:note];
+            [removed addObject:note];
+        }
+        [table removeNotes:removed];
+        [table addNotes:absent];
+        [present addObjectsFromArray:absent];
+        absent = removed;
+    }
+
+    XCTAssertEqual(table.count, (NSUInteger)200, @"The table should hold the notes present.");
+    for (Note *note in present)
+    {
+        XCTAssertTrue([table noteWithLocalID:note.localID] == note, @"A present note should be found by its local ID.");
+        XCTAssertTrue([table noteWithRemoteID:note.remoteID] == note, @"A present note should be found by its remote ID.");
+        XCTAssertTrue(note.tableRow < 200, @"Rows of removed notes should be reused.");
+    }
+    for (Note *note in absent)
+    {
+        XCTAssertNil([table noteWithLocalID:note.localID], @"A removed note should not be found.");
+        XCTAssertEqual(note.tableRow, (NSUInteger)NSNotFound, @"A removed note should have no row.");
+    }
+
+    [table removeAllNotes];
+    XCTAssertEqual(table.count, (NSUInteger)0, @"Every note should be removed.");
+    XCTAssertNil([table noteWithLocalID:((Note *)[present firstObject]).localID], @"No note should be found once all are removed.");
+}
+
+- (void)testEarlierNoteIsFoundOnceTheLaterOneLeaves
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    NSArray *notes = [self notes:3];
+    Note *first = [notes objectAtIndex:0];
+    Note *second = [notes objectAtIndex:1];
+    Note *third = [notes objectAtIndex:2];
+    NSString *shared = first.remoteID;
+    [second setRemoteID:shared];
+    [third setRemoteID:shared];
+    [table addNotes:notes];
+    XCTAssertTrue([table noteWithRemoteID:shared] == third, @"The latest note should be found.");
+
+    [table removeNotes:@[third]];
+    Note *found = [table noteWithRemoteID:shared];
+    XCTAssertTrue(found == first || found == second, @"An earlier note should be found once the later one is removed.");
+
+    //The note found gives the ID up, so the other earlier note is found
+    Note *other = found == first ? second : first;
+    [found setRemoteID:@"changed"];
+    XCTAssertTrue([table noteWithRemoteID:@"changed"] == found, @"The note should be found by its new ID.");
+    XCTAssertTrue([table noteWithRemoteID:shared] == other, @"The remaining note should be found by the shared ID.");
+
+    [table removeNotes:@[other]];
+    XCTAssertNil([table noteWithRemoteID:shared], @"The ID should no longer be found once every note holding it is removed.");
+
+    //Removing a note which was no longer found leaves the one which is
+    [table addNotes:@[other, third]];
+    [table removeNotes:@[other]];
+    XCTAssertTrue([table noteWithRemoteID:shared] == third, @"Removing an earlier note should leave the later one found.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testLookupPerformance
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    NSArray *notes = [self notes:kTableBenchmarkNoteCount];
+    [table addNotes:notes];
+    NSArray *localIDs = [notes valueForKey:@"localID"];
+    NSArray *remoteIDs = [notes valueForKey:@"remoteID"];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kTableBenchmarkNoteCount; ++i)
+        {
+            [table noteWithLocalID:[localIDs objectAtIndex:i]];
+            [table noteWithRemoteID:[remoteIDs objectAtIndex:i]];
+        }
+    }];
+}
+
+- (void)testFlagScanPerformance
+{
+    NoteTable *table = [[NoteTable alloc] init];
+    NSArray *notes = [self notes:kTableBenchmarkNoteCount];
+    [table addNotes:notes];
+    //A few dirty notes among many clean ones, as between syncs
+    for (NSUInteger i = 0; i < kTableBenchmarkNoteCount; i += 100)
+    {
+        [[notes objectAtIndex:i] setDirty:YES];
+    }
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100; ++i)
+        {
+            XCTAssertEqual([table notesWithAnyFlags:NoteTableFlagDirty].count, kTableBenchmarkNoteCount / 100, @"Every dirty note should be found.");
+        }
+    }];
+}
+
+- (void)testChurnPerformance
+{
+    NSArray *notes = [self notes:kTableBenchmarkNoteCount];
+    NSArray *half = [notes subarrayWithRange:NSMakeRange(0, kTableBenchmarkNoteCount / 2)];
+
+    [self measureBlock:^{
+        NoteTable *table = [[NoteTable alloc] init];
+        [table addNotes:notes];
+        for (NSUInteger i = 0; i < 10; ++i)
+        {
+            [table removeNotes:half];
+            [table addNotes:half];
+        }
+        XCTAssertEqual(table.count, kTableBenchmarkNoteCount, @"Every note should be in the table.");
+        [table removeAllNotes];
+    }];
+}
+
+#pragma mark - Helpers
+
+- (NSArray *)notes:(NSUInteger)count
+{
+    NSMutableArray *retVal = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i)
+    {
+        Note *note = [[Note alloc] init];
+        [note setLocalID:[[NSUUID UUID] UUIDString]];
+        [note setRemoteID:[[NSUUID UUID] UUIDString]];
+        [retVal addObject:note];
+    }
+    return retVal;
+}
+
+@end
@@ -0,0 +1,233 @@
+//
+//  SyncCheckpointTests.m
+//  GrokinNotesTests
+//
+//  Created by Levi Brown on 10/17/26.
+//  Copyright (c) 2026 Levi Brown. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "SyncCheckpoint.h"
+#import "FolderTree.h"
+#import "GTLDrive.h"
+
+static NSUInteger const kCheckpointBenchmarkFolderCount = 1000;
+
+//The layout of the checkpoint file, as written by SyncCheckpoint
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t length;
+    uint32_t checksum;
+} SyncCheckpointTestsHeader;
+
+@interface SyncCheckpointTests : XCTestCase
+
+@property (nonatomic,strong) NSURL *directory;
+@property (nonatomic,strong) NSURL *url;
+
+@end
+
+@implementation SyncCheckpointTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    self.directory = [NSURL fileURLWithPath:path isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+    self.url = [self.directory URLByAppendingPathComponent:@"SyncCheckpoint"];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Tests
+
+- (void)testSavedCheckpointIsLoaded
+{
+    SyncCheckpoint *checkpoint = [[SyncCheckpoint alloc] initWithURL:self.url];
+    checkpoint.changeID = @(1234);
+    [checkpoint.folderTree setFolderWithID:@"folder" title:@"Notes" parentID:nil];
+    [checkpoint.folderTree setParentID:@"folder" ofFileWithID:@"file"];
+    [checkpoint recordFailedChange:[self changeWithID:1 fileID:@"failed"]];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([checkpoint save:&error], @"Saving the checkpoint failed: %@", error);
+
+    SyncCheckpoint *loaded = [[SyncCheckpoint alloc] initWithURL:self.url];
+    XCTAssertTrue([loaded load:&error], @"Loading the checkpoint failed: %@", error);
+    XCTAssertEqualObjects(loaded.changeID, @(1234), @"The change ID should be loaded.");
+    XCTAssertEqualObjects([loaded.folderTree pathOfFileWithID:@"file"], @[@"Notes"], @"The folder tree should be loaded.");
+    XCTAssertEqual(loaded.failedChangeCount, (NSUInteger)1, @"The failed change should be loaded.");
+}
+
+- (void)testMissingCheckpointIsEmpty
+{
+    SyncCheckpoint *checkpoint = [[SyncCheckpoint alloc] initWithURL:self.url];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([checkpoint load:&error], @"A missing checkpoint should not be an error: %@", error);
+    XCTAssertNil(checkpoint.changeID, @"A missing checkpoint should have no change ID.");
+}
+
+- (void)testDamagedCheckpointIsRejected
+{
+    SyncCheckpoint *checkpoint = [[SyncCheckpoint alloc] initWithURL:self.url];
+    checkpoint.changeID = @(1234);
+    [checkpoint.folderTree setFolderWithID:@"folder" title:@"Notes" parentID:nil];
+    [checkpoint save:nil];
+
+    //A single flipped bit of the payload
+    NSMutableData *data = [NSMutableData dataWithContentsOfURL:self.url];
+    ((uint8_t *)[data mutableBytes])[data.length - 3] ^= 0x04;
+    [data writeToURL:self.url atomically:YES];
+
+    SyncCheckpoint *loaded = [[SyncCheckpoint alloc] initWithURL:self.url];
+    __autoreleasing NSError *error = nil;
+    XCTAssertFalse([loaded load:&error], @"A damaged checkpoint should not be loaded.");
+    XCTAssertEqualObjects(error.domain, SyncCheckpointErrorDomain, @"The error should be a checkpoint error.");
+    XCTAssertEqual(error.code, (NSInteger)SyncCheckpointErrorBadChecksum, @"The checksum should be reported as bad.");
+    XCTAssertNil(loaded.changeID, @"Nothing should be loaded from a damaged checkpoint.");
+    XCTAssertEqual(loaded.folderTree.folderCount, (NSUInteger)0, @"Nothing should be loaded from a damaged checkpoint.");
+
+    //A truncated payload
+    [data setLength:data.length - 10];
+    [data writeToURL:self.url atomically:YES];
+    XCTAssertFalse([loaded load:&error], @"A truncated checkpoint should not be loaded.");
+    XCTAssertEqual(error.code, (NSInteger)SyncCheckpointErrorBadChecksum, @"The length should be reported as bad.");
+}
+
+- (void)testCheckpointWithoutFoldersKeepsChangeID
+{
+    //As written before the folder tree was kept
+    NSDictionary *state = @{@"changeID": @(42), @"failedChanges": @[]};
+    [self writeCheckpointWithVersion:1 state:state];
+
+    SyncCheckpoint *checkpoint = [[SyncCheckpoint alloc] initWithURL:self.url];
+    __autoreleasing NSError *error = nil;
+    XCTAssertTrue([checkpoint load:&error], @"A checkpoint of the previous version should be loaded: %@", error);
+    XCTAssertEqualObjects(checkpoint.changeID, @(42), @"The change ID should be kept.");
+    XCTAssertEqual(checkpoint.folderTree.folderCount, (NSUInteger)0, @"The folders should be learned again.");
+
+    [self writeCheckpointWithVersion:99 state:state];
+    XCTAssertFalse([checkpoint load:&error], @"An unknown version should not be loaded.");
+    XCTAssertEqual(error.code, (NSInteger)SyncCheckpointErrorBadVersion, @"The version should be reported as bad.");
+}
+
+- (void)testFailedChangesAreRetriedUntilApplied
+{
+    SyncCheckpoint *checkpoint = [[SyncCheckpoint alloc] initWithURL:self.url];
+    checkpoint.maximumFailedChangeCount = 2;
+    checkpoint.initialRetryInterval = 0;
+    GTLDriveChange *first = [self changeWithID:1 fileID:@"first"];
+    [checkpoint recordFailedChange:first];
+    [checkpoint recordFailedChange:[self changeWithID:2 fileID:@"second"]];
+    XCTAssertEqual([checkpoint dueFailedChanges].count, (NSUInteger)2, @"Both changes should be due.");
+
+    //A later change to a file takes the place of its failed change
+    XCTAssertTrue([checkpoint hasRoomForFailedChanges:@[[self changeWithID:3 fileID:@"first"]]], @"A change to a file already waiting should fit.");
+    XCTAssertFalse([checkpoint hasRoomForFailedChanges:@[[self changeWithID:4 fileID:@"third"]]], @"A change to another file should not fit.");
+
+    [checkpoint recordAppliedChange:first];
+    XCTAssertEqual(checkpoint.failedChangeCount, (NSUInteger)1, @"The applied change should no longer wait.");
+
+    checkpoint.initialRetryInterval = 60;
+    [checkpoint recordFailedChange:[self changeWithID:5 fileID:@"fifth"]];
+    XCTAssertEqual([checkpoint dueFailedChanges].count, (NSUInteger)1, @"A change should not be due before its retry interval.");
+}
+
+- (void)testFolderPathsFollowMovesInAnyOrder
+{
+    FolderTree *tree = [[FolderTree alloc] init];
+    //The child arrives before its parent
+    [tree setFolderWithID:@"child" title:@"Child" parentID:@"parent"];
+    [tree setParentID:@"child" ofFileWithID:@"file"];
+    XCTAssertNil([tree pathOfFileWithID:@"file"], @"The path should be unresolved until the parent is known.");
+    XCTAssertEqualObjects([tree missingFolderIDs], [NSSet setWithObject:@"parent"], @"The parent should be missing.");
+
+    [tree setFolderWithID:@"parent" title:@"Parent" parentID:nil];
+    XCTAssertEqualObjects([tree pathOfFileWithID:@"file"], (@[@"Parent", @"Child"]), @"The path should resolve once the parent is known.");
+    XCTAssertEqual([tree missingFolderIDs].count, (NSUInteger)0, @"No folder should be missing.");
+
+    //Renaming and moving a folder carries what is within it along
+    XCTAssertTrue([tree setFolderWithID:@"other" title:@"Other" parentID:nil], @"A new folder should be a change.");
+    XCTAssertTrue([tree setFolderWithID:@"parent" title:@"Renamed" parentID:@"other"], @"A moved folder should be a change.");
+    XCTAssertFalse([tree setFolderWithID:@"parent" title:@"Renamed" parentID:@"other"], @"Recording a folder as it is should not be a change.");
+    XCTAssertEqualObjects([tree pathOfFileWithID:@"file"], (@[@"Other", @"Renamed", @"Child"]), @"The file should move with its folder.");
+    XCTAssertFalse([tree setParentID:@"child" ofFileWithID:@"file"], @"A file in the same folder should not be a change.");
+
+    //A loop is unresolved until a later change breaks it
+    [tree setFolderWithID:@"other" title:@"Other" parentID:@"child"];
+    XCTAssertNil([tree pathOfFolderWithID:@"child"], @"A folder within itself should be unresolved.");
+    [tree setFolderWithID:@"other" title:@"Other" parentID:nil];
+    XCTAssertEqualObjects([tree pathOfFolderWithID:@"child"], (@[@"Other", @"Renamed", @"Child"]), @"The path should resolve once the loop is broken.");
+
+    XCTAssertTrue([tree removeFolderWithID:@"parent"], @"Removing a recorded folder should be a change.");
+    XCTAssertFalse([tree removeFolderWithID:@"parent"], @"Removing a folder again should not be a change.");
+    XCTAssertNil([tree pathOfFileWithID:@"file"], @"The path should be unresolved once a folder on it is removed.");
+    XCTAssertEqualObjects([tree pathOfFileWithID:@"unknown"], @[], @"A file in no known folder should be at the root.");
+}
+
+#pragma mark - Benchmarks
+
+- (void)testSaveAndLoadPerformance
+{
+    SyncCheckpoint *checkpoint = [[SyncCheckpoint alloc] initWithURL:self.url];
+    checkpoint.changeID = @(123456789);
+    for (NSUInteger i = 0; i < kCheckpointBenchmarkFolderCount; ++i)
+    {
+        NSString *parentID = i > 0 ? [NSString stringWithFormat:@"folder%lu", (unsigned long)(i / 10)] : nil;
+        [checkpoint.folderTree setFolderWithID:[NSString stringWithFormat:@"folder%lu", (unsigned long)i] title:[NSString stringWithFormat:@"Folder %lu", (unsigned long)i] parentID:parentID];
+    }
+    for (NSUInteger i = 0; i < checkpoint.maximumFailedChangeCount; ++i)
+    {
+        [checkpoint recordFailedChange:[self changeWithID:i fileID:[NSString stringWithFormat:@"file%lu", (unsigned long)i]]];
+    }
+
+    [self measureBlock:^{
+        [checkpoint save:nil];
+        SyncCheckpoint *loaded = [[SyncCheckpoint alloc] initWithURL:self.url];
+        XCTAssertTrue([loaded load:nil], @"The checkpoint should be loaded.");
+        XCTAssertEqual(loaded.folderTree.folderCount, kCheckpointBenchmarkFolderCount, @"Every folder should be loaded.");
+    }];
+}
+
+#pragma mark - Helpers
+
+- (GTLDriveChange *)changeWithID:(long long)changeID fileID:(NSString *)fileID
+{
+    GTLDriveChange *retVal = [GTLDriveChange object];
+    retVal.identifier = @(changeID);
+    retVal.fileId = fileID;
+    retVal.file = [GTLDriveFile object];
+    retVal.file.identifier = fileID;
+    retVal.file.title = fileID;
+    return retVal;
+}
+
+- (void)writeCheckpointWithVersion:(uint32_t)version state:(NSDictionary *)state
+{
+    NSData *payload = [NSPropertyListSerialization dataWithPropertyList:state format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    SyncCheckpointTestsHeader header;
+    header.magic = 0x50435347;
+    header.version = version;
+    header.length = (uint32_t)payload.length;
+    //FNV-1a
+    header.checksum = 2166136261U;
+    const uint8_t *bytes = payload.bytes;
+    for (NSUInteger i = 0; i < payload.length; ++i)
+    {
+        header.checksum ^= bytes[i];
+        header.checksum *= 16777619U;
+    }
+
+    NSMutableData *data = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+    [data appendData:payload];
+    [data writeToURL:self.url atomically:YES];
+}
+
+@end